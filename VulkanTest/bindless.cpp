@@ -0,0 +1,252 @@
+//
+//  bindless.cpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#include "bindless.hpp"
+#include "base.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+// Size of the arrays with descriptor indexing (clamped to the device limits)
+constexpr uint32_t const BINDLESS_MAX_TEXTURES = 4096;
+constexpr uint32_t const BINDLESS_MAX_STORAGE_BUFFERS = 1024;
+constexpr uint32_t const BINDLESS_MAX_SAMPLERS = 64;
+// Size of the arrays without descriptor indexing (the guaranteed
+// per-stage minimum is 16 sampled images / samplers and 4 storage buffers)
+constexpr uint32_t const FALLBACK_MAX_TEXTURES = 16;
+constexpr uint32_t const FALLBACK_MAX_STORAGE_BUFFERS = 4;
+constexpr uint32_t const FALLBACK_MAX_SAMPLERS = 4;
+// Descriptors of each type left for the other sets of the pipeline layouts
+constexpr uint32_t const RESERVED_DESCRIPTORS = 2;
+
+static uint32_t clampCapacity(uint32_t wanted, uint32_t device_limit) {
+    const uint32_t available = device_limit > RESERVED_DESCRIPTORS ? device_limit - RESERVED_DESCRIPTORS : 1;
+    return std::max(1u, std::min(wanted, available));
+}
+
+void BindlessDescriptors::init(VkDevice device, const DeviceCapabilities &capabilities, uint32_t frames_in_flight) {
+    m_bindless = capabilities.descriptor_indexing;
+    const VkPhysicalDeviceLimits &limits = capabilities.properties.limits;
+    uint32_t texture_capacity = 0;
+    uint32_t storage_buffer_capacity = 0;
+    uint32_t sampler_capacity = 0;
+    if (m_bindless) {
+        texture_capacity = clampCapacity(BINDLESS_MAX_TEXTURES, capabilities.max_update_after_bind_sampled_images);
+        storage_buffer_capacity = clampCapacity(BINDLESS_MAX_STORAGE_BUFFERS, capabilities.max_update_after_bind_storage_buffers);
+        sampler_capacity = clampCapacity(BINDLESS_MAX_SAMPLERS, capabilities.max_update_after_bind_samplers);
+    } else {
+        texture_capacity = clampCapacity(FALLBACK_MAX_TEXTURES, limits.maxPerStageDescriptorSampledImages);
+        storage_buffer_capacity = clampCapacity(FALLBACK_MAX_STORAGE_BUFFERS, limits.maxPerStageDescriptorStorageBuffers);
+        sampler_capacity = clampCapacity(FALLBACK_MAX_SAMPLERS, limits.maxPerStageDescriptorSamplers);
+    }
+    Log("-> Bindless descriptors: " << (m_bindless ? "descriptor indexing" : "fallback (one set per frame)"));
+    if (!m_bindless && !capabilities.sampled_image_array_dynamic_indexing)
+        LogE("dynamic indexing of sampled image arrays is not supported: only the first texture can be used");
+    Log("\t textures: " << texture_capacity << ", storage buffers: " << storage_buffer_capacity << ", samplers: " << sampler_capacity);
+
+    const uint32_t sets_count = m_bindless ? 1 : frames_in_flight;
+    _initSlots(m_textures, TEXTURE_BINDING, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, texture_capacity, sets_count);
+    _initSlots(m_storage_buffers, STORAGE_BUFFER_BINDING, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, storage_buffer_capacity, sets_count);
+    _initSlots(m_samplers, SAMPLER_BINDING, VK_DESCRIPTOR_TYPE_SAMPLER, sampler_capacity, sets_count);
+    for (BindingSlots *slots: {&m_textures, &m_storage_buffers, &m_samplers})
+        slots->retired_slots.resize(frames_in_flight);
+
+    // Layout
+    VkDescriptorSetLayoutBinding bindings[3] {};
+    const BindingSlots *all_slots[3] = {&m_textures, &m_storage_buffers, &m_samplers};
+    VkDescriptorBindingFlags binding_flags[3] {};
+    for (uint32_t i = 0; i < 3; i++) {
+        bindings[i].binding = all_slots[i]->binding;
+        bindings[i].descriptorType = all_slots[i]->type;
+        bindings[i].descriptorCount = all_slots[i]->capacity;
+        bindings[i].stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
+        // Slots can be written while the set is bound, and may be left empty
+        binding_flags[i] = VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT
+            | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT
+            | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT;
+    }
+    VkDescriptorSetLayoutBindingFlagsCreateInfo binding_flags_info {};
+    binding_flags_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+    binding_flags_info.bindingCount = 3;
+    binding_flags_info.pBindingFlags = binding_flags;
+
+    VkDescriptorSetLayoutCreateInfo layout_info {};
+    layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layout_info.bindingCount = 3;
+    layout_info.pBindings = bindings;
+    if (m_bindless) {
+        layout_info.pNext = &binding_flags_info;
+        layout_info.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+    }
+    if (vkCreateDescriptorSetLayout(device, &layout_info, nullptr, &m_layout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create the bindless descriptor set layout");
+    }
+
+    // Pool, only used for these sets
+    VkDescriptorPoolSize pool_sizes[3] {};
+    for (uint32_t i = 0; i < 3; i++) {
+        pool_sizes[i].type = all_slots[i]->type;
+        pool_sizes[i].descriptorCount = all_slots[i]->capacity * sets_count;
+    }
+    VkDescriptorPoolCreateInfo pool_info {};
+    pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pool_info.flags = m_bindless ? VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT : 0;
+    pool_info.maxSets = sets_count;
+    pool_info.poolSizeCount = 3;
+    pool_info.pPoolSizes = pool_sizes;
+    if (vkCreateDescriptorPool(device, &pool_info, nullptr, &m_pool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create the bindless descriptor pool");
+    }
+
+    m_sets.resize(sets_count);
+    const std::vector<VkDescriptorSetLayout> layouts(sets_count, m_layout);
+    VkDescriptorSetAllocateInfo alloc_info {};
+    alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    alloc_info.descriptorPool = m_pool;
+    alloc_info.descriptorSetCount = sets_count;
+    alloc_info.pSetLayouts = layouts.data();
+    if (vkAllocateDescriptorSets(device, &alloc_info, m_sets.data()) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate the bindless descriptor sets");
+    }
+}
+
+void BindlessDescriptors::clean(VkDevice device) {
+    // The sets are freed with their pool
+    if (m_pool != VK_NULL_HANDLE) vkDestroyDescriptorPool(device, m_pool, nullptr);
+    if (m_layout != VK_NULL_HANDLE) vkDestroyDescriptorSetLayout(device, m_layout, nullptr);
+    m_pool = VK_NULL_HANDLE;
+    m_layout = VK_NULL_HANDLE;
+    m_sets.clear();
+}
+
+void BindlessDescriptors::_initSlots(BindingSlots &slots, uint32_t binding, VkDescriptorType type, uint32_t capacity, uint32_t sets_count) {
+    slots = BindingSlots {};
+    slots.binding = binding;
+    slots.type = type;
+    slots.capacity = capacity;
+    slots.dirty_slots.resize(sets_count);
+    if (type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER)
+        slots.buffer_infos.resize(capacity);
+    else
+        slots.image_infos.resize(capacity);
+}
+
+uint32_t BindlessDescriptors::_allocateSlot(BindingSlots &slots) {
+    if (!slots.free_slots.empty()) {
+        const uint32_t slot = slots.free_slots.back();
+        slots.free_slots.pop_back();
+        return slot;
+    }
+    if (slots.next_slot >= slots.capacity) {
+        LogE("bindless binding " << slots.binding << " is full (" << slots.capacity << " slots)");
+        throw std::runtime_error("no more bindless slots available");
+    }
+    return slots.next_slot++;
+}
+
+void BindlessDescriptors::_markDirty(BindingSlots &slots, uint32_t slot) {
+    if (!m_bindless && slot == 0) {
+        // Without partially bound bindings every slot must hold a valid
+        // descriptor: the unused ones point to the first resource
+        for (uint32_t i = slots.next_slot; i < slots.capacity; i++) {
+            if (!slots.image_infos.empty()) slots.image_infos[i] = slots.image_infos[0];
+            if (!slots.buffer_infos.empty()) slots.buffer_infos[i] = slots.buffer_infos[0];
+        }
+        for (auto &dirty: slots.dirty_slots) {
+            dirty.clear();
+            for (uint32_t i = 0; i < slots.capacity; i++) dirty.push_back(i);
+        }
+        return;
+    }
+    for (auto &dirty: slots.dirty_slots)
+        dirty.push_back(slot);
+}
+
+BindlessHandle BindlessDescriptors::registerTexture(VkImageView image_view, VkImageLayout layout) {
+    const uint32_t slot = _allocateSlot(m_textures);
+    m_textures.image_infos[slot] = {VK_NULL_HANDLE, image_view, layout};
+    _markDirty(m_textures, slot);
+    return slot;
+}
+
+BindlessHandle BindlessDescriptors::registerStorageBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range) {
+    const uint32_t slot = _allocateSlot(m_storage_buffers);
+    m_storage_buffers.buffer_infos[slot] = {buffer, offset, range};
+    _markDirty(m_storage_buffers, slot);
+    return slot;
+}
+
+BindlessHandle BindlessDescriptors::registerSampler(VkSampler sampler) {
+    const uint32_t slot = _allocateSlot(m_samplers);
+    m_samplers.image_infos[slot] = {sampler, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_UNDEFINED};
+    _markDirty(m_samplers, slot);
+    return slot;
+}
+
+void BindlessDescriptors::_release(BindingSlots &slots, BindlessHandle handle) {
+    if (handle == BINDLESS_INVALID_HANDLE || handle >= slots.next_slot)
+        return;
+    // Without descriptor indexing, the first resource backs the unused slots
+    if (!m_bindless && handle == 0)
+        return;
+    if (!m_bindless) {
+        // Do not keep a descriptor to a resource that may be destroyed
+        if (!slots.image_infos.empty()) slots.image_infos[handle] = slots.image_infos[0];
+        if (!slots.buffer_infos.empty()) slots.buffer_infos[handle] = slots.buffer_infos[0];
+        _markDirty(slots, handle);
+    }
+    slots.retired_slots[m_current_frame].push_back(handle);
+}
+
+void BindlessDescriptors::releaseTexture(BindlessHandle handle) {
+    _release(m_textures, handle);
+}
+
+void BindlessDescriptors::releaseStorageBuffer(BindlessHandle handle) {
+    _release(m_storage_buffers, handle);
+}
+
+void BindlessDescriptors::releaseSampler(BindlessHandle handle) {
+    _release(m_samplers, handle);
+}
+
+void BindlessDescriptors::_writeDirtySlots(VkDevice device, BindingSlots &slots, uint32_t set_index) {
+    std::vector<uint32_t> &dirty = slots.dirty_slots[set_index];
+    if (dirty.empty())
+        return;
+    std::sort(dirty.begin(), dirty.end());
+    dirty.erase(std::unique(dirty.begin(), dirty.end()), dirty.end());
+
+    // One write per slot: simple, and registrations are rare after loading
+    std::vector<VkWriteDescriptorSet> writes(dirty.size());
+    for (size_t i = 0; i < dirty.size(); i++) {
+        VkWriteDescriptorSet &write = writes[i];
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = m_sets[set_index];
+        write.dstBinding = slots.binding;
+        write.dstArrayElement = dirty[i];
+        write.descriptorCount = 1;
+        write.descriptorType = slots.type;
+        if (slots.type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER)
+            write.pBufferInfo = &slots.buffer_infos[dirty[i]];
+        else
+            write.pImageInfo = &slots.image_infos[dirty[i]];
+    }
+    vkUpdateDescriptorSets(device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+    dirty.clear();
+}
+
+void BindlessDescriptors::update(VkDevice device, uint32_t frame_index) {
+    m_current_frame = frame_index;
+    const uint32_t set_index = m_bindless ? 0 : frame_index;
+    for (BindingSlots *slots: {&m_textures, &m_storage_buffers, &m_samplers}) {
+        // The last use of this frame is over: the slots it released are free
+        auto &retired = slots->retired_slots[frame_index];
+        slots->free_slots.insert(slots->free_slots.end(), retired.begin(), retired.end());
+        retired.clear();
+        _writeDirtySlots(device, *slots, set_index);
+    }
+}
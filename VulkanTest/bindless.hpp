@@ -0,0 +1,110 @@
+//
+//  bindless.hpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#ifndef bindless_hpp
+#define bindless_hpp
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#include <vector>
+
+#include "device_capabilities.hpp"
+
+/**
+ * Index of a resource in the bindless descriptor set, given to the
+ * shaders through push constants or per-object data.
+ */
+using BindlessHandle = uint32_t;
+constexpr BindlessHandle const BINDLESS_INVALID_HANDLE = UINT32_MAX;
+
+/**
+ * Global descriptor set of every sampled image, storage buffer and sampler
+ * of the renderer, bound once per frame and indexed by BindlessHandle.
+ *
+ * With descriptor indexing, the set is allocated once with large,
+ * update-after-bind and partially bound arrays, and updated in place.
+ * Without it, the arrays are much smaller, every slot is always written
+ * (the unused ones point to the first registered resource of their type),
+ * and there is one set per frame in flight so that the set used by the
+ * GPU is never updated.
+ *
+ * Registrations are only written in update(), which must be called once
+ * the fence of the frame has been waited for.
+ */
+class BindlessDescriptors {
+
+public:
+    static constexpr uint32_t const TEXTURE_BINDING = 0;
+    static constexpr uint32_t const STORAGE_BUFFER_BINDING = 1;
+    static constexpr uint32_t const SAMPLER_BINDING = 2;
+
+    void init(VkDevice device, const DeviceCapabilities &capabilities, uint32_t frames_in_flight);
+
+    void clean(VkDevice device);
+
+    BindlessHandle registerTexture(VkImageView image_view, VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    BindlessHandle registerStorageBuffer(VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+    BindlessHandle registerSampler(VkSampler sampler);
+
+    /**
+     * Release a handle. Its slot is only reused once every frame in flight
+     * that may still reference it has completed.
+     * Without descriptor indexing, the first handle of each type can not be released.
+     */
+    void releaseTexture(BindlessHandle handle);
+    void releaseStorageBuffer(BindlessHandle handle);
+    void releaseSampler(BindlessHandle handle);
+
+    /**
+     * Write the pending registrations in the set used by the frame,
+     * and recycle the slots released by the previous use of this frame.
+     */
+    void update(VkDevice device, uint32_t frame_index);
+
+    VkDescriptorSetLayout layout() const { return m_layout; }
+    VkDescriptorSet set(uint32_t frame_index) const { return m_sets[m_bindless ? 0 : frame_index]; }
+    bool isBindless() const { return m_bindless; }
+
+    uint32_t textureCapacity() const { return m_textures.capacity; }
+    uint32_t storageBufferCapacity() const { return m_storage_buffers.capacity; }
+    uint32_t samplerCapacity() const { return m_samplers.capacity; }
+
+private:
+    /**
+     * Slots of one binding of the set, with a CPU copy of their descriptors.
+     */
+    struct BindingSlots {
+        uint32_t binding = 0;
+        VkDescriptorType type {};
+        uint32_t capacity = 0;
+        uint32_t next_slot = 0;
+        std::vector<uint32_t> free_slots;
+        // Released slots, per frame in flight, waiting for the frame to complete
+        std::vector<std::vector<uint32_t>> retired_slots;
+        // Slots to write, per set
+        std::vector<std::vector<uint32_t>> dirty_slots;
+        std::vector<VkDescriptorImageInfo> image_infos;
+        std::vector<VkDescriptorBufferInfo> buffer_infos;
+    };
+
+    bool m_bindless = false;
+    uint32_t m_current_frame = 0;
+    VkDescriptorSetLayout m_layout = VK_NULL_HANDLE;
+    VkDescriptorPool m_pool = VK_NULL_HANDLE;
+    std::vector<VkDescriptorSet> m_sets;
+    BindingSlots m_textures;
+    BindingSlots m_storage_buffers;
+    BindingSlots m_samplers;
+
+    void _initSlots(BindingSlots &slots, uint32_t binding, VkDescriptorType type, uint32_t capacity, uint32_t frames_in_flight);
+    uint32_t _allocateSlot(BindingSlots &slots);
+    void _markDirty(BindingSlots &slots, uint32_t slot);
+    void _release(BindingSlots &slots, BindlessHandle handle);
+    void _writeDirtySlots(VkDevice device, BindingSlots &slots, uint32_t set_index);
+};
+
+#endif /* bindless_hpp */
@@ -0,0 +1,123 @@
+//
+//  buffer_utils.cpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#include "buffer_utils.hpp"
+#include "base.hpp"
+#include <cstring>
+#include <stdexcept>
+
+std::optional<uint32_t> findMemoryType(VkPhysicalDevice physical_device, uint32_t type_filter, VkMemoryPropertyFlags properties) {
+    VkPhysicalDeviceMemoryProperties memory_properties {};
+    vkGetPhysicalDeviceMemoryProperties(physical_device, &memory_properties);
+    for (uint32_t i = 0; i < memory_properties.memoryTypeCount; i++) {
+        if ((type_filter & (1 << i)) && (memory_properties.memoryTypes[i].propertyFlags & properties) == properties)
+            return i;
+    }
+    return std::nullopt;
+}
+
+AllocatedBuffer createBuffer(VkPhysicalDevice physical_device, VkDevice device, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties) {
+    AllocatedBuffer allocated_buffer {};
+    allocated_buffer.size = size;
+
+    VkBufferCreateInfo buffer_info {};
+    buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_info.size = size;
+    buffer_info.usage = usage;
+    // Only used by the graphics (and compute) queue
+    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (vkCreateBuffer(device, &buffer_info, nullptr, &allocated_buffer.buffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create buffer");
+    }
+
+    VkMemoryRequirements memory_requirements {};
+    vkGetBufferMemoryRequirements(device, allocated_buffer.buffer, &memory_requirements);
+    const auto memory_type = findMemoryType(physical_device, memory_requirements.memoryTypeBits, properties);
+    if (!memory_type.has_value()) {
+        vkDestroyBuffer(device, allocated_buffer.buffer, nullptr);
+        throw std::runtime_error("failed to find a suitable memory type for buffer");
+    }
+
+    // One allocation per buffer is fine for the few (and large)
+    // buffers we create, but stays far below maxMemoryAllocationCount
+    VkMemoryAllocateInfo alloc_info {};
+    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    alloc_info.allocationSize = memory_requirements.size;
+    alloc_info.memoryTypeIndex = memory_type.value();
+    if (vkAllocateMemory(device, &alloc_info, nullptr, &allocated_buffer.memory) != VK_SUCCESS) {
+        vkDestroyBuffer(device, allocated_buffer.buffer, nullptr);
+        throw std::runtime_error("failed to allocate buffer memory");
+    }
+    vkBindBufferMemory(device, allocated_buffer.buffer, allocated_buffer.memory, 0);
+
+    // Keep host-visible buffers mapped for their whole lifetime
+    if (properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        if (vkMapMemory(device, allocated_buffer.memory, 0, size, 0, &allocated_buffer.mapped) != VK_SUCCESS) {
+            destroyBuffer(device, allocated_buffer);
+            throw std::runtime_error("failed to map buffer memory");
+        }
+    }
+    return allocated_buffer;
+}
+
+void destroyBuffer(VkDevice device, AllocatedBuffer &buffer) {
+    if (buffer.mapped != nullptr) vkUnmapMemory(device, buffer.memory);
+    if (buffer.buffer != VK_NULL_HANDLE) vkDestroyBuffer(device, buffer.buffer, nullptr);
+    if (buffer.memory != VK_NULL_HANDLE) vkFreeMemory(device, buffer.memory, nullptr);
+    buffer = AllocatedBuffer {};
+}
+
+VkCommandBuffer beginSingleTimeCommands(VkDevice device, VkCommandPool command_pool) {
+    VkCommandBufferAllocateInfo alloc_info {};
+    alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    alloc_info.commandPool = command_pool;
+    alloc_info.commandBufferCount = 1;
+
+    VkCommandBuffer command_buffer {};
+    if (vkAllocateCommandBuffers(device, &alloc_info, &command_buffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate single time command buffer");
+    }
+
+    VkCommandBufferBeginInfo begin_info {};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(command_buffer, &begin_info);
+    return command_buffer;
+}
+
+void endSingleTimeCommands(VkDevice device, VkCommandPool command_pool, VkQueue queue, VkCommandBuffer command_buffer) {
+    vkEndCommandBuffer(command_buffer);
+
+    VkSubmitInfo submit_info {};
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &command_buffer;
+    if (vkQueueSubmit(queue, 1, &submit_info, VK_NULL_HANDLE) != VK_SUCCESS) {
+        LogE("failed to submit single time command buffer");
+        throw std::runtime_error("failed to submit single time command buffer");
+    }
+    // Only used at load time, so a full wait is acceptable here
+    vkQueueWaitIdle(queue);
+    vkFreeCommandBuffers(device, command_pool, 1, &command_buffer);
+}
+
+AllocatedBuffer createDeviceLocalBuffer(VkPhysicalDevice physical_device, VkDevice device, VkCommandPool command_pool, VkQueue queue, const void *data, VkDeviceSize size, VkBufferUsageFlags usage) {
+    AllocatedBuffer staging_buffer = createBuffer(physical_device, device, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    memcpy(staging_buffer.mapped, data, static_cast<size_t>(size));
+
+    AllocatedBuffer buffer = createBuffer(physical_device, device, size, usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    VkCommandBuffer command_buffer = beginSingleTimeCommands(device, command_pool);
+    VkBufferCopy copy_region {};
+    copy_region.size = size;
+    vkCmdCopyBuffer(command_buffer, staging_buffer.buffer, buffer.buffer, 1, &copy_region);
+    endSingleTimeCommands(device, command_pool, queue, command_buffer);
+
+    destroyBuffer(device, staging_buffer);
+    return buffer;
+}
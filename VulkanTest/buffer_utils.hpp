@@ -0,0 +1,59 @@
+//
+//  buffer_utils.hpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#ifndef buffer_utils_hpp
+#define buffer_utils_hpp
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#include <optional>
+
+/**
+ * A buffer and the device memory bound to it.
+ * mapped is only set for host-visible buffers created with persistent mapping.
+ */
+struct AllocatedBuffer {
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize size = 0;
+    void *mapped = nullptr;
+};
+
+/**
+ * Find a memory type index matching both the type filter (from
+ * VkMemoryRequirements) and the requested properties.
+ */
+std::optional<uint32_t> findMemoryType(VkPhysicalDevice physical_device, uint32_t type_filter, VkMemoryPropertyFlags properties);
+
+/**
+ * Create a buffer and allocate / bind its memory.
+ * Host-visible buffers are persistently mapped.
+ * Throws if the buffer cannot be created.
+ */
+AllocatedBuffer createBuffer(VkPhysicalDevice physical_device, VkDevice device, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties);
+
+/**
+ * Unmap (if needed), destroy and free the buffer.
+ */
+void destroyBuffer(VkDevice device, AllocatedBuffer &buffer);
+
+/**
+ * Allocate and begin a command buffer for a one-time submission.
+ */
+VkCommandBuffer beginSingleTimeCommands(VkDevice device, VkCommandPool command_pool);
+
+/**
+ * End, submit and wait for a command buffer created with beginSingleTimeCommands.
+ */
+void endSingleTimeCommands(VkDevice device, VkCommandPool command_pool, VkQueue queue, VkCommandBuffer command_buffer);
+
+/**
+ * Create a device-local buffer and fill it through a staging buffer.
+ */
+AllocatedBuffer createDeviceLocalBuffer(VkPhysicalDevice physical_device, VkDevice device, VkCommandPool command_pool, VkQueue queue, const void *data, VkDeviceSize size, VkBufferUsageFlags usage);
+
+#endif /* buffer_utils_hpp */
@@ -0,0 +1,297 @@
+//
+//  capture_encoder.cpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#include "capture_encoder.hpp"
+#include "base.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+// Largest stored deflate block
+constexpr size_t const PNG_STORED_BLOCK_SIZE = 65535;
+
+static void appendBigEndian(std::vector<uint8_t> &bytes, uint32_t value) {
+    bytes.push_back(static_cast<uint8_t>(value >> 24));
+    bytes.push_back(static_cast<uint8_t>(value >> 16));
+    bytes.push_back(static_cast<uint8_t>(value >> 8));
+    bytes.push_back(static_cast<uint8_t>(value));
+}
+
+static bool isBgra(VkFormat format) {
+    return format == VK_FORMAT_B8G8R8A8_UNORM || format == VK_FORMAT_B8G8R8A8_SRGB;
+}
+
+/**
+ * Tightly packed RGB rows, from the 4 bytes per texel of the readback.
+ */
+static std::vector<uint8_t> toRgb(const std::vector<uint8_t> &pixels, VkFormat format) {
+    const size_t texel_count = pixels.size() / 4;
+    const bool bgra = isBgra(format);
+    std::vector<uint8_t> rgb(texel_count * 3);
+    for (size_t i = 0; i < texel_count; i++) {
+        rgb[3 * i + 0] = pixels[4 * i + (bgra ? 2 : 0)];
+        rgb[3 * i + 1] = pixels[4 * i + 1];
+        rgb[3 * i + 2] = pixels[4 * i + (bgra ? 0 : 2)];
+    }
+    return rgb;
+}
+
+/**
+ * QOI, 3 channels (https://qoiformat.org/qoi-specification.pdf).
+ */
+static std::vector<uint8_t> encodeQoi(const std::vector<uint8_t> &rgb, VkExtent2D extent, bool srgb) {
+    constexpr uint8_t const QOI_OP_INDEX = 0x00;
+    constexpr uint8_t const QOI_OP_DIFF = 0x40;
+    constexpr uint8_t const QOI_OP_LUMA = 0x80;
+    constexpr uint8_t const QOI_OP_RUN = 0xc0;
+    constexpr uint8_t const QOI_OP_RGB = 0xfe;
+
+    std::vector<uint8_t> bytes;
+    // Worst case: an RGB op per pixel
+    bytes.reserve(14 + rgb.size() / 3 * 4 + 8);
+    bytes.insert(bytes.end(), {'q', 'o', 'i', 'f'});
+    appendBigEndian(bytes, extent.width);
+    appendBigEndian(bytes, extent.height);
+    bytes.push_back(3);
+    // 0: sRGB with linear alpha, 1: all channels linear
+    bytes.push_back(srgb ? 0 : 1);
+
+    std::array<std::array<uint8_t, 3>, 64> index {};
+    std::array<uint8_t, 3> previous = {0, 0, 0};
+    uint32_t run = 0;
+    const size_t texel_count = rgb.size() / 3;
+    for (size_t i = 0; i < texel_count; i++) {
+        const std::array<uint8_t, 3> texel = {rgb[3 * i], rgb[3 * i + 1], rgb[3 * i + 2]};
+        if (texel == previous) {
+            run++;
+            if (run == 62 || i + 1 == texel_count) {
+                bytes.push_back(static_cast<uint8_t>(QOI_OP_RUN | (run - 1)));
+                run = 0;
+            }
+            continue;
+        }
+        if (run > 0) {
+            bytes.push_back(static_cast<uint8_t>(QOI_OP_RUN | (run - 1)));
+            run = 0;
+        }
+        // Alpha is always 255
+        const uint32_t hash = (texel[0] * 3 + texel[1] * 5 + texel[2] * 7 + 255 * 11) % 64;
+        if (index[hash] == texel) {
+            bytes.push_back(static_cast<uint8_t>(QOI_OP_INDEX | hash));
+        } else {
+            index[hash] = texel;
+            const int8_t dr = static_cast<int8_t>(texel[0] - previous[0]);
+            const int8_t dg = static_cast<int8_t>(texel[1] - previous[1]);
+            const int8_t db = static_cast<int8_t>(texel[2] - previous[2]);
+            const int8_t dr_dg = static_cast<int8_t>(dr - dg);
+            const int8_t db_dg = static_cast<int8_t>(db - dg);
+            if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+                bytes.push_back(static_cast<uint8_t>(QOI_OP_DIFF | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2)));
+            } else if (dg >= -32 && dg <= 31 && dr_dg >= -8 && dr_dg <= 7 && db_dg >= -8 && db_dg <= 7) {
+                bytes.push_back(static_cast<uint8_t>(QOI_OP_LUMA | (dg + 32)));
+                bytes.push_back(static_cast<uint8_t>((dr_dg + 8) << 4 | (db_dg + 8)));
+            } else {
+                bytes.insert(bytes.end(), {QOI_OP_RGB, texel[0], texel[1], texel[2]});
+            }
+        }
+        previous = texel;
+    }
+    bytes.insert(bytes.end(), {0, 0, 0, 0, 0, 0, 0, 1});
+    return bytes;
+}
+
+static uint32_t crc32(const uint8_t *data, size_t size, uint32_t crc = 0) {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> values {};
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t value = i;
+            for (int bit = 0; bit < 8; bit++)
+                value = (value & 1) ? 0xedb88320u ^ (value >> 1) : value >> 1;
+            values[i] = value;
+        }
+        return values;
+    }();
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++)
+        crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    return ~crc;
+}
+
+static void appendPngChunk(std::vector<uint8_t> &bytes, const char type[4], const std::vector<uint8_t> &data) {
+    appendBigEndian(bytes, static_cast<uint32_t>(data.size()));
+    const size_t type_offset = bytes.size();
+    bytes.insert(bytes.end(), type, type + 4);
+    bytes.insert(bytes.end(), data.begin(), data.end());
+    // Over the type and the data
+    appendBigEndian(bytes, crc32(bytes.data() + type_offset, bytes.size() - type_offset));
+}
+
+/**
+ * PNG, 8-bit RGB, with a zlib stream of stored blocks: no compression, but
+ * readable by any decoder, without a zlib dependency.
+ */
+static std::vector<uint8_t> encodePng(const std::vector<uint8_t> &rgb, VkExtent2D extent) {
+    // Each row starts with its filter type (0: none)
+    const size_t row_size = 3 * static_cast<size_t>(extent.width);
+    std::vector<uint8_t> scanlines;
+    scanlines.reserve((row_size + 1) * extent.height);
+    for (uint32_t y = 0; y < extent.height; y++) {
+        scanlines.push_back(0);
+        scanlines.insert(scanlines.end(), rgb.begin() + y * row_size, rgb.begin() + (y + 1) * row_size);
+    }
+
+    std::vector<uint8_t> zlib;
+    const size_t block_count = std::max<size_t>(1, (scanlines.size() + PNG_STORED_BLOCK_SIZE - 1) / PNG_STORED_BLOCK_SIZE);
+    zlib.reserve(2 + scanlines.size() + 5 * block_count + 4);
+    // Deflate, 32K window, no preset dictionary
+    zlib.insert(zlib.end(), {0x78, 0x01});
+    uint32_t adler_a = 1;
+    uint32_t adler_b = 0;
+    for (size_t block = 0; block < block_count; block++) {
+        const size_t first = block * PNG_STORED_BLOCK_SIZE;
+        const size_t size = std::min(PNG_STORED_BLOCK_SIZE, scanlines.size() - first);
+        // BFINAL on the last block, BTYPE 00 (stored), then LEN and NLEN (little endian)
+        zlib.push_back(block + 1 == block_count ? 1 : 0);
+        zlib.push_back(static_cast<uint8_t>(size));
+        zlib.push_back(static_cast<uint8_t>(size >> 8));
+        zlib.push_back(static_cast<uint8_t>(~size));
+        zlib.push_back(static_cast<uint8_t>(~size >> 8));
+        zlib.insert(zlib.end(), scanlines.begin() + first, scanlines.begin() + first + size);
+        for (size_t i = first; i < first + size; i++) {
+            adler_a = (adler_a + scanlines[i]) % 65521;
+            adler_b = (adler_b + adler_a) % 65521;
+        }
+    }
+    appendBigEndian(zlib, adler_b << 16 | adler_a);
+
+    std::vector<uint8_t> header;
+    appendBigEndian(header, extent.width);
+    appendBigEndian(header, extent.height);
+    // 8 bits per channel, RGB, deflate, adaptive filtering, no interlace
+    header.insert(header.end(), {8, 2, 0, 0, 0});
+
+    std::vector<uint8_t> bytes = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    bytes.reserve(bytes.size() + 25 + zlib.size() + 12 + 12);
+    appendPngChunk(bytes, "IHDR", header);
+    appendPngChunk(bytes, "IDAT", zlib);
+    appendPngChunk(bytes, "IEND", {});
+    return bytes;
+}
+
+void CaptureEncoder::init(const CaptureEncoderDesc &desc, VkExtent2D extent) {
+    m_desc = desc;
+    m_desc.queue_capacity = std::max(1u, desc.queue_capacity);
+    m_desc.max_interval = std::max(1u, desc.max_interval);
+    m_stop = false;
+    m_interval = 1;
+    m_interval_position = 0;
+    m_submitted = 0;
+    std::filesystem::create_directories(m_desc.directory);
+    // Allocated once: submit only copies
+    for (uint32_t i = 0; i < m_desc.queue_capacity; i++) {
+        auto frame = std::make_unique<PendingFrame>();
+        frame->pixels.reserve(4 * static_cast<size_t>(extent.width) * extent.height);
+        m_free_frames.push_back(std::move(frame));
+    }
+    const uint32_t thread_count = std::max(1u, desc.thread_count);
+    for (uint32_t i = 0; i < thread_count; i++)
+        m_threads.emplace_back(&CaptureEncoder::_encoderLoop, this);
+    Log("-> Capture encoder: " << thread_count << " threads, " << m_desc.queue_capacity << " frames queued at most, to " << m_desc.directory);
+}
+
+void CaptureEncoder::clean() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake_up.notify_all();
+    for (std::thread &thread: m_threads)
+        thread.join();
+    m_threads.clear();
+    m_queue.clear();
+    m_free_frames.clear();
+}
+
+bool CaptureEncoder::submit(const FrameCapture &capture) {
+    if (m_desc.max_frames != 0 && m_submitted >= m_desc.max_frames)
+        return false;
+    if (m_desc.backpressure == CaptureBackpressure::Throttle && m_interval_position++ % m_interval != 0) {
+        m_skipped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    std::unique_ptr<PendingFrame> frame;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_free_frames.empty()) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            if (m_desc.backpressure == CaptureBackpressure::Throttle) {
+                m_interval = std::min(m_interval * 2, m_desc.max_interval);
+                m_interval_position = 1;
+            }
+            return false;
+        }
+        // Drained: back toward every frame
+        if (m_interval > 1 && m_queue.size() <= m_desc.queue_capacity / 4) {
+            m_interval /= 2;
+            m_interval_position = 1;
+        }
+        frame = std::move(m_free_frames.back());
+        m_free_frames.pop_back();
+    }
+    // The readback buffer is reused as soon as this returns
+    frame->frame_number = capture.frame_number;
+    frame->extent = capture.extent;
+    frame->format = capture.format;
+    frame->pixels.assign(capture.pixels, capture.pixels + capture.size);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.push_back(std::move(frame));
+    }
+    m_wake_up.notify_one();
+    m_submitted++;
+    return true;
+}
+
+void CaptureEncoder::_encoderLoop() {
+    while (true) {
+        std::unique_ptr<PendingFrame> frame;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake_up.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+            // Stopping: finish the queued frames first
+            if (m_queue.empty())
+                return;
+            frame = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+        _writeFrame(*frame);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_free_frames.push_back(std::move(frame));
+    }
+}
+
+void CaptureEncoder::_writeFrame(const PendingFrame &frame) {
+    const std::vector<uint8_t> rgb = toRgb(frame.pixels, frame.format);
+    const bool qoi = m_desc.format == CaptureFileFormat::Qoi;
+    const bool srgb = frame.format == VK_FORMAT_B8G8R8A8_SRGB || frame.format == VK_FORMAT_R8G8B8A8_SRGB;
+    const std::vector<uint8_t> bytes = qoi ? encodeQoi(rgb, frame.extent, srgb) : encodePng(rgb, frame.extent);
+
+    char number[32];
+    std::snprintf(number, sizeof(number), "%06llu", static_cast<unsigned long long>(frame.frame_number));
+    const std::filesystem::path path = std::filesystem::path(m_desc.directory) / (m_desc.prefix + number + (qoi ? ".qoi" : ".png"));
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    if (!file) {
+        LogE("failed to write the capture " << path.string());
+        m_failed.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    m_written.fetch_add(1, std::memory_order_relaxed);
+}
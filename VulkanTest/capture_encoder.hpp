@@ -0,0 +1,120 @@
+//
+//  capture_encoder.hpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#ifndef capture_encoder_hpp
+#define capture_encoder_hpp
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "frame_readback.hpp"
+
+enum class CaptureFileFormat {
+    // Quite OK Image format: lossless, encoded several times faster than PNG
+    Qoi,
+    // Stored (uncompressed) deflate blocks: no zlib, large files
+    Png,
+};
+
+/**
+ * What submit does when the encoders fall behind.
+ */
+enum class CaptureBackpressure {
+    // Drop the frames finding every buffer in use
+    Drop,
+    // Also capture only one frame out of an interval, doubled each time a
+    // frame is dropped, and halved back once the queue has drained
+    Throttle,
+};
+
+struct CaptureEncoderDesc {
+    // Created if needed. Files are named <prefix><frame number>.<qoi|png>
+    std::string directory = "captures";
+    std::string prefix = "frame_";
+    CaptureFileFormat format = CaptureFileFormat::Qoi;
+    CaptureBackpressure backpressure = CaptureBackpressure::Throttle;
+    uint32_t thread_count = 2;
+    // Frames waiting or being encoded, at most (one image buffer each)
+    uint32_t queue_capacity = 8;
+    // Throttle: capture interval upper bound
+    uint32_t max_interval = 16;
+    // Frames to capture before ignoring the next ones (0: no limit)
+    uint32_t max_frames = 0;
+};
+
+/**
+ * Writes captured frames to numbered image files, on background threads.
+ *
+ * submit copies the pixels into one of queue_capacity preallocated buffers
+ * and queues it: it never waits for the encoders. A pool of encoder
+ * threads pops the frames, converts them to RGB, encodes and writes them,
+ * then gives their buffer back. When every buffer is in use, the frame is
+ * dropped (and with CaptureBackpressure::Throttle, the capture rate goes
+ * down until the queue drains).
+ */
+class CaptureEncoder {
+
+public:
+    void init(const CaptureEncoderDesc &desc, VkExtent2D extent);
+
+    /**
+     * Encode the frames still queued, then stop and join the threads.
+     */
+    void clean();
+
+    /**
+     * Queue a copy of the frame, or drop it. Returns true if queued.
+     * Called from the render thread only.
+     */
+    bool submit(const FrameCapture &capture);
+
+    uint64_t writtenCount() const { return m_written.load(std::memory_order_relaxed); }
+    uint64_t droppedCount() const { return m_dropped.load(std::memory_order_relaxed); }
+    // Frames skipped by the throttle interval
+    uint64_t skippedCount() const { return m_skipped.load(std::memory_order_relaxed); }
+    uint64_t failedCount() const { return m_failed.load(std::memory_order_relaxed); }
+    uint32_t interval() const { return m_interval; }
+
+private:
+    struct PendingFrame {
+        uint64_t frame_number = 0;
+        VkExtent2D extent {};
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        std::vector<uint8_t> pixels;
+    };
+
+    CaptureEncoderDesc m_desc {};
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_wake_up;
+    bool m_stop = false;
+    // Guarded by m_mutex
+    std::deque<std::unique_ptr<PendingFrame>> m_queue;
+    std::vector<std::unique_ptr<PendingFrame>> m_free_frames;
+
+    // Render thread only
+    uint32_t m_interval = 1;
+    uint32_t m_interval_position = 0;
+    uint32_t m_submitted = 0;
+
+    std::atomic<uint64_t> m_written {0};
+    std::atomic<uint64_t> m_dropped {0};
+    std::atomic<uint64_t> m_skipped {0};
+    std::atomic<uint64_t> m_failed {0};
+
+    void _encoderLoop();
+    void _writeFrame(const PendingFrame &frame);
+};
+
+#endif /* capture_encoder_hpp */
@@ -0,0 +1,193 @@
+//
+//  clustered_lighting.cpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#include "clustered_lighting.hpp"
+#include "base.hpp"
+#include "push_constants.hpp"
+#include "shader_support.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+// Must match the local size of light_cull.comp
+constexpr uint32_t const CLUSTER_WORKGROUP_SIZE = 64;
+// Words at the start of each frame of the cluster buffer (the index counter,
+// then padding), before the (offset, count) range of each cluster and the
+// light indices. Must match light_cull.comp and shader.frag.
+constexpr uint32_t const CLUSTER_HEADER_WORDS = 4;
+
+// Push constants of light_cull.comp
+struct ClusterParams {
+    glm::mat4 view;
+    // xy: 1 / projection[0][0], 1 / projection[1][1] (view space size of
+    // the clip space at a depth of 1), z: near plane, w: depth slices per
+    // unit of log(depth)
+    glm::vec4 projection;
+    // xyz: clusters per row / column / depth, w: tile size in pixels
+    glm::uvec4 grid;
+    // x: light count, y: first word of the frame, z: index capacity
+    glm::uvec4 lights;
+    glm::vec2 viewport;
+};
+
+void ClusteredLighting::init(VkPhysicalDevice physical_device, VkDevice device, const DeviceCapabilities &capabilities, VkCommandPool command_pool, VkQueue queue, BindlessDescriptors &bindless, VkExtent2D extent, float z_near, const ClusterGridDesc &desc, const std::vector<PointLight> &lights, uint32_t light_count, uint32_t frames_in_flight) {
+    if (lights.empty()) {
+        throw std::runtime_error("clustered lighting needs at least one light");
+    }
+    m_extent = extent;
+    m_desc = desc;
+    m_z_near = z_near;
+    m_grid = glm::uvec3(
+        (extent.width + desc.tile_size - 1) / desc.tile_size,
+        (extent.height + desc.tile_size - 1) / desc.tile_size,
+        desc.depth_slices);
+    m_max_lights = static_cast<uint32_t>(lights.size());
+    setLightCount(light_count);
+
+    // Never written again: device local
+    m_light_buffer = createDeviceLocalBuffer(physical_device, device, command_pool, queue, lights.data(), sizeof(PointLight) * lights.size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+    m_index_capacity = clusterCount() * desc.index_capacity_per_cluster;
+    m_frame_words = CLUSTER_HEADER_WORDS + 2 * clusterCount() + m_index_capacity;
+    m_cluster_buffer = createBuffer(
+        physical_device,
+        device,
+        sizeof(uint32_t) * m_frame_words * frames_in_flight,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    m_light_buffer_handle = bindless.registerStorageBuffer(m_light_buffer.buffer);
+    m_cluster_buffer_handle = bindless.registerStorageBuffer(m_cluster_buffer.buffer);
+
+    _createDescriptors(device);
+    _createPipeline(device, capabilities);
+    Log("-> Clustered lighting: " << m_grid.x << "x" << m_grid.y << "x" << m_grid.z << " clusters, " << m_light_count << " / " << m_max_lights << " lights");
+}
+
+void ClusteredLighting::setLightCount(uint32_t light_count) {
+    m_light_count = std::min(light_count, m_max_lights);
+}
+
+void ClusteredLighting::_createDescriptors(VkDevice device) {
+    // 0: lights, 1: ranges and index lists
+    VkDescriptorSetLayoutBinding bindings[2] {};
+    for (uint32_t i = 0; i < 2; i++) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+    VkDescriptorSetLayoutCreateInfo layout_info {};
+    layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layout_info.bindingCount = 2;
+    layout_info.pBindings = bindings;
+    if (vkCreateDescriptorSetLayout(device, &layout_info, nullptr, &m_descriptor_set_layout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create the light culling descriptor set layout");
+    }
+
+    // Whole buffers, every frame: written once
+    m_descriptor_allocator.init(device, 1, {{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2.0f}});
+    m_descriptor_set = m_descriptor_allocator.allocate(device, m_descriptor_set_layout);
+    const VkDescriptorBufferInfo buffer_infos[2] = {
+        {m_light_buffer.buffer, 0, VK_WHOLE_SIZE},
+        {m_cluster_buffer.buffer, 0, VK_WHOLE_SIZE}
+    };
+    VkWriteDescriptorSet writes[2] {};
+    for (uint32_t i = 0; i < 2; i++) {
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet = m_descriptor_set;
+        writes[i].dstBinding = i;
+        writes[i].descriptorCount = 1;
+        writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        writes[i].pBufferInfo = &buffer_infos[i];
+    }
+    vkUpdateDescriptorSets(device, 2, writes, 0, nullptr);
+}
+
+void ClusteredLighting::_createPipeline(VkDevice device, const DeviceCapabilities &capabilities) {
+    const VkPushConstantRange push_constant_range = pushConstantRange<ClusterParams>(capabilities, VK_SHADER_STAGE_COMPUTE_BIT);
+    VkPipelineLayoutCreateInfo pipeline_layout_info {};
+    pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipeline_layout_info.setLayoutCount = 1;
+    pipeline_layout_info.pSetLayouts = &m_descriptor_set_layout;
+    pipeline_layout_info.pushConstantRangeCount = 1;
+    pipeline_layout_info.pPushConstantRanges = &push_constant_range;
+    if (vkCreatePipelineLayout(device, &pipeline_layout_info, nullptr, &m_pipeline_layout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create the light culling pipeline layout");
+    }
+
+    VkShaderModule shader_module = createShaderModule(device, "light_cull.spv");
+    VkComputePipelineCreateInfo pipeline_info {};
+    pipeline_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipeline_info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipeline_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipeline_info.stage.module = shader_module;
+    pipeline_info.stage.pName = "main";
+    pipeline_info.layout = m_pipeline_layout;
+    const auto res = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &m_pipeline);
+    vkDestroyShaderModule(device, shader_module, nullptr);
+    if (res != VK_SUCCESS) {
+        throw std::runtime_error("failed to create the light culling pipeline");
+    }
+}
+
+void ClusteredLighting::clean(VkDevice device, BindlessDescriptors &bindless) {
+    if (m_pipeline != VK_NULL_HANDLE) vkDestroyPipeline(device, m_pipeline, nullptr);
+    if (m_pipeline_layout != VK_NULL_HANDLE) vkDestroyPipelineLayout(device, m_pipeline_layout, nullptr);
+    m_descriptor_allocator.clean(device);
+    if (m_descriptor_set_layout != VK_NULL_HANDLE) vkDestroyDescriptorSetLayout(device, m_descriptor_set_layout, nullptr);
+    if (m_light_buffer_handle != BINDLESS_INVALID_HANDLE) bindless.releaseStorageBuffer(m_light_buffer_handle);
+    if (m_cluster_buffer_handle != BINDLESS_INVALID_HANDLE) bindless.releaseStorageBuffer(m_cluster_buffer_handle);
+    destroyBuffer(device, m_light_buffer);
+    destroyBuffer(device, m_cluster_buffer);
+    m_pipeline = VK_NULL_HANDLE;
+    m_pipeline_layout = VK_NULL_HANDLE;
+    m_descriptor_set_layout = VK_NULL_HANDLE;
+    m_descriptor_set = VK_NULL_HANDLE;
+    m_light_buffer_handle = BINDLESS_INVALID_HANDLE;
+    m_cluster_buffer_handle = BINDLESS_INVALID_HANDLE;
+}
+
+void ClusteredLighting::recordCulling(VkCommandBuffer command_buffer, uint32_t frame_index, const glm::mat4 &view, const glm::mat4 &projection) {
+    const uint32_t frame_first_word = frame_index * m_frame_words;
+    // Reset the index counter of the frame
+    vkCmdFillBuffer(command_buffer, m_cluster_buffer.buffer, sizeof(uint32_t) * frame_first_word, sizeof(uint32_t), 0);
+    VkMemoryBarrier fill_barrier {};
+    fill_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    fill_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    fill_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &fill_barrier, 0, nullptr, 0, nullptr);
+
+    ClusterParams params {};
+    params.view = view;
+    params.projection = glm::vec4(
+        1.0f / projection[0][0],
+        1.0f / projection[1][1],
+        m_z_near,
+        static_cast<float>(m_grid.z) / std::log(m_desc.far_depth / m_z_near));
+    params.grid = glm::uvec4(m_grid, m_desc.tile_size);
+    params.lights = glm::uvec4(m_light_count, frame_first_word, m_index_capacity, 0);
+    params.viewport = glm::vec2(m_extent.width, m_extent.height);
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline_layout, 0, 1, &m_descriptor_set, 0, nullptr);
+    pushConstants(command_buffer, m_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, params);
+    vkCmdDispatch(command_buffer, (clusterCount() + CLUSTER_WORKGROUP_SIZE - 1) / CLUSTER_WORKGROUP_SIZE, 1, 1);
+}
+
+void ClusteredLighting::recordOutputBarrier(VkCommandBuffer command_buffer) {
+    VkMemoryBarrier cull_barrier {};
+    cull_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    cull_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    cull_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 1, &cull_barrier, 0, nullptr, 0, nullptr);
+}
+
+void ClusteredLighting::fillFrameUniforms(FrameUniforms &uniforms, uint32_t frame_index, float ambient, VkExtent2D render_extent) const {
+    uniforms.light_grid = glm::uvec4(m_grid, m_desc.tile_size);
+    uniforms.light_buffers = glm::uvec4(m_light_buffer_handle, m_cluster_buffer_handle, frame_index * m_frame_words, m_light_count);
+    // The clusters cover the same part of the view at any render extent
+    const float grid_pixels_per_pixel = static_cast<float>(m_extent.width) / static_cast<float>(render_extent.width);
+    uniforms.light_depth = glm::vec4(m_z_near, static_cast<float>(m_grid.z) / std::log(m_desc.far_depth / m_z_near), ambient, grid_pixels_per_pixel);
+}
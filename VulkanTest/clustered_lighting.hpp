@@ -0,0 +1,132 @@
+//
+//  clustered_lighting.hpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#ifndef clustered_lighting_hpp
+#define clustered_lighting_hpp
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "bindless.hpp"
+#include "buffer_utils.hpp"
+#include "descriptor_allocator.hpp"
+#include "device_capabilities.hpp"
+#include "scene.hpp"
+
+/**
+ * A point light, read by the shaders (std430 layout).
+ */
+struct PointLight {
+    // xyz: position (world space), w: radius, where the light fades out
+    glm::vec4 position_radius;
+    // rgb: color times intensity, w: unused
+    glm::vec4 color;
+};
+
+/**
+ * Froxel grid of the clustered lighting: the screen is split in tiles of
+ * tile_size x tile_size pixels, and the view depth in depth_slices slices
+ * growing exponentially from the near plane to far_depth (nothing is lit
+ * farther). index_capacity_per_cluster bounds the light indices stored per
+ * frame, as an average per cluster.
+ */
+struct ClusterGridDesc {
+    uint32_t tile_size = 64;
+    uint32_t depth_slices = 24;
+    float far_depth = 100.0f;
+    uint32_t index_capacity_per_cluster = 256;
+};
+
+/**
+ * Clustered forward lighting.
+ *
+ * Each frame, a compute pass (light_cull.comp) tests the bounds of every
+ * light against the view space box of every cluster of the froxel grid,
+ * and writes the lights of each cluster as a range of a compact index
+ * list. The fragment shader then finds its cluster from its pixel and
+ * depth, and only loops over the lights of that range.
+ *
+ * The lights live in a storage buffer written once. The ranges and the
+ * index lists of all the frames in flight share one storage buffer, each
+ * frame writing its own part: both buffers are reachable through the
+ * bindless set, with the handles and the grid given in FrameUniforms.
+ * The index lists are truncated when they exceed their capacity.
+ */
+class ClusteredLighting {
+
+public:
+    /**
+     * Create the grid for a render target of the given extent and a
+     * projection of near plane z_near, and upload the lights (the first
+     * light_count ones are used, see setLightCount). Registers two
+     * storage buffers in the bindless set.
+     */
+    void init(VkPhysicalDevice physical_device, VkDevice device, const DeviceCapabilities &capabilities, VkCommandPool command_pool, VkQueue queue, BindlessDescriptors &bindless, VkExtent2D extent, float z_near, const ClusterGridDesc &desc, const std::vector<PointLight> &lights, uint32_t light_count, uint32_t frames_in_flight);
+
+    void clean(VkDevice device, BindlessDescriptors &bindless);
+
+    /**
+     * Number of lights binned from the next frame, at most the number of
+     * lights given to init.
+     */
+    void setLightCount(uint32_t light_count);
+    uint32_t lightCount() const { return m_light_count; }
+    uint32_t clusterCount() const { return m_grid.x * m_grid.y * m_grid.z; }
+
+    /**
+     * Record the binning of the lights for the frame, outside of any
+     * render pass. The lists are not visible to the fragment shaders
+     * until recordOutputBarrier (or a frame graph barrier on clusterBuffer).
+     */
+    void recordCulling(VkCommandBuffer command_buffer, uint32_t frame_index, const glm::mat4 &view, const glm::mat4 &projection);
+
+    /**
+     * Make the light lists visible to the fragment shaders.
+     */
+    void recordOutputBarrier(VkCommandBuffer command_buffer);
+
+    /**
+     * Write the grid, handles and part of the cluster buffer of the frame
+     * in the lighting members of the frame uniforms, with the ambient
+     * light added to the point lights. The grid covers the extent given to
+     * init: render_extent is the one the frame is rendered at, which may be
+     * smaller (dynamic resolution).
+     */
+    void fillFrameUniforms(FrameUniforms &uniforms, uint32_t frame_index, float ambient, VkExtent2D render_extent) const;
+
+    // Light ranges and index lists of every frame
+    VkBuffer clusterBuffer() const { return m_cluster_buffer.buffer; }
+
+private:
+    AllocatedBuffer m_light_buffer;
+    AllocatedBuffer m_cluster_buffer;
+    BindlessHandle m_light_buffer_handle = BINDLESS_INVALID_HANDLE;
+    BindlessHandle m_cluster_buffer_handle = BINDLESS_INVALID_HANDLE;
+    // Clusters per row / column / depth
+    glm::uvec3 m_grid = glm::uvec3(0);
+    VkExtent2D m_extent {};
+    ClusterGridDesc m_desc {};
+    float m_z_near = 0.0f;
+    uint32_t m_max_lights = 0;
+    uint32_t m_light_count = 0;
+    // Words of the cluster buffer per frame, and light indices among them
+    uint32_t m_frame_words = 0;
+    uint32_t m_index_capacity = 0;
+
+    DescriptorAllocator m_descriptor_allocator;
+    VkDescriptorSetLayout m_descriptor_set_layout = VK_NULL_HANDLE;
+    VkDescriptorSet m_descriptor_set = VK_NULL_HANDLE;
+    VkPipelineLayout m_pipeline_layout = VK_NULL_HANDLE;
+    VkPipeline m_pipeline = VK_NULL_HANDLE;
+
+    void _createDescriptors(VkDevice device);
+    void _createPipeline(VkDevice device, const DeviceCapabilities &capabilities);
+};
+
+#endif /* clustered_lighting_hpp */
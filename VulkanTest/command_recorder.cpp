@@ -0,0 +1,102 @@
+//
+//  command_recorder.cpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#include "command_recorder.hpp"
+#include "base.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+void ParallelCommandRecorder::init(VkDevice device, uint32_t queue_family_index, JobSystem &job_system, uint32_t frames_in_flight) {
+    m_job_system = &job_system;
+    const uint32_t worker_count = job_system.workerCount();
+    m_pools.resize(frames_in_flight);
+    for (auto &frame_pools: m_pools) {
+        frame_pools.resize(worker_count);
+        for (WorkerPool &worker_pool: frame_pools) {
+            VkCommandPoolCreateInfo pool_info {};
+            pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            // Short-lived command buffers, reset all together with the pool
+            pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+            pool_info.queueFamilyIndex = queue_family_index;
+            if (vkCreateCommandPool(device, &pool_info, nullptr, &worker_pool.pool) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create a recording command pool");
+            }
+        }
+    }
+    Log("-> Parallel recording: " << worker_count << " workers, " << frames_in_flight * worker_count << " command pools");
+}
+
+void ParallelCommandRecorder::clean(VkDevice device) {
+    // Destroying a pool frees its command buffers
+    for (auto &frame_pools: m_pools)
+        for (WorkerPool &worker_pool: frame_pools)
+            vkDestroyCommandPool(device, worker_pool.pool, nullptr);
+    m_pools.clear();
+    m_job_system = nullptr;
+}
+
+void ParallelCommandRecorder::beginFrame(VkDevice device, uint32_t frame_index) {
+    m_current_frame = frame_index;
+    for (WorkerPool &worker_pool: m_pools[m_current_frame]) {
+        vkResetCommandPool(device, worker_pool.pool, 0);
+        worker_pool.used = 0;
+    }
+}
+
+std::vector<VkCommandBuffer> ParallelCommandRecorder::record(VkDevice device, const VkCommandBufferInheritanceInfo &inheritance, uint32_t item_count, uint32_t min_chunk_size, const RecordCallback &callback) {
+    std::vector<VkCommandBuffer> command_buffers;
+    if (item_count == 0)
+        return command_buffers;
+
+    // One chunk per worker, unless the chunks would be too small to be worth it
+    const uint32_t min_size = std::max(1u, min_chunk_size);
+    const uint32_t chunk_count = std::max(1u, std::min(m_job_system->workerCount(), item_count / min_size));
+    const uint32_t chunk_size = (item_count + chunk_count - 1) / chunk_count;
+    command_buffers.resize(chunk_count, VK_NULL_HANDLE);
+
+    m_job_system->parallelFor("record draws", 0, chunk_count, 1, [&](uint32_t first_chunk, uint32_t last_chunk) {
+        // A job runs on a single worker: its pool is not used by anyone else meanwhile
+        WorkerPool &worker_pool = m_pools[m_current_frame][JobSystem::currentWorker()];
+        for (uint32_t chunk = first_chunk; chunk < last_chunk; chunk++) {
+            const uint32_t first = chunk * chunk_size;
+            const uint32_t count = std::min(chunk_size, item_count - first);
+            VkCommandBuffer command_buffer = _nextCommandBuffer(device, worker_pool);
+
+            VkCommandBufferBeginInfo begin_info {};
+            begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            // Entirely inside the render pass / rendering of the primary command buffer
+            begin_info.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+            begin_info.pInheritanceInfo = &inheritance;
+            if (vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS) {
+                throw std::runtime_error("failed to begin a secondary command buffer");
+            }
+            callback(command_buffer, first, count);
+            if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS) {
+                throw std::runtime_error("failed to record a secondary command buffer");
+            }
+            // Each chunk has its own slot: no lock needed
+            command_buffers[chunk] = command_buffer;
+        }
+    });
+    return command_buffers;
+}
+
+VkCommandBuffer ParallelCommandRecorder::_nextCommandBuffer(VkDevice device, WorkerPool &worker_pool) {
+    if (worker_pool.used == worker_pool.buffers.size()) {
+        VkCommandBufferAllocateInfo alloc_info {};
+        alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        alloc_info.commandPool = worker_pool.pool;
+        alloc_info.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        alloc_info.commandBufferCount = 1;
+        VkCommandBuffer command_buffer {};
+        if (vkAllocateCommandBuffers(device, &alloc_info, &command_buffer) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate a secondary command buffer");
+        }
+        worker_pool.buffers.push_back(command_buffer);
+    }
+    return worker_pool.buffers[worker_pool.used++];
+}
@@ -0,0 +1,70 @@
+//
+//  command_recorder.hpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#ifndef command_recorder_hpp
+#define command_recorder_hpp
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#include <functional>
+#include <vector>
+
+#include "job_system.hpp"
+
+/**
+ * Records a list of items (draws) in secondary command buffers, on several
+ * threads at once, with the jobs of a JobSystem.
+ * A command pool can only be used by one thread at a time, so each worker
+ * of the job system owns a pool per frame in flight: the pools of a frame
+ * are reset at once in beginFrame(), once the fence of the frame has been
+ * waited for, instead of resetting each command buffer.
+ */
+class ParallelCommandRecorder {
+
+public:
+    /**
+     * Record items [first, first + count) in a secondary command buffer,
+     * already begun. Called concurrently from several workers.
+     */
+    using RecordCallback = std::function<void(VkCommandBuffer, uint32_t first, uint32_t count)>;
+
+    void init(VkDevice device, uint32_t queue_family_index, JobSystem &job_system, uint32_t frames_in_flight);
+
+    void clean(VkDevice device);
+
+    /**
+     * Reset the pools of the frame: every secondary command buffer
+     * recorded by its previous use is released.
+     */
+    void beginFrame(VkDevice device, uint32_t frame_index);
+
+    /**
+     * Split item_count items in chunks of at least min_chunk_size items,
+     * record them concurrently, and return the secondary command buffers
+     * in item order, to give to vkCmdExecuteCommands.
+     * inheritance describes the render pass / rendering they are executed in.
+     * Must be called from a worker of the job system.
+     * Rethrows the first exception thrown while recording.
+     */
+    std::vector<VkCommandBuffer> record(VkDevice device, const VkCommandBufferInheritanceInfo &inheritance, uint32_t item_count, uint32_t min_chunk_size, const RecordCallback &callback);
+
+private:
+    struct WorkerPool {
+        VkCommandPool pool = VK_NULL_HANDLE;
+        std::vector<VkCommandBuffer> buffers;
+        uint32_t used = 0;
+    };
+
+    JobSystem *m_job_system = nullptr;
+    uint32_t m_current_frame = 0;
+    // Pools, per frame in flight then per worker
+    std::vector<std::vector<WorkerPool>> m_pools;
+
+    VkCommandBuffer _nextCommandBuffer(VkDevice device, WorkerPool &worker_pool);
+};
+
+#endif /* command_recorder_hpp */
@@ -0,0 +1,235 @@
+//
+//  depth_pyramid.cpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#include "depth_pyramid.hpp"
+#include "base.hpp"
+#include "push_constants.hpp"
+#include "shader_support.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+// Must match the local size of depth_pyramid.comp
+constexpr uint32_t const PYRAMID_WORKGROUP_SIZE = 8;
+constexpr VkFormat const PYRAMID_FORMAT = VK_FORMAT_R32_SFLOAT;
+
+// Push constants of depth_pyramid.comp
+struct PyramidParams {
+    glm::ivec2 source_size;
+    glm::ivec2 destination_size;
+};
+
+static VkImageMemoryBarrier levelBarrier(VkImage image, uint32_t base_level, uint32_t level_count, VkImageLayout old_layout, VkImageLayout new_layout, VkAccessFlags src_access, VkAccessFlags dst_access) {
+    VkImageMemoryBarrier barrier {};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.oldLayout = old_layout;
+    barrier.newLayout = new_layout;
+    barrier.srcAccessMask = src_access;
+    barrier.dstAccessMask = dst_access;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = base_level;
+    barrier.subresourceRange.levelCount = level_count;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+    return barrier;
+}
+
+bool DepthPyramid::isSupported(VkPhysicalDevice physical_device, const DeviceCapabilities &capabilities, VkFormat depth_format, VkSampleCountFlagBits samples) {
+    // The build samples the (multisampled) depth target itself
+    if ((capabilities.properties.limits.sampledImageDepthSampleCounts & samples) == 0)
+        return false;
+    VkFormatProperties depth_properties {};
+    vkGetPhysicalDeviceFormatProperties(physical_device, depth_format, &depth_properties);
+    VkFormatProperties pyramid_properties {};
+    vkGetPhysicalDeviceFormatProperties(physical_device, PYRAMID_FORMAT, &pyramid_properties);
+    // R32_SFLOAT storage is required by Vulkan, but not depth sampling
+    const VkFormatFeatureFlags pyramid_features = VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
+    return (depth_properties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT)
+        && (pyramid_properties.optimalTilingFeatures & pyramid_features) == pyramid_features;
+}
+
+void DepthPyramid::init(VkPhysicalDevice physical_device, VkDevice device, const DeviceCapabilities &capabilities, const AllocatedImage &depth_target, VkSampleCountFlagBits samples) {
+    m_built = false;
+
+    // Rounded up at each level, down to 1x1
+    m_level_extents.clear();
+    VkExtent2D level_extent = depth_target.extent;
+    m_level_extents.push_back(level_extent);
+    while (level_extent.width > 1 || level_extent.height > 1) {
+        level_extent.width = std::max(1u, (level_extent.width + 1) / 2);
+        level_extent.height = std::max(1u, (level_extent.height + 1) / 2);
+        m_level_extents.push_back(level_extent);
+    }
+    const uint32_t level_count = static_cast<uint32_t>(m_level_extents.size());
+    m_pyramid = createImage(
+        physical_device,
+        device,
+        depth_target.extent,
+        level_count,
+        VK_SAMPLE_COUNT_1_BIT,
+        PYRAMID_FORMAT,
+        VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        VK_IMAGE_ASPECT_COLOR_BIT);
+    for (uint32_t level = 0; level < level_count; level++)
+        m_level_views.push_back(createImageView(device, m_pyramid.image, PYRAMID_FORMAT, VK_IMAGE_ASPECT_COLOR_BIT, level, 1));
+    m_depth_view = createImageView(device, depth_target.image, depth_target.format, VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1);
+
+    // The shaders fetch texels: no filtering
+    VkSamplerCreateInfo sampler_info {};
+    sampler_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    sampler_info.magFilter = VK_FILTER_NEAREST;
+    sampler_info.minFilter = VK_FILTER_NEAREST;
+    sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_info.maxLod = static_cast<float>(level_count);
+    if (vkCreateSampler(device, &sampler_info, nullptr, &m_sampler) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create the depth pyramid sampler");
+    }
+
+    _createDescriptors(device);
+    _createPipelines(device, capabilities, samples);
+    Log("-> Depth pyramid: " << m_pyramid.extent.width << "x" << m_pyramid.extent.height << ", " << level_count << " levels");
+}
+
+void DepthPyramid::_createDescriptors(VkDevice device) {
+    // 0: source (depth buffer or previous level), 1: destination level
+    VkDescriptorSetLayoutBinding bindings[2] {};
+    bindings[0].binding = 0;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bindings[0].descriptorCount = 1;
+    bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    bindings[1].binding = 1;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    bindings[1].descriptorCount = 1;
+    bindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    VkDescriptorSetLayoutCreateInfo layout_info {};
+    layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layout_info.bindingCount = 2;
+    layout_info.pBindings = bindings;
+    if (vkCreateDescriptorSetLayout(device, &layout_info, nullptr, &m_descriptor_set_layout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create the depth pyramid descriptor set layout");
+    }
+
+    // The sets never change (until the pyramid is recreated): written once
+    const uint32_t level_count = static_cast<uint32_t>(m_level_views.size());
+    m_descriptor_allocator.init(device, level_count, {
+        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1.0f},
+        {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.0f}
+    });
+    m_descriptor_sets.resize(level_count);
+    for (uint32_t level = 0; level < level_count; level++) {
+        m_descriptor_sets[level] = m_descriptor_allocator.allocate(device, m_descriptor_set_layout);
+        // The previous level was just written in GENERAL, the depth buffer is sampled
+        const VkDescriptorImageInfo source_info = level == 0
+            ? VkDescriptorImageInfo {m_sampler, m_depth_view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL}
+            : VkDescriptorImageInfo {m_sampler, m_level_views[level - 1], VK_IMAGE_LAYOUT_GENERAL};
+        const VkDescriptorImageInfo destination_info {VK_NULL_HANDLE, m_level_views[level], VK_IMAGE_LAYOUT_GENERAL};
+        VkWriteDescriptorSet writes[2] {};
+        for (uint32_t i = 0; i < 2; i++) {
+            writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[i].dstSet = m_descriptor_sets[level];
+            writes[i].dstBinding = i;
+            writes[i].descriptorCount = 1;
+        }
+        writes[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        writes[0].pImageInfo = &source_info;
+        writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        writes[1].pImageInfo = &destination_info;
+        vkUpdateDescriptorSets(device, 2, writes, 0, nullptr);
+    }
+}
+
+void DepthPyramid::_createPipelines(VkDevice device, const DeviceCapabilities &capabilities, VkSampleCountFlagBits samples) {
+    const VkPushConstantRange push_constant_range = pushConstantRange<PyramidParams>(capabilities, VK_SHADER_STAGE_COMPUTE_BIT);
+    VkPipelineLayoutCreateInfo pipeline_layout_info {};
+    pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipeline_layout_info.setLayoutCount = 1;
+    pipeline_layout_info.pSetLayouts = &m_descriptor_set_layout;
+    pipeline_layout_info.pushConstantRangeCount = 1;
+    pipeline_layout_info.pPushConstantRanges = &push_constant_range;
+    if (vkCreatePipelineLayout(device, &pipeline_layout_info, nullptr, &m_pipeline_layout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create the depth pyramid pipeline layout");
+    }
+
+    // Variants of depth_pyramid.comp: a multisampled depth buffer is read per sample
+    VkShaderModule shader_modules[2] = {
+        createShaderModule(device, samples == VK_SAMPLE_COUNT_1_BIT ? "hiz_depth.spv" : "hiz_depth_ms.spv"),
+        createShaderModule(device, "hiz_reduce.spv")
+    };
+    VkComputePipelineCreateInfo pipeline_infos[2] {};
+    for (uint32_t i = 0; i < 2; i++) {
+        pipeline_infos[i].sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipeline_infos[i].stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        pipeline_infos[i].stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipeline_infos[i].stage.module = shader_modules[i];
+        pipeline_infos[i].stage.pName = "main";
+        pipeline_infos[i].layout = m_pipeline_layout;
+    }
+    VkPipeline pipelines[2] = {VK_NULL_HANDLE, VK_NULL_HANDLE};
+    const auto res = vkCreateComputePipelines(device, VK_NULL_HANDLE, 2, pipeline_infos, nullptr, pipelines);
+    for (VkShaderModule shader_module: shader_modules)
+        vkDestroyShaderModule(device, shader_module, nullptr);
+    if (res != VK_SUCCESS) {
+        throw std::runtime_error("failed to create the depth pyramid pipelines");
+    }
+    m_copy_pipeline = pipelines[0];
+    m_reduce_pipeline = pipelines[1];
+}
+
+void DepthPyramid::clean(VkDevice device) {
+    if (m_copy_pipeline != VK_NULL_HANDLE) vkDestroyPipeline(device, m_copy_pipeline, nullptr);
+    if (m_reduce_pipeline != VK_NULL_HANDLE) vkDestroyPipeline(device, m_reduce_pipeline, nullptr);
+    if (m_pipeline_layout != VK_NULL_HANDLE) vkDestroyPipelineLayout(device, m_pipeline_layout, nullptr);
+    m_descriptor_allocator.clean(device);
+    m_descriptor_sets.clear();
+    if (m_descriptor_set_layout != VK_NULL_HANDLE) vkDestroyDescriptorSetLayout(device, m_descriptor_set_layout, nullptr);
+    if (m_sampler != VK_NULL_HANDLE) vkDestroySampler(device, m_sampler, nullptr);
+    for (VkImageView view: m_level_views)
+        vkDestroyImageView(device, view, nullptr);
+    m_level_views.clear();
+    m_level_extents.clear();
+    if (m_depth_view != VK_NULL_HANDLE) vkDestroyImageView(device, m_depth_view, nullptr);
+    destroyImage(device, m_pyramid);
+    m_copy_pipeline = VK_NULL_HANDLE;
+    m_reduce_pipeline = VK_NULL_HANDLE;
+    m_pipeline_layout = VK_NULL_HANDLE;
+    m_descriptor_set_layout = VK_NULL_HANDLE;
+    m_sampler = VK_NULL_HANDLE;
+    m_depth_view = VK_NULL_HANDLE;
+    m_built = false;
+}
+
+void DepthPyramid::recordBuild(VkCommandBuffer command_buffer, const glm::mat4 &view_proj, VkExtent2D rendered_extent) {
+    const uint32_t level_count = static_cast<uint32_t>(m_level_extents.size());
+    for (uint32_t level = 0; level < level_count; level++) {
+        const VkExtent2D source_extent = level == 0 ? rendered_extent : m_level_extents[level - 1];
+        const VkExtent2D destination_extent = m_level_extents[level];
+        PyramidParams params {};
+        params.source_size = glm::ivec2(source_extent.width, source_extent.height);
+        params.destination_size = glm::ivec2(destination_extent.width, destination_extent.height);
+        vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, level == 0 ? m_copy_pipeline : m_reduce_pipeline);
+        vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline_layout, 0, 1, &m_descriptor_sets[level], 0, nullptr);
+        pushConstants(command_buffer, m_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, params);
+        vkCmdDispatch(
+            command_buffer,
+            (destination_extent.width + PYRAMID_WORKGROUP_SIZE - 1) / PYRAMID_WORKGROUP_SIZE,
+            (destination_extent.height + PYRAMID_WORKGROUP_SIZE - 1) / PYRAMID_WORKGROUP_SIZE,
+            1);
+        // The level is the source of the next dispatch (the levels stay in GENERAL)
+        if (level + 1 < level_count) {
+            const VkImageMemoryBarrier level_barrier = levelBarrier(m_pyramid.image, level, 1, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT);
+            vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &level_barrier);
+        }
+    }
+    m_view_proj = view_proj;
+    m_built = true;
+}
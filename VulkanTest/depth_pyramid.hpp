@@ -0,0 +1,97 @@
+//
+//  depth_pyramid.hpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#ifndef depth_pyramid_hpp
+#define depth_pyramid_hpp
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "descriptor_allocator.hpp"
+#include "device_capabilities.hpp"
+#include "image_utils.hpp"
+
+/**
+ * Hierarchical-Z (Hi-Z) pyramid of a depth buffer, for occlusion culling.
+ *
+ * Level 0 is a copy of the depth buffer (the farthest sample of each pixel
+ * when it is multisampled), and each next level keeps the farthest depth of
+ * 2x2 texels of the previous one (sizes rounded up, down to 1x1): a texel
+ * of level n bounds the depth of the 2^n x 2^n pixels it covers.
+ * With reverse-Z, the farthest depth is the smallest one.
+ * Built with one compute dispatch per level (depth_pyramid.comp).
+ */
+class DepthPyramid {
+
+public:
+    /**
+     * Returns true if the depth format can be sampled, with the sample
+     * count of the depth target (sampledImageDepthSampleCounts).
+     */
+    static bool isSupported(VkPhysicalDevice physical_device, const DeviceCapabilities &capabilities, VkFormat depth_format, VkSampleCountFlagBits samples);
+
+    /**
+     * Create the pyramid of depth_target, which must have the sampled usage.
+     */
+    void init(VkPhysicalDevice physical_device, VkDevice device, const DeviceCapabilities &capabilities, const AllocatedImage &depth_target, VkSampleCountFlagBits samples);
+
+    void clean(VkDevice device);
+
+    /**
+     * Whether the pyramid holds a depth buffer: false until the first
+     * recordBuild.
+     */
+    bool built() const { return m_built; }
+
+    /**
+     * Record the build of the pyramid from the depth buffer, outside of any
+     * render pass. The depth buffer must be in
+     * VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL and the pyramid in
+     * VK_IMAGE_LAYOUT_GENERAL, both visible to the compute shaders (see the
+     * frame graph); the pyramid is left in GENERAL.
+     * view_proj is the matrix the depth buffer was rendered with, and
+     * rendered_extent the part of it rendered (from the origin, e.g. with
+     * dynamic resolution): level 0 stretches it to the whole pyramid.
+     */
+    void recordBuild(VkCommandBuffer command_buffer, const glm::mat4 &view_proj, VkExtent2D rendered_extent);
+
+    VkImage image() const { return m_pyramid.image; }
+    // All the levels
+    VkImageView view() const { return m_pyramid.view; }
+    VkSampler sampler() const { return m_sampler; }
+    VkExtent2D extent() const { return m_pyramid.extent; }
+    uint32_t levelCount() const { return m_pyramid.mip_levels; }
+    // Matrix of the last build
+    const glm::mat4& viewProj() const { return m_view_proj; }
+
+private:
+    AllocatedImage m_pyramid;
+    // Depth aspect only: a combined depth / stencil view can not be sampled
+    VkImageView m_depth_view = VK_NULL_HANDLE;
+    std::vector<VkImageView> m_level_views;
+    std::vector<VkExtent2D> m_level_extents;
+    VkSampler m_sampler = VK_NULL_HANDLE;
+
+    DescriptorAllocator m_descriptor_allocator;
+    VkDescriptorSetLayout m_descriptor_set_layout = VK_NULL_HANDLE;
+    // Set i reads level i - 1 (the depth buffer for level 0), writes level i
+    std::vector<VkDescriptorSet> m_descriptor_sets;
+    VkPipelineLayout m_pipeline_layout = VK_NULL_HANDLE;
+    // Level 0 (copy of the depth buffer), and the next levels
+    VkPipeline m_copy_pipeline = VK_NULL_HANDLE;
+    VkPipeline m_reduce_pipeline = VK_NULL_HANDLE;
+
+    glm::mat4 m_view_proj = glm::mat4(1.0f);
+    bool m_built = false;
+
+    void _createDescriptors(VkDevice device);
+    void _createPipelines(VkDevice device, const DeviceCapabilities &capabilities, VkSampleCountFlagBits samples);
+};
+
+#endif /* depth_pyramid_hpp */
@@ -0,0 +1,125 @@
+//
+//  descriptor_allocator.cpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#include "descriptor_allocator.hpp"
+#include "base.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+// Each new pool holds 50% more sets than the previous one, up to this limit
+constexpr uint32_t const MAX_SETS_PER_POOL = 4096;
+
+void DescriptorAllocator::init(VkDevice device, uint32_t initial_sets_per_pool, const std::vector<PoolSizeRatio> &ratios) {
+    m_ratios = ratios;
+    m_sets_per_pool = initial_sets_per_pool;
+    m_ready_pools.push_back(_createPool(device, m_sets_per_pool));
+}
+
+void DescriptorAllocator::clean(VkDevice device) {
+    for (const VkDescriptorPool pool: m_ready_pools)
+        vkDestroyDescriptorPool(device, pool, nullptr);
+    for (const VkDescriptorPool pool: m_full_pools)
+        vkDestroyDescriptorPool(device, pool, nullptr);
+    m_ready_pools.clear();
+    m_full_pools.clear();
+}
+
+VkDescriptorPool DescriptorAllocator::_createPool(VkDevice device, uint32_t set_count) {
+    std::vector<VkDescriptorPoolSize> pool_sizes;
+    for (const PoolSizeRatio &ratio: m_ratios) {
+        VkDescriptorPoolSize pool_size {};
+        pool_size.type = ratio.type;
+        pool_size.descriptorCount = std::max(1u, static_cast<uint32_t>(ratio.ratio * set_count));
+        pool_sizes.push_back(pool_size);
+    }
+    VkDescriptorPoolCreateInfo pool_info {};
+    pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    // No VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT: sets are only
+    // released with vkResetDescriptorPool, which lets the driver use a linear allocator
+    pool_info.flags = 0;
+    pool_info.maxSets = set_count;
+    pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+    pool_info.pPoolSizes = pool_sizes.data();
+
+    VkDescriptorPool pool {};
+    if (vkCreateDescriptorPool(device, &pool_info, nullptr, &pool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create a descriptor pool");
+    }
+    return pool;
+}
+
+VkDescriptorPool DescriptorAllocator::_getPool(VkDevice device) {
+    if (!m_ready_pools.empty()) {
+        const VkDescriptorPool pool = m_ready_pools.back();
+        m_ready_pools.pop_back();
+        return pool;
+    }
+    // Every pool is full: grow
+    m_sets_per_pool = std::min(MAX_SETS_PER_POOL, m_sets_per_pool + m_sets_per_pool / 2);
+    Log("-> New descriptor pool (" << m_sets_per_pool << " sets, " << poolCount() + 1 << " pools)");
+    return _createPool(device, m_sets_per_pool);
+}
+
+VkDescriptorSet DescriptorAllocator::allocate(VkDevice device, VkDescriptorSetLayout layout, const void *pNext) {
+    VkDescriptorPool pool = _getPool(device);
+
+    VkDescriptorSetAllocateInfo alloc_info {};
+    alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    alloc_info.pNext = pNext;
+    alloc_info.descriptorPool = pool;
+    alloc_info.descriptorSetCount = 1;
+    alloc_info.pSetLayouts = &layout;
+
+    VkDescriptorSet descriptor_set {};
+    VkResult res = vkAllocateDescriptorSets(device, &alloc_info, &descriptor_set);
+    if (res == VK_ERROR_OUT_OF_POOL_MEMORY || res == VK_ERROR_FRAGMENTED_POOL) {
+        // Retry once, in another (possibly new) pool
+        m_full_pools.push_back(pool);
+        pool = _getPool(device);
+        alloc_info.descriptorPool = pool;
+        res = vkAllocateDescriptorSets(device, &alloc_info, &descriptor_set);
+    }
+    // The pool goes back to the ready list, even if it failed:
+    // the error is not a pool exhaustion anymore
+    m_ready_pools.push_back(pool);
+    if (res != VK_SUCCESS) {
+        LogE("failed to allocate a descriptor set (" << res << ")");
+        throw std::runtime_error("failed to allocate a descriptor set");
+    }
+    return descriptor_set;
+}
+
+void DescriptorAllocator::reset(VkDevice device) {
+    for (const VkDescriptorPool pool: m_ready_pools)
+        vkResetDescriptorPool(device, pool, 0);
+    for (const VkDescriptorPool pool: m_full_pools) {
+        vkResetDescriptorPool(device, pool, 0);
+        m_ready_pools.push_back(pool);
+    }
+    m_full_pools.clear();
+}
+
+void FrameDescriptorAllocators::init(VkDevice device, uint32_t frames_in_flight, uint32_t initial_sets_per_pool, const std::vector<PoolSizeRatio> &ratios) {
+    m_allocators.resize(frames_in_flight);
+    for (auto &allocator: m_allocators)
+        allocator.init(device, initial_sets_per_pool, ratios);
+}
+
+void FrameDescriptorAllocators::clean(VkDevice device) {
+    for (auto &allocator: m_allocators)
+        allocator.clean(device);
+    m_allocators.clear();
+}
+
+void FrameDescriptorAllocators::beginFrame(VkDevice device, uint32_t frame_index) {
+    m_current_frame = frame_index;
+    m_allocators[m_current_frame].reset(device);
+}
+
+VkDescriptorSet FrameDescriptorAllocators::allocate(VkDevice device, VkDescriptorSetLayout layout, const void *pNext) {
+    return m_allocators[m_current_frame].allocate(device, layout, pNext);
+}
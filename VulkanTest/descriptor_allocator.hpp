@@ -0,0 +1,96 @@
+//
+//  descriptor_allocator.hpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#ifndef descriptor_allocator_hpp
+#define descriptor_allocator_hpp
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#include <vector>
+
+/**
+ * Number of descriptors of a type to reserve per descriptor set in a pool.
+ */
+struct PoolSizeRatio {
+    VkDescriptorType type;
+    float ratio;
+};
+
+/**
+ * Descriptor set allocator over a growing list of pools.
+ * When a pool is exhausted (VK_ERROR_OUT_OF_POOL_MEMORY) or fragmented
+ * (VK_ERROR_FRAGMENTED_POOL), it is put aside and the allocation is retried
+ * in a new, bigger pool. Sets are never freed one by one: every pool is
+ * reset at once with reset().
+ */
+class DescriptorAllocator {
+
+public:
+    void init(VkDevice device, uint32_t initial_sets_per_pool, const std::vector<PoolSizeRatio> &ratios);
+
+    /**
+     * Destroy all the pools (and so all the sets allocated from them).
+     */
+    void clean(VkDevice device);
+
+    /**
+     * Allocate a set, creating a new pool if needed.
+     * pNext is given to VkDescriptorSetAllocateInfo (e.g. variable descriptor counts).
+     * Throws if the set can not be allocated, even from a new pool.
+     */
+    VkDescriptorSet allocate(VkDevice device, VkDescriptorSetLayout layout, const void *pNext = nullptr);
+
+    /**
+     * Reset every pool: all the sets allocated so far are invalidated, and
+     * the pools can be reused. The sets must not be in use by the GPU anymore.
+     */
+    void reset(VkDevice device);
+
+    uint32_t poolCount() const { return static_cast<uint32_t>(m_ready_pools.size() + m_full_pools.size()); }
+
+private:
+    std::vector<PoolSizeRatio> m_ratios;
+    // Pools which may still have room for new sets
+    std::vector<VkDescriptorPool> m_ready_pools;
+    // Pools which failed an allocation since the last reset
+    std::vector<VkDescriptorPool> m_full_pools;
+    uint32_t m_sets_per_pool = 0;
+
+    VkDescriptorPool _getPool(VkDevice device);
+    VkDescriptorPool _createPool(VkDevice device, uint32_t set_count);
+};
+
+/**
+ * One DescriptorAllocator per frame in flight, for the sets which only live
+ * for a frame. The allocator of a frame is reset wholesale in beginFrame(),
+ * once the fence of the previous use of this frame has been waited for.
+ */
+class FrameDescriptorAllocators {
+
+public:
+    void init(VkDevice device, uint32_t frames_in_flight, uint32_t initial_sets_per_pool, const std::vector<PoolSizeRatio> &ratios);
+
+    void clean(VkDevice device);
+
+    /**
+     * Reset the allocator of the frame, and make it the current one.
+     */
+    void beginFrame(VkDevice device, uint32_t frame_index);
+
+    /**
+     * Allocate a set which is valid until the next use of the current frame.
+     */
+    VkDescriptorSet allocate(VkDevice device, VkDescriptorSetLayout layout, const void *pNext = nullptr);
+
+    DescriptorAllocator& current() { return m_allocators[m_current_frame]; }
+
+private:
+    std::vector<DescriptorAllocator> m_allocators;
+    uint32_t m_current_frame = 0;
+};
+
+#endif /* descriptor_allocator_hpp */
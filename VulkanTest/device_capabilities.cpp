@@ -0,0 +1,178 @@
+//
+//  device_capabilities.cpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#include "device_capabilities.hpp"
+#include "base.hpp"
+#include "extension_support.hpp"
+#include <cstring>
+
+static bool isDeviceExtensionSupported(VkPhysicalDevice physical_device, const char *extension_name) {
+    uint32_t extension_count {};
+    vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &extension_count, nullptr);
+    std::vector<VkExtensionProperties> extensions(extension_count);
+    vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &extension_count, extensions.data());
+    for (const VkExtensionProperties &extension: extensions) {
+        if (strcmp(extension.extensionName, extension_name) == 0)
+            return true;
+    }
+    return false;
+}
+
+DeviceCapabilities queryDeviceCapabilities(VkPhysicalDevice physical_device) {
+    DeviceCapabilities capabilities {};
+    vkGetPhysicalDeviceProperties(physical_device, &capabilities.properties);
+
+    // The Vulkan 1.2 / 1.3 features structures can only be chained
+    // if the device itself supports these versions
+    const bool has_vulkan12 = capabilities.properties.apiVersion >= VK_API_VERSION_1_2;
+    const bool has_vulkan13 = capabilities.properties.apiVersion >= VK_API_VERSION_1_3;
+    // Likewise, extension structures need the extension
+    const bool has_mesh_shader_extension = has_vulkan12 && isDeviceExtensionSupported(physical_device, VK_EXT_MESH_SHADER_EXTENSION_NAME);
+
+    VkPhysicalDeviceMeshShaderFeaturesEXT mesh_shader {};
+    mesh_shader.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_FEATURES_EXT;
+    VkPhysicalDeviceVulkan13Features vulkan13 {};
+    vulkan13.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+    vulkan13.pNext = has_mesh_shader_extension ? &mesh_shader : nullptr;
+    VkPhysicalDeviceVulkan12Features vulkan12 {};
+    vulkan12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    if (has_vulkan13)
+        vulkan12.pNext = &vulkan13;
+    else if (has_mesh_shader_extension)
+        vulkan12.pNext = &mesh_shader;
+    VkPhysicalDeviceFeatures2 features2 {};
+    features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features2.pNext = has_vulkan12 ? &vulkan12 : nullptr;
+    vkGetPhysicalDeviceFeatures2(physical_device, &features2);
+    capabilities.features = features2.features;
+
+    capabilities.draw_indirect_count = has_vulkan12 && vulkan12.drawIndirectCount;
+    capabilities.multi_draw_indirect = features2.features.multiDrawIndirect;
+    capabilities.draw_indirect_first_instance = features2.features.drawIndirectFirstInstance;
+    capabilities.sampled_image_array_dynamic_indexing = features2.features.shaderSampledImageArrayDynamicIndexing;
+    capabilities.storage_buffer_array_dynamic_indexing = features2.features.shaderStorageBufferArrayDynamicIndexing;
+    capabilities.storage_image_array_dynamic_indexing = features2.features.shaderStorageImageArrayDynamicIndexing;
+    capabilities.descriptor_indexing = has_vulkan12
+        && vulkan12.descriptorIndexing
+        && vulkan12.runtimeDescriptorArray
+        && vulkan12.descriptorBindingPartiallyBound
+        && vulkan12.descriptorBindingUpdateUnusedWhilePending
+        && vulkan12.descriptorBindingSampledImageUpdateAfterBind
+        && vulkan12.descriptorBindingStorageBufferUpdateAfterBind
+        && vulkan12.shaderSampledImageArrayNonUniformIndexing
+        && vulkan12.shaderStorageBufferArrayNonUniformIndexing;
+    capabilities.dynamic_rendering = has_vulkan13 && vulkan13.dynamicRendering;
+    // No feature bit to enable once promoted to core
+    capabilities.extended_dynamic_state = has_vulkan13;
+    capabilities.memory_budget = isDeviceExtensionSupported(physical_device, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    capabilities.mesh_shader = has_mesh_shader_extension && mesh_shader.taskShader && mesh_shader.meshShader;
+    capabilities.timestamps = capabilities.properties.limits.timestampComputeAndGraphics && capabilities.properties.limits.timestampPeriod > 0.0f;
+    capabilities.pipeline_statistics = capabilities.features.pipelineStatisticsQuery;
+    capabilities.inherited_queries = capabilities.features.inheritedQueries;
+
+    if (capabilities.properties.apiVersion >= VK_API_VERSION_1_1) {
+        VkPhysicalDeviceSubgroupProperties subgroup_properties {};
+        subgroup_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_PROPERTIES;
+        VkPhysicalDeviceProperties2 properties2 {};
+        properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        properties2.pNext = &subgroup_properties;
+        vkGetPhysicalDeviceProperties2(physical_device, &properties2);
+        const VkSubgroupFeatureFlags quad_operations = VK_SUBGROUP_FEATURE_BASIC_BIT | VK_SUBGROUP_FEATURE_QUAD_BIT;
+        capabilities.subgroup_quad_compute = (subgroup_properties.supportedStages & VK_SHADER_STAGE_COMPUTE_BIT)
+            && (subgroup_properties.supportedOperations & quad_operations) == quad_operations;
+    }
+
+    if (capabilities.descriptor_indexing) {
+        VkPhysicalDeviceVulkan12Properties vulkan12_properties {};
+        vulkan12_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+        VkPhysicalDeviceProperties2 properties2 {};
+        properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        properties2.pNext = &vulkan12_properties;
+        vkGetPhysicalDeviceProperties2(physical_device, &properties2);
+        capabilities.max_update_after_bind_sampled_images = vulkan12_properties.maxPerStageDescriptorUpdateAfterBindSampledImages;
+        capabilities.max_update_after_bind_storage_buffers = vulkan12_properties.maxPerStageDescriptorUpdateAfterBindStorageBuffers;
+        capabilities.max_update_after_bind_samplers = vulkan12_properties.maxPerStageDescriptorUpdateAfterBindSamplers;
+    }
+
+    Log("-> Device capabilities:");
+    Log("\t drawIndirectCount: " << capabilities.draw_indirect_count);
+    Log("\t multiDrawIndirect: " << capabilities.multi_draw_indirect);
+    Log("\t drawIndirectFirstInstance: " << capabilities.draw_indirect_first_instance);
+    Log("\t descriptorIndexing: " << capabilities.descriptor_indexing);
+    Log("\t dynamicRendering: " << capabilities.dynamic_rendering);
+    Log("\t extendedDynamicState: " << capabilities.extended_dynamic_state);
+    Log("\t memoryBudget: " << capabilities.memory_budget);
+    Log("\t meshShader: " << capabilities.mesh_shader);
+    Log("\t timestamps: " << capabilities.timestamps << " (" << capabilities.properties.limits.timestampPeriod << " ns per tick)");
+    Log("\t pipelineStatisticsQuery: " << capabilities.pipeline_statistics << " (inheritedQueries: " << capabilities.inherited_queries << ")");
+    Log("\t subgroupQuadCompute: " << capabilities.subgroup_quad_compute);
+    Log("\t framebufferColorSampleCounts: " << capabilities.properties.limits.framebufferColorSampleCounts);
+    Log("\t framebufferDepthSampleCounts: " << capabilities.properties.limits.framebufferDepthSampleCounts);
+    return capabilities;
+}
+
+VkSampleCountFlagBits selectSampleCount(const DeviceCapabilities &capabilities, uint32_t requested_samples) {
+    const VkSampleCountFlags supported = capabilities.properties.limits.framebufferColorSampleCounts
+        & capabilities.properties.limits.framebufferDepthSampleCounts;
+    // Sample counts are powers of two, and their flag is their value
+    for (uint32_t samples = VK_SAMPLE_COUNT_64_BIT; samples > VK_SAMPLE_COUNT_1_BIT; samples >>= 1) {
+        if (samples <= requested_samples && (supported & samples))
+            return static_cast<VkSampleCountFlagBits>(samples);
+    }
+    return VK_SAMPLE_COUNT_1_BIT;
+}
+
+const void* EnabledDeviceFeatures::chain() {
+    features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    vulkan12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    vulkan13.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+    mesh_shader.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_FEATURES_EXT;
+    mesh_shader.pNext = nullptr;
+    void *extensions_head = mesh_shader.meshShader ? &mesh_shader : nullptr;
+    vulkan13.pNext = extensions_head;
+    vulkan12.pNext = api_version >= VK_API_VERSION_1_3 ? &vulkan13 : extensions_head;
+    features2.pNext = api_version >= VK_API_VERSION_1_2 ? &vulkan12 : nullptr;
+    return &features2;
+}
+
+EnabledDeviceFeatures selectEnabledFeatures(const DeviceCapabilities &capabilities) {
+    EnabledDeviceFeatures enabled {};
+    enabled.api_version = capabilities.properties.apiVersion;
+    enabled.features2.features.multiDrawIndirect = capabilities.multi_draw_indirect;
+    enabled.features2.features.drawIndirectFirstInstance = capabilities.draw_indirect_first_instance;
+    enabled.features2.features.shaderSampledImageArrayDynamicIndexing = capabilities.sampled_image_array_dynamic_indexing;
+    enabled.features2.features.shaderStorageBufferArrayDynamicIndexing = capabilities.storage_buffer_array_dynamic_indexing;
+    enabled.features2.features.shaderStorageImageArrayDynamicIndexing = capabilities.storage_image_array_dynamic_indexing;
+    enabled.features2.features.pipelineStatisticsQuery = capabilities.pipeline_statistics;
+    enabled.features2.features.inheritedQueries = capabilities.inherited_queries;
+    enabled.vulkan12.drawIndirectCount = capabilities.draw_indirect_count;
+    enabled.vulkan13.dynamicRendering = capabilities.dynamic_rendering;
+    if (capabilities.mesh_shader) {
+        enabled.mesh_shader.taskShader = VK_TRUE;
+        enabled.mesh_shader.meshShader = VK_TRUE;
+    }
+    if (capabilities.descriptor_indexing) {
+        enabled.vulkan12.descriptorIndexing = VK_TRUE;
+        enabled.vulkan12.runtimeDescriptorArray = VK_TRUE;
+        enabled.vulkan12.descriptorBindingPartiallyBound = VK_TRUE;
+        enabled.vulkan12.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+        enabled.vulkan12.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+        enabled.vulkan12.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+        enabled.vulkan12.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+        enabled.vulkan12.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
+    }
+    return enabled;
+}
+
+std::vector<const char*> selectEnabledExtensions(const DeviceCapabilities &capabilities) {
+    std::vector<const char*> extensions = device_extensions;
+    if (capabilities.memory_budget)
+        extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    if (capabilities.mesh_shader)
+        extensions.push_back(VK_EXT_MESH_SHADER_EXTENSION_NAME);
+    return extensions;
+}
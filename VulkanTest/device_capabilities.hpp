@@ -0,0 +1,105 @@
+//
+//  device_capabilities.hpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#ifndef device_capabilities_hpp
+#define device_capabilities_hpp
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#include <vector>
+
+/**
+ * Optional features / limits of the graphics device the renderer
+ * can take advantage of.
+ * Every optional path of the renderer checks this structure, instead
+ * of querying the device again.
+ */
+struct DeviceCapabilities {
+    VkPhysicalDeviceProperties properties {};
+    VkPhysicalDeviceFeatures features {};
+    // vkCmdDrawIndexedIndirectCount (core in Vulkan 1.2)
+    bool draw_indirect_count = false;
+    // Indirect draws with drawCount > 1
+    bool multi_draw_indirect = false;
+    // Indirect draws with firstInstance != 0
+    bool draw_indirect_first_instance = false;
+    // Descriptor indexing (core in Vulkan 1.2) with everything the bindless
+    // set needs: runtime arrays, partially bound and update-after-bind bindings
+    bool descriptor_indexing = false;
+    // Dynamic (but uniform) indexing of descriptor arrays, core Vulkan 1.0 features
+    bool sampled_image_array_dynamic_indexing = false;
+    bool storage_buffer_array_dynamic_indexing = false;
+    bool storage_image_array_dynamic_indexing = false;
+    // Subgroup quad operations in compute shaders (Vulkan 1.1)
+    bool subgroup_quad_compute = false;
+    // vkCmdBeginRendering, without render pass / framebuffer objects (core in Vulkan 1.3)
+    bool dynamic_rendering = false;
+    // Cull mode, front face, topology and depth test / write set in the
+    // command buffer (VK_EXT_extended_dynamic_state, core in Vulkan 1.3)
+    bool extended_dynamic_state = false;
+    // Heap budget / usage queries (VK_EXT_memory_budget)
+    bool memory_budget = false;
+    // Task and mesh shaders (VK_EXT_mesh_shader, on Vulkan 1.2 devices for SPIR-V 1.4)
+    bool mesh_shader = false;
+    // Timestamp queries on the graphics and compute queues
+    // (timestampComputeAndGraphics), ticking every limits.timestampPeriod ns
+    bool timestamps = false;
+    // Pipeline statistics queries (pipelineStatisticsQuery), and queries
+    // active in the primary command buffer while executing secondary ones
+    // (inheritedQueries)
+    bool pipeline_statistics = false;
+    bool inherited_queries = false;
+    // Per-stage limits of update-after-bind descriptors (0 without descriptor indexing)
+    uint32_t max_update_after_bind_sampled_images = 0;
+    uint32_t max_update_after_bind_storage_buffers = 0;
+    uint32_t max_update_after_bind_samplers = 0;
+};
+
+/**
+ * Query the optional features of the physical device.
+ */
+DeviceCapabilities queryDeviceCapabilities(VkPhysicalDevice physical_device);
+
+/**
+ * Highest sample count, up to requested_samples, supported by both the
+ * color and the depth attachments of the device
+ * (framebufferColorSampleCounts / framebufferDepthSampleCounts).
+ * VK_SAMPLE_COUNT_1_BIT (no multisampling) if requested_samples <= 1.
+ */
+VkSampleCountFlagBits selectSampleCount(const DeviceCapabilities &capabilities, uint32_t requested_samples);
+
+/**
+ * Feature structures to chain in VkDeviceCreateInfo::pNext, with only the
+ * features the renderer uses (and the device supports) enabled.
+ */
+struct EnabledDeviceFeatures {
+    uint32_t api_version = VK_API_VERSION_1_0;
+    VkPhysicalDeviceFeatures2 features2 {};
+    VkPhysicalDeviceVulkan12Features vulkan12 {};
+    VkPhysicalDeviceVulkan13Features vulkan13 {};
+    // Chained only if meshShader is enabled
+    VkPhysicalDeviceMeshShaderFeaturesEXT mesh_shader {};
+
+    /**
+     * Link the structures together and return the head of the chain.
+     * Must be called once the structure has its final address.
+     */
+    const void* chain();
+};
+
+/**
+ * Select the device features to enable according to the capabilities.
+ */
+EnabledDeviceFeatures selectEnabledFeatures(const DeviceCapabilities &capabilities);
+
+/**
+ * Device extensions to enable: the required ones (device_extensions),
+ * plus the optional ones the capabilities rely on.
+ */
+std::vector<const char*> selectEnabledExtensions(const DeviceCapabilities &capabilities);
+
+#endif /* device_capabilities_hpp */
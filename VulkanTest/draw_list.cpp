@@ -0,0 +1,247 @@
+//
+//  draw_list.cpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#include "draw_list.hpp"
+#include "push_constants.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+constexpr uint32_t const DRAW_KEY_MESH_SHIFT = DRAW_KEY_DEPTH_BITS;
+constexpr uint32_t const DRAW_KEY_DESCRIPTOR_SETS_SHIFT = DRAW_KEY_MESH_SHIFT + DRAW_KEY_MESH_BITS;
+constexpr uint32_t const DRAW_KEY_PIPELINE_SHIFT = DRAW_KEY_DESCRIPTOR_SETS_SHIFT + DRAW_KEY_DESCRIPTOR_SETS_BITS;
+constexpr uint32_t const DRAW_KEY_PASS_SHIFT = DRAW_KEY_PIPELINE_SHIFT + DRAW_KEY_PIPELINE_BITS;
+static_assert(DRAW_KEY_PASS_SHIFT + DRAW_KEY_PASS_BITS == 64, "the draw sort key fields must fill 64 bits");
+
+// Binds possibly recorded before a draw
+constexpr uint32_t const BIND_PIPELINE = 1 << 0;
+constexpr uint32_t const BIND_DESCRIPTOR_SETS = 1 << 1;
+constexpr uint32_t const BIND_VERTEX_BUFFER = 1 << 2;
+constexpr uint32_t const BIND_INDEX_BUFFER = 1 << 3;
+constexpr uint32_t const BINDS_PER_DRAW = 4;
+
+static uint32_t keyField(uint64_t key, uint32_t shift, uint32_t bits) {
+    return static_cast<uint32_t>((key >> shift) & ((uint64_t(1) << bits) - 1));
+}
+
+/**
+ * State bound in a command buffer by the draws recorded so far.
+ */
+struct BoundDrawState {
+    uint32_t pipeline = UINT32_MAX;
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    uint32_t descriptor_sets = UINT32_MAX;
+    VkBuffer vertex_buffer = VK_NULL_HANDLE;
+    VkDeviceSize vertex_offset = 0;
+    VkBuffer index_buffer = VK_NULL_HANDLE;
+    VkDeviceSize index_offset = 0;
+    VkIndexType index_type = VK_INDEX_TYPE_UINT32;
+};
+
+/**
+ * Update the bound state for the next draw, and return the binds it needs.
+ */
+static uint32_t bindDrawState(BoundDrawState &bound, uint32_t pipeline_id, const DrawPipelineBinding &pipeline, uint32_t descriptor_sets_id, const DrawMeshBinding &mesh) {
+    uint32_t binds = 0;
+    if (pipeline_id != bound.pipeline) {
+        binds |= BIND_PIPELINE;
+        bound.pipeline = pipeline_id;
+    }
+    // A pipeline of another layout may disturb the bound sets
+    if (descriptor_sets_id != bound.descriptor_sets || pipeline.layout != bound.layout) {
+        binds |= BIND_DESCRIPTOR_SETS;
+        bound.descriptor_sets = descriptor_sets_id;
+        bound.layout = pipeline.layout;
+    }
+    if (mesh.vertex_buffer != bound.vertex_buffer || mesh.vertex_offset != bound.vertex_offset) {
+        binds |= BIND_VERTEX_BUFFER;
+        bound.vertex_buffer = mesh.vertex_buffer;
+        bound.vertex_offset = mesh.vertex_offset;
+    }
+    if (mesh.index_buffer != bound.index_buffer || mesh.index_offset != bound.index_offset || mesh.index_type != bound.index_type) {
+        binds |= BIND_INDEX_BUFFER;
+        bound.index_buffer = mesh.index_buffer;
+        bound.index_offset = mesh.index_offset;
+        bound.index_type = mesh.index_type;
+    }
+    return binds;
+}
+
+static uint32_t bindCount(uint32_t binds) {
+    uint32_t count = 0;
+    for (; binds != 0; binds &= binds - 1)
+        count++;
+    return count;
+}
+
+uint64_t makeDrawSortKey(uint32_t pass, uint32_t pipeline, uint32_t descriptor_sets, uint32_t mesh, float depth) {
+    // Positive floats compare like their bits
+    const float clamped_depth = std::max(depth, 0.0f);
+    uint32_t depth_bits = 0;
+    std::memcpy(&depth_bits, &clamped_depth, sizeof(depth_bits));
+    return (static_cast<uint64_t>(pass) << DRAW_KEY_PASS_SHIFT)
+        | (static_cast<uint64_t>(pipeline) << DRAW_KEY_PIPELINE_SHIFT)
+        | (static_cast<uint64_t>(descriptor_sets) << DRAW_KEY_DESCRIPTOR_SETS_SHIFT)
+        | (static_cast<uint64_t>(mesh) << DRAW_KEY_MESH_SHIFT)
+        | depth_bits;
+}
+
+void DrawList::reset() {
+    m_pipelines.clear();
+    m_descriptor_sets.clear();
+    m_meshes.clear();
+    m_draws.clear();
+    m_entries.clear();
+    m_pipeline_binds = 0;
+    m_descriptor_set_binds = 0;
+    m_vertex_buffer_binds = 0;
+    m_index_buffer_binds = 0;
+    m_recorded_draws = 0;
+    m_unsorted_binds = 0;
+}
+
+uint32_t DrawList::addPipeline(const DrawPipelineBinding &binding) {
+    if (m_pipelines.size() >= (size_t(1) << DRAW_KEY_PIPELINE_BITS)) {
+        throw std::runtime_error("too many pipelines in the draw list");
+    }
+    m_pipelines.push_back(binding);
+    return static_cast<uint32_t>(m_pipelines.size() - 1);
+}
+
+uint32_t DrawList::addDescriptorSets(const DrawDescriptorBinding &binding) {
+    if (m_descriptor_sets.size() >= (size_t(1) << DRAW_KEY_DESCRIPTOR_SETS_BITS)) {
+        throw std::runtime_error("too many descriptor sets in the draw list");
+    }
+    m_descriptor_sets.push_back(binding);
+    return static_cast<uint32_t>(m_descriptor_sets.size() - 1);
+}
+
+uint32_t DrawList::addMesh(const DrawMeshBinding &binding) {
+    if (m_meshes.size() >= (size_t(1) << DRAW_KEY_MESH_BITS)) {
+        throw std::runtime_error("too many meshes in the draw list");
+    }
+    m_meshes.push_back(binding);
+    return static_cast<uint32_t>(m_meshes.size() - 1);
+}
+
+void DrawList::add(uint64_t key, const DrawRecord &draw, uint32_t texture_handle) {
+    m_entries.push_back({key, static_cast<uint32_t>(m_draws.size())});
+    m_draws.push_back({draw, texture_handle});
+}
+
+void DrawList::sort() {
+    // Binds in the submission order, for the stats
+    BoundDrawState unsorted_state {};
+    m_unsorted_binds = 0;
+    for (const Entry &entry: m_entries) {
+        const uint32_t pipeline = keyField(entry.key, DRAW_KEY_PIPELINE_SHIFT, DRAW_KEY_PIPELINE_BITS);
+        const uint32_t descriptor_sets = keyField(entry.key, DRAW_KEY_DESCRIPTOR_SETS_SHIFT, DRAW_KEY_DESCRIPTOR_SETS_BITS);
+        const uint32_t mesh = keyField(entry.key, DRAW_KEY_MESH_SHIFT, DRAW_KEY_MESH_BITS);
+        m_unsorted_binds += bindCount(bindDrawState(unsorted_state, pipeline, m_pipelines[pipeline], descriptor_sets, m_meshes[mesh]));
+    }
+
+    const size_t count = m_entries.size();
+    if (count < 2)
+        return;
+    // One histogram per byte of the key, all counted in a single pass
+    constexpr uint32_t digit_count = sizeof(uint64_t);
+    uint32_t histograms[digit_count][256] = {};
+    for (const Entry &entry: m_entries)
+        for (uint32_t digit = 0; digit < digit_count; digit++)
+            histograms[digit][(entry.key >> (8 * digit)) & 0xFF]++;
+
+    m_sort_scratch.resize(count);
+    for (uint32_t digit = 0; digit < digit_count; digit++) {
+        const uint32_t shift = 8 * digit;
+        uint32_t *histogram = histograms[digit];
+        // Every key has the same byte: already in order for this digit
+        if (histogram[(m_entries[0].key >> shift) & 0xFF] == count)
+            continue;
+        uint32_t offset = 0;
+        for (uint32_t bucket = 0; bucket < 256; bucket++) {
+            const uint32_t bucket_size = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += bucket_size;
+        }
+        // Stable: keeps the order of the lower digits
+        for (const Entry &entry: m_entries)
+            m_sort_scratch[histogram[(entry.key >> shift) & 0xFF]++] = entry;
+        m_entries.swap(m_sort_scratch);
+    }
+}
+
+void DrawList::passRange(uint32_t pass, uint32_t &first, uint32_t &count) const {
+    const auto begin = std::partition_point(m_entries.begin(), m_entries.end(), [pass](const Entry &entry) {
+        return (entry.key >> DRAW_KEY_PASS_SHIFT) < pass;
+    });
+    const auto end = std::partition_point(begin, m_entries.end(), [pass](const Entry &entry) {
+        return (entry.key >> DRAW_KEY_PASS_SHIFT) <= pass;
+    });
+    first = static_cast<uint32_t>(begin - m_entries.begin());
+    count = static_cast<uint32_t>(end - begin);
+}
+
+void DrawList::record(VkCommandBuffer command_buffer, uint32_t first, uint32_t count) {
+    BoundDrawState bound {};
+    uint32_t pipeline_binds = 0;
+    uint32_t descriptor_set_binds = 0;
+    uint32_t vertex_buffer_binds = 0;
+    uint32_t index_buffer_binds = 0;
+    for (uint32_t i = first; i < first + count; i++) {
+        const Entry &entry = m_entries[i];
+        const uint32_t pipeline_id = keyField(entry.key, DRAW_KEY_PIPELINE_SHIFT, DRAW_KEY_PIPELINE_BITS);
+        const uint32_t descriptor_sets_id = keyField(entry.key, DRAW_KEY_DESCRIPTOR_SETS_SHIFT, DRAW_KEY_DESCRIPTOR_SETS_BITS);
+        const DrawPipelineBinding &pipeline = m_pipelines[pipeline_id];
+        const DrawMeshBinding &mesh = m_meshes[keyField(entry.key, DRAW_KEY_MESH_SHIFT, DRAW_KEY_MESH_BITS)];
+        const uint32_t binds = bindDrawState(bound, pipeline_id, pipeline, descriptor_sets_id, mesh);
+        if (binds & BIND_PIPELINE) {
+            vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.pipeline);
+            if (pipeline.set_dynamic_state)
+                pipeline.set_dynamic_state(command_buffer);
+            pipeline_binds++;
+        }
+        if (binds & BIND_DESCRIPTOR_SETS) {
+            const DrawDescriptorBinding &descriptor_sets = m_descriptor_sets[descriptor_sets_id];
+            vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, descriptor_sets.layout, descriptor_sets.first_set,
+                                    static_cast<uint32_t>(descriptor_sets.sets.size()), descriptor_sets.sets.data(),
+                                    static_cast<uint32_t>(descriptor_sets.dynamic_offsets.size()), descriptor_sets.dynamic_offsets.data());
+            descriptor_set_binds++;
+        }
+        if (binds & BIND_VERTEX_BUFFER) {
+            vkCmdBindVertexBuffers(command_buffer, 0, 1, &mesh.vertex_buffer, &mesh.vertex_offset);
+            vertex_buffer_binds++;
+        }
+        if (binds & BIND_INDEX_BUFFER) {
+            vkCmdBindIndexBuffer(command_buffer, mesh.index_buffer, mesh.index_offset, mesh.index_type);
+            index_buffer_binds++;
+        }
+        const Draw &draw = m_draws[entry.draw];
+        DrawPushConstants draw_constants {};
+        draw_constants.object_index = draw.record.object_index;
+        draw_constants.texture_handle = draw.texture_handle;
+        pushConstants(command_buffer, pipeline.layout, pipeline.push_constant_stages, draw_constants);
+        vkCmdDrawIndexed(command_buffer, draw.record.index_count, 1, draw.record.first_index, draw.record.vertex_offset, 0);
+    }
+    m_pipeline_binds.fetch_add(pipeline_binds, std::memory_order_relaxed);
+    m_descriptor_set_binds.fetch_add(descriptor_set_binds, std::memory_order_relaxed);
+    m_vertex_buffer_binds.fetch_add(vertex_buffer_binds, std::memory_order_relaxed);
+    m_index_buffer_binds.fetch_add(index_buffer_binds, std::memory_order_relaxed);
+    m_recorded_draws.fetch_add(count, std::memory_order_relaxed);
+}
+
+DrawListStats DrawList::stats() const {
+    DrawListStats stats {};
+    stats.draws = m_recorded_draws.load(std::memory_order_relaxed);
+    stats.pipeline_binds = m_pipeline_binds.load(std::memory_order_relaxed);
+    stats.descriptor_set_binds = m_descriptor_set_binds.load(std::memory_order_relaxed);
+    stats.vertex_buffer_binds = m_vertex_buffer_binds.load(std::memory_order_relaxed);
+    stats.index_buffer_binds = m_index_buffer_binds.load(std::memory_order_relaxed);
+    const uint32_t binds = stats.pipeline_binds + stats.descriptor_set_binds + stats.vertex_buffer_binds + stats.index_buffer_binds;
+    stats.skipped_binds = BINDS_PER_DRAW * stats.draws - binds;
+    stats.unsorted_binds = m_unsorted_binds;
+    return stats;
+}
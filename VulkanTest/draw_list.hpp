@@ -0,0 +1,157 @@
+//
+//  draw_list.hpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#ifndef draw_list_hpp
+#define draw_list_hpp
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#include <atomic>
+#include <functional>
+#include <vector>
+
+#include "scene.hpp"
+
+// Fields of a draw sort key, from the most significant bits: the draws are
+// ordered by pass, then by pipeline, descriptor sets and mesh buffers (the
+// state changes, from the most to the least expensive), then front to back
+constexpr uint32_t const DRAW_KEY_PASS_BITS = 4;
+constexpr uint32_t const DRAW_KEY_PIPELINE_BITS = 8;
+constexpr uint32_t const DRAW_KEY_DESCRIPTOR_SETS_BITS = 8;
+constexpr uint32_t const DRAW_KEY_MESH_BITS = 12;
+constexpr uint32_t const DRAW_KEY_DEPTH_BITS = 32;
+
+/**
+ * Build the 64-bit sort key of a draw. The ids are the ones returned by
+ * the DrawList add functions, depth is the view depth of the object
+ * (negative depths are clamped to 0).
+ */
+uint64_t makeDrawSortKey(uint32_t pass, uint32_t pipeline, uint32_t descriptor_sets, uint32_t mesh, float depth);
+
+struct DrawPipelineBinding {
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    // Stages of the DrawPushConstants range of the layout
+    VkShaderStageFlags push_constant_stages = 0;
+    // Dynamic state to set after binding the pipeline (may be empty)
+    std::function<void(VkCommandBuffer)> set_dynamic_state;
+};
+
+struct DrawDescriptorBinding {
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    uint32_t first_set = 0;
+    std::vector<VkDescriptorSet> sets;
+    std::vector<uint32_t> dynamic_offsets;
+};
+
+/**
+ * Vertex / index buffers read by the draws of a mesh.
+ */
+struct DrawMeshBinding {
+    VkBuffer vertex_buffer = VK_NULL_HANDLE;
+    VkDeviceSize vertex_offset = 0;
+    VkBuffer index_buffer = VK_NULL_HANDLE;
+    VkDeviceSize index_offset = 0;
+    VkIndexType index_type = VK_INDEX_TYPE_UINT32;
+};
+
+/**
+ * Binds of the last recorded frame.
+ */
+struct DrawListStats {
+    uint32_t draws = 0;
+    uint32_t pipeline_binds = 0;
+    uint32_t descriptor_set_binds = 0;
+    uint32_t vertex_buffer_binds = 0;
+    uint32_t index_buffer_binds = 0;
+    // Binds not recorded because the state was already bound, out of the 4
+    // binds per draw of a list binding everything for each draw
+    uint32_t skipped_binds = 0;
+    // Binds the draws would need in the order they were added (in a
+    // single command buffer), to compare with the sorted order
+    uint32_t unsorted_binds = 0;
+};
+
+/**
+ * A frame's list of indexed draws, sorted to minimize the state changes.
+ *
+ * Each frame: reset(), register the bindings (pipelines, descriptor sets,
+ * meshes) the draws use, add the draws with their sort key, sort(), then
+ * record the draws of each pass. Recording only binds the state that
+ * changes from one draw to the next: sorted by key, the draws sharing a
+ * pipeline / descriptor sets / mesh are adjacent and bind it once.
+ * The keys are sorted with an 8-bit LSD radix sort, skipping the digits
+ * every key shares (most of the key bits, in practice).
+ */
+class DrawList {
+
+public:
+    /**
+     * Drop the draws and bindings of the previous frame (keeps the memory).
+     */
+    void reset();
+
+    /**
+     * Register a binding, and return its id for makeDrawSortKey.
+     * Throws if there are more than the key field can hold.
+     */
+    uint32_t addPipeline(const DrawPipelineBinding &binding);
+    uint32_t addDescriptorSets(const DrawDescriptorBinding &binding);
+    uint32_t addMesh(const DrawMeshBinding &binding);
+
+    /**
+     * Add a draw (pushing object_index and texture_handle as its
+     * DrawPushConstants, with firstInstance = 0).
+     */
+    void add(uint64_t key, const DrawRecord &draw, uint32_t texture_handle);
+
+    void sort();
+
+    /**
+     * Range of the sorted draws of a pass.
+     */
+    void passRange(uint32_t pass, uint32_t &first, uint32_t &count) const;
+
+    /**
+     * Record the sorted draws [first, first + count), in a command buffer
+     * where nothing is bound yet (a secondary command buffer inherits
+     * nothing). Can be called concurrently, on different command buffers.
+     */
+    void record(VkCommandBuffer command_buffer, uint32_t first, uint32_t count);
+
+    uint32_t size() const { return static_cast<uint32_t>(m_entries.size()); }
+
+    DrawListStats stats() const;
+
+private:
+    struct Entry {
+        uint64_t key;
+        uint32_t draw;
+    };
+
+    struct Draw {
+        DrawRecord record;
+        uint32_t texture_handle;
+    };
+
+    std::vector<DrawPipelineBinding> m_pipelines;
+    std::vector<DrawDescriptorBinding> m_descriptor_sets;
+    std::vector<DrawMeshBinding> m_meshes;
+    std::vector<Draw> m_draws;
+    // Sorted by sort()
+    std::vector<Entry> m_entries;
+    std::vector<Entry> m_sort_scratch;
+
+    std::atomic<uint32_t> m_pipeline_binds {0};
+    std::atomic<uint32_t> m_descriptor_set_binds {0};
+    std::atomic<uint32_t> m_vertex_buffer_binds {0};
+    std::atomic<uint32_t> m_index_buffer_binds {0};
+    std::atomic<uint32_t> m_recorded_draws {0};
+    uint32_t m_unsorted_binds = 0;
+};
+
+#endif /* draw_list_hpp */
@@ -0,0 +1,59 @@
+//
+//  dynamic_resolution.cpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#include "dynamic_resolution.hpp"
+#include <algorithm>
+#include <cmath>
+
+static VkExtent2D scaledExtent(VkExtent2D extent, float scale) {
+    return {
+        std::max(1u, static_cast<uint32_t>(std::lround(extent.width * scale))),
+        std::max(1u, static_cast<uint32_t>(std::lround(extent.height * scale)))
+    };
+}
+
+void DynamicResolution::init(VkExtent2D output_extent, const DynamicResolutionDesc &desc) {
+    m_desc = desc;
+    m_output_extent = output_extent;
+    m_scale = desc.max_scale;
+    m_render_extent = scaledExtent(output_extent, m_scale);
+    m_total_ms = 0.0;
+    m_measured_frames = 0;
+    // The first frames are not recorded yet
+    m_skipped_frames = 0;
+    m_average_ms = 0.0;
+}
+
+bool DynamicResolution::addFrameTime(double gpu_ms) {
+    // Recorded at the previous scale
+    if (m_skipped_frames < m_desc.latency_frames) {
+        m_skipped_frames++;
+        return false;
+    }
+    m_total_ms += gpu_ms;
+    if (++m_measured_frames < m_desc.interval_frames)
+        return false;
+    m_average_ms = m_total_ms / m_measured_frames;
+    m_total_ms = 0.0;
+    m_measured_frames = 0;
+    if (m_average_ms <= 0.0 || std::abs(m_average_ms / m_desc.target_ms - 1.0) <= m_desc.tolerance)
+        return false;
+
+    // Time proportional to the pixel count
+    const float ideal_scale = m_scale * static_cast<float>(std::sqrt(m_desc.target_ms / m_average_ms));
+    float correction = (ideal_scale - m_scale) * (1.0f - m_desc.damping);
+    if (correction > 0.0f)
+        correction *= 0.5f;
+    const float scale = std::clamp(m_scale + correction, m_desc.min_scale, m_desc.max_scale);
+    const VkExtent2D render_extent = scaledExtent(m_output_extent, scale);
+    if (render_extent.width == m_render_extent.width && render_extent.height == m_render_extent.height)
+        return false;
+    m_scale = scale;
+    m_render_extent = render_extent;
+    m_skipped_frames = 0;
+    return true;
+}
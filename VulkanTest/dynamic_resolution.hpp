@@ -0,0 +1,77 @@
+//
+//  dynamic_resolution.hpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#ifndef dynamic_resolution_hpp
+#define dynamic_resolution_hpp
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+/**
+ * Settings of the dynamic resolution controller.
+ */
+struct DynamicResolutionDesc {
+    // GPU time of a frame aimed at, in milliseconds
+    float target_ms = 8.0f;
+    // Bounds of the scale of the render extent (each axis)
+    float min_scale = 0.5f;
+    float max_scale = 1.0f;
+    // Fraction of the estimated correction left out at each adjustment:
+    // 0 jumps to the estimated scale, closer to 1 moves slower
+    float damping = 0.5f;
+    // Frames averaged between two adjustments
+    uint32_t interval_frames = 8;
+    // No adjustment while the average time is within this fraction of the target
+    float tolerance = 0.05f;
+    // Frames between the recording of a frame and the read back of its GPU
+    // time (the frames in flight): the times of the frames recorded before
+    // an adjustment are dropped
+    uint32_t latency_frames = 2;
+};
+
+/**
+ * Scale of the resolution the scene is rendered at, adjusted from the
+ * measured GPU time of the frames to stay within a time budget.
+ *
+ * Every interval_frames frames, the average GPU time gives the scale that
+ * would meet the target, the time being assumed proportional to the pixel
+ * count (the square of the scale). The scale moves toward it, damped, and
+ * twice slower up than down: a load spike is absorbed within a few frames,
+ * and the scale does not oscillate around the target.
+ */
+class DynamicResolution {
+
+public:
+    /**
+     * Start at the maximum scale of the output extent.
+     */
+    void init(VkExtent2D output_extent, const DynamicResolutionDesc &desc);
+
+    /**
+     * Add the GPU time of a frame (read back latency_frames frames after its
+     * recording). Returns true if the scale has changed.
+     */
+    bool addFrameTime(double gpu_ms);
+
+    float scale() const { return m_scale; }
+    // The output extent at the current scale, at least 1x1
+    VkExtent2D renderExtent() const { return m_render_extent; }
+    // Average GPU time of the last interval
+    double averageMilliseconds() const { return m_average_ms; }
+
+private:
+    DynamicResolutionDesc m_desc {};
+    VkExtent2D m_output_extent {};
+    VkExtent2D m_render_extent {};
+    float m_scale = 1.0f;
+    double m_total_ms = 0.0;
+    uint32_t m_measured_frames = 0;
+    uint32_t m_skipped_frames = 0;
+    double m_average_ms = 0.0;
+};
+
+#endif /* dynamic_resolution_hpp */
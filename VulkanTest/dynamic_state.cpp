@@ -0,0 +1,68 @@
+//
+//  dynamic_state.cpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#include "dynamic_state.hpp"
+
+std::vector<VkDynamicState> pipelineDynamicStates(bool extended, bool mesh_shading) {
+    std::vector<VkDynamicState> dynamic_states = {
+        VK_DYNAMIC_STATE_VIEWPORT,
+        VK_DYNAMIC_STATE_SCISSOR
+    };
+    if (extended) {
+        dynamic_states.push_back(VK_DYNAMIC_STATE_CULL_MODE);
+        dynamic_states.push_back(VK_DYNAMIC_STATE_FRONT_FACE);
+        if (!mesh_shading)
+            dynamic_states.push_back(VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY);
+        dynamic_states.push_back(VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE);
+        dynamic_states.push_back(VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE);
+        dynamic_states.push_back(VK_DYNAMIC_STATE_DEPTH_COMPARE_OP);
+    }
+    return dynamic_states;
+}
+
+bool useExtendedDynamicState(const DeviceCapabilities &capabilities, bool requested) {
+    return requested && capabilities.extended_dynamic_state;
+}
+
+void setViewportAndScissor(VkCommandBuffer command_buffer, VkExtent2D extent) {
+    VkViewport viewport {};
+    viewport.x = 0.0f;
+    viewport.y = 0.0f;
+    viewport.width = static_cast<float>(extent.width);
+    viewport.height = static_cast<float>(extent.height);
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+    vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+
+    VkRect2D scissor {};
+    scissor.offset = {0, 0};
+    scissor.extent = extent;
+    vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+}
+
+VkPipelineDepthStencilStateCreateInfo depthStencilState(const RasterState &state) {
+    VkPipelineDepthStencilStateCreateInfo depth_stencil_state {};
+    depth_stencil_state.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    depth_stencil_state.depthTestEnable = state.depth_test ? VK_TRUE : VK_FALSE;
+    depth_stencil_state.depthWriteEnable = state.depth_write ? VK_TRUE : VK_FALSE;
+    depth_stencil_state.depthCompareOp = state.depth_compare_op;
+    depth_stencil_state.depthBoundsTestEnable = VK_FALSE;
+    depth_stencil_state.stencilTestEnable = VK_FALSE;
+    depth_stencil_state.minDepthBounds = 0.0f;
+    depth_stencil_state.maxDepthBounds = 1.0f;
+    return depth_stencil_state;
+}
+
+void setRasterState(VkCommandBuffer command_buffer, const RasterState &state) {
+    vkCmdSetCullMode(command_buffer, state.cull_mode);
+    vkCmdSetFrontFace(command_buffer, state.front_face);
+    // The pipeline topology class (triangles here) must stay the same
+    vkCmdSetPrimitiveTopology(command_buffer, state.topology);
+    vkCmdSetDepthTestEnable(command_buffer, state.depth_test ? VK_TRUE : VK_FALSE);
+    vkCmdSetDepthWriteEnable(command_buffer, state.depth_write ? VK_TRUE : VK_FALSE);
+    vkCmdSetDepthCompareOp(command_buffer, state.depth_compare_op);
+}
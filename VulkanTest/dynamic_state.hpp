@@ -0,0 +1,65 @@
+//
+//  dynamic_state.hpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#ifndef dynamic_state_hpp
+#define dynamic_state_hpp
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#include <vector>
+
+#include "device_capabilities.hpp"
+
+/**
+ * Fixed-function state a graphics pipeline leaves to the command buffer
+ * when extended dynamic state is available.
+ * Without it, the same values are baked in the pipeline instead: one
+ * pipeline per combination.
+ */
+struct RasterState {
+    VkCullModeFlags cull_mode = VK_CULL_MODE_BACK_BIT;
+    VkFrontFace front_face = VK_FRONT_FACE_CLOCKWISE;
+    VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    bool depth_test = false;
+    bool depth_write = false;
+    // Reverse-Z (see projection.hpp): nearer is greater
+    VkCompareOp depth_compare_op = VK_COMPARE_OP_GREATER;
+};
+
+/**
+ * Dynamic states of a graphics pipeline: viewport and scissor always,
+ * plus the RasterState ones if extended is true.
+ * Mesh shading pipelines have no input assembly: mesh_shading leaves
+ * the topology out.
+ */
+std::vector<VkDynamicState> pipelineDynamicStates(bool extended, bool mesh_shading = false);
+
+/**
+ * Whether to use extended dynamic state: requested and supported.
+ */
+bool useExtendedDynamicState(const DeviceCapabilities &capabilities, bool requested);
+
+/**
+ * Set a viewport and a scissor covering the whole extent.
+ * Must be recorded before the first draw with a pipeline using dynamic
+ * viewport / scissor.
+ */
+void setViewportAndScissor(VkCommandBuffer command_buffer, VkExtent2D extent);
+
+/**
+ * Depth state of a pipeline, from the RasterState (its depth values
+ * are only used without extended dynamic state).
+ */
+VkPipelineDepthStencilStateCreateInfo depthStencilState(const RasterState &state);
+
+/**
+ * Record every RasterState value.
+ * Only valid with a pipeline created with pipelineDynamicStates(true).
+ */
+void setRasterState(VkCommandBuffer command_buffer, const RasterState &state);
+
+#endif /* dynamic_state_hpp */
@@ -0,0 +1,565 @@
+//
+//  frame_graph.cpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#include "frame_graph.hpp"
+#include "base.hpp"
+#include "buffer_utils.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+/**
+ * Synchronization scope of a ResourceUsage.
+ */
+struct UsageInfo {
+    VkPipelineStageFlags stages;
+    VkAccessFlags access;
+    VkImageLayout layout;
+    bool write;
+    VkImageUsageFlags image_usage;
+    VkBufferUsageFlags buffer_usage;
+};
+
+UsageInfo usageInfo(ResourceUsage usage) {
+    switch (usage) {
+        case ResourceUsage::ColorAttachmentWrite:
+            return {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, true, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, 0};
+        case ResourceUsage::DepthAttachmentWrite:
+            return {VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, true, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, 0};
+        case ResourceUsage::DepthAttachmentRead:
+            return {VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, false, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, 0};
+        case ResourceUsage::SampledRead:
+            return {VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, false, VK_IMAGE_USAGE_SAMPLED_BIT, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT};
+        case ResourceUsage::StorageRead:
+            return {VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, false, VK_IMAGE_USAGE_STORAGE_BIT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT};
+        case ResourceUsage::StorageWrite:
+            return {VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL, true, VK_IMAGE_USAGE_STORAGE_BIT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT};
+        case ResourceUsage::VertexStorageRead:
+            return {VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, false, VK_IMAGE_USAGE_STORAGE_BIT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT};
+        case ResourceUsage::FragmentStorageRead:
+            return {VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, false, VK_IMAGE_USAGE_STORAGE_BIT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT};
+        case ResourceUsage::TransferRead:
+            return {VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, false, VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_BUFFER_USAGE_TRANSFER_SRC_BIT};
+        case ResourceUsage::TransferWrite:
+            return {VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, true, VK_IMAGE_USAGE_TRANSFER_DST_BIT, VK_BUFFER_USAGE_TRANSFER_DST_BIT};
+        case ResourceUsage::IndirectRead:
+            return {VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, false, 0, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT};
+    }
+    throw std::invalid_argument("unknown resource usage");
+}
+
+VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+    // Vulkan alignments are powers of two
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+}
+
+void FrameGraph::init(VkPhysicalDevice physical_device, const DeviceCapabilities &capabilities, uint32_t frames_in_flight) {
+    m_physical_device = physical_device;
+    // Linear (buffers) and optimal (images) resources aliased in the same memory
+    // must be at least this far apart
+    m_granularity = std::max<VkDeviceSize>(1, capabilities.properties.limits.bufferImageGranularity);
+    m_frames.resize(frames_in_flight);
+}
+
+void FrameGraph::clean(VkDevice device) {
+    for (auto &frame: m_frames)
+        _destroyTransients(device, frame);
+    m_frames.clear();
+    reset();
+}
+
+void FrameGraph::reset() {
+    m_resources.clear();
+    m_passes.clear();
+    m_final_barriers.clear();
+    m_final_src_stages = 0;
+}
+
+FrameGraphResource FrameGraph::importImage(const std::string &name, VkImage image, VkImageView view, VkImageAspectFlags aspect, VkImageLayout initial_layout, VkPipelineStageFlags initial_stage, VkAccessFlags initial_access, VkImageLayout final_layout) {
+    Resource resource {};
+    resource.name = name;
+    resource.kind = ResourceKind::ImportedImage;
+    resource.image = image;
+    resource.view = view;
+    resource.aspect = aspect;
+    resource.initial_stage = initial_stage;
+    resource.initial_access = initial_access;
+    resource.final_layout = final_layout;
+    resource.state.layout = initial_layout;
+    m_resources.push_back(resource);
+    return static_cast<FrameGraphResource>(m_resources.size() - 1);
+}
+
+FrameGraphResource FrameGraph::importBuffer(const std::string &name, VkBuffer buffer) {
+    Resource resource {};
+    resource.name = name;
+    resource.kind = ResourceKind::ImportedBuffer;
+    resource.buffer = buffer;
+    m_resources.push_back(resource);
+    return static_cast<FrameGraphResource>(m_resources.size() - 1);
+}
+
+FrameGraphResource FrameGraph::createImage(const std::string &name, const TransientImageDesc &desc) {
+    Resource resource {};
+    resource.name = name;
+    resource.kind = ResourceKind::TransientImage;
+    resource.aspect = desc.aspect;
+    resource.image_desc = desc;
+    m_resources.push_back(resource);
+    return static_cast<FrameGraphResource>(m_resources.size() - 1);
+}
+
+FrameGraphResource FrameGraph::createBuffer(const std::string &name, VkDeviceSize size, VkBufferUsageFlags usage) {
+    Resource resource {};
+    resource.name = name;
+    resource.kind = ResourceKind::TransientBuffer;
+    resource.buffer_size = size;
+    resource.buffer_usage = usage;
+    m_resources.push_back(resource);
+    return static_cast<FrameGraphResource>(m_resources.size() - 1);
+}
+
+void FrameGraph::addPass(const std::string &name, const std::vector<FrameGraphAccess> &accesses, ExecuteCallback execute, bool side_effects) {
+    for (const FrameGraphAccess &access: accesses) {
+        if (access.resource >= m_resources.size()) {
+            LogE("frame graph: pass " << name << " uses an unknown resource");
+            throw std::invalid_argument("unknown frame graph resource");
+        }
+    }
+    Pass pass {};
+    pass.name = name;
+    pass.accesses = accesses;
+    pass.execute = std::move(execute);
+    pass.side_effects = side_effects;
+    m_passes.push_back(std::move(pass));
+}
+
+void FrameGraph::compile(VkDevice device, uint32_t frame_index) {
+    m_current_frame = frame_index;
+    _cullPasses();
+    _computeLifetimes();
+
+    // The previous use of this frame has completed (its fence has been
+    // waited for): its transients can be destroyed right away
+    PhysicalFrame &frame = m_frames[m_current_frame];
+    const std::string signature = _transientSignature();
+    if (signature != frame.signature) {
+        _destroyTransients(device, frame);
+        _allocateTransients(device, frame);
+        frame.signature = signature;
+    }
+    _bindTransients(frame);
+    _scheduleBarriers();
+    m_stats.transient_bytes = frame.transient_bytes;
+    m_stats.allocated_bytes = frame.allocated_bytes;
+}
+
+void FrameGraph::execute(VkCommandBuffer command_buffer, VkCommandBuffer late_command_buffer, const std::string &first_late_pass) {
+    for (const Pass &pass: m_passes) {
+        if (late_command_buffer != VK_NULL_HANDLE && pass.name == first_late_pass)
+            command_buffer = late_command_buffer;
+        if (!pass.alive)
+            continue;
+        if (!pass.image_barriers.empty() || !pass.buffer_barriers.empty()) {
+            vkCmdPipelineBarrier(
+                command_buffer,
+                pass.src_stages,
+                pass.dst_stages,
+                0,
+                0, nullptr,
+                static_cast<uint32_t>(pass.buffer_barriers.size()), pass.buffer_barriers.data(),
+                static_cast<uint32_t>(pass.image_barriers.size()), pass.image_barriers.data());
+        }
+        if (m_pass_begin_hook && m_pass_end_hook) {
+            const uint32_t scope = m_pass_begin_hook(command_buffer, pass.name);
+            pass.execute(command_buffer);
+            m_pass_end_hook(command_buffer, scope);
+            continue;
+        }
+        pass.execute(command_buffer);
+    }
+    if (!m_final_barriers.empty()) {
+        vkCmdPipelineBarrier(command_buffer, m_final_src_stages, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(m_final_barriers.size()), m_final_barriers.data());
+    }
+}
+
+VkImage FrameGraph::image(FrameGraphResource resource) const {
+    return m_resources.at(resource).image;
+}
+
+VkImageView FrameGraph::imageView(FrameGraphResource resource) const {
+    return m_resources.at(resource).view;
+}
+
+VkBuffer FrameGraph::buffer(FrameGraphResource resource) const {
+    return m_resources.at(resource).buffer;
+}
+
+void FrameGraph::_cullPasses() {
+    // Walk the passes backwards: a pass is needed if it writes something a
+    // needed pass reads, an imported resource, or has side effects
+    std::vector<bool> needed(m_resources.size(), false);
+    m_stats = FrameGraphStats {};
+    m_stats.passes = static_cast<uint32_t>(m_passes.size());
+    for (auto pass = m_passes.rbegin(); pass != m_passes.rend(); ++pass) {
+        pass->alive = pass->side_effects;
+        for (const FrameGraphAccess &access: pass->accesses) {
+            const Resource &resource = m_resources[access.resource];
+            const bool imported = resource.kind == ResourceKind::ImportedImage || resource.kind == ResourceKind::ImportedBuffer;
+            if (usageInfo(access.usage).write && (imported || needed[access.resource]))
+                pass->alive = true;
+        }
+        if (!pass->alive) {
+            m_stats.culled_passes++;
+            continue;
+        }
+        for (const FrameGraphAccess &access: pass->accesses) {
+            if (!usageInfo(access.usage).write)
+                needed[access.resource] = true;
+        }
+    }
+}
+
+void FrameGraph::_computeLifetimes() {
+    for (uint32_t i = 0; i < m_passes.size(); i++) {
+        if (!m_passes[i].alive)
+            continue;
+        for (const FrameGraphAccess &access: m_passes[i].accesses) {
+            Resource &resource = m_resources[access.resource];
+            const UsageInfo info = usageInfo(access.usage);
+            resource.first_pass = std::min(resource.first_pass, i);
+            resource.last_pass = std::max(resource.last_pass, i);
+            resource.image_desc.usage |= info.image_usage;
+            resource.buffer_usage |= info.buffer_usage;
+        }
+    }
+}
+
+std::string FrameGraph::_transientSignature() const {
+    std::string signature;
+    for (const Resource &resource: m_resources) {
+        if (resource.kind == ResourceKind::TransientImage) {
+            const TransientImageDesc &desc = resource.image_desc;
+            signature += "i" + std::to_string(desc.extent.width) + "x" + std::to_string(desc.extent.height)
+                + "/" + std::to_string(desc.format) + "/" + std::to_string(desc.samples) + "/" + std::to_string(desc.usage);
+        } else if (resource.kind == ResourceKind::TransientBuffer) {
+            signature += "b" + std::to_string(resource.buffer_size) + "/" + std::to_string(resource.buffer_usage);
+        } else {
+            signature += "-";
+        }
+        // Lifetimes decide the aliasing
+        signature += "@" + std::to_string(resource.first_pass) + ":" + std::to_string(resource.last_pass) + ";";
+    }
+    return signature;
+}
+
+void FrameGraph::_allocateTransients(VkDevice device, PhysicalFrame &frame) {
+    const size_t resource_count = m_resources.size();
+    frame.images.assign(resource_count, VK_NULL_HANDLE);
+    frame.views.assign(resource_count, VK_NULL_HANDLE);
+    frame.buffers.assign(resource_count, VK_NULL_HANDLE);
+    frame.alias_predecessors.assign(resource_count, {});
+    frame.transient_bytes = 0;
+    frame.allocated_bytes = 0;
+
+    struct Placement {
+        FrameGraphResource resource;
+        uint32_t memory_type;
+        VkDeviceSize alignment;
+        VkDeviceSize offset;
+        VkDeviceSize size;
+    };
+    std::vector<Placement> placements;
+
+    // Create the transients used by alive passes, without memory
+    for (FrameGraphResource i = 0; i < resource_count; i++) {
+        const Resource &resource = m_resources[i];
+        if (resource.first_pass == UINT32_MAX)
+            continue;
+        VkMemoryRequirements memory_requirements {};
+        if (resource.kind == ResourceKind::TransientImage) {
+            const TransientImageDesc &desc = resource.image_desc;
+            VkImageCreateInfo image_info {};
+            image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+            image_info.imageType = VK_IMAGE_TYPE_2D;
+            image_info.extent = {desc.extent.width, desc.extent.height, 1};
+            image_info.mipLevels = 1;
+            image_info.arrayLayers = 1;
+            image_info.format = desc.format;
+            image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+            image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            image_info.usage = desc.usage;
+            image_info.samples = desc.samples;
+            image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            if (vkCreateImage(device, &image_info, nullptr, &frame.images[i]) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create a frame graph image");
+            }
+            vkGetImageMemoryRequirements(device, frame.images[i], &memory_requirements);
+        } else if (resource.kind == ResourceKind::TransientBuffer) {
+            VkBufferCreateInfo buffer_info {};
+            buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+            buffer_info.size = resource.buffer_size;
+            buffer_info.usage = resource.buffer_usage;
+            buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            if (vkCreateBuffer(device, &buffer_info, nullptr, &frame.buffers[i]) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create a frame graph buffer");
+            }
+            vkGetBufferMemoryRequirements(device, frame.buffers[i], &memory_requirements);
+        } else {
+            continue;
+        }
+        const auto memory_type = findMemoryType(m_physical_device, memory_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        if (!memory_type.has_value()) {
+            throw std::runtime_error("failed to find a memory type for a frame graph resource");
+        }
+        Placement placement {};
+        placement.resource = i;
+        placement.memory_type = memory_type.value();
+        // Aligning every offset on the granularity keeps buffers and images apart
+        placement.alignment = std::max(memory_requirements.alignment, m_granularity);
+        placement.offset = 0;
+        placement.size = memory_requirements.size;
+        placements.push_back(placement);
+        frame.transient_bytes += memory_requirements.size;
+    }
+
+    // Place the largest resources first, at the lowest offset not used by a
+    // resource alive at the same time
+    std::sort(placements.begin(), placements.end(), [](const Placement &a, const Placement &b) { return a.size > b.size; });
+    auto overlap_in_time = [this](FrameGraphResource a, FrameGraphResource b) {
+        return m_resources[a].first_pass <= m_resources[b].last_pass && m_resources[b].first_pass <= m_resources[a].last_pass;
+    };
+    std::vector<VkDeviceSize> memory_sizes(VK_MAX_MEMORY_TYPES, 0);
+    for (size_t p = 0; p < placements.size(); p++) {
+        Placement &placement = placements[p];
+        std::vector<VkDeviceSize> candidates = {0};
+        for (size_t q = 0; q < p; q++) {
+            if (placements[q].memory_type == placement.memory_type && overlap_in_time(placement.resource, placements[q].resource))
+                candidates.push_back(alignUp(placements[q].offset + placements[q].size, placement.alignment));
+        }
+        std::sort(candidates.begin(), candidates.end());
+        for (const VkDeviceSize candidate: candidates) {
+            bool free = true;
+            for (size_t q = 0; q < p && free; q++) {
+                const Placement &other = placements[q];
+                free = other.memory_type != placement.memory_type
+                    || !overlap_in_time(placement.resource, other.resource)
+                    || candidate + placement.size <= other.offset
+                    || other.offset + other.size <= candidate;
+            }
+            if (free) {
+                placement.offset = candidate;
+                break;
+            }
+        }
+        memory_sizes[placement.memory_type] = std::max(memory_sizes[placement.memory_type], placement.offset + placement.size);
+        // Previous users of this memory: the resource has to wait for them
+        for (size_t q = 0; q < p; q++) {
+            const Placement &other = placements[q];
+            if (other.memory_type == placement.memory_type
+                && !overlap_in_time(placement.resource, other.resource)
+                && placement.offset < other.offset + other.size
+                && other.offset < placement.offset + placement.size) {
+                if (m_resources[other.resource].last_pass < m_resources[placement.resource].first_pass)
+                    frame.alias_predecessors[placement.resource].push_back(other.resource);
+                else
+                    frame.alias_predecessors[other.resource].push_back(placement.resource);
+            }
+        }
+    }
+
+    // One block of memory per memory type, shared by every resource of this type
+    std::vector<VkDeviceMemory> blocks(VK_MAX_MEMORY_TYPES, VK_NULL_HANDLE);
+    for (uint32_t memory_type = 0; memory_type < VK_MAX_MEMORY_TYPES; memory_type++) {
+        if (memory_sizes[memory_type] == 0)
+            continue;
+        VkMemoryAllocateInfo alloc_info {};
+        alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        alloc_info.allocationSize = memory_sizes[memory_type];
+        alloc_info.memoryTypeIndex = memory_type;
+        if (vkAllocateMemory(device, &alloc_info, nullptr, &blocks[memory_type]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate frame graph memory");
+        }
+        frame.memory.push_back(blocks[memory_type]);
+        frame.allocated_bytes += memory_sizes[memory_type];
+    }
+    for (const Placement &placement: placements) {
+        const FrameGraphResource i = placement.resource;
+        if (frame.images[i] != VK_NULL_HANDLE) {
+            vkBindImageMemory(device, frame.images[i], blocks[placement.memory_type], placement.offset);
+            VkImageViewCreateInfo view_info {};
+            view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            view_info.image = frame.images[i];
+            view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+            view_info.format = m_resources[i].image_desc.format;
+            view_info.subresourceRange.aspectMask = m_resources[i].image_desc.aspect;
+            view_info.subresourceRange.baseMipLevel = 0;
+            view_info.subresourceRange.levelCount = 1;
+            view_info.subresourceRange.baseArrayLayer = 0;
+            view_info.subresourceRange.layerCount = 1;
+            if (vkCreateImageView(device, &view_info, nullptr, &frame.views[i]) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create a frame graph image view");
+            }
+        } else {
+            vkBindBufferMemory(device, frame.buffers[i], blocks[placement.memory_type], placement.offset);
+        }
+    }
+    if (!placements.empty()) {
+        Log("-> Frame graph transients (frame " << m_current_frame << "): " << placements.size()
+            << " resources, " << frame.transient_bytes << " bytes in " << frame.allocated_bytes << " bytes of memory");
+    }
+}
+
+void FrameGraph::_destroyTransients(VkDevice device, PhysicalFrame &frame) {
+    for (const VkImageView view: frame.views)
+        if (view != VK_NULL_HANDLE) vkDestroyImageView(device, view, nullptr);
+    for (const VkImage image: frame.images)
+        if (image != VK_NULL_HANDLE) vkDestroyImage(device, image, nullptr);
+    for (const VkBuffer buffer: frame.buffers)
+        if (buffer != VK_NULL_HANDLE) vkDestroyBuffer(device, buffer, nullptr);
+    for (const VkDeviceMemory memory: frame.memory)
+        vkFreeMemory(device, memory, nullptr);
+    frame = PhysicalFrame {};
+}
+
+void FrameGraph::_bindTransients(const PhysicalFrame &frame) {
+    for (FrameGraphResource i = 0; i < m_resources.size(); i++) {
+        Resource &resource = m_resources[i];
+        if (resource.kind == ResourceKind::TransientImage) {
+            resource.image = frame.images[i];
+            resource.view = frame.views[i];
+        } else if (resource.kind == ResourceKind::TransientBuffer) {
+            resource.buffer = frame.buffers[i];
+        } else {
+            continue;
+        }
+        resource.alias_predecessors = frame.alias_predecessors[i];
+    }
+}
+
+void FrameGraph::_scheduleBarriers() {
+    for (Resource &resource: m_resources) {
+        // An imported resource waits for initial_stage (and makes
+        // initial_access available) before its first access
+        resource.state.write_stages = resource.initial_stage;
+        resource.state.write_access = resource.initial_access;
+    }
+    for (Pass &pass: m_passes) {
+        if (!pass.alive)
+            continue;
+        for (const FrameGraphAccess &access: pass.accesses)
+            _addBarrier(pass, m_resources[access.resource], access);
+        if (!pass.image_barriers.empty() || !pass.buffer_barriers.empty()) {
+            if (pass.src_stages == 0)
+                pass.src_stages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+            m_stats.barrier_batches++;
+            m_stats.image_barriers += static_cast<uint32_t>(pass.image_barriers.size());
+            m_stats.buffer_barriers += static_cast<uint32_t>(pass.buffer_barriers.size());
+        }
+    }
+
+    // Leave the imported images in the layout expected after the graph
+    for (const Resource &resource: m_resources) {
+        if (resource.kind != ResourceKind::ImportedImage || resource.final_layout == VK_IMAGE_LAYOUT_UNDEFINED || resource.final_layout == resource.state.layout)
+            continue;
+        VkImageMemoryBarrier barrier {};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = resource.state.write_access;
+        barrier.dstAccessMask = 0;
+        barrier.oldLayout = resource.state.layout;
+        barrier.newLayout = resource.final_layout;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = resource.image;
+        barrier.subresourceRange = {resource.aspect, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS};
+        m_final_barriers.push_back(barrier);
+        m_final_src_stages |= resource.state.write_stages | resource.state.read_stages;
+    }
+    if (!m_final_barriers.empty()) {
+        if (m_final_src_stages == 0)
+            m_final_src_stages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+        m_stats.barrier_batches++;
+        m_stats.image_barriers += static_cast<uint32_t>(m_final_barriers.size());
+    }
+}
+
+void FrameGraph::_addBarrier(Pass &pass, Resource &resource, const FrameGraphAccess &access) {
+    const UsageInfo info = usageInfo(access.usage);
+    const bool is_image = resource.kind == ResourceKind::ImportedImage || resource.kind == ResourceKind::TransientImage;
+    ResourceState &state = resource.state;
+    const bool layout_change = is_image && state.layout != info.layout;
+
+    VkPipelineStageFlags src_stages = 0;
+    VkAccessFlags src_access = 0;
+    bool needs_barrier = false;
+    // First use of an aliased resource: wait for the previous users of the memory
+    if (state.write_stages == 0 && state.read_stages == 0 && !resource.alias_predecessors.empty()) {
+        for (const FrameGraphResource predecessor: resource.alias_predecessors) {
+            const ResourceState &previous = m_resources[predecessor].state;
+            src_stages |= previous.write_stages | previous.read_stages;
+            src_access |= previous.write_access;
+        }
+        needs_barrier = true;
+    }
+
+    const VkImageLayout old_layout = state.layout;
+    if (info.write || layout_change) {
+        // Write after read / write, or layout transition: wait for every previous access
+        src_stages |= state.write_stages | state.read_stages;
+        src_access |= state.write_access;
+        needs_barrier = needs_barrier || layout_change || src_stages != 0;
+        state.layout = is_image ? info.layout : state.layout;
+        state.write_stages = info.stages;
+        state.write_access = info.write ? info.access : 0;
+        // A layout transition is visible to the stages of the barrier
+        state.visible_stages = info.write ? 0 : info.stages;
+        state.visible_access = info.write ? 0 : info.access;
+        state.read_stages = info.write ? 0 : info.stages;
+    } else {
+        // Read after write: only if the write is not visible to this access yet
+        if (state.write_stages != 0 && ((info.stages & ~state.visible_stages) != 0 || (info.access & ~state.visible_access) != 0)) {
+            src_stages |= state.write_stages;
+            src_access |= state.write_access;
+            needs_barrier = true;
+            state.visible_stages |= info.stages;
+            state.visible_access |= info.access;
+        }
+        state.read_stages |= info.stages;
+    }
+    if (!needs_barrier)
+        return;
+
+    pass.src_stages |= src_stages;
+    pass.dst_stages |= info.stages;
+    if (is_image) {
+        VkImageMemoryBarrier barrier {};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = src_access;
+        barrier.dstAccessMask = info.access;
+        barrier.oldLayout = old_layout;
+        barrier.newLayout = state.layout;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = resource.image;
+        barrier.subresourceRange = {resource.aspect, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS};
+        pass.image_barriers.push_back(barrier);
+    } else {
+        VkBufferMemoryBarrier barrier {};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask = src_access;
+        barrier.dstAccessMask = info.access;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.buffer = resource.buffer;
+        barrier.offset = 0;
+        barrier.size = VK_WHOLE_SIZE;
+        pass.buffer_barriers.push_back(barrier);
+    }
+}
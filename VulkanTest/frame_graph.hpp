@@ -0,0 +1,268 @@
+//
+//  frame_graph.hpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#ifndef frame_graph_hpp
+#define frame_graph_hpp
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "device_capabilities.hpp"
+
+/**
+ * Index of a resource in the frame graph, valid until the next reset().
+ */
+using FrameGraphResource = uint32_t;
+constexpr FrameGraphResource const FRAME_GRAPH_INVALID_RESOURCE = UINT32_MAX;
+
+/**
+ * How a pass uses a resource.
+ * Each usage maps to the pipeline stages, access mask and (for images)
+ * layout the graph synchronizes on.
+ */
+enum class ResourceUsage {
+    ColorAttachmentWrite,
+    DepthAttachmentWrite,
+    DepthAttachmentRead,
+    SampledRead,
+    StorageRead,
+    StorageWrite,
+    // Storage buffer read by the vertex shader (e.g. instance data written by a compute pass)
+    VertexStorageRead,
+    // Storage buffer read by the fragment shader (e.g. light lists written by a compute pass)
+    FragmentStorageRead,
+    TransferRead,
+    TransferWrite,
+    IndirectRead,
+};
+
+/**
+ * A resource and the way a pass uses it.
+ */
+struct FrameGraphAccess {
+    FrameGraphResource resource = FRAME_GRAPH_INVALID_RESOURCE;
+    ResourceUsage usage = ResourceUsage::SampledRead;
+};
+
+/**
+ * Image created (and aliased) by the graph, only alive during the frame.
+ * Usage flags implied by the accesses of the passes are added automatically.
+ */
+struct TransientImageDesc {
+    VkExtent2D extent {};
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+    VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+    VkImageUsageFlags usage = 0;
+};
+
+/**
+ * Result of the last compile().
+ */
+struct FrameGraphStats {
+    uint32_t passes = 0;
+    uint32_t culled_passes = 0;
+    // vkCmdPipelineBarrier calls, and the barriers batched in them
+    uint32_t barrier_batches = 0;
+    uint32_t image_barriers = 0;
+    uint32_t buffer_barriers = 0;
+    // Sum of the sizes of the transient resources, and memory actually allocated
+    VkDeviceSize transient_bytes = 0;
+    VkDeviceSize allocated_bytes = 0;
+};
+
+/**
+ * Frame graph: the passes of a frame declare the resources they read and
+ * write, and the graph takes care of the rest.
+ *
+ * Every frame: reset(), declare the resources and passes (in execution
+ * order), compile(), then execute() in the command buffer of the frame.
+ * compile() culls the passes whose outputs are never used (passes writing
+ * an imported resource, or flagged with side effects, are always kept),
+ * computes the pipeline barriers and layout transitions between passes
+ * (batched in one vkCmdPipelineBarrier per pass), and places the transient
+ * resources in shared memory blocks: resources whose lifetimes do not
+ * overlap are aliased at the same offset.
+ *
+ * Transient resources are kept between frames, per frame in flight, and
+ * only created again when the declared transients change.
+ */
+class FrameGraph {
+
+public:
+    using ExecuteCallback = std::function<void(VkCommandBuffer)>;
+    /**
+     * Called around each pass executed (after its barriers), e.g. to
+     * measure it: begin returns a scope given back to end.
+     */
+    using PassBeginHook = std::function<uint32_t(VkCommandBuffer, const std::string &name)>;
+    using PassEndHook = std::function<void(VkCommandBuffer, uint32_t scope)>;
+
+    void init(VkPhysicalDevice physical_device, const DeviceCapabilities &capabilities, uint32_t frames_in_flight);
+
+    void clean(VkDevice device);
+
+    /**
+     * Forget the passes and resources of the previous frame.
+     */
+    void reset();
+
+    /**
+     * Image owned outside of the graph (e.g. a swap chain image).
+     * initial_stage is the stage the first access has to wait for (the
+     * wait stage of the acquire semaphore for a swap chain image), and
+     * initial_access the writes made available to it: e.g. the attachment
+     * writes of the previous frame, for an image shared by the frames in
+     * flight (0 if the image is not written before the graph).
+     * If final_layout is not VK_IMAGE_LAYOUT_UNDEFINED, the image is
+     * transitioned to it at the end of the graph.
+     */
+    FrameGraphResource importImage(const std::string &name, VkImage image, VkImageView view, VkImageAspectFlags aspect, VkImageLayout initial_layout, VkPipelineStageFlags initial_stage, VkAccessFlags initial_access, VkImageLayout final_layout);
+
+    /**
+     * Buffer owned outside of the graph.
+     */
+    FrameGraphResource importBuffer(const std::string &name, VkBuffer buffer);
+
+    FrameGraphResource createImage(const std::string &name, const TransientImageDesc &desc);
+
+    FrameGraphResource createBuffer(const std::string &name, VkDeviceSize size, VkBufferUsageFlags usage = 0);
+
+    /**
+     * Add a pass, executed after the passes already added.
+     * A pass accesses each resource at most once.
+     */
+    void addPass(const std::string &name, const std::vector<FrameGraphAccess> &accesses, ExecuteCallback execute, bool side_effects = false);
+
+    /**
+     * Cull, schedule and allocate the graph for the frame.
+     * Must be called once per reset(), after the fence of the frame has
+     * been waited for.
+     */
+    void compile(VkDevice device, uint32_t frame_index);
+
+    /**
+     * Record the passes of the compiled graph, with their barriers.
+     * With a late_command_buffer, the passes from the one named
+     * first_late_pass on (and the final layout transitions) are recorded
+     * in it instead, e.g. to submit the passes using the swap chain image
+     * in a batch waiting for it. Both must be submitted to the same queue,
+     * in this order: the barriers between them stay valid.
+     */
+    void execute(VkCommandBuffer command_buffer, VkCommandBuffer late_command_buffer = VK_NULL_HANDLE, const std::string &first_late_pass = "");
+
+    /**
+     * Physical handles of a resource, valid after compile().
+     * VK_NULL_HANDLE for a transient resource only used by culled passes.
+     */
+    VkImage image(FrameGraphResource resource) const;
+    VkImageView imageView(FrameGraphResource resource) const;
+    VkBuffer buffer(FrameGraphResource resource) const;
+
+    const FrameGraphStats& stats() const { return m_stats; }
+
+    /**
+     * Set (or remove, with nullptr) the pass hooks.
+     */
+    void setPassHooks(PassBeginHook begin, PassEndHook end) {
+        m_pass_begin_hook = std::move(begin);
+        m_pass_end_hook = std::move(end);
+    }
+
+private:
+    enum class ResourceKind { ImportedImage, ImportedBuffer, TransientImage, TransientBuffer };
+
+    /**
+     * Synchronization state of a resource while the passes are scheduled.
+     */
+    struct ResourceState {
+        VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        // Last write, and the stages / accesses it has been made visible to
+        VkPipelineStageFlags write_stages = 0;
+        VkAccessFlags write_access = 0;
+        VkPipelineStageFlags visible_stages = 0;
+        VkAccessFlags visible_access = 0;
+        // Reads since the last write
+        VkPipelineStageFlags read_stages = 0;
+    };
+
+    struct Resource {
+        std::string name;
+        ResourceKind kind = ResourceKind::ImportedImage;
+        VkImage image = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkImageAspectFlags aspect = 0;
+        VkImageLayout final_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkPipelineStageFlags initial_stage = 0;
+        VkAccessFlags initial_access = 0;
+        TransientImageDesc image_desc {};
+        VkDeviceSize buffer_size = 0;
+        VkBufferUsageFlags buffer_usage = 0;
+        // First and last alive passes using it
+        uint32_t first_pass = UINT32_MAX;
+        uint32_t last_pass = 0;
+        // Transients using the same memory before it (aliasing)
+        std::vector<FrameGraphResource> alias_predecessors;
+        ResourceState state {};
+    };
+
+    struct Pass {
+        std::string name;
+        std::vector<FrameGraphAccess> accesses;
+        ExecuteCallback execute;
+        bool side_effects = false;
+        bool alive = false;
+        // Barriers recorded right before the pass
+        VkPipelineStageFlags src_stages = 0;
+        VkPipelineStageFlags dst_stages = 0;
+        std::vector<VkImageMemoryBarrier> image_barriers;
+        std::vector<VkBufferMemoryBarrier> buffer_barriers;
+    };
+
+    /**
+     * Transient resources of a frame in flight.
+     * signature describes the transients they were created for.
+     */
+    struct PhysicalFrame {
+        std::string signature;
+        std::vector<VkDeviceMemory> memory;
+        std::vector<VkImage> images;
+        std::vector<VkImageView> views;
+        std::vector<VkBuffer> buffers;
+        std::vector<std::vector<FrameGraphResource>> alias_predecessors;
+        VkDeviceSize transient_bytes = 0;
+        VkDeviceSize allocated_bytes = 0;
+    };
+
+    VkPhysicalDevice m_physical_device = VK_NULL_HANDLE;
+    VkDeviceSize m_granularity = 1;
+    std::vector<Resource> m_resources;
+    std::vector<Pass> m_passes;
+    // Barriers to the final layouts of the imported images
+    VkPipelineStageFlags m_final_src_stages = 0;
+    std::vector<VkImageMemoryBarrier> m_final_barriers;
+    std::vector<PhysicalFrame> m_frames;
+    uint32_t m_current_frame = 0;
+    FrameGraphStats m_stats {};
+    PassBeginHook m_pass_begin_hook;
+    PassEndHook m_pass_end_hook;
+
+    void _cullPasses();
+    void _computeLifetimes();
+    std::string _transientSignature() const;
+    void _allocateTransients(VkDevice device, PhysicalFrame &frame);
+    void _destroyTransients(VkDevice device, PhysicalFrame &frame);
+    void _bindTransients(const PhysicalFrame &frame);
+    void _scheduleBarriers();
+    void _addBarrier(Pass &pass, Resource &resource, const FrameGraphAccess &access);
+};
+
+#endif /* frame_graph_hpp */
@@ -0,0 +1,163 @@
+//
+//  frame_readback.cpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#include "frame_readback.hpp"
+#include "base.hpp"
+#include <stdexcept>
+#include <utility>
+
+constexpr VkDeviceSize const READBACK_TEXEL_SIZE = 4;
+
+static VkImageMemoryBarrier transferBarrier(VkImage image, VkImageLayout old_layout, VkImageLayout new_layout, VkAccessFlags src_access, VkAccessFlags dst_access) {
+    VkImageMemoryBarrier barrier {};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.oldLayout = old_layout;
+    barrier.newLayout = new_layout;
+    barrier.srcAccessMask = src_access;
+    barrier.dstAccessMask = dst_access;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+    return barrier;
+}
+
+bool FrameReadback::isSupported(VkFormat format) {
+    switch (format) {
+        case VK_FORMAT_B8G8R8A8_UNORM:
+        case VK_FORMAT_B8G8R8A8_SRGB:
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_R8G8B8A8_SRGB:
+            return true;
+        default:
+            return false;
+    }
+}
+
+void FrameReadback::init(VkPhysicalDevice physical_device, VkDevice device, VkExtent2D extent, VkFormat format, uint32_t slot_count, FrameCaptureConsumer consumer) {
+    if (!isSupported(format)) {
+        throw std::runtime_error("unsupported frame readback format");
+    }
+    m_extent = extent;
+    m_format = format;
+    m_consumer = std::move(consumer);
+    m_captured_count = 0;
+    m_dropped_count = 0;
+
+    // Read by the CPU: cached memory if any, otherwise every read goes
+    // through the bus. Cached memory that is not coherent is invalidated
+    // before reading.
+    const VkMemoryPropertyFlags candidates[] = {
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+    };
+    VkMemoryPropertyFlags properties = candidates[2];
+    for (const VkMemoryPropertyFlags candidate: candidates) {
+        if (findMemoryType(physical_device, ~0u, candidate).has_value()) {
+            properties = candidate;
+            break;
+        }
+    }
+    const bool cached = (properties & VK_MEMORY_PROPERTY_HOST_CACHED_BIT) != 0;
+    m_coherent = (properties & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+    const VkDeviceSize size = READBACK_TEXEL_SIZE * extent.width * extent.height;
+    m_slots.resize(slot_count);
+    for (Slot &slot: m_slots)
+        slot.buffer = createBuffer(physical_device, device, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT, properties);
+    Log("-> Frame readback: " << slot_count << " buffers of " << size / 1024 << " KB, " << (cached ? "host cached" : "uncached") << " memory");
+}
+
+void FrameReadback::clean(VkDevice device) {
+    // Captures still in flight are dropped
+    for (Slot &slot: m_slots)
+        destroyBuffer(device, slot.buffer);
+    m_slots.clear();
+    m_consumer = nullptr;
+}
+
+void FrameReadback::beginFrame(VkDevice device, uint32_t frame_index) {
+    for (Slot &slot: m_slots) {
+        if (!slot.in_flight || slot.frame_index != frame_index)
+            continue;
+        if (!m_coherent) {
+            VkMappedMemoryRange range {};
+            range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+            range.memory = slot.buffer.memory;
+            range.offset = 0;
+            range.size = VK_WHOLE_SIZE;
+            vkInvalidateMappedMemoryRanges(device, 1, &range);
+        }
+        FrameCapture capture {};
+        capture.frame_number = slot.frame_number;
+        capture.extent = m_extent;
+        capture.format = m_format;
+        capture.pixels = static_cast<const uint8_t*>(slot.buffer.mapped);
+        capture.size = slot.buffer.size;
+        if (m_consumer)
+            m_consumer(capture);
+        slot.in_flight = false;
+    }
+}
+
+bool FrameReadback::recordCopy(VkCommandBuffer command_buffer, uint32_t frame_index, uint64_t frame_number, VkImage image, VkImageLayout image_layout) {
+    Slot *free_slot = nullptr;
+    for (Slot &slot: m_slots) {
+        if (!slot.in_flight) {
+            free_slot = &slot;
+            break;
+        }
+    }
+    if (free_slot == nullptr) {
+        m_dropped_count++;
+        return false;
+    }
+    free_slot->in_flight = true;
+    free_slot->frame_index = frame_index;
+    free_slot->frame_number = frame_number;
+    m_captured_count++;
+
+    const bool transition = image_layout != VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    if (transition) {
+        // Rendered by the color attachment writes (or resolve) of the frame.
+        // Every stage: chains with the final layout transition of a render
+        // pass, whose implicit external dependency waits for BOTTOM_OF_PIPE
+        const VkImageMemoryBarrier barrier = transferBarrier(image, image_layout, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    }
+    VkBufferImageCopy region {};
+    region.bufferOffset = 0;
+    // Tightly packed
+    region.bufferRowLength = 0;
+    region.bufferImageHeight = 0;
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 1;
+    region.imageExtent = {m_extent.width, m_extent.height, 1};
+    vkCmdCopyImageToBuffer(command_buffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, free_slot->buffer.buffer, 1, &region);
+    if (transition) {
+        const VkImageMemoryBarrier barrier = transferBarrier(image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image_layout, VK_ACCESS_TRANSFER_READ_BIT, 0);
+        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    }
+    // Visible to the host once the fence of the frame is signaled
+    VkBufferMemoryBarrier host_barrier {};
+    host_barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    host_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    host_barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    host_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    host_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    host_barrier.buffer = free_slot->buffer.buffer;
+    host_barrier.offset = 0;
+    host_barrier.size = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &host_barrier, 0, nullptr);
+    return true;
+}
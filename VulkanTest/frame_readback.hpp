@@ -0,0 +1,97 @@
+//
+//  frame_readback.hpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#ifndef frame_readback_hpp
+#define frame_readback_hpp
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#include <functional>
+#include <vector>
+
+#include "buffer_utils.hpp"
+
+/**
+ * A rendered image read back by the CPU. Only valid during the consumer
+ * call: the pixels are in a host buffer reused by a next capture.
+ */
+struct FrameCapture {
+    // Number of the frame rendering the image
+    uint64_t frame_number = 0;
+    VkExtent2D extent {};
+    // 8-bit, 4-channel format (e.g. VK_FORMAT_B8G8R8A8_SRGB)
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    // Rows of extent.width texels of 4 bytes, without padding
+    const uint8_t *pixels = nullptr;
+    VkDeviceSize size = 0;
+};
+
+using FrameCaptureConsumer = std::function<void(const FrameCapture &)>;
+
+/**
+ * Asynchronous readback of rendered images.
+ *
+ * A frame records the copy of its image into a free host buffer (host
+ * cached if possible) of a ring of slot_count buffers. Once the fence of
+ * the frame has been waited for, the next time the frame comes around,
+ * beginFrame hands the pixels to the consumer and frees the buffer: the
+ * render loop never waits for a copy, and a capture is dropped when every
+ * buffer is in use. slot_count = frames in flight is enough as long as the
+ * consumer copies the pixels out before returning.
+ */
+class FrameReadback {
+
+public:
+    /**
+     * Returns true if images of the format can be read back.
+     */
+    static bool isSupported(VkFormat format);
+
+    void init(VkPhysicalDevice physical_device, VkDevice device, VkExtent2D extent, VkFormat format, uint32_t slot_count, FrameCaptureConsumer consumer);
+
+    void clean(VkDevice device);
+
+    /**
+     * Hand the captures recorded by the previous use of the frame to the
+     * consumer: to call once the fence of the frame has been waited for.
+     */
+    void beginFrame(VkDevice device, uint32_t frame_index);
+
+    /**
+     * Record the copy of the image (of the extent given to init) in a free
+     * buffer, outside of any render pass. The image must be in
+     * image_layout: if it is not VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, it
+     * is transitioned to it for the copy then back (e.g. a presentable
+     * swap chain image), otherwise its writes must be visible to the
+     * transfer stage (see the frame graph).
+     * Returns false if the capture is dropped: every buffer is in use.
+     */
+    bool recordCopy(VkCommandBuffer command_buffer, uint32_t frame_index, uint64_t frame_number, VkImage image, VkImageLayout image_layout);
+
+    uint64_t capturedCount() const { return m_captured_count; }
+    uint64_t droppedCount() const { return m_dropped_count; }
+
+private:
+    struct Slot {
+        AllocatedBuffer buffer;
+        bool in_flight = false;
+        // Frame in flight which recorded the copy, and its number
+        uint32_t frame_index = 0;
+        uint64_t frame_number = 0;
+    };
+
+    std::vector<Slot> m_slots;
+    VkExtent2D m_extent {};
+    VkFormat m_format = VK_FORMAT_UNDEFINED;
+    // Host cached memory is not always coherent: invalidated before reading
+    bool m_coherent = true;
+    FrameCaptureConsumer m_consumer;
+    uint64_t m_captured_count = 0;
+    uint64_t m_dropped_count = 0;
+};
+
+#endif /* frame_readback_hpp */
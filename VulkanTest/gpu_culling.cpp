@@ -0,0 +1,280 @@
+//
+//  gpu_culling.cpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#include "gpu_culling.hpp"
+#include "base.hpp"
+#include "push_constants.hpp"
+#include "shader_support.hpp"
+#include <cstring>
+#include <stdexcept>
+
+// Must match the local_size_x of cull.comp
+constexpr uint32_t const CULL_WORKGROUP_SIZE = 64;
+
+// Push constants of cull.comp (the frustum planes are extracted from view_proj)
+struct CullParams {
+    glm::mat4 view_proj;
+    uint32_t draw_count;
+    // 1: write the visible draws only, and count them (vkCmdDrawIndexedIndirectCount)
+    // 0: write every draw, with instanceCount = 0 for culled ones
+    uint32_t compact;
+    // 0: early (or only) phase, 1: late phase
+    uint32_t late;
+    // 1: test against the depth pyramid (not built yet on the first frame)
+    uint32_t occlusion;
+};
+
+// Stats buffer of cull.comp, added to by each workgroup
+struct CullingCounters {
+    uint32_t frustum_culled;
+    // Flagged as candidates for the late phase
+    uint32_t early_occluded;
+    uint32_t drawn_early;
+    uint32_t drawn_late;
+};
+
+bool GpuCulling::isSupported(const DeviceCapabilities &capabilities) {
+    // object_index is passed as firstInstance of each indirect draw
+    return capabilities.draw_indirect_first_instance;
+}
+
+void GpuCulling::init(VkPhysicalDevice physical_device, VkDevice device, const DeviceCapabilities &capabilities, const AllocatedBuffer &object_buffer, const AllocatedBuffer &draw_buffer, uint32_t draw_count, uint32_t frames_in_flight, bool occlusion_culling) {
+    Log("-> Initializing GPU culling (" << draw_count << " draws)...");
+    m_occlusion_culling = occlusion_culling;
+    m_use_draw_count = capabilities.draw_indirect_count;
+    m_use_multi_draw = capabilities.multi_draw_indirect;
+    m_draw_count = draw_count;
+    m_object_buffer = object_buffer.buffer;
+    m_draw_buffer = draw_buffer.buffer;
+    m_stats = CullingStats {};
+    Log("\t draw path: " << (m_use_draw_count ? "vkCmdDrawIndexedIndirectCount" : "vkCmdDrawIndexedIndirect"));
+    Log("\t occlusion culling: " << (m_occlusion_culling ? "two-phase, Hi-Z" : "disabled"));
+
+    m_frames.resize(frames_in_flight);
+    for (auto &frame: m_frames) {
+        frame.command_buffer = createBuffer(
+            physical_device,
+            device,
+            sizeof(VkDrawIndexedIndirectCommand) * draw_count,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        frame.count_buffer = createBuffer(
+            physical_device,
+            device,
+            sizeof(uint32_t),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        // Reset by the CPU once read (see beginFrame)
+        frame.stats_buffer = createBuffer(
+            physical_device,
+            device,
+            sizeof(CullingCounters),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        memset(frame.stats_buffer.mapped, 0, sizeof(CullingCounters));
+        if (!m_occlusion_culling)
+            continue;
+        frame.late_command_buffer = createBuffer(
+            physical_device,
+            device,
+            sizeof(VkDrawIndexedIndirectCommand) * draw_count,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        frame.late_count_buffer = createBuffer(
+            physical_device,
+            device,
+            sizeof(uint32_t),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        frame.candidate_buffer = createBuffer(
+            physical_device,
+            device,
+            sizeof(uint32_t) * draw_count,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    }
+    _createDescriptorSetLayout(device);
+    _createPipeline(device, capabilities);
+}
+
+void GpuCulling::_createDescriptorSetLayout(VkDevice device) {
+    // 0: objects, 1: draw records, 2: draw commands (out), 3: draw count (out), 4: stats,
+    // with occlusion culling 5: late candidates, 6: depth pyramid
+    VkDescriptorSetLayoutBinding bindings[7] {};
+    for (uint32_t i = 0; i < 7; i++) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+    bindings[6].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    VkDescriptorSetLayoutCreateInfo layout_info {};
+    layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layout_info.bindingCount = m_occlusion_culling ? 7 : 5;
+    layout_info.pBindings = bindings;
+    if (vkCreateDescriptorSetLayout(device, &layout_info, nullptr, &m_descriptor_set_layout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create the culling descriptor set layout");
+    }
+}
+
+void GpuCulling::_createPipeline(VkDevice device, const DeviceCapabilities &capabilities) {
+    const VkPushConstantRange push_constant_range = pushConstantRange<CullParams>(capabilities, VK_SHADER_STAGE_COMPUTE_BIT);
+
+    VkPipelineLayoutCreateInfo pipeline_layout_info {};
+    pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipeline_layout_info.setLayoutCount = 1;
+    pipeline_layout_info.pSetLayouts = &m_descriptor_set_layout;
+    pipeline_layout_info.pushConstantRangeCount = 1;
+    pipeline_layout_info.pPushConstantRanges = &push_constant_range;
+    if (vkCreatePipelineLayout(device, &pipeline_layout_info, nullptr, &m_pipeline_layout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create the culling pipeline layout");
+    }
+
+    VkShaderModule compute_shader_module = createShaderModule(device, m_occlusion_culling ? "cull_occlusion.spv" : "cull.spv");
+    VkPipelineShaderStageCreateInfo stage_info {};
+    stage_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stage_info.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    stage_info.module = compute_shader_module;
+    stage_info.pName = "main";
+
+    VkComputePipelineCreateInfo pipeline_info {};
+    pipeline_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipeline_info.stage = stage_info;
+    pipeline_info.layout = m_pipeline_layout;
+    const auto res = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &m_pipeline);
+    vkDestroyShaderModule(device, compute_shader_module, nullptr);
+    if (res != VK_SUCCESS) {
+        throw std::runtime_error("failed to create the culling pipeline");
+    }
+}
+
+VkDescriptorSet GpuCulling::_writeDescriptorSet(VkDevice device, const FrameResources &frame, FrameDescriptorAllocators &frame_allocators, bool late, const DepthPyramid *depth_pyramid) {
+    VkDescriptorSet descriptor_set = frame_allocators.allocate(device, m_descriptor_set_layout);
+
+    // The late phase writes its own commands / count
+    const VkDescriptorBufferInfo buffer_infos[6] = {
+        {m_object_buffer, 0, VK_WHOLE_SIZE},
+        {m_draw_buffer, 0, VK_WHOLE_SIZE},
+        {late ? frame.late_command_buffer.buffer : frame.command_buffer.buffer, 0, VK_WHOLE_SIZE},
+        {late ? frame.late_count_buffer.buffer : frame.count_buffer.buffer, 0, VK_WHOLE_SIZE},
+        {frame.stats_buffer.buffer, 0, VK_WHOLE_SIZE},
+        {frame.candidate_buffer.buffer, 0, VK_WHOLE_SIZE}
+    };
+    VkDescriptorImageInfo pyramid_info {};
+    if (depth_pyramid != nullptr)
+        pyramid_info = {depth_pyramid->sampler(), depth_pyramid->view(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+    VkWriteDescriptorSet writes[7] {};
+    for (uint32_t i = 0; i < 7; i++) {
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet = descriptor_set;
+        writes[i].dstBinding = i;
+        writes[i].descriptorCount = 1;
+        writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        writes[i].pBufferInfo = i < 6 ? &buffer_infos[i] : nullptr;
+    }
+    writes[6].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    writes[6].pImageInfo = &pyramid_info;
+    vkUpdateDescriptorSets(device, m_occlusion_culling ? 7 : 5, writes, 0, nullptr);
+    return descriptor_set;
+}
+
+void GpuCulling::beginFrame(uint32_t frame_index) {
+    // The fence of the frame has been waited for: the counters are final
+    CullingCounters *counters = static_cast<CullingCounters*>(m_frames[frame_index].stats_buffer.mapped);
+    m_stats.draws = m_draw_count;
+    m_stats.frustum_culled = counters->frustum_culled;
+    // The candidates drawn by the late phase were only hidden last frame
+    m_stats.occlusion_culled = counters->early_occluded - counters->drawn_late;
+    m_stats.drawn_early = counters->drawn_early;
+    m_stats.drawn_late = counters->drawn_late;
+    memset(counters, 0, sizeof(CullingCounters));
+}
+
+void GpuCulling::recordCulling(VkDevice device, VkCommandBuffer command_buffer, uint32_t frame_index, FrameDescriptorAllocators &frame_allocators, const glm::mat4 &view_proj, const DepthPyramid *depth_pyramid) {
+    if (m_occlusion_culling && depth_pyramid == nullptr) {
+        throw std::runtime_error("occlusion culling needs a depth pyramid");
+    }
+    _dispatch(device, command_buffer, m_frames[frame_index], frame_allocators, view_proj, false, depth_pyramid);
+}
+
+void GpuCulling::recordLateCulling(VkDevice device, VkCommandBuffer command_buffer, uint32_t frame_index, FrameDescriptorAllocators &frame_allocators, const glm::mat4 &view_proj, const DepthPyramid &depth_pyramid) {
+    _dispatch(device, command_buffer, m_frames[frame_index], frame_allocators, view_proj, true, &depth_pyramid);
+}
+
+void GpuCulling::_dispatch(VkDevice device, VkCommandBuffer command_buffer, const FrameResources &frame, FrameDescriptorAllocators &frame_allocators, const glm::mat4 &view_proj, bool late, const DepthPyramid *depth_pyramid) {
+    const VkDescriptorSet descriptor_set = _writeDescriptorSet(device, frame, frame_allocators, late, depth_pyramid);
+
+    // Reset the visible draws counter
+    vkCmdFillBuffer(command_buffer, late ? frame.late_count_buffer.buffer : frame.count_buffer.buffer, 0, sizeof(uint32_t), 0);
+    VkMemoryBarrier fill_barrier {};
+    fill_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    fill_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    fill_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &fill_barrier, 0, nullptr, 0, nullptr);
+
+    CullParams params {};
+    params.view_proj = view_proj;
+    params.draw_count = m_draw_count;
+    params.compact = m_use_draw_count ? 1 : 0;
+    params.late = late ? 1 : 0;
+    params.occlusion = depth_pyramid != nullptr && depth_pyramid->built() ? 1 : 0;
+
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline_layout, 0, 1, &descriptor_set, 0, nullptr);
+    pushConstants(command_buffer, m_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, params);
+    vkCmdDispatch(command_buffer, (m_draw_count + CULL_WORKGROUP_SIZE - 1) / CULL_WORKGROUP_SIZE, 1, 1);
+
+    // The counters are read by the CPU once the fence of the frame is signaled
+    VkMemoryBarrier stats_barrier {};
+    stats_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    stats_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    stats_barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &stats_barrier, 0, nullptr, 0, nullptr);
+}
+
+void GpuCulling::recordOutputBarrier(VkCommandBuffer command_buffer) {
+    // Make the draw commands visible to the indirect draw stage
+    VkMemoryBarrier cull_barrier {};
+    cull_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    cull_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    cull_barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 1, &cull_barrier, 0, nullptr, 0, nullptr);
+}
+
+void GpuCulling::recordDraws(VkCommandBuffer command_buffer, uint32_t frame_index, bool late) {
+    const FrameResources &frame = m_frames[frame_index];
+    const VkBuffer commands = late ? frame.late_command_buffer.buffer : frame.command_buffer.buffer;
+    constexpr uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+    if (m_use_draw_count) {
+        vkCmdDrawIndexedIndirectCount(command_buffer, commands, 0, late ? frame.late_count_buffer.buffer : frame.count_buffer.buffer, 0, m_draw_count, stride);
+    } else if (m_use_multi_draw) {
+        // Culled draws have an instanceCount of 0
+        vkCmdDrawIndexedIndirect(command_buffer, commands, 0, m_draw_count, stride);
+    } else {
+        // drawCount must be 0 or 1 without the multiDrawIndirect feature
+        for (uint32_t i = 0; i < m_draw_count; i++)
+            vkCmdDrawIndexedIndirect(command_buffer, commands, i * stride, 1, stride);
+    }
+}
+
+void GpuCulling::clean(VkDevice device) {
+    for (auto &frame: m_frames) {
+        destroyBuffer(device, frame.command_buffer);
+        destroyBuffer(device, frame.count_buffer);
+        destroyBuffer(device, frame.late_command_buffer);
+        destroyBuffer(device, frame.late_count_buffer);
+        destroyBuffer(device, frame.candidate_buffer);
+        destroyBuffer(device, frame.stats_buffer);
+    }
+    m_frames.clear();
+    if (m_pipeline != VK_NULL_HANDLE) vkDestroyPipeline(device, m_pipeline, nullptr);
+    if (m_pipeline_layout != VK_NULL_HANDLE) vkDestroyPipelineLayout(device, m_pipeline_layout, nullptr);
+    if (m_descriptor_set_layout != VK_NULL_HANDLE) vkDestroyDescriptorSetLayout(device, m_descriptor_set_layout, nullptr);
+    m_pipeline = VK_NULL_HANDLE;
+    m_pipeline_layout = VK_NULL_HANDLE;
+    m_descriptor_set_layout = VK_NULL_HANDLE;
+}
@@ -0,0 +1,163 @@
+//
+//  gpu_culling.hpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#ifndef gpu_culling_hpp
+#define gpu_culling_hpp
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "buffer_utils.hpp"
+#include "descriptor_allocator.hpp"
+#include "depth_pyramid.hpp"
+#include "device_capabilities.hpp"
+
+/**
+ * Draws of the GPU culling pass, read back from a frame in flight.
+ */
+struct CullingStats {
+    uint32_t draws = 0;
+    uint32_t frustum_culled = 0;
+    // Hidden behind both the previous frame's depth and the early phase's
+    uint32_t occlusion_culled = 0;
+    // Drawn by the early (or only) phase, and by the late phase
+    uint32_t drawn_early = 0;
+    uint32_t drawn_late = 0;
+};
+
+/**
+ * GPU-driven draw submission.
+ * A compute pass frustum culls the draw records (stored in a SSBO),
+ * and writes the VkDrawIndexedIndirectCommand of the visible ones in
+ * an indirect buffer. The graphics pass then consumes it with a single
+ * vkCmdDrawIndexedIndirectCount (or vkCmdDrawIndexedIndirect if the
+ * device does not support it), so the CPU cost does not depend on the
+ * number of objects anymore.
+ *
+ * With occlusion culling, the draws are culled in two phases around a
+ * Hi-Z pyramid (DepthPyramid):
+ * - early: the draws in the frustum are tested against the pyramid of the
+ *   previous frame's depth; the visible ones are drawn, the hidden ones
+ *   flagged as candidates
+ * - the pyramid is built again from the depth of the early draws
+ * - late: the candidates are tested against this new pyramid, and the
+ *   visible ones drawn on top of the early draws
+ * An object hidden last frame but visible now is then drawn in the late
+ * phase of the same frame: no popping.
+ */
+class GpuCulling {
+
+public:
+    /**
+     * Returns true if the device supports the GPU-driven path.
+     */
+    static bool isSupported(const DeviceCapabilities &capabilities);
+
+    /**
+     * Create the culling pipeline and the per-frame output buffers.
+     * object_buffer and draw_buffer are the scene SSBOs (ObjectData and DrawRecord).
+     * With occlusion_culling, the culling runs in two phases (see above).
+     */
+    void init(VkPhysicalDevice physical_device, VkDevice device, const DeviceCapabilities &capabilities, const AllocatedBuffer &object_buffer, const AllocatedBuffer &draw_buffer, uint32_t draw_count, uint32_t frames_in_flight, bool occlusion_culling);
+
+    void clean(VkDevice device);
+
+    /**
+     * Read the statistics of the previous use of the frame, once its
+     * fence has been waited for.
+     */
+    void beginFrame(uint32_t frame_index);
+
+    /**
+     * Record the culling dispatch (the early phase with occlusion culling),
+     * outside of any render pass.
+     * The descriptor set of the dispatch is allocated from the
+     * transient allocator of the frame.
+     * With occlusion culling, depth_pyramid is tested once it has been
+     * built, in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL.
+     * The draw commands are not visible to the indirect draws until
+     * recordOutputBarrier (or a frame graph barrier on the output buffers).
+     */
+    void recordCulling(VkDevice device, VkCommandBuffer command_buffer, uint32_t frame_index, FrameDescriptorAllocators &frame_allocators, const glm::mat4 &view_proj, const DepthPyramid *depth_pyramid = nullptr);
+
+    /**
+     * Occlusion culling: record the late phase, once the pyramid has been
+     * built from the depth of the early draws. Same synchronization as
+     * recordCulling, on the late output buffers.
+     */
+    void recordLateCulling(VkDevice device, VkCommandBuffer command_buffer, uint32_t frame_index, FrameDescriptorAllocators &frame_allocators, const glm::mat4 &view_proj, const DepthPyramid &depth_pyramid);
+
+    /**
+     * Make the output of the culling pass visible to the indirect draw stage.
+     */
+    void recordOutputBarrier(VkCommandBuffer command_buffer);
+
+    /**
+     * Record the indirect draws of the early (or only) phase, or of the
+     * late one, inside the render pass, with the graphics pipeline /
+     * vertex and index buffers already bound.
+     */
+    void recordDraws(VkCommandBuffer command_buffer, uint32_t frame_index, bool late = false);
+
+    bool usesDrawCount() const { return m_use_draw_count; }
+    bool occlusionCulling() const { return m_occlusion_culling; }
+
+    /**
+     * Statistics of the last frame read back by beginFrame
+     * (MAX_FRAMES_IN_FLIGHT frames old).
+     */
+    const CullingStats& stats() const { return m_stats; }
+
+    /**
+     * Output buffers of the culling pass for the frame.
+     */
+    VkBuffer drawCommandBuffer(uint32_t frame_index) const { return m_frames[frame_index].command_buffer.buffer; }
+    VkBuffer drawCountBuffer(uint32_t frame_index) const { return m_frames[frame_index].count_buffer.buffer; }
+    // Occlusion culling: written by the late phase
+    VkBuffer lateDrawCommandBuffer(uint32_t frame_index) const { return m_frames[frame_index].late_command_buffer.buffer; }
+    VkBuffer lateDrawCountBuffer(uint32_t frame_index) const { return m_frames[frame_index].late_count_buffer.buffer; }
+    // Occlusion culling: written by the early phase, read by the late one
+    VkBuffer candidateBuffer(uint32_t frame_index) const { return m_frames[frame_index].candidate_buffer.buffer; }
+    // Written by every phase
+    VkBuffer statsBuffer(uint32_t frame_index) const { return m_frames[frame_index].stats_buffer.buffer; }
+
+private:
+    struct FrameResources {
+        // Compacted (or instanceCount = 0 when culled) draw commands
+        AllocatedBuffer command_buffer;
+        // Number of visible draws, written by the culling pass
+        AllocatedBuffer count_buffer;
+        // Same, for the late phase
+        AllocatedBuffer late_command_buffer;
+        AllocatedBuffer late_count_buffer;
+        // One uint per draw: 1 if the early phase found it occluded
+        AllocatedBuffer candidate_buffer;
+        // CullingCounters (gpu_culling.cpp), host visible
+        AllocatedBuffer stats_buffer;
+    };
+
+    bool m_occlusion_culling = false;
+    bool m_use_draw_count = false;
+    bool m_use_multi_draw = false;
+    uint32_t m_draw_count = 0;
+    VkBuffer m_object_buffer = VK_NULL_HANDLE;
+    VkBuffer m_draw_buffer = VK_NULL_HANDLE;
+    VkDescriptorSetLayout m_descriptor_set_layout = VK_NULL_HANDLE;
+    VkPipelineLayout m_pipeline_layout = VK_NULL_HANDLE;
+    VkPipeline m_pipeline = VK_NULL_HANDLE;
+    std::vector<FrameResources> m_frames;
+    CullingStats m_stats {};
+
+    void _createDescriptorSetLayout(VkDevice device);
+    void _createPipeline(VkDevice device, const DeviceCapabilities &capabilities);
+    VkDescriptorSet _writeDescriptorSet(VkDevice device, const FrameResources &frame, FrameDescriptorAllocators &frame_allocators, bool late, const DepthPyramid *depth_pyramid);
+    void _dispatch(VkDevice device, VkCommandBuffer command_buffer, const FrameResources &frame, FrameDescriptorAllocators &frame_allocators, const glm::mat4 &view_proj, bool late, const DepthPyramid *depth_pyramid);
+};
+
+#endif /* gpu_culling_hpp */
@@ -0,0 +1,100 @@
+//
+//  gpu_timer.cpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#include "gpu_timer.hpp"
+#include "base.hpp"
+#include <cstring>
+#include <stdexcept>
+
+void GpuTimer::init(VkDevice device, const DeviceCapabilities &capabilities, uint32_t timestamp_valid_bits, uint32_t frames_in_flight, uint32_t max_scopes) {
+    m_frames.assign(frames_in_flight, {});
+    m_max_scopes = max_scopes;
+    if (!capabilities.timestamps || timestamp_valid_bits == 0) {
+        Log("-> GPU timer disabled: timestamps are not supported");
+        return;
+    }
+    // Two timestamps per scope
+    VkQueryPoolCreateInfo query_pool_info {};
+    query_pool_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    query_pool_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    query_pool_info.queryCount = frames_in_flight * max_scopes * 2;
+    if (vkCreateQueryPool(device, &query_pool_info, nullptr, &m_query_pool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create the timestamp query pool");
+    }
+    m_timestamp_period_ms = static_cast<double>(capabilities.properties.limits.timestampPeriod) / 1e6;
+    m_timestamp_mask = timestamp_valid_bits >= 64 ? UINT64_MAX : (uint64_t(1) << timestamp_valid_bits) - 1;
+    m_timestamps.resize(max_scopes * 2);
+}
+
+void GpuTimer::clean(VkDevice device) {
+    if (m_query_pool != VK_NULL_HANDLE) vkDestroyQueryPool(device, m_query_pool, nullptr);
+    m_query_pool = VK_NULL_HANDLE;
+    m_frames.clear();
+    m_results.clear();
+}
+
+void GpuTimer::beginFrame(VkDevice device, uint32_t frame_index) {
+    m_current_frame = frame_index;
+    if (!enabled())
+        return;
+    FrameScopes &frame = m_frames[frame_index];
+    if (frame.names.empty())
+        return;
+    // The fence of the frame has been waited for: the results are available
+    const uint32_t query_count = static_cast<uint32_t>(frame.names.size()) * 2;
+    const VkResult result = vkGetQueryPoolResults(
+        device,
+        m_query_pool,
+        _firstQuery(frame_index),
+        query_count,
+        sizeof(uint64_t) * query_count,
+        m_timestamps.data(),
+        sizeof(uint64_t),
+        VK_QUERY_RESULT_64_BIT);
+    if (result == VK_SUCCESS) {
+        m_results.clear();
+        for (size_t i = 0; i < frame.names.size(); i++) {
+            // Masked difference: also right if the counter wrapped in the scope
+            const uint64_t ticks = ((m_timestamps[2 * i + 1] & m_timestamp_mask) - (m_timestamps[2 * i] & m_timestamp_mask)) & m_timestamp_mask;
+            m_results.push_back({frame.names[i], static_cast<double>(ticks) * m_timestamp_period_ms});
+        }
+    }
+    frame.names.clear();
+}
+
+void GpuTimer::recordReset(VkCommandBuffer command_buffer) {
+    if (enabled())
+        vkCmdResetQueryPool(command_buffer, m_query_pool, _firstQuery(m_current_frame), m_max_scopes * 2);
+}
+
+uint32_t GpuTimer::begin(VkCommandBuffer command_buffer, const char *name) {
+    FrameScopes &frame = m_frames[m_current_frame];
+    if (!enabled() || frame.names.size() >= m_max_scopes)
+        return UINT32_MAX;
+    const uint32_t scope = static_cast<uint32_t>(frame.names.size());
+    frame.names.push_back(name);
+    // Waits for nothing: written when the GPU starts the commands after it
+    vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_query_pool, _firstQuery(m_current_frame) + 2 * scope);
+    return scope;
+}
+
+void GpuTimer::end(VkCommandBuffer command_buffer, uint32_t scope) {
+    if (scope == UINT32_MAX)
+        return;
+    // Written once the previous commands have completed every stage
+    vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_query_pool, _firstQuery(m_current_frame) + 2 * scope + 1);
+}
+
+double GpuTimer::milliseconds(const char *name) const {
+    double total = -1.0;
+    for (const GpuTimerResult &result: m_results) {
+        if (strcmp(result.name, name) != 0)
+            continue;
+        total = (total < 0.0 ? 0.0 : total) + result.milliseconds;
+    }
+    return total;
+}
@@ -0,0 +1,100 @@
+//
+//  gpu_timer.hpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#ifndef gpu_timer_hpp
+#define gpu_timer_hpp
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#include <vector>
+
+#include "device_capabilities.hpp"
+
+/**
+ * GPU time of a scope of the frame.
+ */
+struct GpuTimerResult {
+    const char *name;
+    double milliseconds;
+};
+
+/**
+ * Measures the GPU time of scopes of the frame with timestamp queries.
+ *
+ * Each frame in flight has its own range of queries: the timestamps of a
+ * frame are read back when its fence has been waited for (in beginFrame),
+ * so reading them never stalls. The results are those of the frame
+ * MAX_FRAMES_IN_FLIGHT frames ago.
+ * Does nothing (and returns no result) if the device does not support
+ * timestamps. Not thread-safe: scopes are recorded by one thread at a time.
+ */
+class GpuTimer {
+
+public:
+    /**
+     * timestamp_valid_bits is the timestampValidBits of the queue family
+     * the scopes are submitted to.
+     */
+    void init(VkDevice device, const DeviceCapabilities &capabilities, uint32_t timestamp_valid_bits, uint32_t frames_in_flight, uint32_t max_scopes);
+
+    void clean(VkDevice device);
+
+    bool enabled() const { return m_query_pool != VK_NULL_HANDLE; }
+
+    /**
+     * Read the timestamps written by the previous use of the frame, once
+     * its fence has been waited for, and forget its scopes.
+     */
+    void beginFrame(VkDevice device, uint32_t frame_index);
+
+    /**
+     * Reset the queries of the frame, outside of any render pass, before
+     * any scope is recorded.
+     */
+    void recordReset(VkCommandBuffer command_buffer);
+
+    /**
+     * Start a scope (name must outlive the timer, e.g. a literal), and
+     * return it for end(). Scopes past max_scopes are not measured.
+     * The scope starts when the GPU starts the commands after begin(),
+     * and ends when the commands before end() are complete: a scope
+     * around a command that waits (e.g. on a semaphore) counts the wait.
+     */
+    uint32_t begin(VkCommandBuffer command_buffer, const char *name);
+
+    void end(VkCommandBuffer command_buffer, uint32_t scope);
+
+    /**
+     * Scopes of the last frame read back.
+     */
+    const std::vector<GpuTimerResult>& results() const { return m_results; }
+
+    /**
+     * Time of the named scope in the last frame read back (summed if it was
+     * recorded several times), or a negative value if it was not measured.
+     */
+    double milliseconds(const char *name) const;
+
+private:
+    struct FrameScopes {
+        std::vector<const char*> names;
+    };
+
+    VkQueryPool m_query_pool = VK_NULL_HANDLE;
+    double m_timestamp_period_ms = 0.0;
+    // Bits of the timestamps written by the queue (the others are undefined)
+    uint64_t m_timestamp_mask = 0;
+    uint32_t m_max_scopes = 0;
+    uint32_t m_current_frame = 0;
+    std::vector<FrameScopes> m_frames;
+    std::vector<uint64_t> m_timestamps;
+    std::vector<GpuTimerResult> m_results;
+
+    uint32_t _firstQuery(uint32_t frame_index) const { return frame_index * m_max_scopes * 2; }
+};
+
+#endif /* gpu_timer_hpp */
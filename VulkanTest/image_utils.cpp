@@ -0,0 +1,204 @@
+//
+//  image_utils.cpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#include "image_utils.hpp"
+#include "base.hpp"
+#include "buffer_utils.hpp"
+#include <cstring>
+#include <stdexcept>
+
+AllocatedImage createImage(VkPhysicalDevice physical_device, VkDevice device, VkExtent2D extent, uint32_t mip_levels, VkSampleCountFlagBits samples, VkFormat format, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImageAspectFlags aspect, VkMemoryPropertyFlags fallback_properties) {
+    AllocatedImage allocated_image {};
+    allocated_image.format = format;
+    allocated_image.extent = extent;
+    allocated_image.mip_levels = mip_levels;
+
+    VkImageCreateInfo image_info {};
+    image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    image_info.imageType = VK_IMAGE_TYPE_2D;
+    image_info.extent = {extent.width, extent.height, 1};
+    image_info.mipLevels = mip_levels;
+    image_info.arrayLayers = 1;
+    image_info.format = format;
+    image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+    image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    image_info.usage = usage;
+    image_info.samples = samples;
+    image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (vkCreateImage(device, &image_info, nullptr, &allocated_image.image) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create image");
+    }
+
+    VkMemoryRequirements memory_requirements {};
+    vkGetImageMemoryRequirements(device, allocated_image.image, &memory_requirements);
+    auto memory_type = findMemoryType(physical_device, memory_requirements.memoryTypeBits, properties);
+    if (!memory_type.has_value() && fallback_properties != 0)
+        memory_type = findMemoryType(physical_device, memory_requirements.memoryTypeBits, fallback_properties);
+    if (!memory_type.has_value()) {
+        vkDestroyImage(device, allocated_image.image, nullptr);
+        throw std::runtime_error("failed to find a suitable memory type for image");
+    }
+
+    VkMemoryAllocateInfo alloc_info {};
+    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    alloc_info.allocationSize = memory_requirements.size;
+    alloc_info.memoryTypeIndex = memory_type.value();
+    if (vkAllocateMemory(device, &alloc_info, nullptr, &allocated_image.memory) != VK_SUCCESS) {
+        vkDestroyImage(device, allocated_image.image, nullptr);
+        throw std::runtime_error("failed to allocate image memory");
+    }
+    vkBindImageMemory(device, allocated_image.image, allocated_image.memory, 0);
+
+    try {
+        allocated_image.view = createImageView(device, allocated_image.image, format, aspect, 0, mip_levels);
+    } catch (const std::runtime_error &) {
+        destroyImage(device, allocated_image);
+        throw;
+    }
+    return allocated_image;
+}
+
+VkImageView createImageView(VkDevice device, VkImage image, VkFormat format, VkImageAspectFlags aspect, uint32_t base_mip_level, uint32_t mip_levels) {
+    VkImageViewCreateInfo view_info {};
+    view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    view_info.image = image;
+    view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    view_info.format = format;
+    view_info.subresourceRange.aspectMask = aspect;
+    view_info.subresourceRange.baseMipLevel = base_mip_level;
+    view_info.subresourceRange.levelCount = mip_levels;
+    view_info.subresourceRange.baseArrayLayer = 0;
+    view_info.subresourceRange.layerCount = 1;
+    VkImageView image_view = VK_NULL_HANDLE;
+    if (vkCreateImageView(device, &view_info, nullptr, &image_view) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create image view");
+    }
+    return image_view;
+}
+
+AllocatedImage createTransientAttachment(VkPhysicalDevice physical_device, VkDevice device, VkExtent2D extent, VkSampleCountFlagBits samples, VkFormat format, VkImageUsageFlags usage, VkImageAspectFlags aspect) {
+    return createImage(
+        physical_device,
+        device,
+        extent,
+        1,
+        samples,
+        format,
+        usage | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT,
+        aspect,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+}
+
+VkFormat findDepthFormat(VkPhysicalDevice physical_device) {
+    const VkFormat candidates[] = {VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT};
+    for (const VkFormat format: candidates) {
+        VkFormatProperties properties {};
+        vkGetPhysicalDeviceFormatProperties(physical_device, format, &properties);
+        if (properties.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT)
+            return format;
+    }
+    throw std::runtime_error("failed to find a supported depth format");
+}
+
+VkImageAspectFlags depthFormatAspect(VkFormat format) {
+    if (format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT)
+        return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+    return VK_IMAGE_ASPECT_DEPTH_BIT;
+}
+
+void destroyImage(VkDevice device, AllocatedImage &image) {
+    if (image.view != VK_NULL_HANDLE) vkDestroyImageView(device, image.view, nullptr);
+    if (image.image != VK_NULL_HANDLE) vkDestroyImage(device, image.image, nullptr);
+    if (image.memory != VK_NULL_HANDLE) vkFreeMemory(device, image.memory, nullptr);
+    image = AllocatedImage {};
+}
+
+void transitionImageLayout(VkCommandBuffer command_buffer, VkImage image, VkImageAspectFlags aspect, uint32_t mip_levels, VkImageLayout old_layout, VkImageLayout new_layout) {
+    VkImageMemoryBarrier barrier {};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.oldLayout = old_layout;
+    barrier.newLayout = new_layout;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange.aspectMask = aspect;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = mip_levels;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+
+    VkPipelineStageFlags src_stage {};
+    VkPipelineStageFlags dst_stage {};
+    if (old_layout == VK_IMAGE_LAYOUT_UNDEFINED && new_layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        src_stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+        dst_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    } else if (old_layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && new_layout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        src_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        dst_stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    } else if (old_layout == VK_IMAGE_LAYOUT_UNDEFINED && new_layout == VK_IMAGE_LAYOUT_GENERAL) {
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        src_stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+        dst_stage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    } else if (old_layout == VK_IMAGE_LAYOUT_UNDEFINED && new_layout == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL) {
+        // Swap chain image, acquired before the color attachment output stage
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        src_stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        dst_stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    } else if (old_layout == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL && new_layout == VK_IMAGE_LAYOUT_PRESENT_SRC_KHR) {
+        // The presentation engine waits on a semaphore: no access to make available
+        barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        barrier.dstAccessMask = 0;
+        src_stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        dst_stage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+    } else {
+        throw std::invalid_argument("unsupported image layout transition");
+    }
+    vkCmdPipelineBarrier(command_buffer, src_stage, dst_stage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+AllocatedImage createTextureImage(VkPhysicalDevice physical_device, VkDevice device, VkCommandPool command_pool, VkQueue queue, const uint32_t *pixels, VkExtent2D extent) {
+    const VkDeviceSize size = static_cast<VkDeviceSize>(extent.width) * extent.height * sizeof(uint32_t);
+    AllocatedBuffer staging_buffer = createBuffer(physical_device, device, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    memcpy(staging_buffer.mapped, pixels, static_cast<size_t>(size));
+
+    AllocatedImage texture = createImage(
+        physical_device,
+        device,
+        extent,
+        1,
+        VK_SAMPLE_COUNT_1_BIT,
+        VK_FORMAT_R8G8B8A8_UNORM,
+        VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        VK_IMAGE_ASPECT_COLOR_BIT);
+
+    VkCommandBuffer command_buffer = beginSingleTimeCommands(device, command_pool);
+    transitionImageLayout(command_buffer, texture.image, VK_IMAGE_ASPECT_COLOR_BIT, 1, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    VkBufferImageCopy region {};
+    region.bufferOffset = 0;
+    region.bufferRowLength = 0;
+    region.bufferImageHeight = 0;
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 1;
+    region.imageOffset = {0, 0, 0};
+    region.imageExtent = {extent.width, extent.height, 1};
+    vkCmdCopyBufferToImage(command_buffer, staging_buffer.buffer, texture.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+    transitionImageLayout(command_buffer, texture.image, VK_IMAGE_ASPECT_COLOR_BIT, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    endSingleTimeCommands(device, command_pool, queue, command_buffer);
+
+    destroyBuffer(device, staging_buffer);
+    return texture;
+}
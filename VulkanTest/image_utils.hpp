@@ -0,0 +1,78 @@
+//
+//  image_utils.hpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#ifndef image_utils_hpp
+#define image_utils_hpp
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+/**
+ * An image, the device memory bound to it, and a view on all its mip levels.
+ */
+struct AllocatedImage {
+    VkImage image = VK_NULL_HANDLE;
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkImageView view = VK_NULL_HANDLE;
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    VkExtent2D extent {};
+    uint32_t mip_levels = 1;
+};
+
+/**
+ * Create a 2D image, allocate / bind its memory and create its view.
+ * If no memory type has the given properties, fallback_properties
+ * (if not 0) are tried instead.
+ * Throws if the image cannot be created.
+ */
+AllocatedImage createImage(VkPhysicalDevice physical_device, VkDevice device, VkExtent2D extent, uint32_t mip_levels, VkSampleCountFlagBits samples, VkFormat format, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImageAspectFlags aspect, VkMemoryPropertyFlags fallback_properties = 0);
+
+/**
+ * Create a 2D view on mip levels [base_mip_level, base_mip_level + mip_levels)
+ * of an image. Throws if the view cannot be created.
+ */
+VkImageView createImageView(VkDevice device, VkImage image, VkFormat format, VkImageAspectFlags aspect, uint32_t base_mip_level, uint32_t mip_levels);
+
+/**
+ * Create an attachment whose contents never leave the render pass
+ * (multisampled color resolved in the pass, depth...): transient usage,
+ * backed by lazily allocated memory when the device has some (tile-based
+ * GPUs then never allocate it), by device local memory otherwise.
+ */
+AllocatedImage createTransientAttachment(VkPhysicalDevice physical_device, VkDevice device, VkExtent2D extent, VkSampleCountFlagBits samples, VkFormat format, VkImageUsageFlags usage, VkImageAspectFlags aspect);
+
+/**
+ * Depth format for the depth attachments: 32-bit float depth if possible
+ * (needed for reverse-Z to be precise), 24-bit otherwise.
+ * Throws if the device supports none of them.
+ */
+VkFormat findDepthFormat(VkPhysicalDevice physical_device);
+
+/**
+ * Aspects of a depth format: depth, plus stencil for the combined formats.
+ */
+VkImageAspectFlags depthFormatAspect(VkFormat format);
+
+/**
+ * Destroy the view and the image, and free its memory.
+ */
+void destroyImage(VkDevice device, AllocatedImage &image);
+
+/**
+ * Record a layout transition of all the mip levels of an image.
+ * Only the transitions used by the renderer are supported.
+ */
+void transitionImageLayout(VkCommandBuffer command_buffer, VkImage image, VkImageAspectFlags aspect, uint32_t mip_levels, VkImageLayout old_layout, VkImageLayout new_layout);
+
+/**
+ * Create a sampled RGBA8 texture (single mip level) from the given pixels,
+ * uploaded through a staging buffer. The texture is left in
+ * VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL.
+ */
+AllocatedImage createTextureImage(VkPhysicalDevice physical_device, VkDevice device, VkCommandPool command_pool, VkQueue queue, const uint32_t *pixels, VkExtent2D extent);
+
+#endif /* image_utils_hpp */
@@ -0,0 +1,189 @@
+//
+//  job_system.cpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#include "job_system.hpp"
+#include "base.hpp"
+#include "profiler.hpp"
+#include <algorithm>
+#include <chrono>
+
+// Failed attempts to find a job before an idle worker goes to sleep
+constexpr uint32_t const IDLE_SPINS_BEFORE_SLEEP = 64;
+
+static thread_local uint32_t t_worker_index = JobSystem::INVALID_WORKER;
+
+bool JobSystem::WorkStealingDeque::push(Job *job) {
+    const int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+    const int64_t top = m_top.load(std::memory_order_acquire);
+    if (bottom - top >= CAPACITY)
+        return false;
+    m_jobs[bottom & (CAPACITY - 1)].store(job, std::memory_order_relaxed);
+    // The job must be visible before the new bottom
+    std::atomic_thread_fence(std::memory_order_release);
+    m_bottom.store(bottom + 1, std::memory_order_relaxed);
+    return true;
+}
+
+JobSystem::Job* JobSystem::WorkStealingDeque::pop() {
+    const int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+    m_bottom.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t top = m_top.load(std::memory_order_relaxed);
+    if (top > bottom) {
+        // Empty
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    Job *job = m_jobs[bottom & (CAPACITY - 1)].load(std::memory_order_relaxed);
+    if (top == bottom) {
+        // Last job: race against the thieves
+        if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            job = nullptr;
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+JobSystem::Job* JobSystem::WorkStealingDeque::steal() {
+    int64_t top = m_top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int64_t bottom = m_bottom.load(std::memory_order_acquire);
+    if (top >= bottom)
+        return nullptr;
+    Job *job = m_jobs[top & (CAPACITY - 1)].load(std::memory_order_relaxed);
+    // Another thief (or the owner) may have taken it first
+    if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        return nullptr;
+    return job;
+}
+
+void JobSystem::init(uint32_t worker_count) {
+    worker_count = std::max(1u, worker_count);
+    m_stop = false;
+    for (uint32_t i = 0; i < worker_count; i++)
+        m_deques.push_back(std::make_unique<WorkStealingDeque>());
+    t_worker_index = 0;
+    for (uint32_t worker_index = 1; worker_index < worker_count; worker_index++)
+        m_threads.emplace_back(&JobSystem::_workerLoop, this, worker_index);
+    Log("-> Job system: " << worker_count << " workers");
+}
+
+void JobSystem::clean() {
+    {
+        std::lock_guard<std::mutex> lock(m_sleep_mutex);
+        m_stop = true;
+    }
+    m_wake_up.notify_all();
+    for (std::thread &thread: m_threads)
+        thread.join();
+    m_threads.clear();
+    m_deques.clear();
+    t_worker_index = INVALID_WORKER;
+}
+
+uint32_t JobSystem::currentWorker() {
+    return t_worker_index;
+}
+
+void JobSystem::run(JobCounter &counter, const char *name, std::function<void()> job_function) {
+    counter.m_pending.fetch_add(1, std::memory_order_relaxed);
+    Job *job = new Job {std::move(job_function), &counter, name};
+    const uint32_t worker_index = currentWorker();
+    if (worker_index == INVALID_WORKER || worker_index >= m_deques.size() || !m_deques[worker_index]->push(job)) {
+        // Not a worker, or the deque is full: run it right away
+        _execute(job, worker_index == INVALID_WORKER ? 0 : worker_index);
+        return;
+    }
+    m_queued.fetch_add(1, std::memory_order_release);
+    m_wake_up.notify_one();
+}
+
+void JobSystem::wait(JobCounter &counter) {
+    const uint32_t worker_index = currentWorker();
+    while (!counter.done()) {
+        Job *job = worker_index != INVALID_WORKER ? _findJob(worker_index) : nullptr;
+        if (job != nullptr)
+            _execute(job, worker_index);
+        else
+            std::this_thread::yield();
+    }
+    if (counter.m_failed.load(std::memory_order_acquire)) {
+        std::exception_ptr error = counter.m_error;
+        counter.m_error = nullptr;
+        counter.m_failed = false;
+        std::rethrow_exception(error);
+    }
+}
+
+void JobSystem::parallelFor(const char *name, uint32_t begin, uint32_t end, uint32_t grain, const std::function<void(uint32_t, uint32_t)> &body) {
+    if (begin >= end)
+        return;
+    grain = std::max(1u, grain);
+    JobCounter counter;
+    for (uint32_t first = begin; first < end; first += grain) {
+        const uint32_t last = std::min(end, first + grain);
+        run(counter, name, [&body, first, last] { body(first, last); });
+    }
+    wait(counter);
+}
+
+void JobSystem::_workerLoop(uint32_t worker_index) {
+    t_worker_index = worker_index;
+    Profiler::setThreadName("worker " + std::to_string(worker_index));
+    uint32_t idle_spins = 0;
+    while (!m_stop.load(std::memory_order_acquire)) {
+        Job *job = _findJob(worker_index);
+        if (job != nullptr) {
+            _execute(job, worker_index);
+            idle_spins = 0;
+            continue;
+        }
+        if (++idle_spins < IDLE_SPINS_BEFORE_SLEEP) {
+            std::this_thread::yield();
+            continue;
+        }
+        // Nothing to do for a while: sleep until a job is queued
+        std::unique_lock<std::mutex> lock(m_sleep_mutex);
+        m_wake_up.wait_for(lock, std::chrono::milliseconds(1), [this] {
+            return m_stop.load(std::memory_order_acquire) || m_queued.load(std::memory_order_acquire) > 0;
+        });
+        idle_spins = 0;
+    }
+}
+
+JobSystem::Job* JobSystem::_findJob(uint32_t worker_index) {
+    Job *job = m_deques[worker_index]->pop();
+    if (job == nullptr) {
+        // Steal from the other workers, starting with the next one
+        const uint32_t worker_count = workerCount();
+        for (uint32_t i = 1; i < worker_count && job == nullptr; i++)
+            job = m_deques[(worker_index + i) % worker_count]->steal();
+    }
+    if (job != nullptr)
+        m_queued.fetch_sub(1, std::memory_order_acq_rel);
+    return job;
+}
+
+void JobSystem::_execute(Job *job, uint32_t worker_index) {
+    const auto start = std::chrono::steady_clock::now();
+    try {
+        ProfileZone(job->name);
+        job->function();
+    } catch (...) {
+        bool expected = false;
+        if (job->counter->m_failed.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+            job->counter->m_error = std::current_exception();
+    }
+    if (m_timing_hook) {
+        const std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - start;
+        m_timing_hook(job->name, worker_index, duration.count());
+    }
+    JobCounter *counter = job->counter;
+    delete job;
+    // Last access to the counter: it may be destroyed right after
+    counter->m_pending.fetch_sub(1, std::memory_order_acq_rel);
+}
@@ -0,0 +1,142 @@
+//
+//  job_system.hpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#ifndef job_system_hpp
+#define job_system_hpp
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Tracks a group of jobs: run() increments it, the end of each job
+ * decrements it. Wait for it with JobSystem::wait().
+ * Must outlive the jobs it tracks.
+ */
+class JobCounter {
+
+public:
+    bool done() const { return m_pending.load(std::memory_order_acquire) == 0; }
+
+private:
+    friend class JobSystem;
+    std::atomic<uint32_t> m_pending {0};
+    // First exception thrown by one of the jobs, rethrown by wait()
+    std::atomic<bool> m_failed {false};
+    std::exception_ptr m_error;
+};
+
+/**
+ * Job system with work stealing.
+ * Each worker owns a lock-free deque (Chase-Lev): it pushes and pops its
+ * own jobs at the bottom (LIFO, cache friendly), while idle workers steal
+ * the oldest jobs at the top. The thread calling init() is worker 0, the
+ * other workers are background threads.
+ *
+ * Jobs may only be submitted from workers (worker 0 included); jobs
+ * submitted from another thread run immediately on that thread.
+ * wait() does not block the worker: it runs (or steals) other jobs until
+ * the counter reaches zero, so jobs can wait for nested jobs.
+ */
+class JobSystem {
+
+public:
+    /**
+     * Called after each job, on the worker that ran it.
+     */
+    using TimingHook = std::function<void(const char *name, uint32_t worker_index, double milliseconds)>;
+
+    /**
+     * Start worker_count - 1 background workers (the calling thread is worker 0).
+     */
+    void init(uint32_t worker_count);
+
+    /**
+     * Stop and join the background workers. No job may be pending.
+     */
+    void clean();
+
+    /**
+     * Queue a job on the current worker. name must be a string literal
+     * (or outlive the job): it is given to the timing hook.
+     */
+    void run(JobCounter &counter, const char *name, std::function<void()> job);
+
+    /**
+     * Run jobs until every job of the counter has completed.
+     * Rethrows the first exception thrown by one of them.
+     */
+    void wait(JobCounter &counter);
+
+    /**
+     * Call body(first, last) over [begin, end), in chunks of grain items
+     * spread over the workers, and wait for all of them.
+     */
+    void parallelFor(const char *name, uint32_t begin, uint32_t end, uint32_t grain, const std::function<void(uint32_t, uint32_t)> &body);
+
+    /**
+     * Set (or remove, with nullptr) the timing hook.
+     * Must not be called while jobs are running.
+     */
+    void setTimingHook(TimingHook hook) { m_timing_hook = std::move(hook); }
+
+    uint32_t workerCount() const { return static_cast<uint32_t>(m_deques.size()); }
+
+    /**
+     * Index of the worker running the calling thread,
+     * or INVALID_WORKER outside of the workers.
+     */
+    static uint32_t currentWorker();
+
+    static constexpr uint32_t const INVALID_WORKER = UINT32_MAX;
+
+private:
+    struct Job {
+        std::function<void()> function;
+        JobCounter *counter = nullptr;
+        const char *name = nullptr;
+    };
+
+    /**
+     * Fixed size Chase-Lev deque.
+     * push / pop: owner only. steal: any thread.
+     */
+    class WorkStealingDeque {
+    public:
+        static constexpr int64_t const CAPACITY = 4096;
+
+        bool push(Job *job);
+        Job* pop();
+        Job* steal();
+
+    private:
+        std::atomic<int64_t> m_top {0};
+        std::atomic<int64_t> m_bottom {0};
+        std::atomic<Job*> m_jobs[CAPACITY] {};
+    };
+
+    std::vector<std::unique_ptr<WorkStealingDeque>> m_deques;
+    std::vector<std::thread> m_threads;
+    std::atomic<bool> m_stop {false};
+    // Queued jobs over all the deques, to put idle workers to sleep
+    std::atomic<uint32_t> m_queued {0};
+    std::mutex m_sleep_mutex;
+    std::condition_variable m_wake_up;
+    TimingHook m_timing_hook;
+
+    void _workerLoop(uint32_t worker_index);
+    Job* _findJob(uint32_t worker_index);
+    void _execute(Job *job, uint32_t worker_index);
+};
+
+#endif /* job_system_hpp */
@@ -15,15 +15,51 @@
 #include <optional>
 #include <set>
 #include <filesystem>
+#include <algorithm>
+#include <thread>
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <random>
 #ifdef _WIN32
 #include <assert.h>
 #endif
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
 
 #include "base.hpp"
 #include "extension_support.hpp"
 #include "queue_utils.hpp"
 #include "swapchain_utils.hpp"
 #include "shader_support.hpp"
+#include "buffer_utils.hpp"
+#include "device_capabilities.hpp"
+#include "scene.hpp"
+#include "gpu_culling.hpp"
+#include "image_utils.hpp"
+#include "bindless.hpp"
+#include "descriptor_allocator.hpp"
+#include "uniform_allocator.hpp"
+#include "push_constants.hpp"
+#include "dynamic_state.hpp"
+#include "frame_graph.hpp"
+#include "job_system.hpp"
+#include "command_recorder.hpp"
+#include "draw_list.hpp"
+#include "projection.hpp"
+#include "mip_generator.hpp"
+#include "texture_streamer.hpp"
+#include "meshlet_renderer.hpp"
+#include "gpu_timer.hpp"
+#include "pipeline_statistics.hpp"
+#include "particle_system.hpp"
+#include "depth_pyramid.hpp"
+#include "mesh_lod.hpp"
+#include "clustered_lighting.hpp"
+#include "dynamic_resolution.hpp"
+#include "frame_readback.hpp"
+#include "capture_encoder.hpp"
+#include "profiler.hpp"
 
 #ifdef DEBUG
 constexpr const bool enable_validation_layers = true;
@@ -46,6 +82,223 @@ constexpr uint32_t const APP_VERSION VK_MAKE_VERSION(
     APP_PATCH_VERSION
 );
 
+// The CPU records a frame while the GPU renders the previous one
+// (see m_in_flight_fences)
+constexpr uint32_t const MAX_FRAMES_IN_FLIGHT = 2;
+
+// Per-frame uniform data, suballocated in a linear allocator
+constexpr VkDeviceSize const UNIFORM_BYTES_PER_FRAME = 64 * 1024;
+
+// Render with vkCmdBeginRendering (Vulkan 1.3) when the device supports it,
+// instead of VkRenderPass / VkFramebuffer objects
+constexpr bool const ENABLE_DYNAMIC_RENDERING = true;
+
+// Set cull mode, front face, topology and depth test / write in the command
+// buffer (if supported), so one pipeline serves every combination
+constexpr bool const ENABLE_EXTENDED_DYNAMIC_STATE = true;
+
+// Upper bound of job system workers (the main thread included)
+constexpr uint32_t const MAX_JOB_WORKERS = 64;
+// Log the average time spent per frame in each kind of job
+constexpr bool const ENABLE_JOB_TIMINGS = false;
+constexpr uint32_t const JOB_TIMINGS_REPORT_FRAMES = 500;
+// Record the CPU zones (initialization, frame steps, jobs) from the start,
+// and write the last ones to PROFILER_TRACE_FILE at exit: open it in
+// chrome://tracing or Perfetto
+constexpr bool const ENABLE_PROFILER = false;
+constexpr const char* PROFILER_TRACE_FILE = "trace.json";
+// Draws tested for visibility by one CPU culling job
+constexpr uint32_t const CULLING_JOB_GRAIN = 256;
+
+// Samples per pixel of the color attachment (1: no MSAA), lowered to
+// what the device supports. Resolved at the end of the pass.
+constexpr uint32_t const MSAA_SAMPLES = 4;
+
+// Render the scene at a scale of the swap chain extent, adjusted from the
+// measured GPU time of the frames to stay within DYNAMIC_RESOLUTION_TARGET_MS,
+// then upscale it to the swap chain image (linear blit). Needs dynamic
+// rendering and timestamp queries.
+constexpr bool const ENABLE_DYNAMIC_RESOLUTION = true;
+constexpr float const DYNAMIC_RESOLUTION_TARGET_MS = 8.0f;
+constexpr float const DYNAMIC_RESOLUTION_MIN_SCALE = 0.5f;
+constexpr float const DYNAMIC_RESOLUTION_MAX_SCALE = 1.0f;
+// Fraction of the estimated correction left out at each adjustment
+constexpr float const DYNAMIC_RESOLUTION_DAMPING = 0.5f;
+// Frames averaged between two adjustments
+constexpr uint32_t const DYNAMIC_RESOLUTION_INTERVAL_FRAMES = 8;
+// Log the render extent when it changes
+constexpr bool const ENABLE_DYNAMIC_RESOLUTION_LOG = false;
+
+// Copy every presented image to host buffers, handed to the CPU once the
+// frame fence is signaled (see FrameReadback): a capture is dropped rather
+// than waited for when the buffers are all in use
+constexpr bool const ENABLE_FRAME_READBACK = false;
+constexpr uint32_t const FRAME_READBACK_BUFFERS = MAX_FRAMES_IN_FLIGHT;
+// Log the readback counters every FRAME_READBACK_REPORT_FRAMES captures
+constexpr uint32_t const FRAME_READBACK_REPORT_FRAMES = 500;
+// Write the frames read back to numbered files, encoded by background
+// threads (see CaptureEncoder). Enables the frame readback.
+constexpr bool const ENABLE_FRAME_CAPTURE = false;
+constexpr const char* CAPTURE_DIRECTORY = "captures";
+constexpr CaptureFileFormat const CAPTURE_FILE_FORMAT = CaptureFileFormat::Qoi;
+// When the encoders fall behind: drop frames, or also lower the capture rate
+constexpr CaptureBackpressure const CAPTURE_BACKPRESSURE = CaptureBackpressure::Throttle;
+constexpr uint32_t const CAPTURE_ENCODER_THREADS = 2;
+constexpr uint32_t const CAPTURE_QUEUE_CAPACITY = 8;
+// Frames written before the capture stops (0: no limit)
+constexpr uint32_t const CAPTURE_MAX_FRAMES = 600;
+
+// Depth-only pass before the main pass: the main pass then shades each
+// pixel once (depth EQUAL), at the cost of processing the geometry twice
+constexpr bool const ENABLE_DEPTH_PREPASS = false;
+
+// The camera looks at the scene plane (z = 0) from CAMERA_DISTANCE: with
+// a 90 degrees vertical field of view, it sees [-1, 1] vertically
+constexpr float const CAMERA_FOV_Y_DEGREES = 90.0f;
+constexpr float const CAMERA_DISTANCE = 1.0f;
+constexpr float const CAMERA_NEAR = 0.05f;
+
+// Record the CPU draw list on several threads, in secondary command buffers
+constexpr bool const ENABLE_PARALLEL_RECORDING = true;
+// Draws per secondary command buffer, at least
+constexpr uint32_t const MIN_DRAWS_PER_RECORDING_CHUNK = 128;
+// Passes of the CPU draw list (first field of the draw sort keys)
+constexpr uint32_t const DRAW_PASS_DEPTH_PREPASS = 0;
+constexpr uint32_t const DRAW_PASS_MAIN = 1;
+// Log the binds recorded / skipped by the draw list every DRAW_LIST_REPORT_FRAMES frames
+constexpr bool const ENABLE_DRAW_LIST_STATS = false;
+constexpr uint32_t const DRAW_LIST_REPORT_FRAMES = 500;
+
+// Textures whose mip levels are streamed in / out of device memory, on
+// demand, within a budget (lowered to the driver budget when the device
+// supports VK_EXT_memory_budget)
+constexpr uint32_t const STREAMED_TEXTURE_COUNT = 16;
+constexpr uint32_t const STREAMED_TEXTURE_SIZE = 256;
+constexpr VkDeviceSize const TEXTURE_STREAMING_BUDGET = 4 * 1024 * 1024;
+// Log the streaming counters every TEXTURE_STREAMING_REPORT_FRAMES frames
+constexpr bool const ENABLE_TEXTURE_STREAMING_STATS = false;
+constexpr uint32_t const TEXTURE_STREAMING_REPORT_FRAMES = 500;
+
+// Stages reading DrawPushConstants
+constexpr VkShaderStageFlags const DRAW_PUSH_CONSTANT_STAGES = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+
+// Size of the grid of triangles to render
+constexpr uint32_t const SCENE_GRID_COLUMNS = 32;
+constexpr uint32_t const SCENE_GRID_ROWS = 32;
+
+// Cull and submit the draws on the GPU (compute culling + indirect draws)
+// when the device supports it, instead of one vkCmdDrawIndexed per object
+constexpr bool const ENABLE_GPU_DRIVEN_RENDERING = true;
+// GPU-driven path with dynamic rendering: also cull the draws hidden behind
+// the depth buffer, in two phases around a Hi-Z pyramid (see GpuCulling)
+constexpr bool const ENABLE_OCCLUSION_CULLING = true;
+// Log the culled / drawn counts every CULLING_STATS_REPORT_FRAMES frames
+constexpr bool const ENABLE_CULLING_STATS = false;
+constexpr uint32_t const CULLING_STATS_REPORT_FRAMES = 500;
+
+// Draw the meshlet spheres with task / mesh shaders (VK_EXT_mesh_shader)
+// when the device supports it, else with compute culling (GPU-driven
+// path) or CPU culling of the meshlets
+constexpr bool const ENABLE_MESH_SHADING = true;
+// Grid of high polygon spheres behind the triangles, split in meshlets
+constexpr uint32_t const MESHLET_OBJECT_COLUMNS = 6;
+constexpr uint32_t const MESHLET_OBJECT_ROWS = 4;
+constexpr uint32_t const MESHLET_SPHERE_SEGMENTS = 64;
+constexpr uint32_t const MESHLET_SPHERE_RINGS = 32;
+// Meshlets built by a previous run (rebuilt if the sphere changes)
+constexpr const char* MESHLET_CACHE_FILE = "sphere.meshlets";
+
+// Spheres drawn from the scene draw records, with a level of detail
+// selected per frame from the projected error of each level. The levels
+// are simplifications of the meshlet sphere, built at startup.
+// false: always draw the full detail mesh (level 0), for comparison.
+constexpr bool const ENABLE_MESH_LOD = true;
+constexpr uint32_t const MESH_LOD_MAX_LEVELS = 6;
+// Triangles kept by each level, relative to the previous one
+constexpr float const MESH_LOD_REDUCTION = 0.5f;
+constexpr uint32_t const MESH_LOD_MIN_TRIANGLES = 32;
+// The coarsest level whose error projects under this many pixels is drawn
+constexpr float const LOD_ERROR_THRESHOLD_PIXELS = 1.0f;
+// Margin around the threshold before switching levels (0: none)
+constexpr float const LOD_HYSTERESIS = 0.25f;
+// Dithered crossfade between two levels (0: switch at once). Not with the
+// depth pre-pass: it writes the depth of both levels.
+constexpr float const LOD_CROSSFADE_SECONDS = 0.3f;
+// The spheres go away from the camera on a diagonal, swaying along the
+// view axis so that they switch levels
+constexpr uint32_t const LOD_OBJECT_COUNT = 8;
+constexpr float const LOD_OBJECT_SCALE = 1.0f;
+constexpr float const LOD_OBJECT_FIRST_DEPTH = 3.0f;
+constexpr float const LOD_OBJECT_SPACING = 3.0f;
+constexpr float const LOD_OBJECT_SWAY = 1.5f;
+constexpr float const LOD_OBJECT_SWAY_SECONDS = 6.0f;
+
+// Particles simulated and compacted by compute shaders, drawn with an
+// indirect draw: the CPU never touches them
+constexpr uint32_t const PARTICLE_COUNT = 100000;
+// Measure the GPU time of the particle simulation and rendering with each
+// count (the particle system is re-created in between), then log it.
+// Needs timestamp queries. 10M particles take 2 x 320 MB of device memory.
+constexpr bool const ENABLE_PARTICLE_BENCHMARK = false;
+constexpr uint32_t const PARTICLE_BENCHMARK_COUNTS[] = {10000, 100000, 1000000, 10000000};
+// Simulated seconds before measuring: longer than a particle life, so the
+// buffers are full
+constexpr float const PARTICLE_BENCHMARK_WARMUP_SECONDS = 5.0f;
+constexpr uint32_t const PARTICLE_BENCHMARK_FRAMES = 300;
+
+// Point lights binned per cluster of a froxel grid by a compute pass, the
+// fragment shader only shading with the lights of its cluster. Needs 2
+// more bindless storage buffers than the object buffer.
+// false: no lighting, the fragment shader outputs the albedo as before.
+constexpr bool const ENABLE_CLUSTERED_LIGHTING = true;
+constexpr uint32_t const LIGHT_COUNT = 1000;
+// Lights created at startup (LIGHT_COUNT of them are binned)
+constexpr uint32_t const MAX_LIGHT_COUNT = 10000;
+// Random lights in a box around the scene
+const glm::vec3 LIGHT_AREA_MIN = glm::vec3(-4.0f, -3.0f, -8.0f);
+const glm::vec3 LIGHT_AREA_MAX = glm::vec3(4.0f, 3.0f, 0.5f);
+constexpr float const LIGHT_RADIUS = 0.75f;
+constexpr float const LIGHT_INTENSITY = 1.0f;
+constexpr float const LIGHT_AMBIENT = 0.3f;
+// Tiles of 64 x 64 pixels, 24 depth slices up to 100 units away, 256
+// light indices per cluster on average
+constexpr uint32_t const CLUSTER_TILE_SIZE = 64;
+constexpr uint32_t const CLUSTER_DEPTH_SLICES = 24;
+constexpr float const CLUSTER_FAR_DEPTH = 100.0f;
+constexpr uint32_t const CLUSTER_AVERAGE_LIGHTS = 256;
+// Measure the GPU time of the light binning and of the forward pass with
+// each light count, then log it. Needs timestamp queries.
+constexpr bool const ENABLE_LIGHT_BENCHMARK = false;
+constexpr uint32_t const LIGHT_BENCHMARK_COUNTS[] = {1, 10, 100, 1000, 10000};
+constexpr uint32_t const LIGHT_BENCHMARK_FRAMES = 300;
+
+// Timestamp scopes measured per frame (see GpuTimer)
+constexpr uint32_t const GPU_TIMER_MAX_SCOPES = 16;
+constexpr const char* GPU_SCOPE_PARTICLE_SIMULATION = "particle simulation";
+constexpr const char* GPU_SCOPE_PARTICLE_RENDERING = "particle rendering";
+constexpr const char* GPU_SCOPE_LIGHT_CULLING = "light culling";
+constexpr const char* GPU_SCOPE_FORWARD_PASS = "forward pass";
+// The frame, without the upscale with dynamic resolution (see _acquireWaitStage)
+constexpr const char* GPU_SCOPE_FRAME = "frame";
+
+// Count the vertices, primitives and shader invocations of each pass with
+// pipeline statistics queries (if the device supports them): logged every
+// PIPELINE_STATISTICS_REPORT_FRAMES frames and with the benchmark results
+constexpr bool const ENABLE_PIPELINE_STATISTICS = false;
+constexpr uint32_t const PIPELINE_STATISTICS_MAX_PASSES = 16;
+constexpr uint32_t const PIPELINE_STATISTICS_REPORT_FRAMES = 500;
+
+/**
+ * Part of the scene drawn by a forward pass: everything (Single), or with
+ * occlusion culling the early draws then, once the depth pyramid has been
+ * built from them, the late ones on top (see GpuCulling).
+ */
+enum class ForwardPhase {
+    Single,
+    Early,
+    Late,
+};
+
 constexpr const char* ENGINE_NAME = "Frame Engine";
 constexpr uint8_t const ENGINE_MAJOR_VERSION = 0;
 constexpr uint8_t const ENGINE_MINOR_VERSION = 1;
@@ -60,6 +313,10 @@ class TriangleApplication {
     
 public:
     void run() {
+        if (ENABLE_PROFILER) {
+            Profiler::setThreadName("main");
+            Profiler::start();
+        }
         /// Initializes the GLFW library and creates a window with a proper configuration
         initWindow();
         /// Initializes the Vulkan library, and link to the app
@@ -68,6 +325,10 @@ public:
         loop();
         ///  Destroy all created instances
         clean();
+        if (ENABLE_PROFILER) {
+            Profiler::stop();
+            Profiler::writeChromeTrace(PROFILER_TRACE_FILE);
+        }
     }
     
     /// The constructor of the Triangle app / example
@@ -93,6 +354,12 @@ private:
     VkInstance m_vk_instance {};
     // The graphics device
     VkPhysicalDevice m_graphics_device = VK_NULL_HANDLE;
+    // Optional features of the graphics device
+    DeviceCapabilities m_device_capabilities {};
+    // Dynamic rendering path: no render pass nor framebuffers
+    bool m_dynamic_rendering = false;
+    // Raster state set in the command buffer instead of baked in the pipeline
+    bool m_extended_dynamic_state = false;
     // Logical graphics device to communicate with
     VkDevice m_logical_graphics_device = NULL;
     // Stores an handle to the drawing / graphics queue,
@@ -113,27 +380,175 @@ private:
     VkSurfaceFormatKHR m_swap_chain_surface_format;
     // The retrieved and stored extent of our swap chain
     VkExtent2D m_swap_chain_extent;
+    // Multisampled color attachment, resolved to the swap chain image
+    // (only with m_msaa_samples > 1)
+    VkSampleCountFlagBits m_msaa_samples = VK_SAMPLE_COUNT_1_BIT;
+    AllocatedImage m_msaa_color_target;
+    // Depth attachment (reverse-Z), with the sample count of the color one
+    VkFormat m_depth_format = VK_FORMAT_UNDEFINED;
+    AllocatedImage m_depth_target;
+    // Dynamic resolution: the scene is rendered to the m_render_extent
+    // corner of the scene color target (resolved to it with MSAA), then
+    // upscaled to the swap chain image. The targets keep the swap chain
+    // extent, so the scale changes without re-creating anything.
+    // The scene color target is a transient of the frame graph (one per
+    // frame in flight), valid during the execution of the graph.
+    // Without: m_render_extent is the swap chain extent.
+    bool m_dynamic_resolution = false;
+    DynamicResolution m_resolution_controller;
+    FrameGraphResource m_scene_color = FRAME_GRAPH_INVALID_RESOURCE;
+    VkExtent2D m_render_extent {};
+    // Copy of the presented images to the CPU, and the frames read back
+    // since the last report, with their latency summed
+    bool m_readback = false;
+    FrameReadback m_frame_readback;
+    uint32_t m_readback_report_frames = 0;
+    uint64_t m_readback_latency_frames = 0;
+    // Files written from the frames read back
+    bool m_frame_capture = false;
+    CaptureEncoder m_capture_encoder;
+    // Frames drawn since the start
+    uint64_t m_frame_number = 0;
     // The graphics pipeline layout, for
     // uniform values
     VkPipelineLayout m_pipeline_layout;
     // Render pass process
-    VkRenderPass m_render_pass;
+    VkRenderPass m_render_pass = VK_NULL_HANDLE;
     // The graphics pipeline
     VkPipeline m_graphics_pipeline;
+    // Fixed-function state of the graphics pipeline, set dynamically if possible
+    RasterState m_raster_state {};
+    // Optional depth-only pass, drawn before the main one
+    bool m_depth_prepass = false;
+    VkPipeline m_depth_prepass_pipeline = VK_NULL_HANDLE;
+    RasterState m_depth_prepass_raster_state {};
     // Attachments specified during render pass creation
     std::vector<VkFramebuffer> m_swap_chain_framebuffers;
     // Create the command pool to create
     // command buffers
     VkCommandPool m_command_pool;
-    VkCommandBuffer m_command_buffer;
+    // Frame work (culling, uniforms, recording) is spread over its workers
+    JobSystem m_job_system;
+    // Accumulated job times, with ENABLE_JOB_TIMINGS
+    struct JobTiming {
+        double total_ms = 0.0;
+        uint32_t count = 0;
+    };
+    std::map<std::string, JobTiming> m_job_timings;
+    std::mutex m_job_timings_mutex;
+    uint32_t m_timed_frames = 0;
+    // Per-worker, per-frame command pools for the secondary command buffers
+    ParallelCommandRecorder m_parallel_recorder;
+    bool m_parallel_recording = false;
+    // One command buffer per frame in flight
+    std::vector<VkCommandBuffer> m_command_buffers;
+    // Dynamic resolution: the passes from the upscale on, submitted in a
+    // second batch, the only one waiting for the swap chain image
+    std::vector<VkCommandBuffer> m_present_command_buffers;
     // Signal that an image has been acquired from the swapchain
-    // and is ready for rendering
-    VkSemaphore m_image_avail_semaphore;
+    // and is ready for rendering (one per frame in flight)
+    std::vector<VkSemaphore> m_image_avail_semaphores;
     // Signal that rendering has been finished and
-    // presentation can happen
-    VkSemaphore m_render_finished_semaphore;
-    // Make sure only one frame is rendering at a time
-    VkFence m_in_flight_fence;
+    // presentation can happen (one per frame in flight)
+    std::vector<VkSemaphore> m_render_finished_semaphores;
+    // Make sure at most MAX_FRAMES_IN_FLIGHT frames are rendering at a time
+    std::vector<VkFence> m_in_flight_fences;
+    // Index of the frame in flight being recorded
+    uint32_t m_current_frame = 0;
+    // The objects to render, and their GPU buffers
+    Scene m_scene;
+    AllocatedBuffer m_vertex_buffer;
+    AllocatedBuffer m_index_buffer;
+    // ObjectData / DrawRecord storage buffers
+    AllocatedBuffer m_object_buffer;
+    AllocatedBuffer m_draw_buffer;
+    // CPU draw path: draws passing the frustum test this frame
+    std::vector<uint8_t> m_draw_visibility;
+    std::vector<uint32_t> m_visible_draws;
+    // CPU draws of the frame (visible scene draws, CPU path meshlets), sorted by state
+    DrawList m_draw_list;
+    uint32_t m_draw_list_report_frames = 0;
+    // Set 0 of the graphics pipeline: the scene objects
+    VkDescriptorSetLayout m_scene_descriptor_set_layout;
+    VkDescriptorSet m_scene_descriptor_set;
+    // Descriptor sets living as long as the application
+    DescriptorAllocator m_descriptor_allocator;
+    // Descriptor sets living for one frame, reset with the frame fence
+    FrameDescriptorAllocators m_frame_descriptor_allocators;
+    // Set 2 of the graphics pipeline: the per-frame uniforms, with a dynamic offset
+    LinearUniformAllocator m_uniform_allocator;
+    VkDescriptorSetLayout m_frame_descriptor_set_layout;
+    VkDescriptorSet m_frame_descriptor_set;
+    // Set 1 of the graphics pipeline: every texture / sampler / storage buffer
+    BindlessDescriptors m_bindless;
+    std::vector<AllocatedImage> m_textures;
+    std::vector<BindlessHandle> m_texture_handles;
+    VkSampler m_default_sampler;
+    BindlessHandle m_default_sampler_handle = BINDLESS_INVALID_HANDLE;
+    BindlessHandle m_object_buffer_handle = BINDLESS_INVALID_HANDLE;
+    // Mip levels of the streamed textures, loaded from the screen size of the objects
+    MipGenerator m_mip_generator;
+    TextureStreamer m_texture_streamer;
+    uint32_t m_streamed_texture_count = 0;
+    uint32_t m_streaming_report_frames = 0;
+    // GPU-driven path: compute culling + indirect draws
+    GpuCulling m_gpu_culling;
+    bool m_gpu_driven = false;
+    // Two-phase occlusion culling, against the Hi-Z pyramid of the depth target
+    bool m_occlusion_culling = false;
+    DepthPyramid m_depth_pyramid;
+    uint32_t m_culling_report_frames = 0;
+    // Objects drawn by meshlets, and the path culling them
+    MeshletPath m_meshlet_path = MeshletPath::Cpu;
+    MeshletMesh m_meshlet_mesh;
+    std::vector<uint32_t> m_meshlet_objects;
+    MeshletRenderer m_meshlet_renderer;
+    // Objects drawn with a level of detail of the sphere: objects and draws
+    // [m_lod_first_object / m_lod_first_draw, + 2 x m_lod_states.size()),
+    // by pairs: the current level, and the level fading out
+    MeshLodChain m_sphere_lods;
+    std::vector<LodState> m_lod_states;
+    uint32_t m_lod_first_object = 0;
+    uint32_t m_lod_first_draw = 0;
+    bool m_lod_crossfade = false;
+    float m_lod_time = 0.0f;
+    // Mesh shading path: sets 0 to 2 of the scene, plus the meshlet data
+    VkPipelineLayout m_meshlet_pipeline_layout = VK_NULL_HANDLE;
+    VkPipeline m_meshlet_pipeline = VK_NULL_HANDLE;
+    VkPipeline m_meshlet_depth_prepass_pipeline = VK_NULL_HANDLE;
+    // GPU particles, simulated every frame for the time since the previous one
+    ParticleSystem m_particles;
+    std::chrono::steady_clock::time_point m_last_frame_time;
+    float m_frame_delta_time = 0.0f;
+    // ENABLE_PARTICLE_BENCHMARK: count being measured (index in
+    // PARTICLE_BENCHMARK_COUNTS), and the GPU times summed over its frames
+    uint32_t m_particle_benchmark_index = 0;
+    uint32_t m_particle_benchmark_frames = 0;
+    double m_particle_simulation_ms = 0.0;
+    double m_particle_rendering_ms = 0.0;
+    // Point lights of the scene, binned per cluster every frame
+    ClusteredLighting m_lighting;
+    bool m_clustered_lighting = false;
+    // ENABLE_LIGHT_BENCHMARK: count being measured (index in
+    // LIGHT_BENCHMARK_COUNTS), frames to skip before measuring it, and the
+    // GPU times summed over its frames
+    uint32_t m_light_benchmark_index = 0;
+    uint32_t m_light_benchmark_skipped_frames = 0;
+    uint32_t m_light_benchmark_frames = 0;
+    double m_light_culling_ms = 0.0;
+    double m_light_forward_ms = 0.0;
+    // GPU time of the scopes of the frame
+    GpuTimer m_gpu_timer;
+    // Work of the passes of the frame, with ENABLE_PIPELINE_STATISTICS
+    PipelineStatistics m_pipeline_statistics;
+    uint32_t m_statistics_report_frames = 0;
+    // Passes of the frame, with the dynamic rendering path
+    FrameGraph m_frame_graph;
+    // The camera (infinite reverse-Z projection)
+    glm::mat4 m_projection = glm::mat4(1.0f);
+    glm::mat4 m_view = glm::mat4(1.0f);
+    glm::mat4 m_view_proj = glm::mat4(1.0f);
+    glm::vec3 m_camera_position = glm::vec3(0.0f);
     
     VkApplicationInfo _createAppInfo() {
         // Create a Vulkan app info
@@ -297,6 +712,26 @@ private:
             throw std::runtime_error("swapchain support is incorrect on your device");
             return;
         }
+        Log("-> Checking the optional device features... ");
+        m_device_capabilities = queryDeviceCapabilities(m_graphics_device);
+        m_dynamic_rendering = ENABLE_DYNAMIC_RENDERING && m_device_capabilities.dynamic_rendering;
+        Log("-> Rendering path: " << (m_dynamic_rendering ? "dynamic rendering" : "render pass"));
+        m_extended_dynamic_state = useExtendedDynamicState(m_device_capabilities, ENABLE_EXTENDED_DYNAMIC_STATE);
+        Log("-> Extended dynamic state: " << m_extended_dynamic_state);
+        m_msaa_samples = selectSampleCount(m_device_capabilities, MSAA_SAMPLES);
+        Log("-> MSAA: " << m_msaa_samples << " samples (" << MSAA_SAMPLES << " requested)");
+        m_depth_format = findDepthFormat(m_graphics_device);
+        Log("-> Depth format: " << m_depth_format);
+        // Known before the descriptor set layouts, whose stages depend on it
+        m_gpu_driven = ENABLE_GPU_DRIVEN_RENDERING && GpuCulling::isSupported(m_device_capabilities);
+        m_meshlet_path = MeshletRenderer::selectPath(m_device_capabilities, ENABLE_MESH_SHADING, m_gpu_driven);
+        // The passes around the depth pyramid are scheduled by the frame graph
+        m_occlusion_culling = ENABLE_OCCLUSION_CULLING && m_gpu_driven && m_dynamic_rendering && DepthPyramid::isSupported(m_graphics_device, m_device_capabilities, m_depth_format, m_msaa_samples);
+        Log("-> Occlusion culling: " << m_occlusion_culling);
+        // The upscale pass is scheduled by the frame graph, the controller
+        // measures the frames with the GPU timer
+        m_dynamic_resolution = ENABLE_DYNAMIC_RESOLUTION && m_dynamic_rendering && m_device_capabilities.timestamps;
+        Log("-> Dynamic resolution: " << m_dynamic_resolution);
     }
     
     /**
@@ -331,14 +766,17 @@ private:
             ++i;
         }
         
-        // Enable all device features for now
-        // TODO: change to specific features
-        VkPhysicalDeviceFeatures device_features {};
+        // Only enable the (supported) features the renderer uses
+        EnabledDeviceFeatures device_features = selectEnabledFeatures(m_device_capabilities);
+        // The required extensions, and the optional ones the device supports
+        const std::vector<const char*> enabled_extensions = selectEnabledExtensions(m_device_capabilities);
         VkDeviceCreateInfo device_create_info {};
         device_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
         device_create_info.pQueueCreateInfos = queue_create_infos;
         device_create_info.queueCreateInfoCount = static_cast<uint32_t>(queue_families.size()); // Evil statement
-        device_create_info.pEnabledFeatures = &device_features;
+        // Features are given through VkPhysicalDeviceFeatures2, in the pNext chain
+        device_create_info.pNext = device_features.chain();
+        device_create_info.pEnabledFeatures = nullptr;
 #ifdef _ENABLE_COMPATIBILITY_WITH_OLDER_VK_IMPL
         // Enable compatibility with older Vulkan implementations: previous
         // implementations of Vulkan made a distinction between instance and
@@ -351,8 +789,8 @@ private:
         }
         // Enable device extensions, required to use Vulkan
         // on your device
-        device_create_info.enabledExtensionCount = static_cast<uint32_t>(device_extensions.size());
-        device_create_info.ppEnabledExtensionNames = device_extensions.data();
+        device_create_info.enabledExtensionCount = static_cast<uint32_t>(enabled_extensions.size());
+        device_create_info.ppEnabledExtensionNames = enabled_extensions.data();
 #endif // _ENABLE_COMPATIBILITY_WITH_OLDER_VK_IMPL
         if (vkCreateDevice(m_graphics_device, &device_create_info, nullptr, &m_logical_graphics_device) != VK_SUCCESS) {
             throw std::runtime_error("failed to create logical device");
@@ -397,6 +835,31 @@ private:
         swap_chain_create_info.imageExtent = m_swap_chain_extent;
         swap_chain_create_info.imageArrayLayers = 1; // Always one here, as we do not develop something with 3D
         swap_chain_create_info.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT; // Color attachment only
+        if (m_dynamic_resolution) {
+            // The scene color target is blitted to the swap chain image, with linear filtering
+            VkFormatProperties format_properties {};
+            vkGetPhysicalDeviceFormatProperties(m_graphics_device, m_swap_chain_surface_format.format, &format_properties);
+            const VkFormatFeatureFlags blit_features = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+            if ((swap_chain_support.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT) == 0
+                || (format_properties.optimalTilingFeatures & blit_features) != blit_features) {
+                Log("-> The swap chain images can not be blitted to: no dynamic resolution");
+                m_dynamic_resolution = false;
+            } else {
+                swap_chain_create_info.imageUsage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+            }
+        }
+        m_render_extent = m_swap_chain_extent;
+        m_readback = ENABLE_FRAME_READBACK || ENABLE_FRAME_CAPTURE;
+        if (m_readback) {
+            // Copied to the readback buffers
+            if ((swap_chain_support.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) == 0
+                || !FrameReadback::isSupported(m_swap_chain_surface_format.format)) {
+                Log("-> The swap chain images can not be read back: no frame readback");
+                m_readback = false;
+            } else {
+                swap_chain_create_info.imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+            }
+        }
         
         // As graphics queue != present queue, we need to specify how to handle swap chain images
         // that will be used across multiple queue families
@@ -477,44 +940,170 @@ private:
         }
     }
     
+    /**
+     * Attachments living only during the render pass, next to the swap chain images.
+     */
+    void _createRenderTargets() {
+        Log("##########################");
+        Log("Creating render targets...");
+        Log("##########################");
+        if (m_occlusion_culling) {
+            // Stored by the early forward pass, sampled by the depth pyramid
+            m_depth_target = createImage(
+                m_graphics_device,
+                m_logical_graphics_device,
+                m_swap_chain_extent,
+                1,
+                m_msaa_samples,
+                m_depth_format,
+                VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                depthFormatAspect(m_depth_format));
+        } else {
+            // Only used during the pass: never stored
+            m_depth_target = createTransientAttachment(
+                m_graphics_device,
+                m_logical_graphics_device,
+                m_swap_chain_extent,
+                m_msaa_samples,
+                m_depth_format,
+                VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+                depthFormatAspect(m_depth_format));
+        }
+        if (m_dynamic_resolution) {
+            // The scene color target is created by the frame graph
+            DynamicResolutionDesc resolution_desc {};
+            resolution_desc.target_ms = DYNAMIC_RESOLUTION_TARGET_MS;
+            resolution_desc.min_scale = DYNAMIC_RESOLUTION_MIN_SCALE;
+            resolution_desc.max_scale = DYNAMIC_RESOLUTION_MAX_SCALE;
+            resolution_desc.damping = DYNAMIC_RESOLUTION_DAMPING;
+            resolution_desc.interval_frames = DYNAMIC_RESOLUTION_INTERVAL_FRAMES;
+            resolution_desc.latency_frames = MAX_FRAMES_IN_FLIGHT;
+            m_resolution_controller.init(m_swap_chain_extent, resolution_desc);
+            m_render_extent = m_resolution_controller.renderExtent();
+            Log("-> Dynamic resolution: scale in [" << DYNAMIC_RESOLUTION_MIN_SCALE << ", " << DYNAMIC_RESOLUTION_MAX_SCALE << "], " << DYNAMIC_RESOLUTION_TARGET_MS << " ms per frame");
+        }
+        if (m_msaa_samples == VK_SAMPLE_COUNT_1_BIT) {
+            Log("-> No MSAA: rendering directly to the color output");
+            return;
+        }
+        if (m_occlusion_culling) {
+            // The samples are kept between the early and late forward passes
+            m_msaa_color_target = createImage(
+                m_graphics_device,
+                m_logical_graphics_device,
+                m_swap_chain_extent,
+                1,
+                m_msaa_samples,
+                m_swap_chain_surface_format.format,
+                VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                VK_IMAGE_ASPECT_COLOR_BIT);
+            return;
+        }
+        // Resolved in the pass: the samples are never stored
+        m_msaa_color_target = createTransientAttachment(
+            m_graphics_device,
+            m_logical_graphics_device,
+            m_swap_chain_extent,
+            m_msaa_samples,
+            m_swap_chain_surface_format.format,
+            VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+            VK_IMAGE_ASPECT_COLOR_BIT);
+    }
+    
+    /**
+     * The scene is in the z = 0 plane, seen from the front.
+     */
+    void _createCamera() {
+        Log("######################");
+        Log("Creating the camera...");
+        Log("######################");
+        const float aspect = static_cast<float>(m_swap_chain_extent.width) / static_cast<float>(m_swap_chain_extent.height);
+        m_projection = infinitePerspectiveReverseZ(glm::radians(CAMERA_FOV_Y_DEGREES), aspect, CAMERA_NEAR);
+        // y down, like the Vulkan clip space: no flip needed
+        m_camera_position = glm::vec3(0.0f, 0.0f, CAMERA_DISTANCE);
+        m_view = glm::lookAt(m_camera_position, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        m_view_proj = m_projection * m_view;
+    }
+    
     void _createRenderPass() {
         Log("#######################");
         Log("Creating render pass...");
         Log("#######################");
+        if (m_dynamic_rendering) {
+            Log("-> Not needed with dynamic rendering");
+            return;
+        }
+        const bool msaa = m_msaa_samples != VK_SAMPLE_COUNT_1_BIT;
         VkAttachmentDescription color_attachment {};
         color_attachment.format = m_swap_chain_surface_format.format;
-        color_attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+        color_attachment.samples = m_msaa_samples;
         // Clear the values to a constant at the start
         color_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-        // Rendered contents will be stored in memory and can be read later
-        color_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        // Rendered contents will be stored in memory and can be read later,
+        // unless they are resolved to the swap chain image first
+        color_attachment.storeOp = msaa ? VK_ATTACHMENT_STORE_OP_DONT_CARE : VK_ATTACHMENT_STORE_OP_STORE;
         color_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
         color_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
         color_attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        color_attachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        color_attachment.finalLayout = msaa ? VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        
+        // The swap chain image, written by the resolve at the end of the subpass
+        VkAttachmentDescription resolve_attachment {};
+        resolve_attachment.format = m_swap_chain_surface_format.format;
+        resolve_attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+        resolve_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        resolve_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        resolve_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        resolve_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        resolve_attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        resolve_attachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        
+        // Cleared to 0: the far plane with reverse-Z
+        VkAttachmentDescription depth_attachment {};
+        depth_attachment.format = m_depth_format;
+        depth_attachment.samples = m_msaa_samples;
+        depth_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        depth_attachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        depth_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        depth_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        depth_attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        depth_attachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        const VkAttachmentDescription attachments[] = {color_attachment, depth_attachment, resolve_attachment};
         
         VkAttachmentReference color_attachment_ref{};
-        // Our array consists of a single VkAttachmentDescription, so its index is 0
+        // The color attachment is the first VkAttachmentDescription, so its index is 0
         color_attachment_ref.attachment = 0;
         color_attachment_ref.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        VkAttachmentReference depth_attachment_ref{};
+        depth_attachment_ref.attachment = 1;
+        depth_attachment_ref.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        VkAttachmentReference resolve_attachment_ref{};
+        resolve_attachment_ref.attachment = 2;
+        resolve_attachment_ref.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
         
         VkSubpassDescription subpass{};
         subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
         subpass.colorAttachmentCount = 1;
         subpass.pColorAttachments = &color_attachment_ref;
+        subpass.pResolveAttachments = msaa ? &resolve_attachment_ref : nullptr;
+        subpass.pDepthStencilAttachment = &depth_attachment_ref;
         
         VkSubpassDependency dependency {};
         dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
         dependency.dstSubpass = 0;
-        dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-        dependency.srcAccessMask = 0;
-        dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-        dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        // The depth and MSAA color attachments are shared by the frames in
+        // flight: wait for the writes of the previous frame to both
+        dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+        dependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+        dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
         
         VkRenderPassCreateInfo render_pass_info{};
         render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-        render_pass_info.attachmentCount = 1;
-        render_pass_info.pAttachments = &color_attachment;
+        render_pass_info.attachmentCount = msaa ? 3 : 2;
+        render_pass_info.pAttachments = attachments;
         render_pass_info.subpassCount = 1;
         render_pass_info.pSubpasses = &subpass;
         render_pass_info.dependencyCount = 1;
@@ -529,99 +1118,132 @@ private:
         Log("#############################");
         Log("Creating graphics pipeline...");
         Log("#############################"); 
-#ifdef __APPLE__
-        const std::string vertex_shader_filepath = std::string(SHADERS_DIR).append("/").append("vert.spv");
-        const std::string fragment_shader_filepath = std::string(SHADERS_DIR).append("/").append("frag.spv");
-#elif defined _WIN32
-            const std::string vertex_shader_filepath = std::string(SHADERS_DIR).append("\\").append("vert.spv");
-        const std::string fragment_shader_filepath = std::string(SHADERS_DIR).append("\\").append("frag.spv");
-#endif
-        const auto opt_vertex_shader_code = loadShaderFile(vertex_shader_filepath);
-        const auto opt_fragment_shader_code = loadShaderFile(fragment_shader_filepath);
-        if (!opt_vertex_shader_code.has_value() || !opt_fragment_shader_code.has_value()) {
-            std::cout << "vertex / fragment shader code have not been found - make sure to run 'build_shaders' script before";
+        // Pipeline layout
+        VkPipelineLayoutCreateInfo pipeline_layout_info {};
+        pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        // 0: scene objects, 1: bindless resources, 2: frame uniforms
+        const VkDescriptorSetLayout set_layouts[] = {m_scene_descriptor_set_layout, m_bindless.layout(), m_frame_descriptor_set_layout};
+        pipeline_layout_info.setLayoutCount = 3;
+        pipeline_layout_info.pSetLayouts = set_layouts;
+        // Per-draw parameters
+        const VkPushConstantRange push_constant_range = pushConstantRange<DrawPushConstants>(m_device_capabilities, DRAW_PUSH_CONSTANT_STAGES);
+        pipeline_layout_info.pushConstantRangeCount = 1;
+        pipeline_layout_info.pPushConstantRanges = &push_constant_range;
+        
+        if (vkCreatePipelineLayout(m_logical_graphics_device, &pipeline_layout_info, nullptr, &m_pipeline_layout) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create a pipeline layout");
         }
-        assert(opt_vertex_shader_code.has_value() && opt_fragment_shader_code.has_value());
-        assert(opt_vertex_shader_code.value().size() > 0 && opt_vertex_shader_code.value().size() == 1504);
-        assert(opt_fragment_shader_code.value().size() > 0 && opt_fragment_shader_code.value().size() == 572);
         
-        VkShaderModule vertex_shader_module {};
-        {
-            const std::vector<char> vertex_shader_code = opt_vertex_shader_code.value();
-            VkShaderModuleCreateInfo shader_module_create_info {};
-            shader_module_create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-            shader_module_create_info.codeSize = vertex_shader_code.size();
-            shader_module_create_info.pCode = reinterpret_cast<const uint32_t*>(vertex_shader_code.data());
-            if (vkCreateShaderModule(m_logical_graphics_device, &shader_module_create_info, nullptr, &vertex_shader_module) != VK_SUCCESS) {
-                throw std::runtime_error("failed to create shader module for vertex shader!");
-                return;
-            }
+        // Reverse-Z depth test. After a depth pre-pass, the depth buffer already
+        // holds the nearest fragments: only those pass, and are shaded
+        m_depth_prepass = ENABLE_DEPTH_PREPASS;
+        m_raster_state.depth_test = true;
+        m_raster_state.depth_write = !m_depth_prepass;
+        m_raster_state.depth_compare_op = m_depth_prepass ? VK_COMPARE_OP_EQUAL : VK_COMPARE_OP_GREATER;
+        m_depth_prepass_raster_state = m_raster_state;
+        m_depth_prepass_raster_state.depth_write = true;
+        m_depth_prepass_raster_state.depth_compare_op = VK_COMPARE_OP_GREATER;
+        
+        m_graphics_pipeline = _createScenePipeline(m_raster_state, false, false);
+        if (m_depth_prepass) {
+            Log("-> Depth pre-pass enabled");
+            m_depth_prepass_pipeline = _createScenePipeline(m_depth_prepass_raster_state, true, false);
         }
-        VkPipelineShaderStageCreateInfo vert_shader_stage_info {};
-        vert_shader_stage_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-        vert_shader_stage_info.stage = VK_SHADER_STAGE_VERTEX_BIT;
-        vert_shader_stage_info.module = vertex_shader_module;
-        vert_shader_stage_info.pName = "main"; // entrypoint - should be main by default
-        vert_shader_stage_info.pSpecializationInfo = nullptr; // no configuration at pipeline creation
         
-        VkShaderModule fragment_shader_module {};
-        {
-            const std::vector<char> fragment_shader_code = opt_fragment_shader_code.value();
-            VkShaderModuleCreateInfo shader_module_create_info {};
-            shader_module_create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-            shader_module_create_info.codeSize = fragment_shader_code.size();
-            shader_module_create_info.pCode = reinterpret_cast<const uint32_t*>(fragment_shader_code.data());
-            if (vkCreateShaderModule(m_logical_graphics_device, &shader_module_create_info, nullptr, &fragment_shader_module) != VK_SUCCESS) {
-                throw std::runtime_error("failed to create shader module for fragment shader!");
-                return;
-            }
+        if (m_meshlet_path != MeshletPath::MeshShader)
+            return;
+        // Same sets as the scene pipeline, plus the meshlet data
+        const VkDescriptorSetLayout meshlet_set_layouts[] = {m_scene_descriptor_set_layout, m_bindless.layout(), m_frame_descriptor_set_layout, m_meshlet_renderer.descriptorSetLayout()};
+        pipeline_layout_info.setLayoutCount = 4;
+        pipeline_layout_info.pSetLayouts = meshlet_set_layouts;
+        const VkPushConstantRange meshlet_push_constant_range = pushConstantRange<MeshletPushConstants>(m_device_capabilities, MESHLET_PUSH_CONSTANT_STAGES);
+        pipeline_layout_info.pPushConstantRanges = &meshlet_push_constant_range;
+        if (vkCreatePipelineLayout(m_logical_graphics_device, &pipeline_layout_info, nullptr, &m_meshlet_pipeline_layout) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create the meshlet pipeline layout");
         }
-        VkPipelineShaderStageCreateInfo frag_shader_stage_info {};
-        frag_shader_stage_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-        frag_shader_stage_info.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-        frag_shader_stage_info.module = fragment_shader_module;
-        frag_shader_stage_info.pName = "main";
-        frag_shader_stage_info.pSpecializationInfo = nullptr;
-        
-        // Now, create the graphics pipeline stages...
-        VkPipelineShaderStageCreateInfo shader_stages[] = {
-            vert_shader_stage_info,
-            frag_shader_stage_info
+        m_meshlet_pipeline = _createScenePipeline(m_raster_state, false, true);
+        if (m_depth_prepass)
+            m_meshlet_depth_prepass_pipeline = _createScenePipeline(m_depth_prepass_raster_state, true, true);
+    }
+    
+    /**
+     * Pipeline drawing the scene with the given fixed-function state.
+     * depth_only: no fragment shader nor color writes (depth pre-pass).
+     * mesh_shading: task / mesh shaders drawing the meshlets, instead of
+     * the vertex shader (and its vertex input / input assembly state).
+     */
+    VkPipeline _createScenePipeline(const RasterState &raster_state, bool depth_only, bool mesh_shading) {
+        std::vector<VkPipelineShaderStageCreateInfo> shader_stages;
+        std::vector<VkShaderModule> shader_modules;
+        const auto add_stage = [this, &shader_stages, &shader_modules](VkShaderStageFlagBits stage, const char *filename) -> VkPipelineShaderStageCreateInfo& {
+            shader_modules.push_back(createShaderModule(m_logical_graphics_device, filename));
+            VkPipelineShaderStageCreateInfo stage_info {};
+            stage_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+            stage_info.stage = stage;
+            stage_info.module = shader_modules.back();
+            stage_info.pName = "main"; // entrypoint - should be main by default
+            stage_info.pSpecializationInfo = nullptr; // no configuration at pipeline creation
+            shader_stages.push_back(stage_info);
+            return shader_stages.back();
         };
+        if (mesh_shading) {
+            add_stage(VK_SHADER_STAGE_TASK_BIT_EXT, "meshlet_task.spv");
+            add_stage(VK_SHADER_STAGE_MESH_BIT_EXT, "meshlet_mesh.spv");
+        } else {
+            add_stage(VK_SHADER_STAGE_VERTEX_BIT, "vert.spv");
+        }
+        
+        // Size of the bindless arrays, which depends on the device, whether
+        // objects may be drawn during a LOD crossfade, and whether they are lit
+        const uint32_t specialization_data[] = {
+            m_bindless.textureCapacity(),
+            m_bindless.samplerCapacity(),
+            static_cast<VkBool32>(m_lod_crossfade),
+            m_bindless.storageBufferCapacity(),
+            static_cast<VkBool32>(m_clustered_lighting)
+        };
+        constexpr uint32_t specialization_count = static_cast<uint32_t>(std::size(specialization_data));
+        VkSpecializationMapEntry specialization_entries[specialization_count] {};
+        for (uint32_t i = 0; i < specialization_count; i++) {
+            specialization_entries[i].constantID = i;
+            specialization_entries[i].offset = i * sizeof(uint32_t);
+            specialization_entries[i].size = sizeof(uint32_t);
+        }
+        VkSpecializationInfo specialization_info {};
+        specialization_info.mapEntryCount = specialization_count;
+        specialization_info.pMapEntries = specialization_entries;
+        specialization_info.dataSize = sizeof(specialization_data);
+        specialization_info.pData = specialization_data;
+        // The depth pre-pass has no fragment shader. A mesh shading draw
+        // covers several objects: their material handles are not uniform
+        if (!depth_only)
+            add_stage(VK_SHADER_STAGE_FRAGMENT_BIT, mesh_shading ? "frag_nonuniform.spv" : "frag.spv").pSpecializationInfo = &specialization_info;
         
         // Vertex input setup
+        const auto binding_description = Vertex::bindingDescription();
+        const auto attribute_descriptions = Vertex::attributeDescriptions();
         VkPipelineVertexInputStateCreateInfo vertex_input_info {};
         vertex_input_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-        vertex_input_info.vertexBindingDescriptionCount = 0;
-        vertex_input_info.pVertexBindingDescriptions = nullptr;
-        vertex_input_info.vertexAttributeDescriptionCount = 0;
-        vertex_input_info.pVertexAttributeDescriptions = nullptr;
+        vertex_input_info.vertexBindingDescriptionCount = 1;
+        vertex_input_info.pVertexBindingDescriptions = &binding_description;
+        vertex_input_info.vertexAttributeDescriptionCount = static_cast<uint32_t>(attribute_descriptions.size());
+        vertex_input_info.pVertexAttributeDescriptions = attribute_descriptions.data();
         
         // Input assembly setup
         VkPipelineInputAssemblyStateCreateInfo input_assembly_info {};
         input_assembly_info.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-        input_assembly_info.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST; // TODO: change to POINTS_LIST ?
+        input_assembly_info.topology = raster_state.topology; // TODO: change to POINTS_LIST ?
         input_assembly_info.primitiveRestartEnable = VK_FALSE;
         
         // Viewport and scissoring
-        VkViewport viewport {};
-        viewport.x = 0.0f;
-        viewport.y = 0.0f;
-        viewport.height = m_swap_chain_extent.height;
-        viewport.width = m_swap_chain_extent.width;
-        viewport.minDepth = 0.0f;
-        viewport.maxDepth = 1.0f;
-        // Cover the viewport entirely
-        VkRect2D scissor {};
-        scissor.offset = {0, 0};
-        scissor.extent = m_swap_chain_extent;
-        // Combine both in a viewport state
+        // Both are dynamic (set in recordCommandBuffer): the pipeline does
+        // not depend on the swap chain extent
         VkPipelineViewportStateCreateInfo viewport_state {};
         viewport_state.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
         viewport_state.viewportCount = 1;
-        viewport_state.pViewports = &viewport;
+        viewport_state.pViewports = nullptr;
         viewport_state.scissorCount = 1;
-        viewport_state.pScissors = &scissor;
+        viewport_state.pScissors = nullptr;
         
         // Rasterizer configuration
         VkPipelineRasterizationStateCreateInfo rasterization_state_create_info {};
@@ -630,8 +1252,9 @@ private:
         rasterization_state_create_info.rasterizerDiscardEnable = VK_FALSE;
         rasterization_state_create_info.polygonMode = VK_POLYGON_MODE_FILL;
         rasterization_state_create_info.lineWidth = 1.0f;
-        rasterization_state_create_info.cullMode = VK_CULL_MODE_BACK_BIT;
-        rasterization_state_create_info.frontFace = VK_FRONT_FACE_CLOCKWISE;
+        // Ignored with extended dynamic state
+        rasterization_state_create_info.cullMode = raster_state.cull_mode;
+        rasterization_state_create_info.frontFace = raster_state.front_face;
         rasterization_state_create_info.depthBiasEnable = VK_FALSE;
         rasterization_state_create_info.depthBiasConstantFactor = 0.0f;
         rasterization_state_create_info.depthBiasClamp = 0.0f;
@@ -642,7 +1265,7 @@ private:
         VkPipelineMultisampleStateCreateInfo multisample_state_create_info {};
         multisample_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
         multisample_state_create_info.sampleShadingEnable = VK_FALSE;
-        multisample_state_create_info.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+        multisample_state_create_info.rasterizationSamples = m_msaa_samples;
         multisample_state_create_info.minSampleShading = 1.0f;
         multisample_state_create_info.pSampleMask = nullptr;
         multisample_state_create_info.alphaToCoverageEnable = VK_FALSE;
@@ -650,7 +1273,7 @@ private:
         
         // Color blinding
         VkPipelineColorBlendAttachmentState color_blend_attachment {};
-        color_blend_attachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+        color_blend_attachment.colorWriteMask = depth_only ? 0 : VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
         color_blend_attachment.blendEnable = VK_FALSE;
         
         VkPipelineColorBlendStateCreateInfo color_blending{};
@@ -659,68 +1282,77 @@ private:
         color_blending.attachmentCount = 1;
         color_blending.pAttachments = &color_blend_attachment;
         
+        // Depth test (dynamic with extended dynamic state)
+        const VkPipelineDepthStencilStateCreateInfo depth_stencil_state = depthStencilState(raster_state);
+        
         // Dynamic state
-        std::vector<VkDynamicState> dynamic_states = {
-            VK_DYNAMIC_STATE_VIEWPORT,
-            VK_DYNAMIC_STATE_LINE_WIDTH
-        };
+        const std::vector<VkDynamicState> dynamic_states = pipelineDynamicStates(m_extended_dynamic_state, mesh_shading);
         VkPipelineDynamicStateCreateInfo dynamic_state{};
         dynamic_state.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
         dynamic_state.dynamicStateCount = static_cast<uint32_t>(dynamic_states.size());
         dynamic_state.pDynamicStates = dynamic_states.data();
         
-        // Pipeline layout
-        VkPipelineLayoutCreateInfo pipeline_layout_info {};
-        pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-        pipeline_layout_info.setLayoutCount = 0;
-        pipeline_layout_info.pSetLayouts = nullptr;
-        pipeline_layout_info.pushConstantRangeCount = 0;
-        pipeline_layout_info.pPushConstantRanges = nullptr;
-        
-        if (vkCreatePipelineLayout(m_logical_graphics_device, &pipeline_layout_info, nullptr, &m_pipeline_layout) != VK_SUCCESS) {
-            throw std::runtime_error("failed to create a pipeline layout");
-        }
-        
         VkGraphicsPipelineCreateInfo pipeline_info{};
         pipeline_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-        pipeline_info.stageCount = 2;
-        pipeline_info.pStages = shader_stages;
-        pipeline_info.pVertexInputState = &vertex_input_info;
-        pipeline_info.pInputAssemblyState = &input_assembly_info;
+        pipeline_info.stageCount = static_cast<uint32_t>(shader_stages.size());
+        pipeline_info.pStages = shader_stages.data();
+        // Mesh shaders fetch their own vertices
+        pipeline_info.pVertexInputState = mesh_shading ? nullptr : &vertex_input_info;
+        pipeline_info.pInputAssemblyState = mesh_shading ? nullptr : &input_assembly_info;
         pipeline_info.pViewportState = &viewport_state;
         pipeline_info.pRasterizationState = &rasterization_state_create_info;
         pipeline_info.pMultisampleState = &multisample_state_create_info;
-        pipeline_info.pDepthStencilState = nullptr; // Optional
+        pipeline_info.pDepthStencilState = &depth_stencil_state;
         pipeline_info.pColorBlendState = &color_blending;
-        pipeline_info.pDynamicState = nullptr; // Optional
-        pipeline_info.layout = m_pipeline_layout;
-        pipeline_info.renderPass = m_render_pass;
+        pipeline_info.pDynamicState = &dynamic_state;
+        pipeline_info.layout = mesh_shading ? m_meshlet_pipeline_layout : m_pipeline_layout;
+        // With dynamic rendering, the pipeline only needs the attachment formats
+        VkPipelineRenderingCreateInfo pipeline_rendering_info {};
+        pipeline_rendering_info.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+        pipeline_rendering_info.colorAttachmentCount = 1;
+        pipeline_rendering_info.pColorAttachmentFormats = &m_swap_chain_surface_format.format;
+        pipeline_rendering_info.depthAttachmentFormat = m_depth_format;
+        pipeline_rendering_info.stencilAttachmentFormat = VK_FORMAT_UNDEFINED;
+        if (m_dynamic_rendering)
+            pipeline_info.pNext = &pipeline_rendering_info;
+        pipeline_info.renderPass = m_render_pass; // VK_NULL_HANDLE with dynamic rendering
         pipeline_info.subpass = 0;
         pipeline_info.basePipelineHandle = VK_NULL_HANDLE;
         pipeline_info.basePipelineIndex = -1;
         
-        if (vkCreateGraphicsPipelines(m_logical_graphics_device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &m_graphics_pipeline) != VK_SUCCESS) {
-            throw std::runtime_error("failed to create graphics pipeline!");
-        }
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        const VkResult result = vkCreateGraphicsPipelines(m_logical_graphics_device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &pipeline);
         
         // Cleanup the modules
-        vkDestroyShaderModule(m_logical_graphics_device, vertex_shader_module, nullptr);
-        vkDestroyShaderModule(m_logical_graphics_device, fragment_shader_module, nullptr);
+        for (VkShaderModule shader_module: shader_modules)
+            vkDestroyShaderModule(m_logical_graphics_device, shader_module, nullptr);
+        if (result != VK_SUCCESS) {
+            throw std::runtime_error("failed to create graphics pipeline!");
+        }
+        return pipeline;
     }
     
     void _createFramebuffers() {
         Log("########################");
         Log("Creating framebuffers...");
         Log("########################");
+        if (m_dynamic_rendering) {
+            Log("-> Not needed with dynamic rendering");
+            return;
+        }
         m_swap_chain_framebuffers.resize(m_swap_chain_image_views.size());
         for (size_t i = 0; i < m_swap_chain_image_views.size(); i++) {
+            // With MSAA, the swap chain image is the resolve attachment
+            const bool msaa = m_msaa_samples != VK_SAMPLE_COUNT_1_BIT;
             VkImageView attachments[] = {
+                msaa ? m_msaa_color_target.view : m_swap_chain_image_views[i],
+                m_depth_target.view,
                 m_swap_chain_image_views[i]
             };
             VkFramebufferCreateInfo framebuffer_info {};
             framebuffer_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
             framebuffer_info.renderPass = m_render_pass;
-            framebuffer_info.attachmentCount = 1;
+            framebuffer_info.attachmentCount = msaa ? 3 : 2;
             framebuffer_info.pAttachments = attachments;
             framebuffer_info.width = m_swap_chain_extent.width;
             framebuffer_info.height = m_swap_chain_extent.height;
@@ -753,19 +1385,504 @@ private:
         }
     }
     
-    void _createCommandBuffer() {
+    void _createJobSystem() {
         Log("##########################");
-        Log("Creating command buffer...");
+        Log("Creating the job system...");
         Log("##########################");
+        const uint32_t hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+        m_job_system.init(std::min(hardware_threads, MAX_JOB_WORKERS));
+        if (ENABLE_JOB_TIMINGS) {
+            m_job_system.setTimingHook([this](const char *name, uint32_t, double milliseconds) {
+                std::lock_guard<std::mutex> lock(m_job_timings_mutex);
+                JobTiming &timing = m_job_timings[name];
+                timing.total_ms += milliseconds;
+                timing.count++;
+            });
+        }
+    }
+    
+    void _createParallelRecorder() {
+        Log("#########################################");
+        Log("Creating the parallel command recorder...");
+        Log("#########################################");
+        m_parallel_recording = ENABLE_PARALLEL_RECORDING && m_job_system.workerCount() > 1;
+        if (!m_parallel_recording) {
+            Log("-> Disabled: recording on the main thread only");
+            return;
+        }
+        QueueFamilyIndices queue_family_indices = findQueueFamilies(m_graphics_device, m_surface);
+        m_parallel_recorder.init(
+            m_logical_graphics_device,
+            queue_family_indices.graphics_family.value(),
+            m_job_system,
+            MAX_FRAMES_IN_FLIGHT);
+    }
+    
+    void _createSceneDescriptorSetLayout() {
+        Log("###########################################");
+        Log("Creating the scene descriptor set layout...");
+        Log("###########################################");
+        // The objects are read by the vertex shader, with gl_InstanceIndex
+        // (and by the task / mesh shaders on the mesh shading path)
+        VkDescriptorSetLayoutBinding object_binding {};
+        object_binding.binding = 0;
+        object_binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        object_binding.descriptorCount = 1;
+        object_binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | _meshShadingStages();
+
+        VkDescriptorSetLayoutCreateInfo layout_info {};
+        layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layout_info.bindingCount = 1;
+        layout_info.pBindings = &object_binding;
+        if (vkCreateDescriptorSetLayout(m_logical_graphics_device, &layout_info, nullptr, &m_scene_descriptor_set_layout) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create the scene descriptor set layout");
+        }
+    }
+
+    void _createTextures() {
+        Log("########################");
+        Log("Creating the textures...");
+        Log("########################");
+        VkSamplerCreateInfo sampler_info {};
+        sampler_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+        sampler_info.magFilter = VK_FILTER_NEAREST;
+        sampler_info.minFilter = VK_FILTER_NEAREST;
+        sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        sampler_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        sampler_info.maxLod = VK_LOD_CLAMP_NONE;
+        if (vkCreateSampler(m_logical_graphics_device, &sampler_info, nullptr, &m_default_sampler) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create the default sampler");
+        }
+        
+        // A white texture, which keeps the vertex colors as is, and a checkerboard
+        const uint32_t white_pixel = 0xFFFFFFFF;
+        m_textures.push_back(createTextureImage(m_graphics_device, m_logical_graphics_device, m_command_pool, m_graphics_queue, &white_pixel, {1, 1}));
+        constexpr uint32_t checker_size = 8;
+        std::vector<uint32_t> checker_pixels(checker_size * checker_size);
+        for (uint32_t y = 0; y < checker_size; y++) {
+            for (uint32_t x = 0; x < checker_size; x++)
+                checker_pixels[y * checker_size + x] = ((x + y) % 2 == 0) ? 0xFFFFFFFF : 0xFF404040;
+        }
+        m_textures.push_back(createTextureImage(m_graphics_device, m_logical_graphics_device, m_command_pool, m_graphics_queue, checker_pixels.data(), {checker_size, checker_size}));
+    }
+    
+    void _createBindlessDescriptors() {
+        Log("#######################################");
+        Log("Creating the bindless descriptor set...");
+        Log("#######################################");
+        m_bindless.init(m_logical_graphics_device, m_device_capabilities, MAX_FRAMES_IN_FLIGHT);
+        // The first registered resources are the defaults of the fallback path
+        for (const AllocatedImage &texture: m_textures)
+            m_texture_handles.push_back(m_bindless.registerTexture(texture.view));
+        m_default_sampler_handle = m_bindless.registerSampler(m_default_sampler);
+    }
+    
+    void _createMipGenerator() {
+        Log("#############################");
+        Log("Creating the mip generator...");
+        Log("#############################");
+        m_mip_generator.init(m_graphics_device, m_logical_graphics_device, m_device_capabilities, MAX_FRAMES_IN_FLIGHT);
+    }
+    
+    void _createTextureStreamer() {
+        Log("################################");
+        Log("Creating the texture streamer...");
+        Log("################################");
+        m_texture_streamer.init(m_graphics_device, m_logical_graphics_device, m_device_capabilities, m_bindless, m_mip_generator, TEXTURE_STREAMING_BUDGET, MAX_FRAMES_IN_FLIGHT);
+        // A streamed texture holds its handle, plus the ones of its previous
+        // images while the frames in flight may sample them (a switch per frame at most)
+        const uint32_t free_handles = m_bindless.textureCapacity() - static_cast<uint32_t>(m_texture_handles.size());
+        m_streamed_texture_count = std::min({STREAMED_TEXTURE_COUNT, MAX_STREAMED_TEXTURES, free_handles / (MAX_FRAMES_IN_FLIGHT + 1)});
+        
+        // Checkerboards of a different color and frequency each, so that
+        // the mip levels are told apart on screen
+        std::vector<uint32_t> pixels(STREAMED_TEXTURE_SIZE * STREAMED_TEXTURE_SIZE);
+        for (uint32_t i = 0; i < m_streamed_texture_count; i++) {
+            const uint32_t color = 0xFF000000 | ((i * 0x3Fu + 0x40) & 0xFF) << 16 | ((0xFF - i * 0x25u) & 0xFF) << 8 | ((i * 0x5Bu + 0x80) & 0xFF);
+            const uint32_t square_size = 2u << (i % 5);
+            for (uint32_t y = 0; y < STREAMED_TEXTURE_SIZE; y++) {
+                for (uint32_t x = 0; x < STREAMED_TEXTURE_SIZE; x++)
+                    pixels[y * STREAMED_TEXTURE_SIZE + x] = ((x / square_size + y / square_size) % 2 == 0) ? color : 0xFFFFFFFF;
+            }
+            m_texture_streamer.addTexture(m_command_pool, m_graphics_queue, pixels.data(), {STREAMED_TEXTURE_SIZE, STREAMED_TEXTURE_SIZE});
+        }
+        Log("-> " << m_streamed_texture_count << " streamed textures of " << STREAMED_TEXTURE_SIZE << "x" << STREAMED_TEXTURE_SIZE);
+    }
+    
+    void _createSceneBuffers() {
+        Log("#############################");
+        Log("Creating the scene buffers...");
+        Log("#############################");
+        m_scene = buildTriangleGridScene(SCENE_GRID_COLUMNS, SCENE_GRID_ROWS, m_texture_handles, m_streamed_texture_count, m_default_sampler_handle);
+        const MeshRange sphere = appendSphereMesh(m_scene, MESHLET_SPHERE_SEGMENTS, MESHLET_SPHERE_RINGS);
+        _addMeshletObjects(sphere);
+        _addLodObjects(sphere);
+        Log("-> " << m_scene.objects.size() << " objects, " << m_scene.draws.size() << " draws");
+        // Geometry never changes: keep it in device local memory
+        m_vertex_buffer = createDeviceLocalBuffer(
+            m_graphics_device,
+            m_logical_graphics_device,
+            m_command_pool,
+            m_graphics_queue,
+            m_scene.vertices.data(),
+            sizeof(Vertex) * m_scene.vertices.size(),
+            // The mesh shaders read the vertices as a storage buffer
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | (m_meshlet_path == MeshletPath::MeshShader ? VK_BUFFER_USAGE_STORAGE_BUFFER_BIT : 0));
+        m_index_buffer = createDeviceLocalBuffer(
+            m_graphics_device,
+            m_logical_graphics_device,
+            m_command_pool,
+            m_graphics_queue,
+            m_scene.indices.data(),
+            sizeof(uint32_t) * m_scene.indices.size(),
+            VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+        // Objects / draws may be updated by the CPU: keep them host visible.
+        // The LOD objects are updated in the command buffer (transfer destination).
+        const VkMemoryPropertyFlags host_memory = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+        const VkBufferUsageFlags scene_usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        m_object_buffer = createBuffer(m_graphics_device, m_logical_graphics_device, sizeof(ObjectData) * m_scene.objects.size(), scene_usage, host_memory);
+        memcpy(m_object_buffer.mapped, m_scene.objects.data(), sizeof(ObjectData) * m_scene.objects.size());
+        m_draw_buffer = createBuffer(m_graphics_device, m_logical_graphics_device, sizeof(DrawRecord) * m_scene.draws.size(), scene_usage, host_memory);
+        memcpy(m_draw_buffer.mapped, m_scene.draws.data(), sizeof(DrawRecord) * m_scene.draws.size());
+        // Also reachable from any shader through the bindless set
+        m_object_buffer_handle = m_bindless.registerStorageBuffer(m_object_buffer.buffer);
+    }
+
+    /**
+     * Append the objects of the sphere mesh drawn by the meshlet renderer,
+     * behind the triangles (not from the scene draw records).
+     */
+    void _addMeshletObjects(const MeshRange &sphere) {
+        m_meshlet_mesh = loadOrBuildMeshlets(MESHLET_CACHE_FILE, m_scene, sphere);
+        constexpr float extent_x = 3.0f;
+        constexpr float extent_y = 2.0f;
+        const float cell_width = extent_x / static_cast<float>(MESHLET_OBJECT_COLUMNS);
+        const float cell_height = extent_y / static_cast<float>(MESHLET_OBJECT_ROWS);
+        const float scale = 0.9f * std::min(cell_width, cell_height);
+        for (uint32_t y = 0; y < MESHLET_OBJECT_ROWS; y++) {
+            for (uint32_t x = 0; x < MESHLET_OBJECT_COLUMNS; x++) {
+                ObjectData object {};
+                object.position_scale = glm::vec4(
+                    -extent_x / 2.0f + (x + 0.5f) * cell_width,
+                    -extent_y / 2.0f + (y + 0.5f) * cell_height,
+                    -0.5f,
+                    scale);
+                object.bounds = glm::vec4(0.0f, 0.0f, 0.0f, 0.5f);
+                // The white texture: the vertex colors show the normals
+                object.material = glm::uvec4(m_texture_handles[0], m_default_sampler_handle, 0, 0);
+                m_meshlet_objects.push_back(static_cast<uint32_t>(m_scene.objects.size()));
+                m_scene.objects.push_back(object);
+            }
+        }
+    }
+
+    /**
+     * Build the levels of detail of the sphere mesh, and append the objects
+     * drawn with them (two objects / draws each, see m_lod_states).
+     */
+    void _addLodObjects(const MeshRange &sphere) {
+        m_sphere_lods = buildMeshLods(m_scene, sphere, MESH_LOD_MAX_LEVELS, MESH_LOD_REDUCTION, MESH_LOD_MIN_TRIANGLES);
+        for (size_t i = 0; i < m_sphere_lods.levels.size(); i++)
+            Log("-> Sphere LOD " << i << ": " << m_sphere_lods.levels[i].range.index_count / 3 << " triangles, error " << m_sphere_lods.levels[i].error);
+        m_lod_crossfade = ENABLE_MESH_LOD && LOD_CROSSFADE_SECONDS > 0.0f && !ENABLE_DEPTH_PREPASS;
+        m_lod_first_object = static_cast<uint32_t>(m_scene.objects.size());
+        m_lod_first_draw = static_cast<uint32_t>(m_scene.draws.size());
+        m_lod_states.assign(LOD_OBJECT_COUNT, LodState {});
+        const MeshRange &full_detail = m_sphere_lods.levels[0].range;
+        for (uint32_t i = 0; i < LOD_OBJECT_COUNT; i++) {
+            ObjectData object {};
+            object.position_scale = glm::vec4(_lodObjectPosition(i), LOD_OBJECT_SCALE);
+            object.bounds = glm::vec4(0.0f, 0.0f, 0.0f, 0.5f);
+            object.material = glm::uvec4(m_texture_handles[0], m_default_sampler_handle, 0, 0);
+            // The level fading out: nothing to draw until a crossfade
+            for (uint32_t fading_out = 0; fading_out < 2; fading_out++) {
+                const uint32_t object_index = static_cast<uint32_t>(m_scene.objects.size());
+                m_scene.draws.push_back({fading_out ? 0 : full_detail.index_count, full_detail.first_index, full_detail.vertex_offset, object_index});
+                m_scene.objects.push_back(object);
+            }
+        }
+    }
+    
+    /**
+     * Position of the LOD object i, at the current LOD time.
+     */
+    glm::vec3 _lodObjectPosition(uint32_t i) const {
+        const float phase = glm::two_pi<float>() * m_lod_time / LOD_OBJECT_SWAY_SECONDS + static_cast<float>(i);
+        const float view_depth = LOD_OBJECT_FIRST_DEPTH + LOD_OBJECT_SPACING * static_cast<float>(i) + LOD_OBJECT_SWAY * std::sin(phase);
+        // The camera looks down -z from CAMERA_DISTANCE
+        return glm::vec3(0.5f * view_depth, 0.25f * view_depth, CAMERA_DISTANCE - view_depth);
+    }
+    
+    void _createDescriptorAllocators() {
+        Log("#####################################");
+        Log("Creating the descriptor allocators...");
+        Log("#####################################");
+        // Descriptors reserved per set, in each pool
+        const std::vector<PoolSizeRatio> ratios = {
+            {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4.0f},
+            {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1.0f},
+            {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.0f},
+            {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1.0f},
+            {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.0f}
+        };
+        m_descriptor_allocator.init(m_logical_graphics_device, 16, ratios);
+        m_frame_descriptor_allocators.init(m_logical_graphics_device, MAX_FRAMES_IN_FLIGHT, 64, ratios);
+    }
+    
+    void _createSceneDescriptorSet() {
+        Log("####################################");
+        Log("Creating the scene descriptor set...");
+        Log("####################################");
+        m_scene_descriptor_set = m_descriptor_allocator.allocate(m_logical_graphics_device, m_scene_descriptor_set_layout);
+
+        VkDescriptorBufferInfo object_buffer_info {};
+        object_buffer_info.buffer = m_object_buffer.buffer;
+        object_buffer_info.offset = 0;
+        object_buffer_info.range = VK_WHOLE_SIZE;
+        VkWriteDescriptorSet write {};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = m_scene_descriptor_set;
+        write.dstBinding = 0;
+        write.descriptorCount = 1;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        write.pBufferInfo = &object_buffer_info;
+        vkUpdateDescriptorSets(m_logical_graphics_device, 1, &write, 0, nullptr);
+    }
+
+    void _createFrameUniforms() {
+        Log("##############################");
+        Log("Creating the frame uniforms...");
+        Log("##############################");
+        m_uniform_allocator.init(m_graphics_device, m_logical_graphics_device, m_device_capabilities, MAX_FRAMES_IN_FLIGHT, UNIFORM_BYTES_PER_FRAME);
+        
+        VkDescriptorSetLayoutBinding frame_binding {};
+        frame_binding.binding = 0;
+        frame_binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        frame_binding.descriptorCount = 1;
+        frame_binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT | _meshShadingStages();
+        VkDescriptorSetLayoutCreateInfo layout_info {};
+        layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layout_info.bindingCount = 1;
+        layout_info.pBindings = &frame_binding;
+        if (vkCreateDescriptorSetLayout(m_logical_graphics_device, &layout_info, nullptr, &m_frame_descriptor_set_layout) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create the frame descriptor set layout");
+        }
+        
+        // Written once: each frame only changes the dynamic offset
+        m_frame_descriptor_set = m_descriptor_allocator.allocate(m_logical_graphics_device, m_frame_descriptor_set_layout);
+        VkDescriptorBufferInfo uniform_buffer_info {};
+        uniform_buffer_info.buffer = m_uniform_allocator.buffer();
+        uniform_buffer_info.offset = 0;
+        uniform_buffer_info.range = sizeof(FrameUniforms);
+        VkWriteDescriptorSet write {};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = m_frame_descriptor_set;
+        write.dstBinding = 0;
+        write.descriptorCount = 1;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        write.pBufferInfo = &uniform_buffer_info;
+        vkUpdateDescriptorSets(m_logical_graphics_device, 1, &write, 0, nullptr);
+    }
+    
+    /**
+     * Stages of the scene sets also read on the mesh shading path.
+     */
+    VkShaderStageFlags _meshShadingStages() const {
+        return m_meshlet_path == MeshletPath::MeshShader ? VK_SHADER_STAGE_TASK_BIT_EXT | VK_SHADER_STAGE_MESH_BIT_EXT : 0;
+    }
+    
+    void _createMeshletRenderer() {
+        Log("################################");
+        Log("Creating the meshlet renderer...");
+        Log("################################");
+        m_meshlet_renderer.init(
+            m_graphics_device,
+            m_logical_graphics_device,
+            m_device_capabilities,
+            m_command_pool,
+            m_graphics_queue,
+            m_descriptor_allocator,
+            m_meshlet_path,
+            m_meshlet_mesh,
+            m_meshlet_objects,
+            m_object_buffer,
+            m_vertex_buffer,
+            MAX_FRAMES_IN_FLIGHT);
+    }
+    
+    void _initGpuCulling() {
+        Log("###########################");
+        Log("Initializing GPU culling...");
+        Log("###########################");
+        if (!m_gpu_driven) {
+            Log("-> GPU-driven rendering disabled or not supported: falling back to CPU draws");
+            return;
+        }
+        m_gpu_culling.init(
+            m_graphics_device,
+            m_logical_graphics_device,
+            m_device_capabilities,
+            m_object_buffer,
+            m_draw_buffer,
+            static_cast<uint32_t>(m_scene.draws.size()),
+            MAX_FRAMES_IN_FLIGHT,
+            m_occlusion_culling);
+    }
+    
+    void _createDepthPyramid() {
+        Log("#############################");
+        Log("Creating the depth pyramid...");
+        Log("#############################");
+        if (!m_occlusion_culling) {
+            Log("-> Occlusion culling disabled or not supported");
+            return;
+        }
+        m_depth_pyramid.init(m_graphics_device, m_logical_graphics_device, m_device_capabilities, m_depth_target, m_msaa_samples);
+    }
+    
+    void _createGpuTimer() {
+        Log("#########################");
+        Log("Creating the GPU timer...");
+        Log("#########################");
+        // The scopes are submitted to the graphics queue
+        const uint32_t graphics_family = findQueueFamilies(m_graphics_device, m_surface).graphics_family.value();
+        uint32_t family_count = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(m_graphics_device, &family_count, nullptr);
+        std::vector<VkQueueFamilyProperties> queue_families(family_count);
+        vkGetPhysicalDeviceQueueFamilyProperties(m_graphics_device, &family_count, queue_families.data());
+        m_gpu_timer.init(m_logical_graphics_device, m_device_capabilities, queue_families[graphics_family].timestampValidBits, MAX_FRAMES_IN_FLIGHT, GPU_TIMER_MAX_SCOPES);
+        if (ENABLE_PARTICLE_BENCHMARK && !m_gpu_timer.enabled())
+            Log("-> No timestamp queries: the particle benchmark is disabled");
+        if (ENABLE_LIGHT_BENCHMARK && !m_gpu_timer.enabled())
+            Log("-> No timestamp queries: the light benchmark is disabled");
+    }
+    
+    void _createPipelineStatistics() {
+        Log("###########################################");
+        Log("Creating the pipeline statistics queries...");
+        Log("###########################################");
+        if (!ENABLE_PIPELINE_STATISTICS) {
+            Log("-> Disabled");
+            return;
+        }
+        m_pipeline_statistics.init(m_logical_graphics_device, m_device_capabilities, MAX_FRAMES_IN_FLIGHT, PIPELINE_STATISTICS_MAX_PASSES);
+        if (m_pipeline_statistics.enabled() && m_parallel_recording && !m_device_capabilities.inherited_queries)
+            Log("-> No inheritedQueries: the draws are recorded on the main thread");
+    }
+    
+    void _createFrameReadback() {
+        Log("##############################");
+        Log("Creating the frame readback...");
+        Log("##############################");
+        if (!m_readback) {
+            Log("-> Disabled");
+            return;
+        }
+        m_frame_readback.init(m_graphics_device, m_logical_graphics_device, m_swap_chain_extent, m_swap_chain_surface_format.format, FRAME_READBACK_BUFFERS, [this](const FrameCapture &capture) {
+            _consumeFrameCapture(capture);
+        });
+        if (!ENABLE_FRAME_CAPTURE)
+            return;
+        CaptureEncoderDesc capture_desc {};
+        capture_desc.directory = CAPTURE_DIRECTORY;
+        capture_desc.format = CAPTURE_FILE_FORMAT;
+        capture_desc.backpressure = CAPTURE_BACKPRESSURE;
+        capture_desc.thread_count = CAPTURE_ENCODER_THREADS;
+        capture_desc.queue_capacity = CAPTURE_QUEUE_CAPACITY;
+        capture_desc.max_frames = CAPTURE_MAX_FRAMES;
+        m_capture_encoder.init(capture_desc, m_swap_chain_extent);
+        m_frame_capture = true;
+    }
+    
+    void _createParticleSystem() {
+        Log("###############################");
+        Log("Creating the particle system...");
+        Log("###############################");
+        ParticleRenderTarget render_target {};
+        render_target.render_pass = m_render_pass; // VK_NULL_HANDLE with dynamic rendering
+        render_target.color_format = m_swap_chain_surface_format.format;
+        render_target.depth_format = m_depth_format;
+        render_target.samples = m_msaa_samples;
+        const uint32_t capacity = ENABLE_PARTICLE_BENCHMARK ? PARTICLE_BENCHMARK_COUNTS[m_particle_benchmark_index] : PARTICLE_COUNT;
+        m_particles.init(m_graphics_device, m_logical_graphics_device, m_device_capabilities, m_command_pool, m_graphics_queue, render_target, capacity);
+        m_last_frame_time = std::chrono::steady_clock::now();
+    }
+    
+    void _createClusteredLighting() {
+        Log("##################################");
+        Log("Creating the clustered lighting...");
+        Log("##################################");
+        if (!ENABLE_CLUSTERED_LIGHTING) {
+            Log("-> Disabled: the fragment shader outputs the albedo");
+            return;
+        }
+        if (m_bindless.storageBufferCapacity() < 3) {
+            Log("-> Not enough bindless storage buffers: no lighting");
+            return;
+        }
+        // Same lights from run to run
+        std::mt19937 generator(42);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        std::vector<PointLight> lights(MAX_LIGHT_COUNT);
+        for (PointLight &light: lights) {
+            const glm::vec3 position = glm::mix(LIGHT_AREA_MIN, LIGHT_AREA_MAX, glm::vec3(unit(generator), unit(generator), unit(generator)));
+            light.position_radius = glm::vec4(position, LIGHT_RADIUS);
+            light.color = glm::vec4(glm::vec3(unit(generator), unit(generator), unit(generator)) * LIGHT_INTENSITY, 0.0f);
+        }
+        ClusterGridDesc grid {};
+        grid.tile_size = CLUSTER_TILE_SIZE;
+        grid.depth_slices = CLUSTER_DEPTH_SLICES;
+        grid.far_depth = CLUSTER_FAR_DEPTH;
+        grid.index_capacity_per_cluster = CLUSTER_AVERAGE_LIGHTS;
+        const uint32_t light_count = ENABLE_LIGHT_BENCHMARK ? LIGHT_BENCHMARK_COUNTS[0] : LIGHT_COUNT;
+        m_lighting.init(m_graphics_device, m_logical_graphics_device, m_device_capabilities, m_command_pool, m_graphics_queue, m_bindless, m_swap_chain_extent, CAMERA_NEAR, grid, lights, light_count, MAX_FRAMES_IN_FLIGHT);
+        m_clustered_lighting = true;
+    }
+    
+    void _createFrameGraph() {
+        Log("#######################");
+        Log("Creating frame graph...");
+        Log("#######################");
+        if (!m_dynamic_rendering) {
+            Log("-> Not used with the render pass: one pass, hand-written dependency");
+            return;
+        }
+        m_frame_graph.init(m_graphics_device, m_device_capabilities, MAX_FRAMES_IN_FLIGHT);
+        if (m_pipeline_statistics.enabled()) {
+            // Every pass is counted, outside of its render pass
+            m_frame_graph.setPassHooks(
+                [this](VkCommandBuffer command_buffer, const std::string &name) {
+                    return m_pipeline_statistics.begin(command_buffer, name);
+                },
+                [this](VkCommandBuffer command_buffer, uint32_t scope) {
+                    m_pipeline_statistics.end(command_buffer, scope);
+                });
+        }
+    }
+
+    void _createCommandBuffers() {
+        Log("###########################");
+        Log("Creating command buffers...");
+        Log("###########################");
         VkCommandBufferAllocateInfo command_buffer_alloc_info {};
         command_buffer_alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
         command_buffer_alloc_info.commandPool = m_command_pool;
         // VK_COMMAND_BUFFER_LEVEL_PRIMARY = can be submitted to a queue for
         // execution, but cannot be called from other command buffers.
         command_buffer_alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-        command_buffer_alloc_info.commandBufferCount = 1;
+        command_buffer_alloc_info.commandBufferCount = MAX_FRAMES_IN_FLIGHT;
         
-        if (vkAllocateCommandBuffers(m_logical_graphics_device, &command_buffer_alloc_info, &m_command_buffer) != VK_SUCCESS) {
+        m_command_buffers.resize(MAX_FRAMES_IN_FLIGHT);
+        if (vkAllocateCommandBuffers(m_logical_graphics_device, &command_buffer_alloc_info, m_command_buffers.data()) != VK_SUCCESS) {
+            Log("failed to create command buffer!");
+            throw std::runtime_error("failed to create command buffer!");
+        }
+        if (!m_dynamic_resolution)
+            return;
+        m_present_command_buffers.resize(MAX_FRAMES_IN_FLIGHT);
+        if (vkAllocateCommandBuffers(m_logical_graphics_device, &command_buffer_alloc_info, m_present_command_buffers.data()) != VK_SUCCESS) {
             Log("failed to create command buffer!");
             throw std::runtime_error("failed to create command buffer!");
         }
@@ -787,49 +1904,1011 @@ private:
         // Using this flag, the program will not wait forever for
         // an image that does not exist...
         fence_create_info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-        if (vkCreateSemaphore(m_logical_graphics_device, &semaphore_create_info, nullptr, &m_image_avail_semaphore) != VK_SUCCESS) {
-            LogE("failed to create semaphore for image availability");
-            throw std::runtime_error("failed to create semaphore for image availability");
+        m_image_avail_semaphores.resize(MAX_FRAMES_IN_FLIGHT);
+        m_render_finished_semaphores.resize(MAX_FRAMES_IN_FLIGHT);
+        m_in_flight_fences.resize(MAX_FRAMES_IN_FLIGHT);
+        for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+            if (vkCreateSemaphore(m_logical_graphics_device, &semaphore_create_info, nullptr, &m_image_avail_semaphores[i]) != VK_SUCCESS) {
+                LogE("failed to create semaphore for image availability");
+                throw std::runtime_error("failed to create semaphore for image availability");
+                return;
+            }
+            if (vkCreateSemaphore(m_logical_graphics_device, &semaphore_create_info, nullptr, &m_render_finished_semaphores[i]) != VK_SUCCESS) {
+                LogE("failed to create semaphore for finished render");
+                throw std::runtime_error("failed to create semaphore for finished render");
+                return;
+            }
+            if (vkCreateFence(m_logical_graphics_device, &fence_create_info, nullptr, &m_in_flight_fences[i]) != VK_SUCCESS) {
+                LogE("failed to create the fence for image synchronization");
+                throw std::runtime_error("failed to create the fence for image synchronization");
+            }
+        }
+    }
+    
+    /**
+     * Set the per-draw parameters of the next draws, without any
+     * descriptor update nor buffer write.
+     */
+    void _pushDrawConstants(VkCommandBuffer command_buffer, uint32_t object_index, BindlessHandle texture_handle) {
+        DrawPushConstants draw_constants {};
+        draw_constants.object_index = object_index;
+        draw_constants.texture_handle = texture_handle;
+        pushConstants(command_buffer, m_pipeline_layout, DRAW_PUSH_CONSTANT_STAGES, draw_constants);
+    }
+    
+    /**
+     * Begin rendering to the swap chain image, with a render pass or
+     * with dynamic rendering. The early phase keeps its attachments for
+     * the late one, which loads them (dynamic rendering only).
+     */
+    void _beginRendering(VkCommandBuffer command_buffer, uint32_t image_index, bool secondary_command_buffers, ForwardPhase phase) {
+        VkClearValue clear_color = {{{0.0f, 0.0f, 0.0f, 1.0f}}};
+        // Reverse-Z: 0 is the far plane
+        VkClearValue clear_depth {};
+        clear_depth.depthStencil = {0.0f, 0};
+        if (m_dynamic_rendering) {
+            // Layout transitions are done by the frame graph
+            const VkImageView output_view = m_dynamic_resolution ? m_frame_graph.imageView(m_scene_color) : m_swap_chain_image_views[image_index];
+            VkRenderingAttachmentInfo color_attachment {};
+            color_attachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+            color_attachment.imageView = output_view;
+            color_attachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            const VkAttachmentLoadOp load_op = phase == ForwardPhase::Late ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_CLEAR;
+            color_attachment.loadOp = load_op;
+            color_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+            color_attachment.clearValue = clear_color;
+            if (m_msaa_samples != VK_SAMPLE_COUNT_1_BIT) {
+                // Render the samples, average them in the color output at
+                // the end of the (last) pass, and drop them
+                color_attachment.imageView = m_msaa_color_target.view;
+                if (phase != ForwardPhase::Early) {
+                    color_attachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+                    color_attachment.resolveMode = VK_RESOLVE_MODE_AVERAGE_BIT;
+                    color_attachment.resolveImageView = output_view;
+                    color_attachment.resolveImageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+                }
+            }
+            
+            VkRenderingAttachmentInfo depth_attachment {};
+            depth_attachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+            depth_attachment.imageView = m_depth_target.view;
+            depth_attachment.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+            depth_attachment.loadOp = load_op;
+            // Read by the depth pyramid after the early phase
+            depth_attachment.storeOp = phase == ForwardPhase::Early ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            depth_attachment.clearValue = clear_depth;
+            
+            VkRenderingInfo rendering_info {};
+            rendering_info.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+            rendering_info.flags = secondary_command_buffers ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT : 0;
+            rendering_info.renderArea.offset = {0, 0};
+            rendering_info.renderArea.extent = m_render_extent;
+            rendering_info.layerCount = 1;
+            rendering_info.colorAttachmentCount = 1;
+            rendering_info.pColorAttachments = &color_attachment;
+            rendering_info.pDepthAttachment = &depth_attachment;
+            vkCmdBeginRendering(command_buffer, &rendering_info);
             return;
         }
-        if (vkCreateSemaphore(m_logical_graphics_device, &semaphore_create_info, nullptr, &m_render_finished_semaphore) != VK_SUCCESS) {
-            LogE("failed to create semaphore for finished render");
-            throw std::runtime_error("failed to create semaphore for finished render");
+        VkRenderPassBeginInfo render_pass_info{};
+        render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        render_pass_info.renderPass = m_render_pass;
+        render_pass_info.framebuffer = m_swap_chain_framebuffers[image_index];
+        render_pass_info.renderArea.offset = {0, 0};
+        render_pass_info.renderArea.extent = m_render_extent;
+        // One per attachment (see _createRenderPass), the resolve one is ignored
+        const VkClearValue clear_values[] = {clear_color, clear_depth, clear_color};
+        render_pass_info.clearValueCount = m_msaa_samples != VK_SAMPLE_COUNT_1_BIT ? 3 : 2;
+        render_pass_info.pClearValues = clear_values;
+        vkCmdBeginRenderPass(command_buffer, &render_pass_info, secondary_command_buffers ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
+    }
+    
+    void _endRendering(VkCommandBuffer command_buffer, uint32_t image_index) {
+        if (m_dynamic_rendering) {
+            vkCmdEndRendering(command_buffer);
             return;
         }
-        if (vkCreateFence(m_logical_graphics_device, &fence_create_info, nullptr, &m_in_flight_fence) != VK_SUCCESS) {
-            LogE("failed to create the fence for image synchronization");
-            throw std::runtime_error("failed to create the fence for image synchronization");
+        vkCmdEndRenderPass(command_buffer);
+    }
+    
+    /**
+     * Bind everything the scene draws need, for the main pass or the depth pre-pass.
+     * Secondary command buffers do not inherit any state: each one binds it again.
+     */
+    void _bindSceneState(VkCommandBuffer command_buffer, uint32_t frame_uniforms_offset, bool depth_prepass) {
+        vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, depth_prepass ? m_depth_prepass_pipeline : m_graphics_pipeline);
+        setViewportAndScissor(command_buffer, m_render_extent);
+        if (m_extended_dynamic_state)
+            setRasterState(command_buffer, depth_prepass ? m_depth_prepass_raster_state : m_raster_state);
+        const VkDeviceSize vertex_offset = 0;
+        vkCmdBindVertexBuffers(command_buffer, 0, 1, &m_vertex_buffer.buffer, &vertex_offset);
+        vkCmdBindIndexBuffer(command_buffer, m_index_buffer.buffer, 0, VK_INDEX_TYPE_UINT32);
+        // Bound once for all the draws: no per-draw descriptor binding
+        const VkDescriptorSet descriptor_sets[] = {m_scene_descriptor_set, m_bindless.set(m_current_frame), m_frame_descriptor_set};
+        vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline_layout, 0, 3, descriptor_sets, 1, &frame_uniforms_offset);
+    }
+    
+    /**
+     * View depth of an object (of its bounding sphere center), to sort its draws.
+     */
+    float _objectViewDepth(uint32_t object_index) const {
+        const ObjectData &object = m_scene.objects[object_index];
+        const glm::vec3 center = glm::vec3(object.position_scale) + glm::vec3(object.bounds) * object.position_scale.w;
+        // The view looks down -z
+        return -(m_view * glm::vec4(center, 1.0f)).z;
+    }
+    
+    /**
+     * Gather the CPU draws of the frame in the draw list, for each pass:
+     * the visible scene draws on the CPU path, the visible meshlets on the
+     * CPU meshlet path. Sorted by pass, pipeline, descriptor sets and mesh,
+     * then front to back (less overdraw).
+     */
+    void _buildDrawList(uint32_t frame_uniforms_offset) {
+        m_draw_list.reset();
+        const bool scene_draws = !m_gpu_driven;
+        const bool meshlet_draws = m_meshlet_path == MeshletPath::Cpu;
+        if (!scene_draws && !meshlet_draws)
+            return;
+        DrawDescriptorBinding scene_sets {};
+        scene_sets.layout = m_pipeline_layout;
+        scene_sets.sets = {m_scene_descriptor_set, m_bindless.set(m_current_frame), m_frame_descriptor_set};
+        scene_sets.dynamic_offsets = {frame_uniforms_offset};
+        const uint32_t descriptor_sets = m_draw_list.addDescriptorSets(scene_sets);
+        
+        uint32_t passes[2] = {};
+        uint32_t pipelines[2] = {};
+        uint32_t pass_count = 0;
+        for (const bool depth_prepass: {true, false}) {
+            if (depth_prepass && !m_depth_prepass)
+                continue;
+            DrawPipelineBinding pipeline {};
+            pipeline.pipeline = depth_prepass ? m_depth_prepass_pipeline : m_graphics_pipeline;
+            pipeline.layout = m_pipeline_layout;
+            pipeline.push_constant_stages = DRAW_PUSH_CONSTANT_STAGES;
+            pipeline.set_dynamic_state = [this, depth_prepass](VkCommandBuffer command_buffer) {
+                setViewportAndScissor(command_buffer, m_render_extent);
+                if (m_extended_dynamic_state)
+                    setRasterState(command_buffer, depth_prepass ? m_depth_prepass_raster_state : m_raster_state);
+            };
+            passes[pass_count] = depth_prepass ? DRAW_PASS_DEPTH_PREPASS : DRAW_PASS_MAIN;
+            pipelines[pass_count] = m_draw_list.addPipeline(pipeline);
+            pass_count++;
+        }
+        
+        const uint32_t scene_mesh = m_draw_list.addMesh({m_vertex_buffer.buffer, 0, m_index_buffer.buffer, 0, VK_INDEX_TYPE_UINT32});
+        // The meshlet indices are scene vertex indices: no vertex offset
+        const uint32_t meshlet_mesh = meshlet_draws ? m_draw_list.addMesh({m_vertex_buffer.buffer, 0, m_meshlet_renderer.indexBuffer(), 0, VK_INDEX_TYPE_UINT32}) : 0;
+        // Added in the order they used to be recorded in (for the stats)
+        for (uint32_t i = 0; i < pass_count; i++) {
+            if (scene_draws) {
+                for (const uint32_t draw_index: m_visible_draws) {
+                    const DrawRecord &draw = m_scene.draws[draw_index];
+                    m_draw_list.add(makeDrawSortKey(passes[i], pipelines[i], descriptor_sets, scene_mesh, _objectViewDepth(draw.object_index)), draw, BINDLESS_INVALID_HANDLE);
+                }
+            }
+            if (meshlet_draws) {
+                for (const MeshletDraw &draw: m_meshlet_renderer.visibleDraws())
+                    m_draw_list.add(makeDrawSortKey(passes[i], pipelines[i], descriptor_sets, meshlet_mesh, _objectViewDepth(draw.object_index)), {draw.index_count, draw.first_index, 0, draw.object_index}, BINDLESS_INVALID_HANDLE);
+            }
+        }
+        m_draw_list.sort();
+    }
+    
+    /**
+     * Record the sorted draws of a pass: only the state changing from
+     * one draw to the next is bound.
+     */
+    void _recordDrawList(VkCommandBuffer command_buffer, bool depth_prepass) {
+        uint32_t first = 0;
+        uint32_t count = 0;
+        m_draw_list.passRange(depth_prepass ? DRAW_PASS_DEPTH_PREPASS : DRAW_PASS_MAIN, first, count);
+        m_draw_list.record(command_buffer, first, count);
+    }
+    
+    /**
+     * Draw the meshlet objects with mesh shaders or indirect draws, after the
+     * scene draws (whose state is still bound on the GPU-driven path).
+     * The CPU path meshlets are in the draw list.
+     */
+    void _recordMeshletDraws(VkCommandBuffer command_buffer, uint32_t frame_uniforms_offset, bool depth_prepass) {
+        switch (m_meshlet_path) {
+            case MeshletPath::MeshShader: {
+                vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, depth_prepass ? m_meshlet_depth_prepass_pipeline : m_meshlet_pipeline);
+                setViewportAndScissor(command_buffer, m_render_extent);
+                if (m_extended_dynamic_state)
+                    setRasterState(command_buffer, depth_prepass ? m_depth_prepass_raster_state : m_raster_state);
+                // Other push constant ranges: the sets of the scene layout are not compatible
+                const VkDescriptorSet descriptor_sets[] = {m_scene_descriptor_set, m_bindless.set(m_current_frame), m_frame_descriptor_set};
+                vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_meshlet_pipeline_layout, 0, 3, descriptor_sets, 1, &frame_uniforms_offset);
+                m_meshlet_renderer.recordMeshTasks(command_buffer, m_meshlet_pipeline_layout);
+                break;
+            }
+            case MeshletPath::ComputeCulling:
+                _pushDrawConstants(command_buffer, 0, BINDLESS_INVALID_HANDLE);
+                m_meshlet_renderer.recordDraws(command_buffer, m_current_frame);
+                break;
+            case MeshletPath::Cpu:
+                break;
+        }
+    }
+    
+    /**
+     * Items given to _recordMeshletDraws: a single batch of draws, none
+     * on the CPU path (drawn with the draw list).
+     */
+    uint32_t _meshletDrawCount() const {
+        return m_meshlet_path == MeshletPath::Cpu ? 0 : 1;
+    }
+    
+    /**
+     * Simulate the particles for the time since the previous frame,
+     * outside of the render pass.
+     */
+    void _recordParticleSimulation(VkCommandBuffer command_buffer) {
+        const uint32_t scope = m_gpu_timer.begin(command_buffer, GPU_SCOPE_PARTICLE_SIMULATION);
+        m_particles.recordSimulation(command_buffer, m_frame_delta_time);
+        m_gpu_timer.end(command_buffer, scope);
+    }
+    
+    /**
+     * Bin the lights in the clusters of the frame, outside of the render pass.
+     */
+    void _recordLightCulling(VkCommandBuffer command_buffer) {
+        const uint32_t scope = m_gpu_timer.begin(command_buffer, GPU_SCOPE_LIGHT_CULLING);
+        m_lighting.recordCulling(command_buffer, m_current_frame, m_view, m_projection);
+        m_gpu_timer.end(command_buffer, scope);
+    }
+    
+    /**
+     * Draw the particles, last in the main pass: blended over the scene,
+     * and behind it where the depth test fails.
+     */
+    void _recordParticleDraw(VkCommandBuffer command_buffer) {
+        const uint32_t scope = m_gpu_timer.begin(command_buffer, GPU_SCOPE_PARTICLE_RENDERING);
+        m_particles.recordDraw(command_buffer, m_render_extent, m_view_proj, m_view);
+        m_gpu_timer.end(command_buffer, scope);
+    }
+    
+    /**
+     * Only the CPU draw list is worth splitting: the GPU-driven path
+     * is a single indirect draw. The secondary command buffers can only
+     * run in a pipeline statistics query with inheritedQueries.
+     */
+    bool _useParallelRecording() const {
+        if (m_pipeline_statistics.enabled() && m_pipeline_statistics.inheritedStatistics() == 0)
+            return false;
+        // The particle benchmark times the particle draw: the secondary
+        // command buffers have no timestamp
+        if (ENABLE_PARTICLE_BENCHMARK && m_gpu_timer.enabled())
+            return false;
+        return m_parallel_recording && !m_gpu_driven && m_visible_draws.size() >= 2 * MIN_DRAWS_PER_RECORDING_CHUNK;
+    }
+    
+    /**
+     * Record the CPU draw list in secondary command buffers, with jobs,
+     * and execute them in order. Each one binds the state of its first
+     * draw again.
+     */
+    void _recordSceneDrawsParallel(VkCommandBuffer command_buffer, uint32_t image_index, uint32_t frame_uniforms_offset, bool depth_prepass) {
+        VkCommandBufferInheritanceRenderingInfo inheritance_rendering_info {};
+        inheritance_rendering_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO;
+        inheritance_rendering_info.colorAttachmentCount = 1;
+        inheritance_rendering_info.pColorAttachmentFormats = &m_swap_chain_surface_format.format;
+        inheritance_rendering_info.depthAttachmentFormat = m_depth_format;
+        inheritance_rendering_info.rasterizationSamples = m_msaa_samples;
+        VkCommandBufferInheritanceInfo inheritance_info {};
+        inheritance_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        // Executed in the pipeline statistics query of the pass, if any
+        inheritance_info.pipelineStatistics = m_pipeline_statistics.inheritedStatistics();
+        if (m_dynamic_rendering) {
+            inheritance_info.pNext = &inheritance_rendering_info;
+        } else {
+            inheritance_info.renderPass = m_render_pass;
+            inheritance_info.subpass = 0;
+            inheritance_info.framebuffer = m_swap_chain_framebuffers[image_index];
+        }
+        
+        uint32_t pass_first = 0;
+        uint32_t pass_count = 0;
+        m_draw_list.passRange(depth_prepass ? DRAW_PASS_DEPTH_PREPASS : DRAW_PASS_MAIN, pass_first, pass_count);
+        std::vector<VkCommandBuffer> secondary_command_buffers = m_parallel_recorder.record(
+            m_logical_graphics_device,
+            inheritance_info,
+            pass_count,
+            MIN_DRAWS_PER_RECORDING_CHUNK,
+            [this, pass_first](VkCommandBuffer secondary_command_buffer, uint32_t first, uint32_t count) {
+                m_draw_list.record(secondary_command_buffer, pass_first + first, count);
+            });
+        // The render pass only takes secondary command buffers: the meshlets too
+        const std::vector<VkCommandBuffer> meshlet_command_buffers = m_parallel_recorder.record(
+            m_logical_graphics_device,
+            inheritance_info,
+            _meshletDrawCount(),
+            MIN_DRAWS_PER_RECORDING_CHUNK,
+            [this, frame_uniforms_offset, depth_prepass](VkCommandBuffer secondary_command_buffer, uint32_t, uint32_t) {
+                _bindSceneState(secondary_command_buffer, frame_uniforms_offset, depth_prepass);
+                _recordMeshletDraws(secondary_command_buffer, frame_uniforms_offset, depth_prepass);
+            });
+        secondary_command_buffers.insert(secondary_command_buffers.end(), meshlet_command_buffers.begin(), meshlet_command_buffers.end());
+        // A single indirect draw, not drawn in the depth pre-pass
+        const std::vector<VkCommandBuffer> particle_command_buffers = m_parallel_recorder.record(
+            m_logical_graphics_device,
+            inheritance_info,
+            depth_prepass ? 0 : 1,
+            1,
+            [this](VkCommandBuffer secondary_command_buffer, uint32_t, uint32_t) {
+                // Not timed: recorded on a job thread, and the GPU timer is
+                // not thread-safe
+                m_particles.recordDraw(secondary_command_buffer, m_render_extent, m_view_proj, m_view);
+            });
+        secondary_command_buffers.insert(secondary_command_buffers.end(), particle_command_buffers.begin(), particle_command_buffers.end());
+        vkCmdExecuteCommands(command_buffer, static_cast<uint32_t>(secondary_command_buffers.size()), secondary_command_buffers.data());
+    }
+    
+    /**
+     * Draw the scene, for the main pass or the depth pre-pass.
+     * The meshlets are drawn by the early phase (they are not occlusion
+     * culled), the particles last, by the late phase.
+     */
+    void _recordSceneDraws(VkCommandBuffer command_buffer, uint32_t image_index, uint32_t frame_uniforms_offset, bool parallel, bool depth_prepass, ForwardPhase phase) {
+        if (parallel) {
+            _recordSceneDrawsParallel(command_buffer, image_index, frame_uniforms_offset, depth_prepass);
+            return;
+        }
+        if (m_gpu_driven) {
+            _bindSceneState(command_buffer, frame_uniforms_offset, depth_prepass);
+            // The object index is given as firstInstance by the culling pass
+            _pushDrawConstants(command_buffer, 0, BINDLESS_INVALID_HANDLE);
+            m_gpu_culling.recordDraws(command_buffer, m_current_frame, phase == ForwardPhase::Late);
+        }
+        if (phase != ForwardPhase::Late) {
+            _recordDrawList(command_buffer, depth_prepass);
+            _recordMeshletDraws(command_buffer, frame_uniforms_offset, depth_prepass);
+        }
+        if (!depth_prepass && phase != ForwardPhase::Early)
+            _recordParticleDraw(command_buffer);
+    }
+    
+    /**
+     * Render the scene (or a phase of it) to the swap chain image.
+     */
+    void _recordForwardPass(VkCommandBuffer command_buffer, uint32_t image_index, uint32_t frame_uniforms_offset, ForwardPhase phase) {
+        // Occlusion culling is GPU-driven: never recorded in parallel
+        const bool parallel = _useParallelRecording();
+        // Around the render pass: no timestamp in it with secondary command buffers
+        const uint32_t scope = m_gpu_timer.begin(command_buffer, GPU_SCOPE_FORWARD_PASS);
+        _beginRendering(command_buffer, image_index, parallel, phase);
+        // Same attachments: the pre-pass fills the depth buffer, the main
+        // pass then only shades the nearest fragments
+        if (m_depth_prepass)
+            _recordSceneDraws(command_buffer, image_index, frame_uniforms_offset, parallel, true, phase);
+        _recordSceneDraws(command_buffer, image_index, frame_uniforms_offset, parallel, false, phase);
+        _endRendering(command_buffer, image_index);
+        m_gpu_timer.end(command_buffer, scope);
+    }
+    
+    /**
+     * Declare the passes of the frame: the graph orders them and
+     * inserts the barriers / layout transitions between them.
+     */
+    void _buildFrameGraph(uint32_t image_index, uint32_t frame_uniforms_offset) {
+        m_frame_graph.reset();
+        // The swap chain image is acquired before its first use (see the submit wait stage)
+        const FrameGraphResource swap_chain_image = m_frame_graph.importImage(
+            "swap chain",
+            m_swap_chain_images[image_index],
+            m_swap_chain_image_views[image_index],
+            VK_IMAGE_ASPECT_COLOR_BIT,
+            VK_IMAGE_LAYOUT_UNDEFINED,
+            _acquireWaitStage(),
+            0,
+            VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+        // Dynamic resolution: the passes render to the scene color target
+        FrameGraphResource color_output = swap_chain_image;
+        if (m_dynamic_resolution) {
+            // One per frame in flight: written while the previous frame
+            // may still be upscaling its own
+            TransientImageDesc scene_color_desc {};
+            scene_color_desc.extent = m_swap_chain_extent;
+            scene_color_desc.format = m_swap_chain_surface_format.format;
+            m_scene_color = m_frame_graph.createImage("scene color", scene_color_desc);
+            color_output = m_scene_color;
+        }
+        std::vector<FrameGraphAccess> attachment_accesses = {{color_output, ResourceUsage::ColorAttachmentWrite}};
+        if (m_msaa_samples != VK_SAMPLE_COUNT_1_BIT) {
+            // Contents discarded every frame: no need to keep its layout.
+            // Shared by the frames in flight: wait for the color writes of
+            // the previous frame (write-after-write)
+            const FrameGraphResource msaa_color_target = m_frame_graph.importImage(
+                "msaa color",
+                m_msaa_color_target.image,
+                m_msaa_color_target.view,
+                VK_IMAGE_ASPECT_COLOR_BIT,
+                VK_IMAGE_LAYOUT_UNDEFINED,
+                VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                VK_IMAGE_LAYOUT_UNDEFINED);
+            attachment_accesses.push_back({msaa_color_target, ResourceUsage::ColorAttachmentWrite});
+        }
+        // Shared by the frames in flight, cleared by each: wait for the
+        // depth writes of the previous frame (write-after-write)
+        const FrameGraphResource depth_target = m_frame_graph.importImage(
+            "depth",
+            m_depth_target.image,
+            m_depth_target.view,
+            depthFormatAspect(m_depth_format),
+            VK_IMAGE_LAYOUT_UNDEFINED,
+            VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+            VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+            VK_IMAGE_LAYOUT_UNDEFINED);
+        attachment_accesses.push_back({depth_target, ResourceUsage::DepthAttachmentWrite});
+        // Occlusion culling: the early forward pass, then the late one on
+        // top of it (same attachments), which draws the particles
+        const bool two_phase = m_occlusion_culling;
+        std::vector<FrameGraphAccess> forward_accesses = attachment_accesses;
+        std::vector<FrameGraphAccess> late_forward_accesses = attachment_accesses;
+        std::vector<FrameGraphAccess> &last_forward_accesses = two_phase ? late_forward_accesses : forward_accesses;
+        
+        // Written by both culling phases, read by the CPU
+        FrameGraphResource culling_stats = FRAME_GRAPH_INVALID_RESOURCE;
+        // Built by the previous frame (sampled by the early culling), then by this one
+        FrameGraphResource depth_pyramid = FRAME_GRAPH_INVALID_RESOURCE;
+        FrameGraphResource late_candidates = FRAME_GRAPH_INVALID_RESOURCE;
+        if (m_gpu_driven) {
+            const FrameGraphResource draw_commands = m_frame_graph.importBuffer("draw commands", m_gpu_culling.drawCommandBuffer(m_current_frame));
+            const FrameGraphResource draw_count = m_frame_graph.importBuffer("draw count", m_gpu_culling.drawCountBuffer(m_current_frame));
+            culling_stats = m_frame_graph.importBuffer("culling stats", m_gpu_culling.statsBuffer(m_current_frame));
+            std::vector<FrameGraphAccess> culling_accesses = {
+                {draw_commands, ResourceUsage::StorageWrite},
+                {draw_count, ResourceUsage::StorageWrite},
+                {culling_stats, ResourceUsage::StorageWrite}
+            };
+            if (two_phase) {
+                depth_pyramid = m_frame_graph.importImage(
+                    "depth pyramid",
+                    m_depth_pyramid.image(),
+                    m_depth_pyramid.view(),
+                    VK_IMAGE_ASPECT_COLOR_BIT,
+                    m_depth_pyramid.built() ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED,
+                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                    0,
+                    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+                late_candidates = m_frame_graph.importBuffer("late candidates", m_gpu_culling.candidateBuffer(m_current_frame));
+                culling_accesses.push_back({depth_pyramid, ResourceUsage::SampledRead});
+                culling_accesses.push_back({late_candidates, ResourceUsage::StorageWrite});
+            }
+            m_frame_graph.addPass(
+                "culling",
+                culling_accesses,
+                [this](VkCommandBuffer command_buffer) {
+                    m_gpu_culling.recordCulling(m_logical_graphics_device, command_buffer, m_current_frame, m_frame_descriptor_allocators, m_view_proj, m_occlusion_culling ? &m_depth_pyramid : nullptr);
+                });
+            forward_accesses.push_back({draw_commands, ResourceUsage::IndirectRead});
+            forward_accesses.push_back({draw_count, ResourceUsage::IndirectRead});
+        }
+        if (m_meshlet_path == MeshletPath::ComputeCulling) {
+            const FrameGraphResource meshlet_commands = m_frame_graph.importBuffer("meshlet draw commands", m_meshlet_renderer.drawCommandBuffer(m_current_frame));
+            const FrameGraphResource meshlet_count = m_frame_graph.importBuffer("meshlet draw count", m_meshlet_renderer.drawCountBuffer(m_current_frame));
+            m_frame_graph.addPass(
+                "meshlet culling",
+                {{meshlet_commands, ResourceUsage::StorageWrite}, {meshlet_count, ResourceUsage::StorageWrite}},
+                [this](VkCommandBuffer command_buffer) {
+                    m_meshlet_renderer.recordCulling(m_logical_graphics_device, command_buffer, m_current_frame, m_frame_descriptor_allocators, m_view_proj, m_camera_position);
+                });
+            forward_accesses.push_back({meshlet_commands, ResourceUsage::IndirectRead});
+            forward_accesses.push_back({meshlet_count, ResourceUsage::IndirectRead});
+        }
+        // The simulation writes both particle buffers (one is drawn) and
+        // the indirect arguments of the draw
+        const FrameGraphResource particles[2] = {
+            m_frame_graph.importBuffer("particles 0", m_particles.particleBuffer(0)),
+            m_frame_graph.importBuffer("particles 1", m_particles.particleBuffer(1))
+        };
+        const FrameGraphResource particle_counters = m_frame_graph.importBuffer("particle counters", m_particles.counterBuffer());
+        m_frame_graph.addPass(
+            "particles",
+            {{particles[0], ResourceUsage::StorageWrite}, {particles[1], ResourceUsage::StorageWrite}, {particle_counters, ResourceUsage::StorageWrite}},
+            [this](VkCommandBuffer command_buffer) {
+                _recordParticleSimulation(command_buffer);
+            });
+        last_forward_accesses.push_back({particles[0], ResourceUsage::VertexStorageRead});
+        last_forward_accesses.push_back({particles[1], ResourceUsage::VertexStorageRead});
+        last_forward_accesses.push_back({particle_counters, ResourceUsage::IndirectRead});
+        if (m_clustered_lighting) {
+            const FrameGraphResource clusters = m_frame_graph.importBuffer("light clusters", m_lighting.clusterBuffer());
+            m_frame_graph.addPass(
+                "light culling",
+                {{clusters, ResourceUsage::StorageWrite}},
+                [this](VkCommandBuffer command_buffer) {
+                    _recordLightCulling(command_buffer);
+                });
+            forward_accesses.push_back({clusters, ResourceUsage::FragmentStorageRead});
+            late_forward_accesses.push_back({clusters, ResourceUsage::FragmentStorageRead});
+        }
+        
+        m_frame_graph.addPass(
+            "forward",
+            forward_accesses,
+            [this, image_index, frame_uniforms_offset, two_phase](VkCommandBuffer command_buffer) {
+                _recordForwardPass(command_buffer, image_index, frame_uniforms_offset, two_phase ? ForwardPhase::Early : ForwardPhase::Single);
+            });
+        if (two_phase) {
+            m_frame_graph.addPass(
+                "depth pyramid",
+                {{depth_target, ResourceUsage::SampledRead}, {depth_pyramid, ResourceUsage::StorageWrite}},
+                [this](VkCommandBuffer command_buffer) {
+                    m_depth_pyramid.recordBuild(command_buffer, m_view_proj, m_render_extent);
+                });
+            const FrameGraphResource late_commands = m_frame_graph.importBuffer("late draw commands", m_gpu_culling.lateDrawCommandBuffer(m_current_frame));
+            const FrameGraphResource late_count = m_frame_graph.importBuffer("late draw count", m_gpu_culling.lateDrawCountBuffer(m_current_frame));
+            m_frame_graph.addPass(
+                "late culling",
+                {
+                    {late_commands, ResourceUsage::StorageWrite},
+                    {late_count, ResourceUsage::StorageWrite},
+                    {culling_stats, ResourceUsage::StorageWrite},
+                    {depth_pyramid, ResourceUsage::SampledRead},
+                    {late_candidates, ResourceUsage::StorageRead}
+                },
+                [this](VkCommandBuffer command_buffer) {
+                    m_gpu_culling.recordLateCulling(m_logical_graphics_device, command_buffer, m_current_frame, m_frame_descriptor_allocators, m_view_proj, m_depth_pyramid);
+                });
+            late_forward_accesses.push_back({late_commands, ResourceUsage::IndirectRead});
+            late_forward_accesses.push_back({late_count, ResourceUsage::IndirectRead});
+            m_frame_graph.addPass(
+                "forward late",
+                late_forward_accesses,
+                [this, image_index, frame_uniforms_offset](VkCommandBuffer command_buffer) {
+                    _recordForwardPass(command_buffer, image_index, frame_uniforms_offset, ForwardPhase::Late);
+                });
+        }
+        if (m_dynamic_resolution) {
+            m_frame_graph.addPass(
+                "upscale",
+                {{color_output, ResourceUsage::TransferRead}, {swap_chain_image, ResourceUsage::TransferWrite}},
+                [this, image_index](VkCommandBuffer command_buffer) {
+                    _recordUpscale(command_buffer, image_index);
+                });
+        }
+        if (m_readback) {
+            // Writes a host buffer, unknown to the graph
+            m_frame_graph.addPass(
+                "readback",
+                {{swap_chain_image, ResourceUsage::TransferRead}},
+                [this, image_index](VkCommandBuffer command_buffer) {
+                    m_frame_readback.recordCopy(command_buffer, m_current_frame, m_frame_number, m_swap_chain_images[image_index], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+                },
+                true);
+        }
+        m_frame_graph.compile(m_logical_graphics_device, m_current_frame);
+    }
+    
+    /**
+     * Stretch the rendered corner of the scene color target to the swap
+     * chain image (both in their transfer layouts).
+     */
+    void _recordUpscale(VkCommandBuffer command_buffer, uint32_t image_index) {
+        VkImageBlit blit {};
+        blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        blit.srcSubresource.mipLevel = 0;
+        blit.srcSubresource.baseArrayLayer = 0;
+        blit.srcSubresource.layerCount = 1;
+        blit.srcOffsets[1] = {static_cast<int32_t>(m_render_extent.width), static_cast<int32_t>(m_render_extent.height), 1};
+        blit.dstSubresource = blit.srcSubresource;
+        blit.dstOffsets[1] = {static_cast<int32_t>(m_swap_chain_extent.width), static_cast<int32_t>(m_swap_chain_extent.height), 1};
+        vkCmdBlitImage(
+            command_buffer,
+            m_frame_graph.image(m_scene_color),
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            m_swap_chain_images[image_index],
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            1,
+            &blit,
+            VK_FILTER_LINEAR);
+    }
+    
+    /**
+     * Dynamic resolution: feed the GPU time of the frame read back to the
+     * controller, which may change the render extent of the next frames.
+     * The frame scope does not wait for the swap chain image (see
+     * _acquireWaitStage): a frame waiting for vsync is not slower.
+     */
+    void _updateRenderScale() {
+        if (!m_dynamic_resolution)
+            return;
+        const double frame_ms = m_gpu_timer.milliseconds(GPU_SCOPE_FRAME);
+        if (frame_ms < 0.0)
+            return;
+        if (!m_resolution_controller.addFrameTime(frame_ms))
+            return;
+        m_render_extent = m_resolution_controller.renderExtent();
+        if (ENABLE_DYNAMIC_RESOLUTION_LOG)
+            Log("Dynamic resolution: " << m_render_extent.width << "x" << m_render_extent.height
+                << " (scale " << m_resolution_controller.scale() << "), "
+                << m_resolution_controller.averageMilliseconds() << " ms per frame");
+    }
+    
+    /**
+     * Write the uniforms of the frame, and return their dynamic offset.
+     */
+    uint32_t _prepareFrameUniforms() {
+        FrameUniforms frame_uniforms {};
+        frame_uniforms.view_proj = m_view_proj;
+        frame_uniforms.viewport = glm::vec4(
+            m_render_extent.width,
+            m_render_extent.height,
+            1.0f / m_render_extent.width,
+            1.0f / m_render_extent.height);
+        for (uint32_t i = 0; i < m_streamed_texture_count; i++)
+            frame_uniforms.streamed_textures[i / 4][i % 4] = m_texture_streamer.handle(i);
+        const FrustumPlanes planes = extractFrustumPlanes(m_view_proj);
+        for (size_t i = 0; i < planes.size(); i++)
+            frame_uniforms.frustum_planes[i] = planes[i];
+        frame_uniforms.camera_position = glm::vec4(m_camera_position, 1.0f);
+        if (m_clustered_lighting)
+            m_lighting.fillFrameUniforms(frame_uniforms, m_current_frame, LIGHT_AMBIENT, m_render_extent);
+        return m_uniform_allocator.push(frame_uniforms);
+    }
+    
+    /**
+     * CPU draw path: frustum test of the draws, in parallel,
+     * then (in order) gather the visible ones in m_visible_draws.
+     */
+    void _cullDraws() {
+        const FrustumPlanes planes = extractFrustumPlanes(m_view_proj);
+        const uint32_t draw_count = static_cast<uint32_t>(m_scene.draws.size());
+        m_draw_visibility.resize(draw_count);
+        m_job_system.parallelFor("cull draws", 0, draw_count, CULLING_JOB_GRAIN, [this, &planes](uint32_t first, uint32_t last) {
+            for (uint32_t i = first; i < last; i++) {
+                // Same test as the culling compute shader
+                const ObjectData &object = m_scene.objects[m_scene.draws[i].object_index];
+                const float scale = object.position_scale.w;
+                const glm::vec3 center = glm::vec3(object.position_scale) + glm::vec3(object.bounds) * scale;
+                m_draw_visibility[i] = isSphereVisible(planes, center, object.bounds.w * scale) ? 1 : 0;
+            }
+        });
+        m_visible_draws.clear();
+        for (uint32_t i = 0; i < draw_count; i++)
+            // Empty draws: the LOD levels not fading out
+            if (m_draw_visibility[i] && m_scene.draws[i].index_count != 0)
+                m_visible_draws.push_back(i);
+    }
+    
+    /**
+     * Move the LOD objects and select their level from the projected error
+     * of the levels, in the CPU copy of the scene: before the frame jobs,
+     * which read it. The GPU copy is updated by _recordLodUpdate.
+     */
+    void _updateLods() {
+        if (m_lod_states.empty())
+            return;
+        m_lod_time += m_frame_delta_time;
+        const float pixels_per_unit = lodPixelsPerUnit(m_projection, static_cast<float>(m_swap_chain_extent.height));
+        for (uint32_t i = 0; i < static_cast<uint32_t>(m_lod_states.size()); i++) {
+            ObjectData &object = m_scene.objects[m_lod_first_object + 2 * i];
+            object.position_scale = glm::vec4(_lodObjectPosition(i), object.position_scale.w);
+            LodState &state = m_lod_states[i];
+            if (ENABLE_MESH_LOD) {
+                const float scale = object.position_scale.w;
+                const glm::vec3 center = glm::vec3(object.position_scale) + glm::vec3(object.bounds) * scale;
+                // Depth of the nearest point of the bounding sphere (the view looks down -z)
+                const float view_depth = std::max(-(m_view * glm::vec4(center, 1.0f)).z - object.bounds.w * scale, CAMERA_NEAR);
+                const uint32_t level = selectLod(m_sphere_lods, scale, view_depth, pixels_per_unit, LOD_ERROR_THRESHOLD_PIXELS, LOD_HYSTERESIS, state.level);
+                updateLodState(state, level, m_frame_delta_time, m_lod_crossfade ? LOD_CROSSFADE_SECONDS : 0.0f);
+            }
+            const MeshRange &range = m_sphere_lods.levels[state.level].range;
+            DrawRecord &draw = m_scene.draws[m_lod_first_draw + 2 * i];
+            draw.index_count = range.index_count;
+            draw.first_index = range.first_index;
+            object.material.w = lodFadeBits(state, false);
+            
+            const MeshRange &previous_range = m_sphere_lods.levels[state.previous_level].range;
+            DrawRecord &fading_draw = m_scene.draws[m_lod_first_draw + 2 * i + 1];
+            fading_draw.index_count = state.fade < 1.0f ? previous_range.index_count : 0;
+            fading_draw.first_index = previous_range.first_index;
+            ObjectData &fading_object = m_scene.objects[m_lod_first_object + 2 * i + 1];
+            fading_object = object;
+            fading_object.material.w = lodFadeBits(state, true);
+        }
+    }
+    
+    /**
+     * Copy the LOD objects / draws to the scene buffers, before any pass
+     * reads them. The previous frame may still be reading them: they are
+     * written in the command buffer, after its reads, not by the host.
+     */
+    void _recordLodUpdate(VkCommandBuffer command_buffer) {
+        if (m_lod_states.empty())
+            return;
+        // Write after read: an execution dependency is enough
+        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 0, nullptr);
+        const uint32_t count = 2 * static_cast<uint32_t>(m_lod_states.size());
+        vkCmdUpdateBuffer(command_buffer, m_object_buffer.buffer, sizeof(ObjectData) * m_lod_first_object, sizeof(ObjectData) * count, &m_scene.objects[m_lod_first_object]);
+        vkCmdUpdateBuffer(command_buffer, m_draw_buffer.buffer, sizeof(DrawRecord) * m_lod_first_draw, sizeof(DrawRecord) * count, &m_scene.draws[m_lod_first_draw]);
+        // Objects read by the culling and vertex shaders, draws by the culling one
+        VkMemoryBarrier update_barrier {};
+        update_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        update_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        update_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, 0, 1, &update_barrier, 0, nullptr, 0, nullptr);
+    }
+    
+    /**
+     * Request the mip level of the streamed textures from the screen
+     * size of the (visible) objects using them, in parallel.
+     */
+    void _requestTextureMips() {
+        const FrustumPlanes planes = extractFrustumPlanes(m_view_proj);
+        const float viewport_height = static_cast<float>(m_swap_chain_extent.height);
+        // Projected size of 1 unit at a distance of 1, in pixels
+        const float pixels_per_unit = std::abs(m_projection[1][1]) * 0.5f * viewport_height;
+        const uint32_t object_count = static_cast<uint32_t>(m_scene.objects.size());
+        m_job_system.parallelFor("texture requests", 0, object_count, CULLING_JOB_GRAIN, [this, &planes, pixels_per_unit](uint32_t first, uint32_t last) {
+            for (uint32_t i = first; i < last; i++) {
+                const ObjectData &object = m_scene.objects[i];
+                if (object.material.z == 0)
+                    continue;
+                const float scale = object.position_scale.w;
+                const glm::vec3 center = glm::vec3(object.position_scale) + glm::vec3(object.bounds) * scale;
+                const float radius = object.bounds.w * scale;
+                if (!isSphereVisible(planes, center, radius))
+                    continue;
+                // The texture spans the whole object: about the diameter of its bounding sphere
+                const float distance = std::max((m_view_proj * glm::vec4(center, 1.0f)).w, CAMERA_NEAR);
+                const float screen_pixels = 2.0f * radius * pixels_per_unit / distance;
+                m_texture_streamer.request(object.material.z - 1, TextureStreamer::mipLevelForScreenSize(STREAMED_TEXTURE_SIZE, screen_pixels));
+            }
+        });
+    }
+    
+    void _reportTextureStreaming() {
+        if (!ENABLE_TEXTURE_STREAMING_STATS || ++m_streaming_report_frames < TEXTURE_STREAMING_REPORT_FRAMES)
+            return;
+        const TextureStreamingStats &stats = m_texture_streamer.stats();
+        Log("Texture streaming: " << stats.resident_bytes / 1024 << " / " << stats.budget_bytes / 1024 << " KB resident, "
+            << stats.pending_loads << " pending loads, " << stats.completed_loads << " loads and " << stats.evictions << " evictions so far");
+        m_streaming_report_frames = 0;
+    }
+    
+    void _reportCullingStats() {
+        if (!ENABLE_CULLING_STATS || !m_gpu_driven || ++m_culling_report_frames < CULLING_STATS_REPORT_FRAMES)
+            return;
+        const CullingStats &stats = m_gpu_culling.stats();
+        Log("GPU culling: " << stats.draws << " draws, " << stats.frustum_culled << " frustum culled, " << stats.occlusion_culled << " occlusion culled, "
+            << stats.drawn_early << " drawn early + " << stats.drawn_late << " drawn late");
+        m_culling_report_frames = 0;
+    }
+    
+    /**
+     * Log the counters of each pass of the last frame read back.
+     */
+    void _logPipelineStatistics() {
+        if (!m_pipeline_statistics.enabled())
+            return;
+        for (const PassStatistics &pass: m_pipeline_statistics.results()) {
+            Log("\t " << pass.name << ":");
+            for (uint32_t i = 0; i < PIPELINE_STATISTICS_COUNTER_COUNT; i++) {
+                const PipelineStatisticsCounter counter = static_cast<PipelineStatisticsCounter>(i);
+                Log("\t\t " << pipelineStatisticsCounterName(counter) << ": " << pass.value(counter));
+            }
+        }
+    }
+    
+    void _reportPipelineStatistics() {
+        if (!m_pipeline_statistics.enabled() || ++m_statistics_report_frames < PIPELINE_STATISTICS_REPORT_FRAMES)
+            return;
+        // Counted MAX_FRAMES_IN_FLIGHT frames ago
+        Log("Pipeline statistics, " << m_pipeline_statistics.results().size() << " passes:");
+        _logPipelineStatistics();
+        m_statistics_report_frames = 0;
+    }
+    
+    void _reportDrawListStats() {
+        if (!ENABLE_DRAW_LIST_STATS || m_draw_list.size() == 0 || ++m_draw_list_report_frames < DRAW_LIST_REPORT_FRAMES)
+            return;
+        const DrawListStats stats = m_draw_list.stats();
+        Log("Draw list: " << stats.draws << " draws, " << stats.pipeline_binds << " pipeline / " << stats.descriptor_set_binds << " descriptor set / "
+            << stats.vertex_buffer_binds << " vertex buffer / " << stats.index_buffer_binds << " index buffer binds, " << stats.skipped_binds
+            << " redundant binds skipped (" << stats.unsorted_binds << " binds unsorted)");
+        m_draw_list_report_frames = 0;
+    }
+    
+    /**
+     * Called with each image read back, a few frames after its rendering.
+     */
+    void _consumeFrameCapture(const FrameCapture &capture) {
+        // Copied: the encoders never hold the readback buffer
+        if (m_frame_capture)
+            m_capture_encoder.submit(capture);
+        m_readback_latency_frames += m_frame_number - capture.frame_number;
+        if (++m_readback_report_frames < FRAME_READBACK_REPORT_FRAMES)
+            return;
+        Log("Frame readback: " << m_frame_readback.capturedCount() << " frames captured, " << m_frame_readback.droppedCount() << " dropped, "
+            << static_cast<double>(m_readback_latency_frames) / m_readback_report_frames << " frames of latency on average");
+        if (m_frame_capture)
+            Log("Frame capture: " << m_capture_encoder.writtenCount() << " files written, " << m_capture_encoder.droppedCount() << " frames dropped, "
+                << m_capture_encoder.skippedCount() << " skipped (1 frame out of " << m_capture_encoder.interval() << " captured)");
+        m_readback_report_frames = 0;
+        m_readback_latency_frames = 0;
+    }
+    
+    /**
+     * ENABLE_PARTICLE_BENCHMARK: average the GPU times of the particles
+     * over PARTICLE_BENCHMARK_FRAMES frames, once the buffers are full, then
+     * log them and move to the next count.
+     */
+    void _runParticleBenchmark() {
+        constexpr uint32_t benchmark_count = static_cast<uint32_t>(std::size(PARTICLE_BENCHMARK_COUNTS));
+        if (!ENABLE_PARTICLE_BENCHMARK || !m_gpu_timer.enabled() || m_particle_benchmark_index >= benchmark_count)
+            return;
+        if (m_particles.simulatedTime() < PARTICLE_BENCHMARK_WARMUP_SECONDS)
+            return;
+        // The timestamps read back are MAX_FRAMES_IN_FLIGHT frames old: the
+        // warm-up leaves the previous count behind
+        const double simulation_ms = m_gpu_timer.milliseconds(GPU_SCOPE_PARTICLE_SIMULATION);
+        const double rendering_ms = m_gpu_timer.milliseconds(GPU_SCOPE_PARTICLE_RENDERING);
+        if (simulation_ms < 0.0 || rendering_ms < 0.0)
+            return;
+        m_particle_simulation_ms += simulation_ms;
+        m_particle_rendering_ms += rendering_ms;
+        if (++m_particle_benchmark_frames < PARTICLE_BENCHMARK_FRAMES)
+            return;
+        
+        Log("Particle benchmark, " << m_particles.capacity() << " particles, average over " << m_particle_benchmark_frames << " frames: "
+            << m_particle_simulation_ms / m_particle_benchmark_frames << " ms simulation, "
+            << m_particle_rendering_ms / m_particle_benchmark_frames << " ms rendering");
+        _logPipelineStatistics();
+        m_particle_benchmark_frames = 0;
+        m_particle_simulation_ms = 0.0;
+        m_particle_rendering_ms = 0.0;
+        if (++m_particle_benchmark_index >= benchmark_count) {
+            Log("Particle benchmark done");
+            return;
         }
+        // The frames in flight still use the buffers
+        vkDeviceWaitIdle(m_logical_graphics_device);
+        m_particles.clean(m_logical_graphics_device);
+        _createParticleSystem();
+    }
+    
+    /**
+     * ENABLE_LIGHT_BENCHMARK: average the GPU times of the light binning
+     * and of the forward pass over LIGHT_BENCHMARK_FRAMES frames, then log
+     * them and move to the next count.
+     */
+    void _runLightBenchmark() {
+        constexpr uint32_t benchmark_count = static_cast<uint32_t>(std::size(LIGHT_BENCHMARK_COUNTS));
+        if (!ENABLE_LIGHT_BENCHMARK || !m_clustered_lighting || !m_gpu_timer.enabled() || m_light_benchmark_index >= benchmark_count)
+            return;
+        // The timestamps read back are MAX_FRAMES_IN_FLIGHT frames old:
+        // skip the frames still recorded with the previous count
+        if (m_light_benchmark_skipped_frames < MAX_FRAMES_IN_FLIGHT) {
+            m_light_benchmark_skipped_frames++;
+            return;
+        }
+        const double culling_ms = m_gpu_timer.milliseconds(GPU_SCOPE_LIGHT_CULLING);
+        const double forward_ms = m_gpu_timer.milliseconds(GPU_SCOPE_FORWARD_PASS);
+        if (culling_ms < 0.0 || forward_ms < 0.0)
+            return;
+        m_light_culling_ms += culling_ms;
+        m_light_forward_ms += forward_ms;
+        if (++m_light_benchmark_frames < LIGHT_BENCHMARK_FRAMES)
+            return;
+        
+        Log("Light benchmark, " << m_lighting.lightCount() << " lights, average over " << m_light_benchmark_frames << " frames: "
+            << m_light_culling_ms / m_light_benchmark_frames << " ms light culling, "
+            << m_light_forward_ms / m_light_benchmark_frames << " ms forward pass");
+        _logPipelineStatistics();
+        m_light_benchmark_frames = 0;
+        m_light_benchmark_skipped_frames = 0;
+        m_light_culling_ms = 0.0;
+        m_light_forward_ms = 0.0;
+        if (++m_light_benchmark_index >= benchmark_count) {
+            Log("Light benchmark done");
+            return;
+        }
+        // Only the count of the next frames changes: no wait
+        m_lighting.setLightCount(LIGHT_BENCHMARK_COUNTS[m_light_benchmark_index]);
+    }
+    
+    void _reportJobTimings() {
+        if (!ENABLE_JOB_TIMINGS || ++m_timed_frames < JOB_TIMINGS_REPORT_FRAMES)
+            return;
+        std::lock_guard<std::mutex> lock(m_job_timings_mutex);
+        Log("Jobs, average per frame over " << m_timed_frames << " frames:");
+        for (const auto &[name, timing]: m_job_timings)
+            Log("-> " << name << ": " << timing.total_ms / m_timed_frames << " ms (" << timing.count / m_timed_frames << " jobs)");
+        m_job_timings.clear();
+        m_timed_frames = 0;
     }
     
-    void recordCommandBuffer(VkCommandBuffer command_buffer, uint32_t image_index) {
+    /**
+     * Record a pass in a pipeline statistics scope, outside of any render
+     * pass (the frame graph does it with its pass hooks).
+     */
+    template<typename Record>
+    void _recordMeasuredPass(VkCommandBuffer command_buffer, const char *name, Record record) {
+        const uint32_t scope = m_pipeline_statistics.begin(command_buffer, name);
+        record();
+        m_pipeline_statistics.end(command_buffer, scope);
+    }
+    
+    /**
+     * Stage of the first use of the swap chain image, where the submit
+     * waits for its acquisition. With dynamic resolution, the scene is
+     * rendered to its own target, and only the upscale (a transfer) uses
+     * the swap chain image: it is submitted in a second batch, so the rest
+     * of the frame neither waits for the image nor counts that wait in its
+     * GPU time.
+     */
+    VkPipelineStageFlags _acquireWaitStage() const {
+        return m_dynamic_resolution ? VK_PIPELINE_STAGE_TRANSFER_BIT : VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    }
+    
+    /**
+     * Record the frame in command_buffer, and (with dynamic resolution)
+     * the passes from the upscale on in present_command_buffer.
+     */
+    void recordCommandBuffer(VkCommandBuffer command_buffer, VkCommandBuffer present_command_buffer, uint32_t image_index, uint32_t frame_uniforms_offset) {
         VkCommandBufferBeginInfo command_buffer_begin_info {};
         command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
         
-        if (vkBeginCommandBuffer(command_buffer, &command_buffer_begin_info) != VK_SUCCESS) {
+        if (vkBeginCommandBuffer(command_buffer, &command_buffer_begin_info) != VK_SUCCESS
+            || (present_command_buffer != VK_NULL_HANDLE && vkBeginCommandBuffer(present_command_buffer, &command_buffer_begin_info) != VK_SUCCESS)) {
             Log("failed to begin command buffer!");
             throw std::runtime_error("failed to begin command buffer!");
             return;
         }
+        m_gpu_timer.recordReset(command_buffer);
+        m_pipeline_statistics.recordReset(command_buffer);
+        // Outside of any render pass: the whole frame (the first batch)
+        const uint32_t frame_scope = m_gpu_timer.begin(command_buffer, GPU_SCOPE_FRAME);
         
-        VkRenderPassBeginInfo render_pass_info{};
-        render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-        render_pass_info.renderPass = m_render_pass;
-        render_pass_info.framebuffer = m_swap_chain_framebuffers[image_index];
-        render_pass_info.renderArea.offset = {0, 0};
-        render_pass_info.renderArea.extent = m_swap_chain_extent;
+        // Streamed textures switched this frame: fill their new image
+        // before any pass samples it
+        m_texture_streamer.recordUploads(m_logical_graphics_device, command_buffer, m_frame_descriptor_allocators);
+        _recordLodUpdate(command_buffer);
         
-        VkClearValue clear_color = {{{0.0f, 0.0f, 0.0f, 1.0f}}};
-        render_pass_info.clearValueCount = 1;
-        render_pass_info.pClearValues = &clear_color;
-        
-        vkCmdBeginRenderPass(command_buffer, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
-        vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_graphics_pipeline);
-        vkCmdDraw(command_buffer, 3, 1, 0, 0);
-        vkCmdEndRenderPass(command_buffer);
+        if (m_dynamic_rendering) {
+            _buildFrameGraph(image_index, frame_uniforms_offset);
+            m_frame_graph.execute(command_buffer, present_command_buffer, "upscale");
+        } else {
+            // Culling has to happen outside of the render pass. Same pass
+            // names as the frame graph, for the pipeline statistics.
+            if (m_gpu_driven) {
+                _recordMeasuredPass(command_buffer, "culling", [&] {
+                    m_gpu_culling.recordCulling(m_logical_graphics_device, command_buffer, m_current_frame, m_frame_descriptor_allocators, m_view_proj);
+                });
+                m_gpu_culling.recordOutputBarrier(command_buffer);
+            }
+            if (m_meshlet_path == MeshletPath::ComputeCulling) {
+                _recordMeasuredPass(command_buffer, "meshlet culling", [&] {
+                    m_meshlet_renderer.recordCulling(m_logical_graphics_device, command_buffer, m_current_frame, m_frame_descriptor_allocators, m_view_proj, m_camera_position);
+                });
+                m_meshlet_renderer.recordOutputBarrier(command_buffer);
+            }
+            _recordMeasuredPass(command_buffer, "particles", [&] {
+                _recordParticleSimulation(command_buffer);
+            });
+            m_particles.recordOutputBarrier(command_buffer);
+            if (m_clustered_lighting) {
+                _recordMeasuredPass(command_buffer, "light culling", [&] {
+                    _recordLightCulling(command_buffer);
+                });
+                m_lighting.recordOutputBarrier(command_buffer);
+            }
+            _recordMeasuredPass(command_buffer, "forward", [&] {
+                _recordForwardPass(command_buffer, image_index, frame_uniforms_offset, ForwardPhase::Single);
+            });
+            // Left presentable by the render pass
+            if (m_readback)
+                m_frame_readback.recordCopy(command_buffer, m_current_frame, m_frame_number, m_swap_chain_images[image_index], VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+        }
+        m_gpu_timer.end(command_buffer, frame_scope);
         
-        if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS) {
+        if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS
+            || (present_command_buffer != VK_NULL_HANDLE && vkEndCommandBuffer(present_command_buffer) != VK_SUCCESS)) {
             Log("failed to record command buffer!");
             throw std::runtime_error("failed to record command buffer!");
             return;
@@ -837,25 +2916,88 @@ private:
     }
     
     void drawFrame() {
-        // Wait until the previous frame has finished
-        vkWaitForFences(m_logical_graphics_device, 1, &m_in_flight_fence, VK_TRUE, UINT64_MAX);
-        vkResetFences(m_logical_graphics_device, 1, &m_in_flight_fence);
+        ProfileZone("drawFrame");
+        // Wait until the previous use of this frame has finished
+        VkFence in_flight_fence = m_in_flight_fences[m_current_frame];
+        {
+            ProfileZone("wait for frame fence");
+            vkWaitForFences(m_logical_graphics_device, 1, &in_flight_fence, VK_TRUE, UINT64_MAX);
+        }
+        vkResetFences(m_logical_graphics_device, 1, &in_flight_fence);
+        // Timestamps of the previous use of this frame are available
+        m_gpu_timer.beginFrame(m_logical_graphics_device, m_current_frame);
+        m_pipeline_statistics.beginFrame(m_logical_graphics_device, m_current_frame);
+        _updateRenderScale();
+        // Images copied by the previous use of this frame are readable
+        if (m_readback)
+            m_frame_readback.beginFrame(m_logical_graphics_device, m_current_frame);
+        if (m_gpu_driven)
+            m_gpu_culling.beginFrame(m_current_frame);
+        const auto frame_time = std::chrono::steady_clock::now();
+        m_frame_delta_time = std::chrono::duration<float>(frame_time - m_last_frame_time).count();
+        m_last_frame_time = frame_time;
+        // Switch the streamed textures whose load has completed (their new
+        // handles are written below), and queue the next loads
+        m_texture_streamer.beginFrame(m_logical_graphics_device, m_current_frame);
+        m_mip_generator.beginFrame(m_logical_graphics_device, m_current_frame);
+        // The GPU is done with the resources of this frame: write the new
+        // descriptors, and drop the transient sets of its previous use
+        m_bindless.update(m_logical_graphics_device, m_current_frame);
+        m_frame_descriptor_allocators.beginFrame(m_logical_graphics_device, m_current_frame);
+        m_uniform_allocator.beginFrame(m_current_frame);
+        if (m_parallel_recording)
+            m_parallel_recorder.beginFrame(m_logical_graphics_device, m_current_frame);
+        _updateLods();
+        
+        // CPU work of the frame, run by the workers while the main
+        // thread waits for the swap chain image
+        JobCounter frame_jobs;
+        uint32_t frame_uniforms_offset = 0;
+        m_job_system.run(frame_jobs, "frame uniforms", [this, &frame_uniforms_offset] {
+            frame_uniforms_offset = _prepareFrameUniforms();
+        });
+        if (!m_gpu_driven)
+            m_job_system.run(frame_jobs, "cpu culling", [this] { _cullDraws(); });
+        if (m_meshlet_path == MeshletPath::Cpu) {
+            m_job_system.run(frame_jobs, "meshlet culling", [this] {
+                m_meshlet_renderer.cull(m_job_system, m_scene.objects, extractFrustumPlanes(m_view_proj), m_camera_position);
+            });
+        }
+        // Read by the streamer at the next frame
+        if (m_streamed_texture_count > 0)
+            m_job_system.run(frame_jobs, "texture requests", [this] { _requestTextureMips(); });
         
         // Acquire an image from the swap chain
         uint32_t image_acq_index {};
-        vkAcquireNextImageKHR(
-                              m_logical_graphics_device,
-                              m_swap_chain,
-                              UINT64_MAX,
-                              m_image_avail_semaphore,
-                              VK_NULL_HANDLE,
-                              &image_acq_index);
-        vkResetCommandBuffer(m_command_buffer, 0);
-        recordCommandBuffer(m_command_buffer, image_acq_index);
-        
-        VkSemaphore wait_semaphores[] = {m_image_avail_semaphore};
-        VkPipelineStageFlags wait_stages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-        VkSemaphore signal_semaphores[] = {m_render_finished_semaphore};
+        {
+            ProfileZone("acquire");
+            vkAcquireNextImageKHR(
+                                  m_logical_graphics_device,
+                                  m_swap_chain,
+                                  UINT64_MAX,
+                                  m_image_avail_semaphores[m_current_frame],
+                                  VK_NULL_HANDLE,
+                                  &image_acq_index);
+        }
+        {
+            // Runs the jobs left, which have their own zones
+            ProfileZone("wait for frame jobs");
+            m_job_system.wait(frame_jobs);
+        }
+        VkCommandBuffer command_buffer = m_command_buffers[m_current_frame];
+        VkCommandBuffer present_command_buffer = m_dynamic_resolution ? m_present_command_buffers[m_current_frame] : VK_NULL_HANDLE;
+        {
+            ProfileZone("record");
+            _buildDrawList(frame_uniforms_offset);
+            vkResetCommandBuffer(command_buffer, 0);
+            if (present_command_buffer != VK_NULL_HANDLE)
+                vkResetCommandBuffer(present_command_buffer, 0);
+            recordCommandBuffer(command_buffer, present_command_buffer, image_acq_index, frame_uniforms_offset);
+        }
+        
+        VkSemaphore wait_semaphores[] = {m_image_avail_semaphores[m_current_frame]};
+        VkPipelineStageFlags wait_stages[] = {_acquireWaitStage()};
+        VkSemaphore signal_semaphores[] = {m_render_finished_semaphores[m_current_frame]};
         
         // Submit the command buffer
         VkSubmitInfo submit_info {};
@@ -864,14 +3006,25 @@ private:
         submit_info.pWaitSemaphores = wait_semaphores;
         submit_info.pWaitDstStageMask = wait_stages;
         submit_info.commandBufferCount = 1;
-        submit_info.pCommandBuffers = &m_command_buffer;
+        submit_info.pCommandBuffers = &command_buffer;
         submit_info.signalSemaphoreCount = 1;
         submit_info.pSignalSemaphores = signal_semaphores;
+        // Dynamic resolution: only the second batch waits for the swap chain image
+        VkSubmitInfo submit_infos[2] = {submit_info, submit_info};
+        if (present_command_buffer != VK_NULL_HANDLE) {
+            submit_infos[0].waitSemaphoreCount = 0;
+            submit_infos[0].signalSemaphoreCount = 0;
+            submit_infos[1].pCommandBuffers = &present_command_buffer;
+        }
+        const uint32_t submit_count = present_command_buffer != VK_NULL_HANDLE ? 2 : 1;
         
-        if (vkQueueSubmit(m_graphics_queue, 1, &submit_info, m_in_flight_fence) != VK_SUCCESS) {
-            LogE("failed to submit draw command buffer!");
-            throw std::runtime_error("failed to submit draw command buffer!");
-            return;
+        {
+            ProfileZone("submit");
+            if (vkQueueSubmit(m_graphics_queue, submit_count, submit_infos, in_flight_fence) != VK_SUCCESS) {
+                LogE("failed to submit draw command buffer!");
+                throw std::runtime_error("failed to submit draw command buffer!");
+                return;
+            }
         }
         
         VkPresentInfoKHR present_info{};
@@ -882,7 +3035,20 @@ private:
         present_info.swapchainCount = 1;
         present_info.pSwapchains = swap_chains;
         present_info.pImageIndices = &image_acq_index;
-        vkQueuePresentKHR(m_present_queue, &present_info);
+        {
+            ProfileZone("present");
+            vkQueuePresentKHR(m_present_queue, &present_info);
+        }
+        
+        m_current_frame = (m_current_frame + 1) % MAX_FRAMES_IN_FLIGHT;
+        m_frame_number++;
+        _reportJobTimings();
+        _reportTextureStreaming();
+        _reportCullingStats();
+        _reportDrawListStats();
+        _reportPipelineStatistics();
+        _runParticleBenchmark();
+        _runLightBenchmark();
     }
     
     void initWindow() {
@@ -894,19 +3060,50 @@ private:
         m_app_window = glfwCreateWindow(WIDTH, HEIGHT, APPLICATION_TITLE, nullptr, nullptr);
     }
     
+    /**
+     * Run an initialization step in a profiler zone.
+     */
+    void _initStep(const char *name, void (TriangleApplication::*step)()) {
+        ProfileZone(name);
+        (this->*step)();
+    }
+    
     void initSystem() {
-        _initVulkan();
-        _createSurface();
-        _pickGraphicsDevice();
-        _initLogicalGraphicsDevice();
-        _createSwapChain();
-        _createImageViews();
-        _createRenderPass();
-        _createGraphicsPipeline();
-        _createFramebuffers();
-        _createCommandPool();
-        _createCommandBuffer();
-        _createSyncObjects();
+        ProfileZone("initSystem");
+        _initStep("createJobSystem", &TriangleApplication::_createJobSystem);
+        _initStep("initVulkan", &TriangleApplication::_initVulkan);
+        _initStep("createSurface", &TriangleApplication::_createSurface);
+        _initStep("pickGraphicsDevice", &TriangleApplication::_pickGraphicsDevice);
+        _initStep("initLogicalGraphicsDevice", &TriangleApplication::_initLogicalGraphicsDevice);
+        _initStep("createSwapChain", &TriangleApplication::_createSwapChain);
+        _initStep("createImageViews", &TriangleApplication::_createImageViews);
+        _initStep("createRenderTargets", &TriangleApplication::_createRenderTargets);
+        _initStep("createCamera", &TriangleApplication::_createCamera);
+        _initStep("createRenderPass", &TriangleApplication::_createRenderPass);
+        _initStep("createCommandPool", &TriangleApplication::_createCommandPool);
+        _initStep("createParallelRecorder", &TriangleApplication::_createParallelRecorder);
+        _initStep("createTextures", &TriangleApplication::_createTextures);
+        _initStep("createBindlessDescriptors", &TriangleApplication::_createBindlessDescriptors);
+        _initStep("createMipGenerator", &TriangleApplication::_createMipGenerator);
+        _initStep("createTextureStreamer", &TriangleApplication::_createTextureStreamer);
+        _initStep("createSceneDescriptorSetLayout", &TriangleApplication::_createSceneDescriptorSetLayout);
+        _initStep("createSceneBuffers", &TriangleApplication::_createSceneBuffers);
+        _initStep("createDescriptorAllocators", &TriangleApplication::_createDescriptorAllocators);
+        _initStep("createSceneDescriptorSet", &TriangleApplication::_createSceneDescriptorSet);
+        _initStep("createFrameUniforms", &TriangleApplication::_createFrameUniforms);
+        _initStep("createMeshletRenderer", &TriangleApplication::_createMeshletRenderer);
+        _initStep("createClusteredLighting", &TriangleApplication::_createClusteredLighting);
+        _initStep("createGraphicsPipeline", &TriangleApplication::_createGraphicsPipeline);
+        _initStep("createFramebuffers", &TriangleApplication::_createFramebuffers);
+        _initStep("createDepthPyramid", &TriangleApplication::_createDepthPyramid);
+        _initStep("initGpuCulling", &TriangleApplication::_initGpuCulling);
+        _initStep("createGpuTimer", &TriangleApplication::_createGpuTimer);
+        _initStep("createPipelineStatistics", &TriangleApplication::_createPipelineStatistics);
+        _initStep("createFrameReadback", &TriangleApplication::_createFrameReadback);
+        _initStep("createParticleSystem", &TriangleApplication::_createParticleSystem);
+        _initStep("createFrameGraph", &TriangleApplication::_createFrameGraph);
+        _initStep("createCommandBuffers", &TriangleApplication::_createCommandBuffers);
+        _initStep("createSyncObjects", &TriangleApplication::_createSyncObjects);
     }
     
     void loop() {
@@ -924,11 +3121,57 @@ private:
         Log("######################################");
         
         Log("* Destroying semaphores and fence objects...");
-        vkDestroySemaphore(m_logical_graphics_device, m_image_avail_semaphore, nullptr);
-        vkDestroySemaphore(m_logical_graphics_device, m_render_finished_semaphore, nullptr);
-        vkDestroyFence(m_logical_graphics_device, m_in_flight_fence, nullptr);
+        for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+            vkDestroySemaphore(m_logical_graphics_device, m_image_avail_semaphores[i], nullptr);
+            vkDestroySemaphore(m_logical_graphics_device, m_render_finished_semaphores[i], nullptr);
+            vkDestroyFence(m_logical_graphics_device, m_in_flight_fences[i], nullptr);
+        }
+        
+        Log("* Destroying the frame graph resources...");
+        m_frame_graph.clean(m_logical_graphics_device);
+        
+        Log("* Destroying the GPU culling resources and the depth pyramid...");
+        m_gpu_culling.clean(m_logical_graphics_device);
+        m_depth_pyramid.clean(m_logical_graphics_device);
+        
+        Log("* Destroying the meshlet renderer...");
+        m_meshlet_renderer.clean(m_logical_graphics_device);
+        
+        Log("* Destroying the clustered lighting...");
+        m_lighting.clean(m_logical_graphics_device, m_bindless);
+        
+        Log("* Flushing the frame capture and destroying the readback buffers...");
+        if (m_frame_capture)
+            m_capture_encoder.clean();
+        m_frame_readback.clean(m_logical_graphics_device);
+        
+        Log("* Destroying the particle system, the GPU timer and the pipeline statistics queries...");
+        m_particles.clean(m_logical_graphics_device);
+        m_gpu_timer.clean(m_logical_graphics_device);
+        m_pipeline_statistics.clean(m_logical_graphics_device);
+        
+        Log("* Destroying the scene buffers and descriptors...");
+        vkDestroyDescriptorSetLayout(m_logical_graphics_device, m_frame_descriptor_set_layout, nullptr);
+        m_uniform_allocator.clean(m_logical_graphics_device);
+        m_frame_descriptor_allocators.clean(m_logical_graphics_device);
+        m_descriptor_allocator.clean(m_logical_graphics_device);
+        vkDestroyDescriptorSetLayout(m_logical_graphics_device, m_scene_descriptor_set_layout, nullptr);
+        destroyBuffer(m_logical_graphics_device, m_draw_buffer);
+        destroyBuffer(m_logical_graphics_device, m_object_buffer);
+        destroyBuffer(m_logical_graphics_device, m_index_buffer);
+        destroyBuffer(m_logical_graphics_device, m_vertex_buffer);
+        
+        Log("* Destroying the bindless descriptors and the textures...");
+        m_texture_streamer.clean(m_logical_graphics_device);
+        m_mip_generator.clean(m_logical_graphics_device);
+        m_bindless.clean(m_logical_graphics_device);
+        for (AllocatedImage &texture: m_textures)
+            destroyImage(m_logical_graphics_device, texture);
+        vkDestroySampler(m_logical_graphics_device, m_default_sampler, nullptr);
         
         Log("* Destroying the command pool...");
+        if (m_parallel_recording)
+            m_parallel_recorder.clean(m_logical_graphics_device);
         vkDestroyCommandPool(m_logical_graphics_device, m_command_pool, nullptr);
         
         Log("* Destroying the framebuffers...");
@@ -938,13 +3181,21 @@ private:
         
         Log("* Destroying the graphics pipeline...");
         vkDestroyPipeline(m_logical_graphics_device, m_graphics_pipeline, nullptr);
+        if (m_depth_prepass_pipeline != VK_NULL_HANDLE) vkDestroyPipeline(m_logical_graphics_device, m_depth_prepass_pipeline, nullptr);
+        if (m_meshlet_pipeline != VK_NULL_HANDLE) vkDestroyPipeline(m_logical_graphics_device, m_meshlet_pipeline, nullptr);
+        if (m_meshlet_depth_prepass_pipeline != VK_NULL_HANDLE) vkDestroyPipeline(m_logical_graphics_device, m_meshlet_depth_prepass_pipeline, nullptr);
         
         Log("* Destroying the pipeline layout...");
         vkDestroyPipelineLayout(m_logical_graphics_device, m_pipeline_layout, nullptr);
+        if (m_meshlet_pipeline_layout != VK_NULL_HANDLE) vkDestroyPipelineLayout(m_logical_graphics_device, m_meshlet_pipeline_layout, nullptr);
         
         Log("* Destroying the render pass...");
-        vkDestroyRenderPass(m_logical_graphics_device, m_render_pass, nullptr);
+        if (m_render_pass != VK_NULL_HANDLE) vkDestroyRenderPass(m_logical_graphics_device, m_render_pass, nullptr);
 
+        Log("* Destroying the render targets...");
+        destroyImage(m_logical_graphics_device, m_msaa_color_target);
+        destroyImage(m_logical_graphics_device, m_depth_target);
+        
         Log("* Destroying the image views...");
         for (const VkImageView image_view: m_swap_chain_image_views) {
             vkDestroyImageView(m_logical_graphics_device, image_view, nullptr);
@@ -964,6 +3215,9 @@ private:
         
         Log("* Destroying the (GLFW) window...");
         if (m_app_window != nullptr) glfwDestroyWindow(m_app_window);
+        
+        Log("* Stopping the job system...");
+        m_job_system.clean();
 
         Log("Terminating...");
         glfwTerminate();
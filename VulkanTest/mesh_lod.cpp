@@ -0,0 +1,361 @@
+//
+//  mesh_lod.cpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#include "mesh_lod.hpp"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <tuple>
+
+// Weight of the planes holding the open borders in place, per squared
+// length of their edge: moving a border costs more than moving a surface
+constexpr double const BORDER_PLANE_WEIGHT = 10.0;
+// A level keeping more than this fraction of the triangles of the previous
+// one is not worth it: the mesh can not be simplified further
+constexpr float const MAX_LEVEL_RATIO = 0.95f;
+
+/**
+ * Quadric error of a vertex (Garland & Heckbert): the weighted sum of the
+ * squared distances to a set of planes, as a symmetric 4x4 matrix.
+ */
+struct Quadric {
+    // Upper triangle of the matrix
+    double a00 = 0.0, a01 = 0.0, a02 = 0.0, a03 = 0.0;
+    double a11 = 0.0, a12 = 0.0, a13 = 0.0;
+    double a22 = 0.0, a23 = 0.0;
+    double a33 = 0.0;
+    // Sum of the weights of the planes
+    double weight = 0.0;
+
+    /**
+     * Add the plane dot(normal, p) + distance = 0 (normal of length 1).
+     */
+    void addPlane(const glm::dvec3 &normal, double distance, double plane_weight) {
+        a00 += plane_weight * normal.x * normal.x;
+        a01 += plane_weight * normal.x * normal.y;
+        a02 += plane_weight * normal.x * normal.z;
+        a03 += plane_weight * normal.x * distance;
+        a11 += plane_weight * normal.y * normal.y;
+        a12 += plane_weight * normal.y * normal.z;
+        a13 += plane_weight * normal.y * distance;
+        a22 += plane_weight * normal.z * normal.z;
+        a23 += plane_weight * normal.z * distance;
+        a33 += plane_weight * distance * distance;
+        weight += plane_weight;
+    }
+
+    void add(const Quadric &other) {
+        a00 += other.a00; a01 += other.a01; a02 += other.a02; a03 += other.a03;
+        a11 += other.a11; a12 += other.a12; a13 += other.a13;
+        a22 += other.a22; a23 += other.a23;
+        a33 += other.a33;
+        weight += other.weight;
+    }
+
+    /**
+     * Mean squared distance of the point to the planes.
+     */
+    double meanSquaredDistance(const glm::dvec3 &p) const {
+        if (weight <= 0.0)
+            return 0.0;
+        const double sum = a00 * p.x * p.x + a11 * p.y * p.y + a22 * p.z * p.z + a33
+            + 2.0 * (a01 * p.x * p.y + a02 * p.x * p.z + a12 * p.y * p.z + a03 * p.x + a13 * p.y + a23 * p.z);
+        // Rounding errors can make it slightly negative
+        return std::max(sum, 0.0) / weight;
+    }
+};
+
+/**
+ * Moving the vertex from onto the vertex to, and the error it adds.
+ */
+struct Collapse {
+    uint32_t from;
+    uint32_t to;
+    double squared_error;
+};
+
+/**
+ * Edge collapse simplification of a mesh, level after level.
+ * Vertices at the same position (UV seams, poles) are welded for the
+ * topology and the quadrics, but the triangles keep their own vertex
+ * for the corners that do not move, so attribute seams are preserved.
+ */
+class QuadricSimplifier {
+
+public:
+    QuadricSimplifier(const Scene &scene, const MeshRange &mesh) {
+        m_indices.assign(scene.indices.begin() + mesh.first_index, scene.indices.begin() + mesh.first_index + mesh.index_count);
+        const uint32_t vertex_count = m_indices.empty() ? 0 : *std::max_element(m_indices.begin(), m_indices.end()) + 1;
+        m_positions.resize(vertex_count);
+        m_canonical.resize(vertex_count);
+        std::map<std::tuple<float, float, float>, uint32_t> vertex_at;
+        for (uint32_t i = 0; i < vertex_count; i++) {
+            const glm::vec3 &position = scene.vertices[mesh.vertex_offset + i].position;
+            m_positions[i] = glm::dvec3(position);
+            m_canonical[i] = vertex_at.emplace(std::make_tuple(position.x, position.y, position.z), i).first->second;
+        }
+        // Welded corners can make a triangle degenerated
+        _removeDegeneratedTriangles();
+
+        // Planes of the triangles, weighted by their area
+        m_quadrics.resize(vertex_count);
+        m_border.assign(vertex_count, 0);
+        std::map<std::pair<uint32_t, uint32_t>, uint32_t> edge_triangles;
+        for (size_t i = 0; i < m_indices.size(); i += 3) {
+            const uint32_t corners[3] = {_vertex(i), _vertex(i + 1), _vertex(i + 2)};
+            const glm::dvec3 normal = _normal(corners[0], corners[1], corners[2]);
+            const double length = glm::length(normal);
+            if (length <= 0.0)
+                continue;
+            const glm::dvec3 unit_normal = normal / length;
+            for (uint32_t corner: corners)
+                m_quadrics[corner].addPlane(unit_normal, -glm::dot(unit_normal, m_positions[corners[0]]), 0.5 * length);
+            for (uint32_t j = 0; j < 3; j++)
+                edge_triangles[std::minmax(corners[j], corners[(j + 1) % 3])]++;
+        }
+        // Open borders: planes through the edge, perpendicular to its triangle
+        for (size_t i = 0; i < m_indices.size(); i += 3) {
+            const uint32_t corners[3] = {_vertex(i), _vertex(i + 1), _vertex(i + 2)};
+            const glm::dvec3 normal = _normal(corners[0], corners[1], corners[2]);
+            for (uint32_t j = 0; j < 3; j++) {
+                const uint32_t a = corners[j];
+                const uint32_t b = corners[(j + 1) % 3];
+                if (edge_triangles[std::minmax(a, b)] != 1)
+                    continue;
+                const glm::dvec3 edge = m_positions[b] - m_positions[a];
+                const glm::dvec3 border_normal = glm::cross(edge, normal);
+                const double length = glm::length(border_normal);
+                if (length <= 0.0)
+                    continue;
+                const glm::dvec3 unit_normal = border_normal / length;
+                const double plane_weight = BORDER_PLANE_WEIGHT * glm::dot(edge, edge);
+                m_quadrics[a].addPlane(unit_normal, -glm::dot(unit_normal, m_positions[a]), plane_weight);
+                m_quadrics[b].addPlane(unit_normal, -glm::dot(unit_normal, m_positions[a]), plane_weight);
+                m_border[a] = 1;
+                m_border[b] = 1;
+            }
+        }
+    }
+
+    /**
+     * Collapse edges until at most target_index_count indices are left.
+     * Returns false if the mesh could not be simplified that far.
+     */
+    bool simplify(size_t target_index_count) {
+        while (m_indices.size() > target_index_count) {
+            if (!_collapsePass(target_index_count))
+                return false;
+        }
+        return true;
+    }
+
+    const std::vector<uint32_t>& indices() const { return m_indices; }
+
+    /**
+     * Largest error added by a collapse so far (the quadrics accumulate
+     * the planes of the source triangles), as a distance.
+     */
+    float error() const { return static_cast<float>(std::sqrt(m_squared_error)); }
+
+private:
+    // Mesh-local indices of the current triangles
+    std::vector<uint32_t> m_indices;
+    std::vector<glm::dvec3> m_positions;
+    // First vertex at the same position: the one carrying the topology
+    std::vector<uint32_t> m_canonical;
+    // Per canonical vertex
+    std::vector<Quadric> m_quadrics;
+    std::vector<uint8_t> m_border;
+    double m_squared_error = 0.0;
+
+    uint32_t _vertex(size_t index) const { return m_canonical[m_indices[index]]; }
+
+    glm::dvec3 _normal(uint32_t a, uint32_t b, uint32_t c) const {
+        return glm::cross(m_positions[b] - m_positions[a], m_positions[c] - m_positions[a]);
+    }
+
+    void _removeDegeneratedTriangles() {
+        size_t kept = 0;
+        for (size_t i = 0; i < m_indices.size(); i += 3) {
+            const uint32_t a = _vertex(i);
+            const uint32_t b = _vertex(i + 1);
+            const uint32_t c = _vertex(i + 2);
+            if (a == b || b == c || c == a)
+                continue;
+            std::copy(m_indices.begin() + i, m_indices.begin() + i + 3, m_indices.begin() + kept);
+            kept += 3;
+        }
+        m_indices.resize(kept);
+    }
+
+    /**
+     * True if moving collapse.from onto collapse.to turns one of the
+     * triangles around it (which do not disappear) by 90 degrees or more.
+     */
+    bool _flips(const Collapse &collapse, const std::vector<uint32_t> &first_triangle, const std::vector<uint32_t> &triangles) const {
+        for (uint32_t i = first_triangle[collapse.from]; i < first_triangle[collapse.from + 1]; i++) {
+            const size_t base = triangles[i] * 3;
+            uint32_t corners[3] = {_vertex(base), _vertex(base + 1), _vertex(base + 2)};
+            if (std::find(corners, corners + 3, collapse.to) != corners + 3)
+                continue;
+            const glm::dvec3 before = _normal(corners[0], corners[1], corners[2]);
+            std::replace(corners, corners + 3, collapse.from, collapse.to);
+            const glm::dvec3 after = _normal(corners[0], corners[1], corners[2]);
+            if (glm::dot(before, after) <= 0.0)
+                return true;
+        }
+        return false;
+    }
+
+    /**
+     * Collapse the edges in the order of their error, each vertex moving at
+     * most once: the triangles around a collapse are left alone until the
+     * next pass, so that the flip tests stay exact.
+     * Returns false if no edge could be collapsed.
+     */
+    bool _collapsePass(size_t target_index_count) {
+        const uint32_t vertex_count = static_cast<uint32_t>(m_positions.size());
+        const uint32_t triangle_count = static_cast<uint32_t>(m_indices.size() / 3);
+        // Triangles around each vertex: triangles[first_triangle[v], first_triangle[v + 1])
+        std::vector<uint32_t> first_triangle(vertex_count + 1, 0);
+        for (size_t i = 0; i < m_indices.size(); i++)
+            first_triangle[_vertex(i) + 1]++;
+        for (uint32_t v = 0; v < vertex_count; v++)
+            first_triangle[v + 1] += first_triangle[v];
+        std::vector<uint32_t> triangles(m_indices.size());
+        std::vector<uint32_t> fill = first_triangle;
+        for (size_t i = 0; i < m_indices.size(); i++)
+            triangles[fill[_vertex(i)]++] = static_cast<uint32_t>(i / 3);
+
+        // Both directions of every edge. A border vertex only moves along
+        // the border, onto another border vertex.
+        std::vector<Collapse> collapses;
+        collapses.reserve(m_indices.size() * 2);
+        for (size_t i = 0; i < m_indices.size(); i++) {
+            const uint32_t a = _vertex(i);
+            const uint32_t b = _vertex(i - i % 3 + (i + 1) % 3);
+            for (const auto &[from, to]: {std::make_pair(a, b), std::make_pair(b, a)}) {
+                if (m_border[from] && !m_border[to])
+                    continue;
+                Quadric quadric = m_quadrics[from];
+                quadric.add(m_quadrics[to]);
+                collapses.push_back({from, to, quadric.meanSquaredDistance(m_positions[to])});
+            }
+        }
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse &a, const Collapse &b) {
+            return a.squared_error < b.squared_error;
+        });
+
+        std::vector<uint8_t> locked(vertex_count, 0);
+        std::vector<uint8_t> removed(triangle_count, 0);
+        size_t index_count = m_indices.size();
+        bool collapsed = false;
+        for (const Collapse &collapse: collapses) {
+            if (index_count <= target_index_count)
+                break;
+            if (locked[collapse.from] || locked[collapse.to] || _flips(collapse, first_triangle, triangles))
+                continue;
+            for (uint32_t i = first_triangle[collapse.from]; i < first_triangle[collapse.from + 1]; i++) {
+                const uint32_t triangle = triangles[i];
+                const size_t base = triangle * 3;
+                for (size_t corner = base; corner < base + 3; corner++) {
+                    if (_vertex(corner) == collapse.from)
+                        m_indices[corner] = collapse.to;
+                    locked[_vertex(corner)] = 1;
+                }
+                const uint32_t a = _vertex(base);
+                const uint32_t b = _vertex(base + 1);
+                const uint32_t c = _vertex(base + 2);
+                if (a == b || b == c || c == a) {
+                    removed[triangle] = 1;
+                    index_count -= 3;
+                }
+            }
+            locked[collapse.from] = 1;
+            m_quadrics[collapse.to].add(m_quadrics[collapse.from]);
+            m_border[collapse.to] |= m_border[collapse.from];
+            m_squared_error = std::max(m_squared_error, collapse.squared_error);
+            collapsed = true;
+        }
+
+        size_t kept = 0;
+        for (uint32_t triangle = 0; triangle < triangle_count; triangle++) {
+            if (removed[triangle])
+                continue;
+            std::copy(m_indices.begin() + triangle * 3, m_indices.begin() + triangle * 3 + 3, m_indices.begin() + kept);
+            kept += 3;
+        }
+        m_indices.resize(kept);
+        return collapsed;
+    }
+};
+
+MeshLodChain buildMeshLods(Scene &scene, const MeshRange &mesh, uint32_t max_levels, float reduction, uint32_t min_triangles) {
+    MeshLodChain chain;
+    chain.levels.push_back({mesh, 0.0f});
+    QuadricSimplifier simplifier(scene, mesh);
+    while (chain.levels.size() < max_levels) {
+        const size_t previous_count = simplifier.indices().size();
+        const size_t target_count = 3 * std::max(static_cast<size_t>(min_triangles), static_cast<size_t>(static_cast<float>(previous_count / 3) * reduction));
+        if (target_count >= previous_count)
+            break;
+        simplifier.simplify(target_count);
+        const std::vector<uint32_t> &indices = simplifier.indices();
+        if (static_cast<float>(indices.size()) > MAX_LEVEL_RATIO * static_cast<float>(previous_count))
+            break;
+        MeshLod lod {};
+        lod.range = {static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(scene.indices.size()), mesh.vertex_offset};
+        lod.error = simplifier.error();
+        scene.indices.insert(scene.indices.end(), indices.begin(), indices.end());
+        chain.levels.push_back(lod);
+    }
+    return chain;
+}
+
+float lodPixelsPerUnit(const glm::mat4 &projection, float viewport_height) {
+    // projection[1][1] maps a unit at a depth of 1 to clip space, whose
+    // [-1, 1] range spans the viewport
+    return std::abs(projection[1][1]) * 0.5f * viewport_height;
+}
+
+float projectedLodError(float error, float scale, float view_depth, float pixels_per_unit) {
+    // At the eye (or behind it): full detail
+    if (view_depth <= 0.0f)
+        return INFINITY;
+    return error * scale * pixels_per_unit / view_depth;
+}
+
+uint32_t selectLod(const MeshLodChain &chain, float scale, float view_depth, float pixels_per_unit, float threshold_pixels, float hysteresis, uint32_t current_level) {
+    // The errors grow with the level: the first one under its threshold is the coarsest
+    for (uint32_t level = static_cast<uint32_t>(chain.levels.size()) - 1; level > 0; level--) {
+        const float threshold = threshold_pixels * (level > current_level ? 1.0f - hysteresis : 1.0f + hysteresis);
+        if (projectedLodError(chain.levels[level].error, scale, view_depth, pixels_per_unit) <= threshold)
+            return level;
+    }
+    return 0;
+}
+
+void updateLodState(LodState &state, uint32_t level, float delta_time, float crossfade_seconds) {
+    if (state.fade < 1.0f) {
+        state.fade = crossfade_seconds > 0.0f ? std::min(state.fade + delta_time / crossfade_seconds, 1.0f) : 1.0f;
+        // At most two levels drawn: the next switch waits for the end of the crossfade
+        if (state.fade < 1.0f)
+            return;
+    }
+    if (level == state.level)
+        return;
+    state.previous_level = state.level;
+    state.level = level;
+    state.fade = crossfade_seconds > 0.0f ? 0.0f : 1.0f;
+}
+
+uint32_t lodFadeBits(const LodState &state, bool fading_out) {
+    if (state.fade >= 1.0f)
+        return 0;
+    const uint32_t fraction = static_cast<uint32_t>(state.fade * static_cast<float>(LOD_FADE_MASK) + 0.5f);
+    return LOD_FADE_BIT | (fading_out ? LOD_FADE_OUT_BIT : 0) | fraction;
+}
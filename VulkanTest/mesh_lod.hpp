@@ -0,0 +1,101 @@
+//
+//  mesh_lod.hpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#ifndef mesh_lod_hpp
+#define mesh_lod_hpp
+
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "scene.hpp"
+
+// ObjectData::material.w of an object drawn during a LOD crossfade (0
+// otherwise): the fragment shader keeps a dithered part of its pixels
+// - LOD_FADE_MASK: fraction of the pixels kept, in 1 / LOD_FADE_MASK
+// - LOD_FADE_OUT_BIT: keep the other pixels (the level fading out)
+// - LOD_FADE_BIT: set during the crossfade, so that a fraction of 0 is valid
+constexpr uint32_t const LOD_FADE_MASK = 0xFFFF;
+constexpr uint32_t const LOD_FADE_OUT_BIT = 1u << 16;
+constexpr uint32_t const LOD_FADE_BIT = 1u << 17;
+
+/**
+ * One level of detail of a mesh. error bounds the distance between the
+ * level and the full detail mesh (mesh space units): an approximation, the
+ * root mean square distance to the planes of the source triangles merged
+ * in each vertex.
+ */
+struct MeshLod {
+    MeshRange range;
+    float error;
+};
+
+/**
+ * Levels of detail of a mesh, from the mesh itself (level 0, error 0) to
+ * the coarsest one. The levels share the vertices of the mesh: only their
+ * indices are added to the scene.
+ */
+struct MeshLodChain {
+    std::vector<MeshLod> levels;
+};
+
+/**
+ * Level of detail of an object, from frame to frame.
+ * While fade < 1, previous_level is still drawn, fading out.
+ */
+struct LodState {
+    uint32_t level = 0;
+    uint32_t previous_level = 0;
+    float fade = 1.0f;
+};
+
+/**
+ * Build the levels of detail of a mesh of the scene, at import time, and
+ * append their indices to the scene.
+ * Each level keeps about reduction times the triangles of the previous one
+ * (at least min_triangles), simplified by quadric error edge collapses:
+ * the edges are collapsed to one of their vertices in the order of the
+ * error they add, as long as no triangle flips.
+ * The chain stops after max_levels levels, or when the mesh can not be
+ * simplified further.
+ */
+MeshLodChain buildMeshLods(Scene &scene, const MeshRange &mesh, uint32_t max_levels, float reduction, uint32_t min_triangles);
+
+/**
+ * Projected size in pixels of 1 unit at a view depth of 1, for a
+ * perspective projection and a viewport of the given height.
+ */
+float lodPixelsPerUnit(const glm::mat4 &projection, float viewport_height);
+
+/**
+ * Size in pixels of the error of a level drawn with the given scale, at
+ * the given view depth (see lodPixelsPerUnit).
+ */
+float projectedLodError(float error, float scale, float view_depth, float pixels_per_unit);
+
+/**
+ * The coarsest level whose projected error stays under threshold_pixels.
+ * With hysteresis h, a level coarser than current_level must stay under
+ * threshold_pixels * (1 - h), and the levels up to current_level under
+ * threshold_pixels * (1 + h): an object around a switch distance does
+ * not switch back and forth.
+ */
+uint32_t selectLod(const MeshLodChain &chain, float scale, float view_depth, float pixels_per_unit, float threshold_pixels, float hysteresis, uint32_t current_level);
+
+/**
+ * Move the object to the selected level: with crossfade_seconds > 0, the
+ * current level fades out over that time while the new one fades in,
+ * otherwise the level switches at once.
+ */
+void updateLodState(LodState &state, uint32_t level, float delta_time, float crossfade_seconds);
+
+/**
+ * ObjectData::material.w of an object drawing the current level of the
+ * state (fading_out = false), or the previous one (fading_out = true).
+ */
+uint32_t lodFadeBits(const LodState &state, bool fading_out);
+
+#endif /* mesh_lod_hpp */
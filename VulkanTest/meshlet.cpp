@@ -0,0 +1,280 @@
+//
+//  meshlet.cpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#include "meshlet.hpp"
+#include "base.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+
+// "MSHL", then the format version
+constexpr uint32_t const MESHLET_FILE_MAGIC = 0x4C48534D;
+constexpr uint32_t const MESHLET_FILE_VERSION = 1;
+
+// Local index of the vertices out of the meshlet being built
+constexpr uint8_t const NO_LOCAL_INDEX = 0xFF;
+constexpr uint32_t const NO_TRIANGLE = UINT32_MAX;
+
+// Under this cosine (about 85 degrees) the normal cone is too wide to cull anything
+constexpr float const MIN_CONE_COSINE = 0.1f;
+
+static_assert(MESHLET_MAX_VERTICES < NO_LOCAL_INDEX, "local vertex indices are stored on 8 bits");
+
+/**
+ * Bounding sphere and normal cone of the triangles [triangle_offset, end) of the mesh.
+ */
+static void computeMeshletBounds(const std::vector<Vertex> &vertices, const MeshletMesh &mesh, Meshlet &meshlet) {
+    glm::vec3 min_position(INFINITY);
+    glm::vec3 max_position(-INFINITY);
+    for (uint32_t i = 0; i < meshlet.vertex_count; i++) {
+        const glm::vec3 &position = vertices[mesh.vertices[meshlet.vertex_offset + i]].position;
+        min_position = glm::min(min_position, position);
+        max_position = glm::max(max_position, position);
+    }
+    const glm::vec3 center = (min_position + max_position) * 0.5f;
+    float radius = 0.0f;
+    for (uint32_t i = 0; i < meshlet.vertex_count; i++)
+        radius = std::max(radius, glm::length(vertices[mesh.vertices[meshlet.vertex_offset + i]].position - center));
+    meshlet.bounds = glm::vec4(center, radius);
+
+    // Front faces: clockwise on screen, so (b - a) x (c - a) points to the camera
+    std::vector<glm::vec3> normals;
+    normals.reserve(meshlet.triangle_count);
+    glm::vec3 normal_sum(0.0f);
+    for (uint32_t i = 0; i < meshlet.triangle_count; i++) {
+        const uint32_t triangle = mesh.triangles[meshlet.triangle_offset + i];
+        const glm::vec3 &a = vertices[mesh.vertices[meshlet.vertex_offset + (triangle & 0xFF)]].position;
+        const glm::vec3 &b = vertices[mesh.vertices[meshlet.vertex_offset + ((triangle >> 8) & 0xFF)]].position;
+        const glm::vec3 &c = vertices[mesh.vertices[meshlet.vertex_offset + ((triangle >> 16) & 0xFF)]].position;
+        const glm::vec3 normal = glm::cross(b - a, c - a);
+        const float length = glm::length(normal);
+        // Degenerated triangles are never rasterized
+        if (length < 1e-12f)
+            continue;
+        normals.push_back(normal / length);
+        normal_sum += normals.back();
+    }
+    meshlet.cone = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+    const float sum_length = glm::length(normal_sum);
+    if (normals.empty() || sum_length < 1e-6f)
+        return;
+    const glm::vec3 axis = normal_sum / sum_length;
+    float min_cosine = 1.0f;
+    for (const glm::vec3 &normal: normals)
+        min_cosine = std::min(min_cosine, glm::dot(axis, normal));
+    // Every normal is within acos(min_cosine) of the axis: all the triangles
+    // face away from the directions within 90 - acos(min_cosine) of the axis
+    meshlet.cone = glm::vec4(axis, min_cosine < MIN_CONE_COSINE ? 1.0f : std::sqrt(1.0f - min_cosine * min_cosine));
+}
+
+MeshletMesh buildMeshlets(const Scene &scene, const MeshRange &source_mesh) {
+    const std::vector<Vertex> &vertices = scene.vertices;
+    MeshletMesh mesh {};
+    mesh.source_mesh = source_mesh;
+    mesh.source_vertex_count = static_cast<uint32_t>(vertices.size());
+    const uint32_t triangle_count = source_mesh.index_count / 3;
+    // Indices of the scene vertex buffer
+    std::vector<uint32_t> indices(triangle_count * 3);
+    for (uint32_t i = 0; i < triangle_count * 3; i++)
+        indices[i] = static_cast<uint32_t>(static_cast<int32_t>(scene.indices[source_mesh.first_index + i]) + source_mesh.vertex_offset);
+
+    // Triangles using each vertex
+    std::vector<uint32_t> adjacency_offsets(vertices.size() + 1, 0);
+    for (uint32_t i = 0; i < triangle_count * 3; i++)
+        adjacency_offsets[indices[i] + 1]++;
+    for (size_t i = 1; i < adjacency_offsets.size(); i++)
+        adjacency_offsets[i] += adjacency_offsets[i - 1];
+    std::vector<uint32_t> adjacency(triangle_count * 3);
+    {
+        std::vector<uint32_t> fill = adjacency_offsets;
+        for (uint32_t i = 0; i < triangle_count * 3; i++)
+            adjacency[fill[indices[i]]++] = i / 3;
+    }
+
+    std::vector<uint8_t> emitted(triangle_count, 0);
+    std::vector<uint8_t> local_index(vertices.size(), NO_LOCAL_INDEX);
+    // Not emitted triangles sharing a vertex with the meshlet
+    std::vector<uint32_t> candidates;
+    Meshlet meshlet {};
+    uint32_t next_seed = 0;
+
+    const auto flush = [&]() {
+        if (meshlet.triangle_count == 0)
+            return;
+        computeMeshletBounds(vertices, mesh, meshlet);
+        mesh.meshlets.push_back(meshlet);
+        for (uint32_t i = 0; i < meshlet.vertex_count; i++)
+            local_index[mesh.vertices[meshlet.vertex_offset + i]] = NO_LOCAL_INDEX;
+        meshlet = Meshlet {};
+        meshlet.vertex_offset = static_cast<uint32_t>(mesh.vertices.size());
+        meshlet.triangle_offset = static_cast<uint32_t>(mesh.triangles.size());
+        candidates.clear();
+    };
+    const auto newVertexCount = [&](uint32_t triangle) {
+        uint32_t count = 0;
+        for (uint32_t k = 0; k < 3; k++)
+            count += local_index[indices[triangle * 3 + k]] == NO_LOCAL_INDEX ? 1 : 0;
+        return count;
+    };
+
+    while (true) {
+        // The candidate adding the fewest vertices: the meshlet grows
+        // around the vertices it already has
+        uint32_t best = NO_TRIANGLE;
+        uint32_t best_new_vertices = 4;
+        for (const uint32_t candidate: candidates) {
+            if (emitted[candidate])
+                continue;
+            const uint32_t new_vertices = newVertexCount(candidate);
+            if (new_vertices < best_new_vertices && meshlet.vertex_count + new_vertices <= MESHLET_MAX_VERTICES) {
+                best = candidate;
+                best_new_vertices = new_vertices;
+            }
+        }
+        if (best == NO_TRIANGLE) {
+            // Nothing connected fits anymore: start a new meshlet from
+            // the next triangle in index order
+            flush();
+            while (next_seed < triangle_count && emitted[next_seed])
+                next_seed++;
+            if (next_seed == triangle_count)
+                break;
+            best = next_seed;
+        }
+
+        uint32_t triangle = 0;
+        for (uint32_t k = 0; k < 3; k++) {
+            const uint32_t vertex = indices[best * 3 + k];
+            if (local_index[vertex] == NO_LOCAL_INDEX) {
+                local_index[vertex] = static_cast<uint8_t>(meshlet.vertex_count++);
+                mesh.vertices.push_back(vertex);
+                for (uint32_t i = adjacency_offsets[vertex]; i < adjacency_offsets[vertex + 1]; i++) {
+                    if (!emitted[adjacency[i]])
+                        candidates.push_back(adjacency[i]);
+                }
+            }
+            triangle |= static_cast<uint32_t>(local_index[vertex]) << (8 * k);
+        }
+        mesh.triangles.push_back(triangle);
+        meshlet.triangle_count++;
+        emitted[best] = 1;
+        if (meshlet.triangle_count == MESHLET_MAX_TRIANGLES)
+            flush();
+    }
+    return mesh;
+}
+
+template <typename T>
+static void writeArray(std::ofstream &file, const std::vector<T> &array) {
+    const uint32_t count = static_cast<uint32_t>(array.size());
+    file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    file.write(reinterpret_cast<const char*>(array.data()), static_cast<std::streamsize>(sizeof(T) * array.size()));
+}
+
+template <typename T>
+static bool readArray(std::ifstream &file, std::vector<T> &array) {
+    uint32_t count = 0;
+    if (!file.read(reinterpret_cast<char*>(&count), sizeof(count)))
+        return false;
+    array.resize(count);
+    return static_cast<bool>(file.read(reinterpret_cast<char*>(array.data()), static_cast<std::streamsize>(sizeof(T) * count)));
+}
+
+void writeMeshletFile(const std::string &filename, const MeshletMesh &mesh) {
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open the meshlet file " + filename);
+    }
+    const uint32_t header[] = {
+        MESHLET_FILE_MAGIC,
+        MESHLET_FILE_VERSION,
+        mesh.source_mesh.index_count,
+        mesh.source_mesh.first_index,
+        static_cast<uint32_t>(mesh.source_mesh.vertex_offset),
+        mesh.source_vertex_count
+    };
+    file.write(reinterpret_cast<const char*>(header), sizeof(header));
+    writeArray(file, mesh.meshlets);
+    writeArray(file, mesh.vertices);
+    writeArray(file, mesh.triangles);
+    if (!file) {
+        throw std::runtime_error("failed to write the meshlet file " + filename);
+    }
+}
+
+bool readMeshletFile(const std::string &filename, MeshletMesh &mesh) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open())
+        return false;
+    uint32_t header[6] {};
+    if (!file.read(reinterpret_cast<char*>(header), sizeof(header)) || header[0] != MESHLET_FILE_MAGIC || header[1] != MESHLET_FILE_VERSION)
+        return false;
+    MeshletMesh loaded {};
+    loaded.source_mesh = {header[2], header[3], static_cast<int32_t>(header[4])};
+    loaded.source_vertex_count = header[5];
+    if (!readArray(file, loaded.meshlets) || !readArray(file, loaded.vertices) || !readArray(file, loaded.triangles))
+        return false;
+    // Every range must be in bounds, the file is not trusted
+    for (const Meshlet &meshlet: loaded.meshlets) {
+        if (meshlet.vertex_count > MESHLET_MAX_VERTICES || meshlet.triangle_count > MESHLET_MAX_TRIANGLES
+            || meshlet.vertex_offset + meshlet.vertex_count > loaded.vertices.size()
+            || meshlet.triangle_offset + meshlet.triangle_count > loaded.triangles.size())
+            return false;
+    }
+    for (const uint32_t vertex: loaded.vertices) {
+        if (vertex >= loaded.source_vertex_count)
+            return false;
+    }
+    mesh = std::move(loaded);
+    return true;
+}
+
+MeshletMesh loadOrBuildMeshlets(const std::string &filename, const Scene &scene, const MeshRange &source_mesh) {
+    MeshletMesh mesh {};
+    if (readMeshletFile(filename, mesh)
+        && mesh.source_mesh.index_count == source_mesh.index_count
+        && mesh.source_mesh.first_index == source_mesh.first_index
+        && mesh.source_mesh.vertex_offset == source_mesh.vertex_offset
+        && mesh.source_vertex_count == scene.vertices.size()) {
+        Log("-> Meshlets loaded from " << filename);
+        return mesh;
+    }
+    mesh = buildMeshlets(scene, source_mesh);
+    try {
+        writeMeshletFile(filename, mesh);
+    } catch (const std::exception &e) {
+        // Only a cache: built again at the next run
+        LogE("meshlets not cached: " << e.what());
+    }
+    return mesh;
+}
+
+std::vector<uint32_t> meshletIndices(const MeshletMesh &mesh) {
+    std::vector<uint32_t> indices;
+    indices.reserve(mesh.triangles.size() * 3);
+    for (const Meshlet &meshlet: mesh.meshlets) {
+        for (uint32_t i = 0; i < meshlet.triangle_count; i++) {
+            const uint32_t triangle = mesh.triangles[meshlet.triangle_offset + i];
+            for (uint32_t k = 0; k < 3; k++)
+                indices.push_back(mesh.vertices[meshlet.vertex_offset + ((triangle >> (8 * k)) & 0xFF)]);
+        }
+    }
+    return indices;
+}
+
+bool isMeshletVisible(const Meshlet &meshlet, const glm::vec4 &position_scale, const FrustumPlanes &planes, const glm::vec3 &camera_position) {
+    // Same tests as the meshlet shaders
+    const float scale = position_scale.w;
+    const glm::vec3 center = glm::vec3(position_scale) + glm::vec3(meshlet.bounds) * scale;
+    const float radius = meshlet.bounds.w * scale;
+    if (!isSphereVisible(planes, center, radius))
+        return false;
+    // Uniform scale: the normals keep their direction
+    const glm::vec3 view = center - camera_position;
+    return glm::dot(view, glm::vec3(meshlet.cone)) < meshlet.cone.w * glm::length(view) + radius;
+}
@@ -0,0 +1,97 @@
+//
+//  meshlet.hpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#ifndef meshlet_hpp
+#define meshlet_hpp
+
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+#include "scene.hpp"
+
+// Limits of a meshlet (must match the mesh shader outputs): 64 vertices
+// and 124 triangles fit the output limits of every mesh shader device,
+// and 124 triangles x 3 bytes stay under 384 bytes of primitive indices
+constexpr uint32_t const MESHLET_MAX_VERTICES = 64;
+constexpr uint32_t const MESHLET_MAX_TRIANGLES = 124;
+
+/**
+ * A cluster of at most MESHLET_MAX_TRIANGLES triangles using at most
+ * MESHLET_MAX_VERTICES vertices, read by the shaders (std430 layout).
+ */
+struct Meshlet {
+    // xyz: center of the bounding sphere (mesh space), w: radius
+    glm::vec4 bounds;
+    // xyz: axis of the cone containing the triangle normals, w: sine of
+    // its half angle (1 when the cone is too wide to ever be back facing)
+    glm::vec4 cone;
+    // First entry in MeshletMesh::vertices / MeshletMesh::triangles
+    uint32_t vertex_offset;
+    uint32_t triangle_offset;
+    uint32_t vertex_count;
+    uint32_t triangle_count;
+};
+
+/**
+ * The meshlets of a mesh.
+ * vertices maps the local vertex indices of each meshlet to the indices of
+ * the scene vertex buffer (vertex_offset of the mesh included); triangles
+ * packs the 3 local vertex indices of each triangle in the low 24 bits of
+ * an uint32_t (8 bits each).
+ */
+struct MeshletMesh {
+    std::vector<Meshlet> meshlets;
+    std::vector<uint32_t> vertices;
+    std::vector<uint32_t> triangles;
+    // Mesh it was built from, to check a cached file
+    MeshRange source_mesh {};
+    uint32_t source_vertex_count = 0;
+};
+
+/**
+ * Split the triangles of a mesh of the scene in meshlets. Each meshlet
+ * grows from a seed triangle by adding the triangles sharing the most
+ * vertices with it, so it stays compact (tight bounding sphere, narrow
+ * normal cone).
+ */
+MeshletMesh buildMeshlets(const Scene &scene, const MeshRange &mesh);
+
+/**
+ * Save meshlets built offline, to skip buildMeshlets at startup.
+ * Throws if the file can not be written.
+ */
+void writeMeshletFile(const std::string &filename, const MeshletMesh &mesh);
+
+/**
+ * Load a file written by writeMeshletFile.
+ * Returns false if it is missing, invalid or of another format version.
+ */
+bool readMeshletFile(const std::string &filename, MeshletMesh &mesh);
+
+/**
+ * Load the meshlets of a mesh from a file if it was built from the same
+ * range of a scene of the same size, else build them and write the file
+ * for the next run.
+ */
+MeshletMesh loadOrBuildMeshlets(const std::string &filename, const Scene &scene, const MeshRange &mesh);
+
+/**
+ * Indices (of the scene vertex buffer) of the triangles of every meshlet,
+ * in meshlet order: meshlet i is drawn with an index count of
+ * 3 * triangle_count from 3 * triangle_offset, for the vertex pipeline.
+ */
+std::vector<uint32_t> meshletIndices(const MeshletMesh &mesh);
+
+/**
+ * Returns true if the meshlet may be visible from camera_position: inside
+ * the frustum, and with some triangles facing the camera. The meshlet is
+ * placed with a uniform scale then a translation (ObjectData::position_scale).
+ */
+bool isMeshletVisible(const Meshlet &meshlet, const glm::vec4 &position_scale, const FrustumPlanes &planes, const glm::vec3 &camera_position);
+
+#endif /* meshlet_hpp */
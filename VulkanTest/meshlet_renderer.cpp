@@ -0,0 +1,318 @@
+//
+//  meshlet_renderer.cpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#include "meshlet_renderer.hpp"
+#include "base.hpp"
+#include "push_constants.hpp"
+#include "scene.hpp"
+#include "shader_support.hpp"
+#include <stdexcept>
+
+// Must match the local_size_x of meshlet.task (meshlets per task workgroup)
+constexpr uint32_t const MESHLET_TASK_WORKGROUP_SIZE = 32;
+// Must match the local_size_x of meshlet_cull.comp
+constexpr uint32_t const MESHLET_CULL_WORKGROUP_SIZE = 64;
+// Meshlets culled by each job of the CPU path
+constexpr uint32_t const MESHLET_CULL_GRAIN = 256;
+
+// The mesh shader reads the vertices as floats
+static_assert(sizeof(Vertex) == 8 * sizeof(float), "meshlet.mesh reads vertices with a stride of 8 floats");
+static_assert(sizeof(Meshlet) == 48, "Meshlet must match its std430 layout in the shaders");
+
+// Push constants of meshlet_cull.comp
+struct MeshletCullParams {
+    glm::vec4 planes[6];
+    glm::vec4 camera_position;
+    uint32_t meshlet_count;
+    uint32_t instance_count;
+    // Same meaning as CullParams::compact (gpu_culling.cpp)
+    uint32_t compact;
+    uint32_t padding;
+};
+
+MeshletPath MeshletRenderer::selectPath(const DeviceCapabilities &capabilities, bool mesh_shading, bool gpu_driven) {
+    // One draw for every instance: the fragment shader indexes the
+    // bindless textures with non-uniform handles (descriptor indexing)
+    if (mesh_shading && capabilities.mesh_shader && capabilities.descriptor_indexing)
+        return MeshletPath::MeshShader;
+    // object_index is passed as firstInstance of each indirect draw
+    if (gpu_driven && capabilities.draw_indirect_first_instance)
+        return MeshletPath::ComputeCulling;
+    return MeshletPath::Cpu;
+}
+
+void MeshletRenderer::init(VkPhysicalDevice physical_device, VkDevice device, const DeviceCapabilities &capabilities, VkCommandPool command_pool, VkQueue queue, DescriptorAllocator &descriptor_allocator, MeshletPath path, const MeshletMesh &mesh, const std::vector<uint32_t> &instance_objects, const AllocatedBuffer &object_buffer, const AllocatedBuffer &vertex_buffer, uint32_t frames_in_flight) {
+    m_path = path;
+    m_meshlet_count = static_cast<uint32_t>(mesh.meshlets.size());
+    m_instance_objects = instance_objects;
+    m_meshlets = mesh.meshlets;
+    m_object_buffer = object_buffer.buffer;
+    m_use_draw_count = capabilities.draw_indirect_count;
+    m_use_multi_draw = capabilities.multi_draw_indirect;
+    if (m_meshlet_count == 0 || m_instance_objects.empty()) {
+        throw std::runtime_error("no meshlet to draw");
+    }
+
+    uint32_t triangle_count = 0;
+    for (const Meshlet &meshlet: mesh.meshlets)
+        triangle_count += meshlet.triangle_count;
+    Log("-> Initializing the meshlet renderer (" << m_meshlet_count << " meshlets x " << instanceCount() << " instances)...");
+    Log("\t average fill: " << static_cast<float>(mesh.vertices.size()) / m_meshlet_count << " vertices, " << static_cast<float>(triangle_count) / m_meshlet_count << " triangles");
+    Log("\t path: " << (m_path == MeshletPath::MeshShader ? "task / mesh shaders" : m_path == MeshletPath::ComputeCulling ? "compute culling + indirect draws" : "CPU culling"));
+
+    if (m_path == MeshletPath::MeshShader) {
+        m_meshlet_buffer = createDeviceLocalBuffer(physical_device, device, command_pool, queue, mesh.meshlets.data(), sizeof(Meshlet) * mesh.meshlets.size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+        m_meshlet_vertex_buffer = createDeviceLocalBuffer(physical_device, device, command_pool, queue, mesh.vertices.data(), sizeof(uint32_t) * mesh.vertices.size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+        m_meshlet_triangle_buffer = createDeviceLocalBuffer(physical_device, device, command_pool, queue, mesh.triangles.data(), sizeof(uint32_t) * mesh.triangles.size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+    } else {
+        const std::vector<uint32_t> indices = meshletIndices(mesh);
+        m_index_buffer = createDeviceLocalBuffer(physical_device, device, command_pool, queue, indices.data(), sizeof(uint32_t) * indices.size(), VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+    }
+    if (m_path != MeshletPath::Cpu) {
+        m_instance_buffer = createDeviceLocalBuffer(physical_device, device, command_pool, queue, m_instance_objects.data(), sizeof(uint32_t) * m_instance_objects.size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+    }
+    if (m_path == MeshletPath::ComputeCulling) {
+        // Culling the meshlets reads their bounds and counts
+        m_meshlet_buffer = createDeviceLocalBuffer(physical_device, device, command_pool, queue, mesh.meshlets.data(), sizeof(Meshlet) * mesh.meshlets.size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+    }
+
+    switch (m_path) {
+        case MeshletPath::MeshShader:
+            _initMeshShading(device, descriptor_allocator, vertex_buffer);
+            break;
+        case MeshletPath::ComputeCulling:
+            _initComputeCulling(physical_device, device, capabilities, frames_in_flight);
+            break;
+        case MeshletPath::Cpu:
+            m_visibility.resize(_commandCount());
+            m_visible_draws.reserve(_commandCount());
+            break;
+    }
+}
+
+void MeshletRenderer::_initMeshShading(VkDevice device, DescriptorAllocator &descriptor_allocator, const AllocatedBuffer &vertex_buffer) {
+    m_draw_mesh_tasks = reinterpret_cast<PFN_vkCmdDrawMeshTasksEXT>(vkGetDeviceProcAddr(device, "vkCmdDrawMeshTasksEXT"));
+    if (m_draw_mesh_tasks == nullptr) {
+        throw std::runtime_error("failed to load vkCmdDrawMeshTasksEXT");
+    }
+
+    // 0: meshlets, 1: meshlet vertices, 2: meshlet triangles, 3: scene vertices, 4: instances
+    VkDescriptorSetLayoutBinding bindings[5] {};
+    for (uint32_t i = 0; i < 5; i++) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_TASK_BIT_EXT | VK_SHADER_STAGE_MESH_BIT_EXT;
+    }
+    VkDescriptorSetLayoutCreateInfo layout_info {};
+    layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layout_info.bindingCount = 5;
+    layout_info.pBindings = bindings;
+    if (vkCreateDescriptorSetLayout(device, &layout_info, nullptr, &m_mesh_descriptor_set_layout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create the meshlet descriptor set layout");
+    }
+
+    // The meshlet data never changes: a single set, written once
+    m_mesh_descriptor_set = descriptor_allocator.allocate(device, m_mesh_descriptor_set_layout);
+    const VkDescriptorBufferInfo buffer_infos[5] = {
+        {m_meshlet_buffer.buffer, 0, VK_WHOLE_SIZE},
+        {m_meshlet_vertex_buffer.buffer, 0, VK_WHOLE_SIZE},
+        {m_meshlet_triangle_buffer.buffer, 0, VK_WHOLE_SIZE},
+        {vertex_buffer.buffer, 0, VK_WHOLE_SIZE},
+        {m_instance_buffer.buffer, 0, VK_WHOLE_SIZE}
+    };
+    VkWriteDescriptorSet writes[5] {};
+    for (uint32_t i = 0; i < 5; i++) {
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet = m_mesh_descriptor_set;
+        writes[i].dstBinding = i;
+        writes[i].descriptorCount = 1;
+        writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        writes[i].pBufferInfo = &buffer_infos[i];
+    }
+    vkUpdateDescriptorSets(device, 5, writes, 0, nullptr);
+}
+
+void MeshletRenderer::_initComputeCulling(VkPhysicalDevice physical_device, VkDevice device, const DeviceCapabilities &capabilities, uint32_t frames_in_flight) {
+    m_frames.resize(frames_in_flight);
+    for (auto &frame: m_frames) {
+        frame.command_buffer = createBuffer(
+            physical_device,
+            device,
+            sizeof(VkDrawIndexedIndirectCommand) * _commandCount(),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        frame.count_buffer = createBuffer(
+            physical_device,
+            device,
+            sizeof(uint32_t),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    }
+
+    // 0: objects, 1: meshlets, 2: instances, 3: draw commands (out), 4: draw count (out)
+    VkDescriptorSetLayoutBinding bindings[5] {};
+    for (uint32_t i = 0; i < 5; i++) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+    VkDescriptorSetLayoutCreateInfo layout_info {};
+    layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layout_info.bindingCount = 5;
+    layout_info.pBindings = bindings;
+    if (vkCreateDescriptorSetLayout(device, &layout_info, nullptr, &m_cull_descriptor_set_layout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create the meshlet culling descriptor set layout");
+    }
+
+    const VkPushConstantRange push_constant_range = pushConstantRange<MeshletCullParams>(capabilities, VK_SHADER_STAGE_COMPUTE_BIT);
+    VkPipelineLayoutCreateInfo pipeline_layout_info {};
+    pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipeline_layout_info.setLayoutCount = 1;
+    pipeline_layout_info.pSetLayouts = &m_cull_descriptor_set_layout;
+    pipeline_layout_info.pushConstantRangeCount = 1;
+    pipeline_layout_info.pPushConstantRanges = &push_constant_range;
+    if (vkCreatePipelineLayout(device, &pipeline_layout_info, nullptr, &m_cull_pipeline_layout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create the meshlet culling pipeline layout");
+    }
+
+    VkShaderModule compute_shader_module = createShaderModule(device, "meshlet_cull.spv");
+    VkPipelineShaderStageCreateInfo stage_info {};
+    stage_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stage_info.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    stage_info.module = compute_shader_module;
+    stage_info.pName = "main";
+
+    VkComputePipelineCreateInfo pipeline_info {};
+    pipeline_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipeline_info.stage = stage_info;
+    pipeline_info.layout = m_cull_pipeline_layout;
+    const auto res = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &m_cull_pipeline);
+    vkDestroyShaderModule(device, compute_shader_module, nullptr);
+    if (res != VK_SUCCESS) {
+        throw std::runtime_error("failed to create the meshlet culling pipeline");
+    }
+}
+
+void MeshletRenderer::recordMeshTasks(VkCommandBuffer command_buffer, VkPipelineLayout pipeline_layout) {
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, 3, 1, &m_mesh_descriptor_set, 0, nullptr);
+    MeshletPushConstants push_constants {};
+    push_constants.meshlet_count = m_meshlet_count;
+    push_constants.texture_handle = UINT32_MAX;
+    pushConstants(command_buffer, pipeline_layout, MESHLET_PUSH_CONSTANT_STAGES, push_constants);
+    // x: groups of meshlets, y: instances
+    m_draw_mesh_tasks(command_buffer, (m_meshlet_count + MESHLET_TASK_WORKGROUP_SIZE - 1) / MESHLET_TASK_WORKGROUP_SIZE, instanceCount(), 1);
+}
+
+void MeshletRenderer::recordCulling(VkDevice device, VkCommandBuffer command_buffer, uint32_t frame_index, FrameDescriptorAllocators &frame_allocators, const glm::mat4 &view_proj, const glm::vec3 &camera_position) {
+    const FrameResources &frame = m_frames[frame_index];
+    VkDescriptorSet descriptor_set = frame_allocators.allocate(device, m_cull_descriptor_set_layout);
+    const VkDescriptorBufferInfo buffer_infos[5] = {
+        {m_object_buffer, 0, VK_WHOLE_SIZE},
+        {m_meshlet_buffer.buffer, 0, VK_WHOLE_SIZE},
+        {m_instance_buffer.buffer, 0, VK_WHOLE_SIZE},
+        {frame.command_buffer.buffer, 0, VK_WHOLE_SIZE},
+        {frame.count_buffer.buffer, 0, VK_WHOLE_SIZE}
+    };
+    VkWriteDescriptorSet writes[5] {};
+    for (uint32_t i = 0; i < 5; i++) {
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet = descriptor_set;
+        writes[i].dstBinding = i;
+        writes[i].descriptorCount = 1;
+        writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        writes[i].pBufferInfo = &buffer_infos[i];
+    }
+    vkUpdateDescriptorSets(device, 5, writes, 0, nullptr);
+
+    // Reset the visible meshlets counter
+    vkCmdFillBuffer(command_buffer, frame.count_buffer.buffer, 0, sizeof(uint32_t), 0);
+    VkMemoryBarrier fill_barrier {};
+    fill_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    fill_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    fill_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &fill_barrier, 0, nullptr, 0, nullptr);
+
+    MeshletCullParams params {};
+    const FrustumPlanes planes = extractFrustumPlanes(view_proj);
+    for (size_t i = 0; i < planes.size(); i++) params.planes[i] = planes[i];
+    params.camera_position = glm::vec4(camera_position, 1.0f);
+    params.meshlet_count = m_meshlet_count;
+    params.instance_count = instanceCount();
+    params.compact = m_use_draw_count ? 1 : 0;
+
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_cull_pipeline);
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_cull_pipeline_layout, 0, 1, &descriptor_set, 0, nullptr);
+    pushConstants(command_buffer, m_cull_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, params);
+    vkCmdDispatch(command_buffer, (_commandCount() + MESHLET_CULL_WORKGROUP_SIZE - 1) / MESHLET_CULL_WORKGROUP_SIZE, 1, 1);
+}
+
+void MeshletRenderer::recordOutputBarrier(VkCommandBuffer command_buffer) {
+    VkMemoryBarrier cull_barrier {};
+    cull_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    cull_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    cull_barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 1, &cull_barrier, 0, nullptr, 0, nullptr);
+}
+
+void MeshletRenderer::recordDraws(VkCommandBuffer command_buffer, uint32_t frame_index) {
+    const FrameResources &frame = m_frames[frame_index];
+    const uint32_t command_count = _commandCount();
+    constexpr uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+    vkCmdBindIndexBuffer(command_buffer, m_index_buffer.buffer, 0, VK_INDEX_TYPE_UINT32);
+    if (m_use_draw_count) {
+        vkCmdDrawIndexedIndirectCount(command_buffer, frame.command_buffer.buffer, 0, frame.count_buffer.buffer, 0, command_count, stride);
+    } else if (m_use_multi_draw) {
+        // Culled meshlets have an instanceCount of 0
+        vkCmdDrawIndexedIndirect(command_buffer, frame.command_buffer.buffer, 0, command_count, stride);
+    } else {
+        for (uint32_t i = 0; i < command_count; i++)
+            vkCmdDrawIndexedIndirect(command_buffer, frame.command_buffer.buffer, i * stride, 1, stride);
+    }
+}
+
+void MeshletRenderer::cull(JobSystem &job_system, const std::vector<ObjectData> &objects, const FrustumPlanes &planes, const glm::vec3 &camera_position) {
+    // Test every (instance, meshlet) pair in parallel, then gather the
+    // visible ones in order on this thread
+    job_system.parallelFor("meshlet culling", 0, _commandCount(), MESHLET_CULL_GRAIN, [&](uint32_t first, uint32_t last) {
+        for (uint32_t i = first; i < last; i++) {
+            const ObjectData &object = objects[m_instance_objects[i / m_meshlet_count]];
+            m_visibility[i] = isMeshletVisible(m_meshlets[i % m_meshlet_count], object.position_scale, planes, camera_position) ? 1 : 0;
+        }
+    });
+    m_visible_draws.clear();
+    for (uint32_t i = 0; i < _commandCount(); i++) {
+        if (m_visibility[i] == 0)
+            continue;
+        const Meshlet &meshlet = m_meshlets[i % m_meshlet_count];
+        m_visible_draws.push_back({meshlet.triangle_count * 3, meshlet.triangle_offset * 3, m_instance_objects[i / m_meshlet_count]});
+    }
+}
+
+void MeshletRenderer::clean(VkDevice device) {
+    for (auto &frame: m_frames) {
+        destroyBuffer(device, frame.command_buffer);
+        destroyBuffer(device, frame.count_buffer);
+    }
+    m_frames.clear();
+    if (m_cull_pipeline != VK_NULL_HANDLE) vkDestroyPipeline(device, m_cull_pipeline, nullptr);
+    if (m_cull_pipeline_layout != VK_NULL_HANDLE) vkDestroyPipelineLayout(device, m_cull_pipeline_layout, nullptr);
+    if (m_cull_descriptor_set_layout != VK_NULL_HANDLE) vkDestroyDescriptorSetLayout(device, m_cull_descriptor_set_layout, nullptr);
+    // m_mesh_descriptor_set is freed with the pools of its allocator
+    if (m_mesh_descriptor_set_layout != VK_NULL_HANDLE) vkDestroyDescriptorSetLayout(device, m_mesh_descriptor_set_layout, nullptr);
+    m_cull_pipeline = VK_NULL_HANDLE;
+    m_cull_pipeline_layout = VK_NULL_HANDLE;
+    m_cull_descriptor_set_layout = VK_NULL_HANDLE;
+    m_mesh_descriptor_set_layout = VK_NULL_HANDLE;
+    m_mesh_descriptor_set = VK_NULL_HANDLE;
+    destroyBuffer(device, m_meshlet_buffer);
+    destroyBuffer(device, m_meshlet_vertex_buffer);
+    destroyBuffer(device, m_meshlet_triangle_buffer);
+    destroyBuffer(device, m_instance_buffer);
+    destroyBuffer(device, m_index_buffer);
+}
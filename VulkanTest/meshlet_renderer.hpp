@@ -0,0 +1,179 @@
+//
+//  meshlet_renderer.hpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#ifndef meshlet_renderer_hpp
+#define meshlet_renderer_hpp
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "buffer_utils.hpp"
+#include "descriptor_allocator.hpp"
+#include "device_capabilities.hpp"
+#include "job_system.hpp"
+#include "meshlet.hpp"
+
+/**
+ * How the meshlets are culled and drawn, from the fastest path.
+ */
+enum class MeshletPath {
+    // Task shaders cull the meshlets, mesh shaders emit the visible ones
+    // (VK_EXT_mesh_shader, and descriptor indexing for the non-uniform
+    // materials of its single draw)
+    MeshShader,
+    // A compute pass culls the meshlets and writes an indirect draw per
+    // visible one, for the vertex pipeline
+    ComputeCulling,
+    // Culled by the jobs, one vkCmdDrawIndexed per visible meshlet
+    Cpu
+};
+
+/**
+ * Push constants of the mesh shading pipelines. texture_handle is at the
+ * offset of DrawPushConstants::texture_handle: the fragment shader is shared.
+ */
+struct MeshletPushConstants {
+    uint32_t meshlet_count;
+    uint32_t texture_handle;
+};
+
+constexpr VkShaderStageFlags const MESHLET_PUSH_CONSTANT_STAGES = VK_SHADER_STAGE_TASK_BIT_EXT | VK_SHADER_STAGE_MESH_BIT_EXT | VK_SHADER_STAGE_FRAGMENT_BIT;
+
+/**
+ * A visible meshlet of the CPU path: a draw of the meshlet index buffer.
+ */
+struct MeshletDraw {
+    uint32_t index_count;
+    uint32_t first_index;
+    uint32_t object_index;
+};
+
+/**
+ * Draws the instances of a meshlet mesh (objects of the scene), culling
+ * each of their meshlets against the frustum and with its normal cone.
+ *
+ * The meshlet data lives in storage buffers read by the task / mesh
+ * shaders (set 3 of the mesh shading pipelines, see descriptorSetLayout()).
+ * The other paths draw the meshlets with the vertex pipeline of the scene,
+ * from an index buffer holding the triangles of every meshlet in order.
+ */
+class MeshletRenderer {
+
+public:
+    /**
+     * The fastest path the device supports: mesh shading if requested,
+     * else compute culling on the GPU-driven path.
+     */
+    static MeshletPath selectPath(const DeviceCapabilities &capabilities, bool mesh_shading, bool gpu_driven);
+
+    /**
+     * Upload the meshlets and create the resources of the path.
+     * object_buffer is the scene ObjectData SSBO, instance_objects the
+     * objects drawing the mesh. vertex_buffer (the scene vertices) must
+     * have the storage buffer usage on the mesh shading path.
+     */
+    void init(VkPhysicalDevice physical_device, VkDevice device, const DeviceCapabilities &capabilities, VkCommandPool command_pool, VkQueue queue, DescriptorAllocator &descriptor_allocator, MeshletPath path, const MeshletMesh &mesh, const std::vector<uint32_t> &instance_objects, const AllocatedBuffer &object_buffer, const AllocatedBuffer &vertex_buffer, uint32_t frames_in_flight);
+
+    void clean(VkDevice device);
+
+    MeshletPath path() const { return m_path; }
+
+    /**
+     * Set 3 of the mesh shading pipelines: the meshlet data.
+     * VK_NULL_HANDLE on the other paths.
+     */
+    VkDescriptorSetLayout descriptorSetLayout() const { return m_mesh_descriptor_set_layout; }
+
+    uint32_t meshletCount() const { return m_meshlet_count; }
+    uint32_t instanceCount() const { return static_cast<uint32_t>(m_instance_objects.size()); }
+
+    /**
+     * Mesh shading path: record the task workgroups of every instance, with
+     * a mesh shading pipeline and its sets 0 to 2 already bound.
+     */
+    void recordMeshTasks(VkCommandBuffer command_buffer, VkPipelineLayout pipeline_layout);
+
+    /**
+     * Compute culling path: record the culling dispatch, outside of any
+     * render pass (see GpuCulling::recordCulling).
+     */
+    void recordCulling(VkDevice device, VkCommandBuffer command_buffer, uint32_t frame_index, FrameDescriptorAllocators &frame_allocators, const glm::mat4 &view_proj, const glm::vec3 &camera_position);
+
+    /**
+     * Compute culling path: make the draws visible to the indirect draw stage.
+     */
+    void recordOutputBarrier(VkCommandBuffer command_buffer);
+
+    /**
+     * Compute culling path: bind the meshlet index buffer and record the
+     * indirect draws, with the scene pipeline / vertex buffer already bound.
+     */
+    void recordDraws(VkCommandBuffer command_buffer, uint32_t frame_index);
+
+    VkBuffer drawCommandBuffer(uint32_t frame_index) const { return m_frames[frame_index].command_buffer.buffer; }
+    VkBuffer drawCountBuffer(uint32_t frame_index) const { return m_frames[frame_index].count_buffer.buffer; }
+
+    /**
+     * CPU path: cull every meshlet of every instance, in parallel.
+     * objects are the scene ObjectData.
+     */
+    void cull(JobSystem &job_system, const std::vector<ObjectData> &objects, const FrustumPlanes &planes, const glm::vec3 &camera_position);
+
+    /**
+     * CPU path: the meshlets that passed the last cull(), in order, to
+     * draw from indexBuffer().
+     */
+    const std::vector<MeshletDraw>& visibleDraws() const { return m_visible_draws; }
+
+    VkBuffer indexBuffer() const { return m_index_buffer.buffer; }
+
+private:
+    struct FrameResources {
+        AllocatedBuffer command_buffer;
+        AllocatedBuffer count_buffer;
+    };
+
+    MeshletPath m_path = MeshletPath::Cpu;
+    bool m_use_draw_count = false;
+    bool m_use_multi_draw = false;
+    uint32_t m_meshlet_count = 0;
+    std::vector<uint32_t> m_instance_objects;
+    // CPU copy of the meshlets, for the CPU path
+    std::vector<Meshlet> m_meshlets;
+    VkBuffer m_object_buffer = VK_NULL_HANDLE;
+
+    // Meshlet, meshlet vertex / triangle and instance SSBOs
+    AllocatedBuffer m_meshlet_buffer;
+    AllocatedBuffer m_meshlet_vertex_buffer;
+    AllocatedBuffer m_meshlet_triangle_buffer;
+    AllocatedBuffer m_instance_buffer;
+    // Vertex pipeline paths: triangles of the meshlets, as scene vertex indices
+    AllocatedBuffer m_index_buffer;
+
+    // Mesh shading path
+    VkDescriptorSetLayout m_mesh_descriptor_set_layout = VK_NULL_HANDLE;
+    VkDescriptorSet m_mesh_descriptor_set = VK_NULL_HANDLE;
+    PFN_vkCmdDrawMeshTasksEXT m_draw_mesh_tasks = nullptr;
+
+    // Compute culling path
+    VkDescriptorSetLayout m_cull_descriptor_set_layout = VK_NULL_HANDLE;
+    VkPipelineLayout m_cull_pipeline_layout = VK_NULL_HANDLE;
+    VkPipeline m_cull_pipeline = VK_NULL_HANDLE;
+    std::vector<FrameResources> m_frames;
+
+    // CPU path
+    std::vector<uint8_t> m_visibility;
+    std::vector<MeshletDraw> m_visible_draws;
+
+    void _initMeshShading(VkDevice device, DescriptorAllocator &descriptor_allocator, const AllocatedBuffer &vertex_buffer);
+    void _initComputeCulling(VkPhysicalDevice physical_device, VkDevice device, const DeviceCapabilities &capabilities, uint32_t frames_in_flight);
+    uint32_t _commandCount() const { return m_meshlet_count * instanceCount(); }
+};
+
+#endif /* meshlet_renderer_hpp */
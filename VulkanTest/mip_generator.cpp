@@ -0,0 +1,296 @@
+//
+//  mip_generator.cpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#include "mip_generator.hpp"
+#include "base.hpp"
+#include "push_constants.hpp"
+#include "shader_support.hpp"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+// Must match downsample.comp
+constexpr uint32_t const DOWNSAMPLE_WORKGROUP_SIZE = 256;
+constexpr uint32_t const DOWNSAMPLE_TILE_SIZE = 64;
+constexpr uint32_t const DOWNSAMPLE_MAX_LEVELS = 12;
+// Level read back by the last workgroup
+constexpr uint32_t const DOWNSAMPLE_MIDDLE_LEVEL = 6;
+
+// Push constants of downsample.comp
+struct DownsampleParams {
+    glm::vec2 inverse_source_size;
+    uint32_t level_count;
+    uint32_t workgroup_count;
+    uint32_t counter_index;
+};
+
+static VkImageMemoryBarrier mipBarrier(VkImage image, uint32_t base_level, uint32_t level_count, VkImageLayout old_layout, VkImageLayout new_layout, VkAccessFlags src_access, VkAccessFlags dst_access) {
+    VkImageMemoryBarrier barrier {};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.oldLayout = old_layout;
+    barrier.newLayout = new_layout;
+    barrier.srcAccessMask = src_access;
+    barrier.dstAccessMask = dst_access;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = base_level;
+    barrier.subresourceRange.levelCount = level_count;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+    return barrier;
+}
+
+void MipGenerator::init(VkPhysicalDevice physical_device, VkDevice device, const DeviceCapabilities &capabilities, uint32_t frames_in_flight) {
+    m_physical_device = physical_device;
+    m_retired_views.resize(frames_in_flight);
+
+    VkFormatProperties format_properties {};
+    vkGetPhysicalDeviceFormatProperties(physical_device, VK_FORMAT_R8G8B8A8_UNORM, &format_properties);
+    // The level index of the images array is dynamically uniform
+    m_compute_supported = (format_properties.optimalTilingFeatures & VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT)
+        && capabilities.storage_image_array_dynamic_indexing;
+    if (!m_compute_supported) {
+        Log("-> Mip generation: blit chain");
+        return;
+    }
+
+    m_counter_buffer = createBuffer(
+        physical_device,
+        device,
+        sizeof(uint32_t) * frames_in_flight,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    // Then reset by the last workgroup of each dispatch
+    memset(m_counter_buffer.mapped, 0, static_cast<size_t>(m_counter_buffer.size));
+
+    VkSamplerCreateInfo sampler_info {};
+    sampler_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    sampler_info.magFilter = VK_FILTER_LINEAR;
+    sampler_info.minFilter = VK_FILTER_LINEAR;
+    sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_info.maxLod = 0.0f;
+    if (vkCreateSampler(device, &sampler_info, nullptr, &m_sampler) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create the downsampling sampler");
+    }
+    _createPipeline(device, capabilities);
+    Log("-> Mip generation: single-pass compute" << (capabilities.subgroup_quad_compute ? ", subgroup quad operations" : ", shared memory only"));
+}
+
+void MipGenerator::_createPipeline(VkDevice device, const DeviceCapabilities &capabilities) {
+    // 0: level 0, 1: levels 1 to 12, 2: middle level, 3: workgroup counters
+    VkDescriptorSetLayoutBinding bindings[4] {};
+    bindings[0].binding = 0;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bindings[0].descriptorCount = 1;
+    bindings[1].binding = 1;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    bindings[1].descriptorCount = DOWNSAMPLE_MAX_LEVELS;
+    bindings[2].binding = 2;
+    bindings[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    bindings[2].descriptorCount = 1;
+    bindings[3].binding = 3;
+    bindings[3].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[3].descriptorCount = 1;
+    for (VkDescriptorSetLayoutBinding &binding: bindings)
+        binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    VkDescriptorSetLayoutCreateInfo layout_info {};
+    layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layout_info.bindingCount = 4;
+    layout_info.pBindings = bindings;
+    if (vkCreateDescriptorSetLayout(device, &layout_info, nullptr, &m_descriptor_set_layout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create the downsampling descriptor set layout");
+    }
+
+    const VkPushConstantRange push_constant_range = pushConstantRange<DownsampleParams>(capabilities, VK_SHADER_STAGE_COMPUTE_BIT);
+    VkPipelineLayoutCreateInfo pipeline_layout_info {};
+    pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipeline_layout_info.setLayoutCount = 1;
+    pipeline_layout_info.pSetLayouts = &m_descriptor_set_layout;
+    pipeline_layout_info.pushConstantRangeCount = 1;
+    pipeline_layout_info.pPushConstantRanges = &push_constant_range;
+    if (vkCreatePipelineLayout(device, &pipeline_layout_info, nullptr, &m_pipeline_layout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create the downsampling pipeline layout");
+    }
+
+    VkShaderModule compute_shader_module = createShaderModule(device, capabilities.subgroup_quad_compute ? "downsample_quad.spv" : "downsample.spv");
+    VkPipelineShaderStageCreateInfo stage_info {};
+    stage_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stage_info.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    stage_info.module = compute_shader_module;
+    stage_info.pName = "main";
+
+    VkComputePipelineCreateInfo pipeline_info {};
+    pipeline_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipeline_info.stage = stage_info;
+    pipeline_info.layout = m_pipeline_layout;
+    const auto res = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &m_pipeline);
+    vkDestroyShaderModule(device, compute_shader_module, nullptr);
+    if (res != VK_SUCCESS) {
+        throw std::runtime_error("failed to create the downsampling pipeline");
+    }
+}
+
+void MipGenerator::clean(VkDevice device) {
+    for (auto &views: m_retired_views) {
+        for (VkImageView view: views)
+            vkDestroyImageView(device, view, nullptr);
+        views.clear();
+    }
+    destroyBuffer(device, m_counter_buffer);
+    if (m_pipeline != VK_NULL_HANDLE) vkDestroyPipeline(device, m_pipeline, nullptr);
+    if (m_pipeline_layout != VK_NULL_HANDLE) vkDestroyPipelineLayout(device, m_pipeline_layout, nullptr);
+    if (m_descriptor_set_layout != VK_NULL_HANDLE) vkDestroyDescriptorSetLayout(device, m_descriptor_set_layout, nullptr);
+    if (m_sampler != VK_NULL_HANDLE) vkDestroySampler(device, m_sampler, nullptr);
+    m_pipeline = VK_NULL_HANDLE;
+    m_pipeline_layout = VK_NULL_HANDLE;
+    m_descriptor_set_layout = VK_NULL_HANDLE;
+    m_sampler = VK_NULL_HANDLE;
+}
+
+void MipGenerator::beginFrame(VkDevice device, uint32_t frame_index) {
+    m_current_frame = frame_index;
+    for (VkImageView view: m_retired_views[frame_index])
+        vkDestroyImageView(device, view, nullptr);
+    m_retired_views[frame_index].clear();
+}
+
+bool MipGenerator::_useCompute(const AllocatedImage &image) const {
+    return m_compute_supported
+        && image.format == VK_FORMAT_R8G8B8A8_UNORM
+        && image.mip_levels - 1 <= DOWNSAMPLE_MAX_LEVELS;
+}
+
+VkImageUsageFlags MipGenerator::requiredUsage(VkFormat format) const {
+    if (m_compute_supported && format == VK_FORMAT_R8G8B8A8_UNORM)
+        return VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT;
+    return VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+}
+
+void MipGenerator::generate(VkDevice device, VkCommandBuffer command_buffer, FrameDescriptorAllocators &frame_allocators, const AllocatedImage &image, VkImageLayout base_layout, VkPipelineStageFlags base_stage, VkAccessFlags base_access) {
+    if (image.mip_levels < 2) {
+        const VkImageMemoryBarrier barrier = mipBarrier(image.image, 0, 1, base_layout, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, base_access, VK_ACCESS_SHADER_READ_BIT);
+        vkCmdPipelineBarrier(command_buffer, base_stage, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+        return;
+    }
+    if (_useCompute(image))
+        _generateWithCompute(device, command_buffer, frame_allocators, image, base_layout, base_stage, base_access);
+    else
+        _generateWithBlits(command_buffer, image, base_layout, base_stage, base_access);
+}
+
+void MipGenerator::_generateWithCompute(VkDevice device, VkCommandBuffer command_buffer, FrameDescriptorAllocators &frame_allocators, const AllocatedImage &image, VkImageLayout base_layout, VkPipelineStageFlags base_stage, VkAccessFlags base_access) {
+    const uint32_t level_count = image.mip_levels - 1;
+
+    // A view per level: destroyed once the frame is over
+    std::vector<VkImageView> &views = m_retired_views[m_current_frame];
+    const VkImageView source_view = createImageView(device, image.image, image.format, VK_IMAGE_ASPECT_COLOR_BIT, 0, 1);
+    views.push_back(source_view);
+    VkDescriptorImageInfo level_infos[DOWNSAMPLE_MAX_LEVELS] {};
+    for (uint32_t i = 0; i < DOWNSAMPLE_MAX_LEVELS; i++) {
+        if (i < level_count) {
+            level_infos[i].imageView = createImageView(device, image.image, image.format, VK_IMAGE_ASPECT_COLOR_BIT, i + 1, 1);
+            views.push_back(level_infos[i].imageView);
+        } else {
+            // Never written, but every element must be valid
+            level_infos[i].imageView = level_infos[level_count - 1].imageView;
+        }
+        level_infos[i].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+    }
+
+    const VkDescriptorSet descriptor_set = frame_allocators.allocate(device, m_descriptor_set_layout);
+    const VkDescriptorImageInfo source_info {m_sampler, source_view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+    const VkDescriptorImageInfo middle_info = level_infos[std::min(DOWNSAMPLE_MIDDLE_LEVEL, level_count) - 1];
+    const VkDescriptorBufferInfo counter_info {m_counter_buffer.buffer, 0, VK_WHOLE_SIZE};
+    VkWriteDescriptorSet writes[4] {};
+    for (uint32_t i = 0; i < 4; i++) {
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet = descriptor_set;
+        writes[i].dstBinding = i;
+        writes[i].descriptorCount = 1;
+        writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    }
+    writes[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    writes[0].pImageInfo = &source_info;
+    writes[1].descriptorCount = DOWNSAMPLE_MAX_LEVELS;
+    writes[1].pImageInfo = level_infos;
+    writes[2].pImageInfo = &middle_info;
+    writes[3].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    writes[3].pBufferInfo = &counter_info;
+    vkUpdateDescriptorSets(device, 4, writes, 0, nullptr);
+
+    // Level 0 read through the sampler, the others written (and the middle one read back)
+    const VkImageMemoryBarrier input_barriers[2] = {
+        mipBarrier(image.image, 0, 1, base_layout, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, base_access, VK_ACCESS_SHADER_READ_BIT),
+        mipBarrier(image.image, 1, level_count, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL, 0, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT)
+    };
+    vkCmdPipelineBarrier(command_buffer, base_stage, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 2, input_barriers);
+
+    const uint32_t workgroups_x = (image.extent.width + DOWNSAMPLE_TILE_SIZE - 1) / DOWNSAMPLE_TILE_SIZE;
+    const uint32_t workgroups_y = (image.extent.height + DOWNSAMPLE_TILE_SIZE - 1) / DOWNSAMPLE_TILE_SIZE;
+    DownsampleParams params {};
+    params.inverse_source_size = glm::vec2(1.0f / image.extent.width, 1.0f / image.extent.height);
+    params.level_count = level_count;
+    params.workgroup_count = workgroups_x * workgroups_y;
+    // The dispatches of a frame are ordered by the barriers below, but
+    // the ones of the frames in flight may overlap
+    params.counter_index = m_current_frame;
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline_layout, 0, 1, &descriptor_set, 0, nullptr);
+    pushConstants(command_buffer, m_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, params);
+    vkCmdDispatch(command_buffer, workgroups_x, workgroups_y, 1);
+
+    // The counter reset by this dispatch must be seen by the next one
+    VkMemoryBarrier counter_barrier {};
+    counter_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    counter_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    counter_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    const VkImageMemoryBarrier output_barrier = mipBarrier(image.image, 1, level_count, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT);
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &counter_barrier, 0, nullptr, 1, &output_barrier);
+}
+
+void MipGenerator::_generateWithBlits(VkCommandBuffer command_buffer, const AllocatedImage &image, VkImageLayout base_layout, VkPipelineStageFlags base_stage, VkAccessFlags base_access) {
+    VkFormatProperties format_properties {};
+    vkGetPhysicalDeviceFormatProperties(m_physical_device, image.format, &format_properties);
+    const VkFormatFeatureFlags blit_features = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT;
+    if ((format_properties.optimalTilingFeatures & blit_features) != blit_features) {
+        throw std::runtime_error("mip generation: the image format supports neither storage nor blits");
+    }
+    const VkFilter filter = (format_properties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT) ? VK_FILTER_LINEAR : VK_FILTER_NEAREST;
+
+    const VkImageMemoryBarrier input_barriers[2] = {
+        mipBarrier(image.image, 0, 1, base_layout, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, base_access, VK_ACCESS_TRANSFER_READ_BIT),
+        mipBarrier(image.image, 1, image.mip_levels - 1, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, VK_ACCESS_TRANSFER_WRITE_BIT)
+    };
+    vkCmdPipelineBarrier(command_buffer, base_stage, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 2, input_barriers);
+
+    int32_t width = static_cast<int32_t>(image.extent.width);
+    int32_t height = static_cast<int32_t>(image.extent.height);
+    for (uint32_t level = 1; level < image.mip_levels; level++) {
+        const int32_t next_width = std::max(1, width / 2);
+        const int32_t next_height = std::max(1, height / 2);
+        VkImageBlit blit {};
+        blit.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 0, 1};
+        blit.srcOffsets[1] = {width, height, 1};
+        blit.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1};
+        blit.dstOffsets[1] = {next_width, next_height, 1};
+        vkCmdBlitImage(command_buffer, image.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, filter);
+        // The level is the source of the next blit: one barrier per level
+        const VkImageMemoryBarrier level_barrier = mipBarrier(image.image, level, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &level_barrier);
+        width = next_width;
+        height = next_height;
+    }
+
+    const VkImageMemoryBarrier output_barrier = mipBarrier(image.image, 0, image.mip_levels, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT);
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &output_barrier);
+}
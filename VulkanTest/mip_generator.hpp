@@ -0,0 +1,82 @@
+//
+//  mip_generator.hpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#ifndef mip_generator_hpp
+#define mip_generator_hpp
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#include <vector>
+
+#include "buffer_utils.hpp"
+#include "descriptor_allocator.hpp"
+#include "device_capabilities.hpp"
+#include "image_utils.hpp"
+
+/**
+ * Fills the mip levels of an image from its level 0, on the GPU.
+ *
+ * RGBA8 images (up to 4096 pixels) go through a single-pass compute
+ * downsampler (downsample.comp): one dispatch writes every level, where a
+ * chain of blits needs a barrier between each level. Each workgroup
+ * reduces a 64x64 tile down to 6 levels, with subgroup quad operations when
+ * the device supports them, and the last workgroup to finish (counted with
+ * a global atomic) reduces the remaining levels.
+ * Other images, or when the format does not support storage, fall back to
+ * a chain of vkCmdBlitImage.
+ */
+class MipGenerator {
+
+public:
+    void init(VkPhysicalDevice physical_device, VkDevice device, const DeviceCapabilities &capabilities, uint32_t frames_in_flight);
+
+    void clean(VkDevice device);
+
+    /**
+     * Destroy the views used by the previous use of the frame,
+     * once its fence has been waited for.
+     */
+    void beginFrame(VkDevice device, uint32_t frame_index);
+
+    /**
+     * Usage flags an image of this format must be created with
+     * to be given to generate().
+     */
+    VkImageUsageFlags requiredUsage(VkFormat format) const;
+
+    /**
+     * Record the generation of levels [1, mip_levels) of the image, outside
+     * of any render pass. Level 0 is in base_layout, written by base_stage
+     * with base_access; the content of the other levels is discarded.
+     * Every level is left in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+     * visible to the fragment and compute shaders.
+     * The descriptor set of the dispatch is allocated from the transient
+     * allocator of the frame.
+     */
+    void generate(VkDevice device, VkCommandBuffer command_buffer, FrameDescriptorAllocators &frame_allocators, const AllocatedImage &image, VkImageLayout base_layout, VkPipelineStageFlags base_stage, VkAccessFlags base_access);
+
+private:
+    VkPhysicalDevice m_physical_device = VK_NULL_HANDLE;
+    // Compute path, for R8G8B8A8_UNORM images
+    bool m_compute_supported = false;
+    VkSampler m_sampler = VK_NULL_HANDLE;
+    VkDescriptorSetLayout m_descriptor_set_layout = VK_NULL_HANDLE;
+    VkPipelineLayout m_pipeline_layout = VK_NULL_HANDLE;
+    VkPipeline m_pipeline = VK_NULL_HANDLE;
+    // Workgroup counters of the dispatches, one per frame in flight
+    AllocatedBuffer m_counter_buffer;
+    uint32_t m_current_frame = 0;
+    // Per-level views of the dispatches, per frame in flight
+    std::vector<std::vector<VkImageView>> m_retired_views;
+
+    bool _useCompute(const AllocatedImage &image) const;
+    void _createPipeline(VkDevice device, const DeviceCapabilities &capabilities);
+    void _generateWithCompute(VkDevice device, VkCommandBuffer command_buffer, FrameDescriptorAllocators &frame_allocators, const AllocatedImage &image, VkImageLayout base_layout, VkPipelineStageFlags base_stage, VkAccessFlags base_access);
+    void _generateWithBlits(VkCommandBuffer command_buffer, const AllocatedImage &image, VkImageLayout base_layout, VkPipelineStageFlags base_stage, VkAccessFlags base_access);
+};
+
+#endif /* mip_generator_hpp */
@@ -0,0 +1,384 @@
+//
+//  particle_system.cpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#include "particle_system.hpp"
+#include "base.hpp"
+#include "dynamic_state.hpp"
+#include "push_constants.hpp"
+#include "shader_support.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+
+// Must match the local_size_x of particles.comp
+constexpr uint32_t const PARTICLE_WORKGROUP_SIZE = 64;
+// Stages of particles.comp (its STAGE specialization constant)
+constexpr uint32_t const PARTICLE_STAGE_SIMULATE = 0;
+constexpr uint32_t const PARTICLE_STAGE_EMIT = 1;
+constexpr uint32_t const PARTICLE_STAGE_FINALIZE = 2;
+// Particles live 2 to 4 seconds (particles.comp): emitting capacity /
+// PARTICLE_AVERAGE_LIFE particles per second keeps the buffers about full
+constexpr float const PARTICLE_AVERAGE_LIFE = 3.0f;
+// A fountain above the center of the scene (y is down)
+const glm::vec4 PARTICLE_EMITTER = glm::vec4(0.0f, 0.4f, 0.1f, 0.5f);
+const glm::vec3 PARTICLE_GRAVITY = glm::vec3(0.0f, 0.6f, 0.0f);
+// Frames longer than this (e.g. a breakpoint) are simulated as this long
+constexpr float const PARTICLE_MAX_DELTA_TIME = 0.1f;
+
+static_assert(sizeof(Particle) == 32, "Particle must match its std430 layout in the shaders");
+
+// Counter buffer (particles.comp): alive particles of each buffer, then
+// the indirect arguments written by the finalize stage
+struct ParticleCounters {
+    uint32_t alive[2];
+    VkDispatchIndirectCommand dispatch;
+    VkDrawIndirectCommand draw;
+};
+
+// Push constants of particles.comp
+struct ParticleParams {
+    // xyz: emitter position, w: emission speed spread
+    glm::vec4 emitter;
+    // xyz: gravity, w: delta time in seconds
+    glm::vec4 gravity;
+    uint32_t source;
+    uint32_t capacity;
+    uint32_t emit_count;
+    uint32_t seed;
+};
+
+// Push constants of particle.vert
+struct ParticleDrawPushConstants {
+    glm::mat4 view_proj;
+    glm::vec4 camera_right;
+    glm::vec4 camera_up;
+};
+
+void ParticleSystem::init(VkPhysicalDevice physical_device, VkDevice device, const DeviceCapabilities &capabilities, VkCommandPool command_pool, VkQueue queue, const ParticleRenderTarget &render_target, uint32_t capacity) {
+    if (capacity == 0) {
+        throw std::runtime_error("a particle system needs a capacity");
+    }
+    m_capacity = capacity;
+    m_source = 0;
+    m_emit_accumulator = 0.0f;
+    m_simulated_time = 0.0f;
+    m_seed = 0;
+    const VkDeviceSize buffer_size = sizeof(Particle) * static_cast<VkDeviceSize>(capacity);
+    Log("-> Initializing the particle system (" << capacity << " particles, 2 x " << buffer_size / (1024 * 1024) << " MB)...");
+
+    // Never read nor written by the CPU: the simulation only reads the
+    // particles it wrote before
+    for (auto &particle_buffer: m_particle_buffers) {
+        particle_buffer = createBuffer(
+            physical_device,
+            device,
+            buffer_size,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    }
+    // No particle: an empty first simulation, and an empty draw
+    ParticleCounters counters {};
+    counters.dispatch = {0, 1, 1};
+    counters.draw = {6, 0, 0, 0};
+    m_counter_buffer = createDeviceLocalBuffer(physical_device, device, command_pool, queue, &counters, sizeof(counters), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+
+    _createDescriptors(device);
+    _createComputePipelines(device, capabilities);
+    _createDrawPipeline(device, capabilities, render_target);
+}
+
+void ParticleSystem::_createDescriptors(VkDevice device) {
+    // 0: source particles, 1: destination particles (drawn), 2: counters
+    VkDescriptorSetLayoutBinding bindings[3] {};
+    for (uint32_t i = 0; i < 3; i++) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_VERTEX_BIT;
+    }
+    VkDescriptorSetLayoutCreateInfo layout_info {};
+    layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layout_info.bindingCount = 3;
+    layout_info.pBindings = bindings;
+    if (vkCreateDescriptorSetLayout(device, &layout_info, nullptr, &m_descriptor_set_layout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create the particle descriptor set layout");
+    }
+
+    // Both sets never change: written once
+    m_descriptor_allocator.init(device, 2, {{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3.0f}});
+    for (uint32_t i = 0; i < 2; i++) {
+        m_descriptor_sets[i] = m_descriptor_allocator.allocate(device, m_descriptor_set_layout);
+        const VkDescriptorBufferInfo buffer_infos[3] = {
+            {m_particle_buffers[i].buffer, 0, VK_WHOLE_SIZE},
+            {m_particle_buffers[1 - i].buffer, 0, VK_WHOLE_SIZE},
+            {m_counter_buffer.buffer, 0, VK_WHOLE_SIZE}
+        };
+        VkWriteDescriptorSet writes[3] {};
+        for (uint32_t j = 0; j < 3; j++) {
+            writes[j].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[j].dstSet = m_descriptor_sets[i];
+            writes[j].dstBinding = j;
+            writes[j].descriptorCount = 1;
+            writes[j].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            writes[j].pBufferInfo = &buffer_infos[j];
+        }
+        vkUpdateDescriptorSets(device, 3, writes, 0, nullptr);
+    }
+}
+
+void ParticleSystem::_createComputePipelines(VkDevice device, const DeviceCapabilities &capabilities) {
+    const VkPushConstantRange push_constant_range = pushConstantRange<ParticleParams>(capabilities, VK_SHADER_STAGE_COMPUTE_BIT);
+    VkPipelineLayoutCreateInfo pipeline_layout_info {};
+    pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipeline_layout_info.setLayoutCount = 1;
+    pipeline_layout_info.pSetLayouts = &m_descriptor_set_layout;
+    pipeline_layout_info.pushConstantRangeCount = 1;
+    pipeline_layout_info.pPushConstantRanges = &push_constant_range;
+    if (vkCreatePipelineLayout(device, &pipeline_layout_info, nullptr, &m_compute_pipeline_layout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create the particle compute pipeline layout");
+    }
+
+    // One pipeline per stage of the same shader
+    VkShaderModule compute_shader_module = createShaderModule(device, "particles.spv");
+    const uint32_t stages[3] = {PARTICLE_STAGE_SIMULATE, PARTICLE_STAGE_EMIT, PARTICLE_STAGE_FINALIZE};
+    VkSpecializationMapEntry specialization_entry {};
+    specialization_entry.constantID = 0;
+    specialization_entry.offset = 0;
+    specialization_entry.size = sizeof(uint32_t);
+    VkSpecializationInfo specialization_infos[3] {};
+    VkComputePipelineCreateInfo pipeline_infos[3] {};
+    for (uint32_t i = 0; i < 3; i++) {
+        specialization_infos[i].mapEntryCount = 1;
+        specialization_infos[i].pMapEntries = &specialization_entry;
+        specialization_infos[i].dataSize = sizeof(uint32_t);
+        specialization_infos[i].pData = &stages[i];
+
+        pipeline_infos[i].sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipeline_infos[i].stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        pipeline_infos[i].stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipeline_infos[i].stage.module = compute_shader_module;
+        pipeline_infos[i].stage.pName = "main";
+        pipeline_infos[i].stage.pSpecializationInfo = &specialization_infos[i];
+        pipeline_infos[i].layout = m_compute_pipeline_layout;
+    }
+    const auto res = vkCreateComputePipelines(device, VK_NULL_HANDLE, 3, pipeline_infos, nullptr, m_compute_pipelines);
+    vkDestroyShaderModule(device, compute_shader_module, nullptr);
+    if (res != VK_SUCCESS) {
+        throw std::runtime_error("failed to create the particle compute pipelines");
+    }
+}
+
+void ParticleSystem::_createDrawPipeline(VkDevice device, const DeviceCapabilities &capabilities, const ParticleRenderTarget &render_target) {
+    const VkPushConstantRange push_constant_range = pushConstantRange<ParticleDrawPushConstants>(capabilities, VK_SHADER_STAGE_VERTEX_BIT);
+    VkPipelineLayoutCreateInfo pipeline_layout_info {};
+    pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipeline_layout_info.setLayoutCount = 1;
+    pipeline_layout_info.pSetLayouts = &m_descriptor_set_layout;
+    pipeline_layout_info.pushConstantRangeCount = 1;
+    pipeline_layout_info.pPushConstantRanges = &push_constant_range;
+    if (vkCreatePipelineLayout(device, &pipeline_layout_info, nullptr, &m_draw_pipeline_layout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create the particle pipeline layout");
+    }
+
+    VkShaderModule vertex_shader_module = createShaderModule(device, "particle_vert.spv");
+    VkShaderModule fragment_shader_module = createShaderModule(device, "particle_frag.spv");
+    VkPipelineShaderStageCreateInfo shader_stages[2] {};
+    shader_stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    shader_stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+    shader_stages[0].module = vertex_shader_module;
+    shader_stages[0].pName = "main";
+    shader_stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    shader_stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    shader_stages[1].module = fragment_shader_module;
+    shader_stages[1].pName = "main";
+
+    // The quads are built from the particle buffer: no vertex input
+    VkPipelineVertexInputStateCreateInfo vertex_input_info {};
+    vertex_input_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+    VkPipelineInputAssemblyStateCreateInfo input_assembly_info {};
+    input_assembly_info.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    input_assembly_info.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    input_assembly_info.primitiveRestartEnable = VK_FALSE;
+
+    // Dynamic, set in recordDraw
+    VkPipelineViewportStateCreateInfo viewport_state {};
+    viewport_state.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewport_state.viewportCount = 1;
+    viewport_state.scissorCount = 1;
+
+    VkPipelineRasterizationStateCreateInfo rasterization_state_create_info {};
+    rasterization_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterization_state_create_info.polygonMode = VK_POLYGON_MODE_FILL;
+    rasterization_state_create_info.lineWidth = 1.0f;
+    rasterization_state_create_info.cullMode = VK_CULL_MODE_NONE;
+    rasterization_state_create_info.frontFace = VK_FRONT_FACE_CLOCKWISE;
+
+    VkPipelineMultisampleStateCreateInfo multisample_state_create_info {};
+    multisample_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisample_state_create_info.rasterizationSamples = render_target.samples;
+    multisample_state_create_info.minSampleShading = 1.0f;
+
+    // Additive: the particles need no sorting
+    VkPipelineColorBlendAttachmentState color_blend_attachment {};
+    color_blend_attachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    color_blend_attachment.blendEnable = VK_TRUE;
+    color_blend_attachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+    color_blend_attachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE;
+    color_blend_attachment.colorBlendOp = VK_BLEND_OP_ADD;
+    color_blend_attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+    color_blend_attachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    color_blend_attachment.alphaBlendOp = VK_BLEND_OP_ADD;
+
+    VkPipelineColorBlendStateCreateInfo color_blending {};
+    color_blending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    color_blending.logicOpEnable = VK_FALSE;
+    color_blending.attachmentCount = 1;
+    color_blending.pAttachments = &color_blend_attachment;
+
+    // Hidden by the scene, but never hiding each other
+    RasterState raster_state {};
+    raster_state.depth_test = true;
+    raster_state.depth_write = false;
+    const VkPipelineDepthStencilStateCreateInfo depth_stencil_state = depthStencilState(raster_state);
+
+    // Only viewport and scissor: the particles are drawn last, with their
+    // own fixed-function state baked in the pipeline
+    const std::vector<VkDynamicState> dynamic_states = pipelineDynamicStates(false);
+    VkPipelineDynamicStateCreateInfo dynamic_state {};
+    dynamic_state.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamic_state.dynamicStateCount = static_cast<uint32_t>(dynamic_states.size());
+    dynamic_state.pDynamicStates = dynamic_states.data();
+
+    VkGraphicsPipelineCreateInfo pipeline_info {};
+    pipeline_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipeline_info.stageCount = 2;
+    pipeline_info.pStages = shader_stages;
+    pipeline_info.pVertexInputState = &vertex_input_info;
+    pipeline_info.pInputAssemblyState = &input_assembly_info;
+    pipeline_info.pViewportState = &viewport_state;
+    pipeline_info.pRasterizationState = &rasterization_state_create_info;
+    pipeline_info.pMultisampleState = &multisample_state_create_info;
+    pipeline_info.pDepthStencilState = &depth_stencil_state;
+    pipeline_info.pColorBlendState = &color_blending;
+    pipeline_info.pDynamicState = &dynamic_state;
+    pipeline_info.layout = m_draw_pipeline_layout;
+    VkPipelineRenderingCreateInfo pipeline_rendering_info {};
+    pipeline_rendering_info.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+    pipeline_rendering_info.colorAttachmentCount = 1;
+    pipeline_rendering_info.pColorAttachmentFormats = &render_target.color_format;
+    pipeline_rendering_info.depthAttachmentFormat = render_target.depth_format;
+    pipeline_rendering_info.stencilAttachmentFormat = VK_FORMAT_UNDEFINED;
+    if (render_target.render_pass == VK_NULL_HANDLE)
+        pipeline_info.pNext = &pipeline_rendering_info;
+    pipeline_info.renderPass = render_target.render_pass;
+    pipeline_info.subpass = 0;
+    pipeline_info.basePipelineIndex = -1;
+
+    const VkResult result = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &m_draw_pipeline);
+    vkDestroyShaderModule(device, vertex_shader_module, nullptr);
+    vkDestroyShaderModule(device, fragment_shader_module, nullptr);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create the particle pipeline");
+    }
+}
+
+void ParticleSystem::recordSimulation(VkCommandBuffer command_buffer, float delta_time) {
+    delta_time = std::min(delta_time, PARTICLE_MAX_DELTA_TIME);
+    m_simulated_time += delta_time;
+    m_emit_accumulator = std::min(m_emit_accumulator + m_capacity * delta_time / PARTICLE_AVERAGE_LIFE, static_cast<float>(m_capacity));
+    const uint32_t emit_count = static_cast<uint32_t>(m_emit_accumulator);
+    m_emit_accumulator -= emit_count;
+
+    // The previous frame drew the particles (vertex stage) and the counters
+    // (indirect stage) this simulation overwrites, and wrote the counters
+    // this one reads
+    VkMemoryBarrier start_barrier {};
+    start_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    start_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    start_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 1, &start_barrier, 0, nullptr, 0, nullptr);
+
+    // Before the finalize stage: the alive counter, and the destination particles
+    VkMemoryBarrier stage_barrier {};
+    stage_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    stage_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    stage_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+    ParticleParams params {};
+    params.emitter = PARTICLE_EMITTER;
+    params.gravity = glm::vec4(PARTICLE_GRAVITY, delta_time);
+    params.source = m_source;
+    params.capacity = m_capacity;
+    params.emit_count = emit_count;
+    params.seed = m_seed++;
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_compute_pipeline_layout, 0, 1, &m_descriptor_sets[m_source], 0, nullptr);
+    pushConstants(command_buffer, m_compute_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, params);
+
+    // Survivors first: the size of the dispatch was written by the last
+    // finalize stage, on the GPU
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_compute_pipelines[PARTICLE_STAGE_SIMULATE]);
+    vkCmdDispatchIndirect(command_buffer, m_counter_buffer.buffer, offsetof(ParticleCounters, dispatch));
+    // Both stages append to the destination with atomics: they may overlap
+    if (emit_count > 0) {
+        vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_compute_pipelines[PARTICLE_STAGE_EMIT]);
+        vkCmdDispatch(command_buffer, (emit_count + PARTICLE_WORKGROUP_SIZE - 1) / PARTICLE_WORKGROUP_SIZE, 1, 1);
+    }
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &stage_barrier, 0, nullptr, 0, nullptr);
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_compute_pipelines[PARTICLE_STAGE_FINALIZE]);
+    vkCmdDispatch(command_buffer, 1, 1, 1);
+
+    // The destination is drawn, then simulated next frame
+    m_source = 1 - m_source;
+}
+
+void ParticleSystem::recordOutputBarrier(VkCommandBuffer command_buffer) {
+    VkMemoryBarrier output_barrier {};
+    output_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    output_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    output_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 1, &output_barrier, 0, nullptr, 0, nullptr);
+}
+
+void ParticleSystem::recordDraw(VkCommandBuffer command_buffer, VkExtent2D extent, const glm::mat4 &view_proj, const glm::mat4 &view) {
+    ParticleDrawPushConstants push_constants {};
+    push_constants.view_proj = view_proj;
+    // Rows of the view rotation: the camera axes in world space
+    push_constants.camera_right = glm::vec4(view[0][0], view[1][0], view[2][0], 0.0f);
+    push_constants.camera_up = glm::vec4(view[0][1], view[1][1], view[2][1], 0.0f);
+
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_draw_pipeline);
+    setViewportAndScissor(command_buffer, extent);
+    // The set of the last simulation: its destination is binding 1
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_draw_pipeline_layout, 0, 1, &m_descriptor_sets[1 - m_source], 0, nullptr);
+    pushConstants(command_buffer, m_draw_pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT, push_constants);
+    // 6 vertices per alive particle, written by the finalize stage
+    vkCmdDrawIndirect(command_buffer, m_counter_buffer.buffer, offsetof(ParticleCounters, draw), 1, sizeof(VkDrawIndirectCommand));
+}
+
+void ParticleSystem::clean(VkDevice device) {
+    if (m_draw_pipeline != VK_NULL_HANDLE) vkDestroyPipeline(device, m_draw_pipeline, nullptr);
+    if (m_draw_pipeline_layout != VK_NULL_HANDLE) vkDestroyPipelineLayout(device, m_draw_pipeline_layout, nullptr);
+    for (auto &pipeline: m_compute_pipelines) {
+        if (pipeline != VK_NULL_HANDLE) vkDestroyPipeline(device, pipeline, nullptr);
+        pipeline = VK_NULL_HANDLE;
+    }
+    if (m_compute_pipeline_layout != VK_NULL_HANDLE) vkDestroyPipelineLayout(device, m_compute_pipeline_layout, nullptr);
+    // The sets are freed with the pools of the allocator
+    m_descriptor_allocator.clean(device);
+    if (m_descriptor_set_layout != VK_NULL_HANDLE) vkDestroyDescriptorSetLayout(device, m_descriptor_set_layout, nullptr);
+    m_draw_pipeline = VK_NULL_HANDLE;
+    m_draw_pipeline_layout = VK_NULL_HANDLE;
+    m_compute_pipeline_layout = VK_NULL_HANDLE;
+    m_descriptor_set_layout = VK_NULL_HANDLE;
+    m_descriptor_sets[0] = VK_NULL_HANDLE;
+    m_descriptor_sets[1] = VK_NULL_HANDLE;
+    for (auto &particle_buffer: m_particle_buffers)
+        destroyBuffer(device, particle_buffer);
+    destroyBuffer(device, m_counter_buffer);
+    m_capacity = 0;
+}
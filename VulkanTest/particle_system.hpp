@@ -0,0 +1,124 @@
+//
+//  particle_system.hpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#ifndef particle_system_hpp
+#define particle_system_hpp
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+
+#include "buffer_utils.hpp"
+#include "descriptor_allocator.hpp"
+#include "device_capabilities.hpp"
+
+/**
+ * A particle, in the storage buffers (std430 layout).
+ */
+struct Particle {
+    // xyz: position, w: remaining life in seconds
+    glm::vec4 position_life;
+    // xyz: velocity, w: size of the quad
+    glm::vec4 velocity_size;
+};
+
+/**
+ * Attachments the particles are drawn to: a render pass, or (with
+ * render_pass = VK_NULL_HANDLE) dynamic rendering with these formats.
+ */
+struct ParticleRenderTarget {
+    VkRenderPass render_pass = VK_NULL_HANDLE;
+    VkFormat color_format = VK_FORMAT_UNDEFINED;
+    VkFormat depth_format = VK_FORMAT_UNDEFINED;
+    VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+};
+
+/**
+ * Particles simulated entirely on the GPU, the CPU only records the
+ * dispatches and the draw.
+ *
+ * The particles live in two storage buffers used in turn (ping-pong):
+ * every frame, the simulation reads the alive particles of one buffer,
+ * moves them, and appends the survivors to the other buffer (compaction,
+ * through an atomic alive counter). New particles are then appended after
+ * them, and a last single invocation clamps the counter and writes the
+ * indirect arguments: the dispatch of the next simulation, and the draw
+ * (one instanced quad per alive particle). The number of alive particles
+ * is never read back.
+ * Particles are emitted at capacity / average life per second, so about
+ * capacity particles are alive once the system is warm.
+ */
+class ParticleSystem {
+
+public:
+    void init(VkPhysicalDevice physical_device, VkDevice device, const DeviceCapabilities &capabilities, VkCommandPool command_pool, VkQueue queue, const ParticleRenderTarget &render_target, uint32_t capacity);
+
+    void clean(VkDevice device);
+
+    uint32_t capacity() const { return m_capacity; }
+
+    /**
+     * Seconds simulated since init (the buffers are about full after the
+     * longest particle life, 4 seconds).
+     */
+    float simulatedTime() const { return m_simulated_time; }
+
+    /**
+     * Record the simulation of the frame, outside of any render pass:
+     * delta_time (seconds) of simulation, plus the particles emitted during it.
+     * Must be recorded once per frame, before the draw.
+     * The draw is not visible to the vertex stage until recordOutputBarrier
+     * (or a frame graph barrier on particleBuffer() / counterBuffer()).
+     */
+    void recordSimulation(VkCommandBuffer command_buffer, float delta_time);
+
+    /**
+     * Make the output of the simulation visible to the draw.
+     */
+    void recordOutputBarrier(VkCommandBuffer command_buffer);
+
+    /**
+     * Record the draw of the particles simulated last, inside the render
+     * pass, as camera facing quads (additive, depth tested, not written).
+     */
+    void recordDraw(VkCommandBuffer command_buffer, VkExtent2D extent, const glm::mat4 &view_proj, const glm::mat4 &view);
+
+    /**
+     * The two particle buffers (both written by a simulation), and the
+     * buffer of the alive counters / indirect arguments.
+     */
+    VkBuffer particleBuffer(uint32_t index) const { return m_particle_buffers[index].buffer; }
+    VkBuffer counterBuffer() const { return m_counter_buffer.buffer; }
+
+private:
+    uint32_t m_capacity = 0;
+    // Buffer the next simulation reads
+    uint32_t m_source = 0;
+    // Particles to emit, carried from frame to frame
+    float m_emit_accumulator = 0.0f;
+    float m_simulated_time = 0.0f;
+    uint32_t m_seed = 0;
+    AllocatedBuffer m_particle_buffers[2];
+    // ParticleCounters (particle_system.cpp)
+    AllocatedBuffer m_counter_buffer;
+
+    DescriptorAllocator m_descriptor_allocator;
+    VkDescriptorSetLayout m_descriptor_set_layout = VK_NULL_HANDLE;
+    // Set i reads particles[i] and writes particles[1 - i]
+    VkDescriptorSet m_descriptor_sets[2] = {VK_NULL_HANDLE, VK_NULL_HANDLE};
+    VkPipelineLayout m_compute_pipeline_layout = VK_NULL_HANDLE;
+    // Simulate / emit / finalize stages of particles.comp
+    VkPipeline m_compute_pipelines[3] = {VK_NULL_HANDLE, VK_NULL_HANDLE, VK_NULL_HANDLE};
+    VkPipelineLayout m_draw_pipeline_layout = VK_NULL_HANDLE;
+    VkPipeline m_draw_pipeline = VK_NULL_HANDLE;
+
+    void _createDescriptors(VkDevice device);
+    void _createComputePipelines(VkDevice device, const DeviceCapabilities &capabilities);
+    void _createDrawPipeline(VkDevice device, const DeviceCapabilities &capabilities, const ParticleRenderTarget &render_target);
+};
+
+#endif /* particle_system_hpp */
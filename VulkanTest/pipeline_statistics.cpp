@@ -0,0 +1,137 @@
+//
+//  pipeline_statistics.cpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#include "pipeline_statistics.hpp"
+#include "base.hpp"
+#include <stdexcept>
+
+// In the order of PipelineStatisticsCounter (increasing bits)
+constexpr VkQueryPipelineStatisticFlags const PIPELINE_STATISTICS_FLAGS =
+    VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT
+    | VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT
+    | VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT
+    | VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT
+    | VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT
+    | VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT
+    | VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+
+const char* pipelineStatisticsCounterName(PipelineStatisticsCounter counter) {
+    switch (counter) {
+        case PipelineStatisticsCounter::InputAssemblyVertices:
+            return "input assembly vertices";
+        case PipelineStatisticsCounter::InputAssemblyPrimitives:
+            return "input assembly primitives";
+        case PipelineStatisticsCounter::VertexShaderInvocations:
+            return "vertex shader invocations";
+        case PipelineStatisticsCounter::ClippingInvocations:
+            return "clipping invocations";
+        case PipelineStatisticsCounter::ClippingPrimitives:
+            return "clipping primitives";
+        case PipelineStatisticsCounter::FragmentShaderInvocations:
+            return "fragment shader invocations";
+        case PipelineStatisticsCounter::ComputeShaderInvocations:
+            return "compute shader invocations";
+    }
+    return "unknown";
+}
+
+void PipelineStatistics::init(VkDevice device, const DeviceCapabilities &capabilities, uint32_t frames_in_flight, uint32_t max_scopes) {
+    m_frames.assign(frames_in_flight, {});
+    m_max_scopes = max_scopes;
+    if (!capabilities.pipeline_statistics) {
+        Log("-> Pipeline statistics disabled: pipelineStatisticsQuery is not supported");
+        return;
+    }
+    VkQueryPoolCreateInfo query_pool_info {};
+    query_pool_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    query_pool_info.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+    query_pool_info.queryCount = frames_in_flight * max_scopes;
+    query_pool_info.pipelineStatistics = PIPELINE_STATISTICS_FLAGS;
+    if (vkCreateQueryPool(device, &query_pool_info, nullptr, &m_query_pool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create the pipeline statistics query pool");
+    }
+    m_inherited_queries = capabilities.inherited_queries;
+    m_values.resize(max_scopes * PIPELINE_STATISTICS_COUNTER_COUNT);
+}
+
+void PipelineStatistics::clean(VkDevice device) {
+    if (m_query_pool != VK_NULL_HANDLE) vkDestroyQueryPool(device, m_query_pool, nullptr);
+    m_query_pool = VK_NULL_HANDLE;
+    m_frames.clear();
+    m_results.clear();
+}
+
+void PipelineStatistics::beginFrame(VkDevice device, uint32_t frame_index) {
+    m_current_frame = frame_index;
+    m_open_scope = UINT32_MAX;
+    if (!enabled())
+        return;
+    FrameScopes &frame = m_frames[frame_index];
+    if (frame.names.empty())
+        return;
+    // The fence of the frame has been waited for: the results are available
+    const uint32_t query_count = static_cast<uint32_t>(frame.names.size());
+    const VkDeviceSize stride = sizeof(uint64_t) * PIPELINE_STATISTICS_COUNTER_COUNT;
+    const VkResult result = vkGetQueryPoolResults(
+        device,
+        m_query_pool,
+        _firstQuery(frame_index),
+        query_count,
+        stride * query_count,
+        m_values.data(),
+        stride,
+        VK_QUERY_RESULT_64_BIT);
+    if (result == VK_SUCCESS) {
+        m_results.resize(query_count);
+        for (uint32_t i = 0; i < query_count; i++) {
+            m_results[i].name = frame.names[i];
+            for (uint32_t counter = 0; counter < PIPELINE_STATISTICS_COUNTER_COUNT; counter++)
+                m_results[i].counters[counter] = m_values[i * PIPELINE_STATISTICS_COUNTER_COUNT + counter];
+        }
+    }
+    frame.names.clear();
+}
+
+void PipelineStatistics::recordReset(VkCommandBuffer command_buffer) {
+    if (enabled())
+        vkCmdResetQueryPool(command_buffer, m_query_pool, _firstQuery(m_current_frame), m_max_scopes);
+}
+
+uint32_t PipelineStatistics::begin(VkCommandBuffer command_buffer, const std::string &name) {
+    FrameScopes &frame = m_frames[m_current_frame];
+    if (!enabled() || frame.names.size() >= m_max_scopes)
+        return UINT32_MAX;
+    if (m_open_scope != UINT32_MAX) {
+        throw std::runtime_error("pipeline statistics scopes cannot be nested");
+    }
+    const uint32_t scope = static_cast<uint32_t>(frame.names.size());
+    frame.names.push_back(name);
+    vkCmdBeginQuery(command_buffer, m_query_pool, _firstQuery(m_current_frame) + scope, 0);
+    m_open_scope = scope;
+    return scope;
+}
+
+void PipelineStatistics::end(VkCommandBuffer command_buffer, uint32_t scope) {
+    if (scope == UINT32_MAX)
+        return;
+    vkCmdEndQuery(command_buffer, m_query_pool, _firstQuery(m_current_frame) + scope);
+    m_open_scope = UINT32_MAX;
+}
+
+VkQueryPipelineStatisticFlags PipelineStatistics::inheritedStatistics() const {
+    return enabled() && m_inherited_queries ? PIPELINE_STATISTICS_FLAGS : 0;
+}
+
+int64_t PipelineStatistics::counter(const std::string &name, PipelineStatisticsCounter counter) const {
+    int64_t total = -1;
+    for (const PassStatistics &result: m_results) {
+        if (result.name != name)
+            continue;
+        total = (total < 0 ? 0 : total) + static_cast<int64_t>(result.value(counter));
+    }
+    return total;
+}
@@ -0,0 +1,130 @@
+//
+//  pipeline_statistics.hpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#ifndef pipeline_statistics_hpp
+#define pipeline_statistics_hpp
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#include <array>
+#include <string>
+#include <vector>
+
+#include "device_capabilities.hpp"
+
+/**
+ * Counters of a pipeline statistics query, in the order Vulkan writes
+ * them (the order of their VkQueryPipelineStatisticFlagBits).
+ */
+enum class PipelineStatisticsCounter {
+    InputAssemblyVertices,
+    InputAssemblyPrimitives,
+    VertexShaderInvocations,
+    // Primitives reaching the clipping stage, and primitives output by it
+    ClippingInvocations,
+    ClippingPrimitives,
+    FragmentShaderInvocations,
+    ComputeShaderInvocations,
+};
+
+constexpr uint32_t const PIPELINE_STATISTICS_COUNTER_COUNT = 7;
+
+/**
+ * Name of a counter, for the logs (e.g. "fragment shader invocations").
+ */
+const char* pipelineStatisticsCounterName(PipelineStatisticsCounter counter);
+
+/**
+ * Counters of a pass of a frame.
+ */
+struct PassStatistics {
+    std::string name;
+    std::array<uint64_t, PIPELINE_STATISTICS_COUNTER_COUNT> counters {};
+
+    uint64_t value(PipelineStatisticsCounter counter) const { return counters[static_cast<uint32_t>(counter)]; }
+};
+
+/**
+ * Counts the work of the passes of the frame with pipeline statistics
+ * queries: vertices / primitives assembled, shader invocations per stage,
+ * primitives clipped. Tells whether a pass is bound by its geometry or by
+ * its fragments.
+ *
+ * Like the GpuTimer, each frame in flight has its own range of queries,
+ * read back (without waiting) once the fence of the frame has been waited
+ * for. Queries of this type cannot be nested: a scope must end before the
+ * next one begins, and both are recorded outside of any render pass.
+ * Secondary command buffers executed in a scope inherit the query only if
+ * the device supports inheritedQueries (see inheritedStatistics()).
+ * Does nothing (and returns no result) if the device does not support
+ * pipelineStatisticsQuery. Not thread-safe.
+ */
+class PipelineStatistics {
+
+public:
+    void init(VkDevice device, const DeviceCapabilities &capabilities, uint32_t frames_in_flight, uint32_t max_scopes);
+
+    void clean(VkDevice device);
+
+    bool enabled() const { return m_query_pool != VK_NULL_HANDLE; }
+
+    /**
+     * Read the counters of the previous use of the frame, once its fence
+     * has been waited for, and forget its scopes.
+     */
+    void beginFrame(VkDevice device, uint32_t frame_index);
+
+    /**
+     * Reset the queries of the frame, outside of any render pass, before
+     * any scope is recorded.
+     */
+    void recordReset(VkCommandBuffer command_buffer);
+
+    /**
+     * Start counting a pass, and return its scope for end().
+     * Scopes past max_scopes are not measured.
+     */
+    uint32_t begin(VkCommandBuffer command_buffer, const std::string &name);
+
+    void end(VkCommandBuffer command_buffer, uint32_t scope);
+
+    /**
+     * Statistics to give in VkCommandBufferInheritanceInfo::pipelineStatistics
+     * for secondary command buffers executed in a scope.
+     */
+    VkQueryPipelineStatisticFlags inheritedStatistics() const;
+
+    /**
+     * Passes of the last frame read back.
+     */
+    const std::vector<PassStatistics>& results() const { return m_results; }
+
+    /**
+     * Counter of the named pass in the last frame read back (summed if it
+     * was recorded several times), or a negative value if it was not measured.
+     */
+    int64_t counter(const std::string &name, PipelineStatisticsCounter counter) const;
+
+private:
+    struct FrameScopes {
+        std::vector<std::string> names;
+    };
+
+    VkQueryPool m_query_pool = VK_NULL_HANDLE;
+    bool m_inherited_queries = false;
+    uint32_t m_max_scopes = 0;
+    uint32_t m_current_frame = 0;
+    // Scope recorded between begin() and end(), if any
+    uint32_t m_open_scope = UINT32_MAX;
+    std::vector<FrameScopes> m_frames;
+    std::vector<uint64_t> m_values;
+    std::vector<PassStatistics> m_results;
+
+    uint32_t _firstQuery(uint32_t frame_index) const { return frame_index * m_max_scopes; }
+};
+
+#endif /* pipeline_statistics_hpp */
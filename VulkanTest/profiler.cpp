@@ -0,0 +1,141 @@
+//
+//  profiler.cpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#include "profiler.hpp"
+#include "base.hpp"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+struct ProfilerEvent {
+    const char *name;
+    uint64_t begin;
+    uint64_t end;
+};
+
+/**
+ * Ring of the zones of a thread: written by that thread only, read by
+ * writeChromeTrace.
+ */
+struct ProfilerThreadBuffer {
+    uint32_t thread_id = 0;
+    // Guarded by s_registry_mutex
+    std::string name;
+    // Allocated on the first zone, under s_registry_mutex
+    std::unique_ptr<ProfilerEvent[]> events;
+    // Events written so far (the last PROFILER_RING_CAPACITY are kept)
+    std::atomic<uint64_t> head {0};
+};
+
+static const std::chrono::steady_clock::time_point s_origin = std::chrono::steady_clock::now();
+static std::mutex s_registry_mutex;
+// Never freed: a thread keeps a pointer to its buffer
+static std::vector<std::unique_ptr<ProfilerThreadBuffer>> s_thread_buffers;
+static thread_local ProfilerThreadBuffer *t_thread_buffer = nullptr;
+
+static ProfilerThreadBuffer& threadBuffer() {
+    if (t_thread_buffer == nullptr) {
+        std::lock_guard<std::mutex> lock(s_registry_mutex);
+        auto buffer = std::make_unique<ProfilerThreadBuffer>();
+        buffer->thread_id = static_cast<uint32_t>(s_thread_buffers.size());
+        buffer->name = "thread " + std::to_string(buffer->thread_id);
+        t_thread_buffer = buffer.get();
+        s_thread_buffers.push_back(std::move(buffer));
+    }
+    return *t_thread_buffer;
+}
+
+static void writeJsonString(std::ofstream &file, const char *text) {
+    file << '"';
+    for (const char *c = text; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\')
+            file << '\\';
+        file << *c;
+    }
+    file << '"';
+}
+
+// Fixed point: no exponent, nanosecond precision
+static void writeMicroseconds(std::ofstream &file, uint64_t nanoseconds) {
+    const uint64_t fraction = nanoseconds % 1000;
+    file << nanoseconds / 1000 << '.' << fraction / 100 << fraction / 10 % 10 << fraction % 10;
+}
+
+void Profiler::setThreadName(const std::string &name) {
+    ProfilerThreadBuffer &buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(s_registry_mutex);
+    buffer.name = name;
+}
+
+uint64_t Profiler::now() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - s_origin).count());
+}
+
+void Profiler::record(const char *name, uint64_t begin, uint64_t end) {
+    ProfilerThreadBuffer &buffer = threadBuffer();
+    if (buffer.events == nullptr) {
+        std::lock_guard<std::mutex> lock(s_registry_mutex);
+        buffer.events = std::make_unique<ProfilerEvent[]>(PROFILER_RING_CAPACITY);
+    }
+    const uint64_t head = buffer.head.load(std::memory_order_relaxed);
+    buffer.events[head % PROFILER_RING_CAPACITY] = {name, begin, end};
+    // The event is written before it is counted
+    buffer.head.store(head + 1, std::memory_order_release);
+}
+
+bool Profiler::writeChromeTrace(const std::string &path) {
+    std::ofstream file(path);
+    if (!file) {
+        LogE("failed to open the profiler trace " << path);
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(s_registry_mutex);
+    uint64_t event_count = 0;
+    std::vector<ProfilerEvent> events;
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    for (const std::unique_ptr<ProfilerThreadBuffer> &buffer: s_thread_buffers) {
+        file << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->thread_id << ",\"args\":{\"name\":";
+        writeJsonString(file, buffer->name.c_str());
+        file << "}}";
+        first = false;
+        if (buffer->events == nullptr)
+            continue;
+        const uint64_t head = buffer->head.load(std::memory_order_acquire);
+        const uint64_t oldest = head > PROFILER_RING_CAPACITY ? head - PROFILER_RING_CAPACITY : 0;
+        events.clear();
+        for (uint64_t i = oldest; i < head; i++)
+            events.push_back(buffer->events[i % PROFILER_RING_CAPACITY]);
+        // Drop the events the thread may have overwritten while copying
+        // (and the one it may be writing)
+        const uint64_t new_head = buffer->head.load(std::memory_order_acquire);
+        const uint64_t first_valid = new_head + 1 > PROFILER_RING_CAPACITY ? new_head + 1 - PROFILER_RING_CAPACITY : 0;
+        for (uint64_t i = std::max(oldest, first_valid); i < head; i++) {
+            const ProfilerEvent &event = events[i - oldest];
+            // Complete events, in microseconds
+            file << ",\n{\"name\":";
+            writeJsonString(file, event.name);
+            file << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->thread_id
+                << ",\"ts\":";
+            writeMicroseconds(file, event.begin);
+            file << ",\"dur\":";
+            writeMicroseconds(file, event.end - event.begin);
+            file << "}";
+            event_count++;
+        }
+    }
+    file << "\n]}\n";
+    if (!file) {
+        LogE("failed to write the profiler trace " << path);
+        return false;
+    }
+    Log("-> Profiler trace: " << event_count << " zones of " << s_thread_buffers.size() << " threads written to " << path);
+    return true;
+}
@@ -0,0 +1,97 @@
+//
+//  profiler.hpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#ifndef profiler_hpp
+#define profiler_hpp
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Events kept per thread: the oldest ones are overwritten
+constexpr uint32_t const PROFILER_RING_CAPACITY = 64 * 1024;
+
+/**
+ * CPU profiler of scoped zones (see ProfileZone).
+ *
+ * A zone records its begin / end timestamps in a ring buffer of the
+ * calling thread, written by that thread only: no lock nor shared cache
+ * line on the hot path. The rings are allocated on the first zone of each
+ * thread, and live until the end of the program.
+ * When the profiler is not started, a zone only costs the load of a flag;
+ * with PROFILER_DISABLED defined, zones are compiled out.
+ */
+class Profiler {
+
+public:
+    /**
+     * Start / stop recording the zones (of every thread).
+     */
+    static void start() { s_enabled.store(true, std::memory_order_relaxed); }
+    static void stop() { s_enabled.store(false, std::memory_order_relaxed); }
+    static bool enabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+    /**
+     * Name of the calling thread in the trace.
+     */
+    static void setThreadName(const std::string &name);
+
+    /**
+     * Nanoseconds since the start of the program.
+     */
+    static uint64_t now();
+
+    /**
+     * Record a zone of the calling thread. name must be a string literal
+     * (or outlive the profiler).
+     */
+    static void record(const char *name, uint64_t begin, uint64_t end);
+
+    /**
+     * Write the recorded zones of every thread as a Chrome trace-event JSON
+     * file (chrome://tracing, Perfetto). Zones recorded meanwhile may be
+     * missing: call it once stopped. Returns false if the file cannot be
+     * written.
+     */
+    static bool writeChromeTrace(const std::string &path);
+
+private:
+    inline static std::atomic<bool> s_enabled {false};
+};
+
+/**
+ * Records its lifetime as a zone, if the profiler is started.
+ */
+class ScopedZone {
+
+public:
+    explicit ScopedZone(const char *name) : m_name(Profiler::enabled() ? name : nullptr), m_begin(m_name != nullptr ? Profiler::now() : 0) {}
+
+    ~ScopedZone() {
+        if (m_name != nullptr)
+            Profiler::record(m_name, m_begin, Profiler::now());
+    }
+
+    ScopedZone(const ScopedZone &) = delete;
+    ScopedZone& operator=(const ScopedZone &) = delete;
+
+private:
+    const char *m_name;
+    uint64_t m_begin;
+};
+
+#define PROFILER_CONCAT_IMPL(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_IMPL(a, b)
+
+#ifdef PROFILER_DISABLED
+#define ProfileZone(name)
+#else
+// Zone from here to the end of the enclosing scope
+#define ProfileZone(name) ScopedZone PROFILER_CONCAT(profile_zone_, __LINE__)(name)
+#endif
+
+#endif /* profiler_hpp */
@@ -0,0 +1,33 @@
+//
+//  projection.cpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#include "projection.hpp"
+#include <cmath>
+
+glm::mat4 perspectiveReverseZ(float fov_y, float aspect, float z_near, float z_far) {
+    const float focal_length = 1.0f / std::tan(fov_y / 2.0f);
+    glm::mat4 projection(0.0f);
+    projection[0][0] = focal_length / aspect;
+    projection[1][1] = focal_length;
+    // z_clip = (z_near * z_view + z_near * z_far) / (z_far - z_near), w_clip = -z_view
+    projection[2][2] = z_near / (z_far - z_near);
+    projection[2][3] = -1.0f;
+    projection[3][2] = z_near * z_far / (z_far - z_near);
+    return projection;
+}
+
+glm::mat4 infinitePerspectiveReverseZ(float fov_y, float aspect, float z_near) {
+    const float focal_length = 1.0f / std::tan(fov_y / 2.0f);
+    glm::mat4 projection(0.0f);
+    projection[0][0] = focal_length / aspect;
+    projection[1][1] = focal_length;
+    // Limit of perspectiveReverseZ when z_far goes to infinity
+    projection[2][2] = 0.0f;
+    projection[2][3] = -1.0f;
+    projection[3][2] = z_near;
+    return projection;
+}
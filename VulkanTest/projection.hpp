@@ -0,0 +1,34 @@
+//
+//  projection.hpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#ifndef projection_hpp
+#define projection_hpp
+
+#include <glm/glm.hpp>
+
+/**
+ * Reverse-Z projections, for the Vulkan clip space (0 <= z <= w) and
+ * right-handed view spaces, like glm's ext/matrix_clip_space perspectiveRH_ZO.
+ * The near plane is mapped to a depth of 1 and the far plane to 0: the
+ * floating point precision of the depth buffer (dense around 0) then
+ * compensates the 1 / z distribution of the depth. Depth tests use
+ * VK_COMPARE_OP_GREATER, and the depth buffer is cleared to 0.
+ */
+
+/**
+ * Reverse-Z perspective projection (fov_y in radians).
+ */
+glm::mat4 perspectiveReverseZ(float fov_y, float aspect, float z_near, float z_far);
+
+/**
+ * Reverse-Z perspective projection with the far plane at infinity:
+ * depth = z_near / distance, never clipped in the distance.
+ * The frustum extracted from it has a degenerated far plane.
+ */
+glm::mat4 infinitePerspectiveReverseZ(float fov_y, float aspect, float z_near);
+
+#endif /* projection_hpp */
@@ -0,0 +1,60 @@
+//
+//  push_constants.hpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#ifndef push_constants_hpp
+#define push_constants_hpp
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#include <stdexcept>
+#include <type_traits>
+
+#include "base.hpp"
+#include "device_capabilities.hpp"
+
+/**
+ * Typed push constants: T is the C++ mirror of a GLSL push_constant block.
+ * Push constants are written in the command buffer itself, which makes
+ * them the cheapest way to give small per-draw data to the shaders
+ * (no descriptor update nor buffer write).
+ */
+template<typename T>
+constexpr void checkPushConstantType() {
+    static_assert(std::is_trivially_copyable<T>::value, "push constants must be trivially copyable");
+    static_assert(sizeof(T) % 4 == 0, "push constants size must be a multiple of 4");
+}
+
+/**
+ * Range of T, to register in VkPipelineLayoutCreateInfo.
+ * Throws if T (at the given offset) does not fit in maxPushConstantsSize.
+ */
+template<typename T>
+VkPushConstantRange pushConstantRange(const DeviceCapabilities &capabilities, VkShaderStageFlags stages, uint32_t offset = 0) {
+    checkPushConstantType<T>();
+    const uint32_t max_size = capabilities.properties.limits.maxPushConstantsSize;
+    if (offset + sizeof(T) > max_size) {
+        LogE("push constants of " << offset + sizeof(T) << " bytes, the device supports " << max_size);
+        throw std::runtime_error("push constants are too large for this device");
+    }
+    VkPushConstantRange range {};
+    range.stageFlags = stages;
+    range.offset = offset;
+    range.size = sizeof(T);
+    return range;
+}
+
+/**
+ * Record vkCmdPushConstants for the whole T.
+ * stages must match the ones of the range registered in the layout.
+ */
+template<typename T>
+void pushConstants(VkCommandBuffer command_buffer, VkPipelineLayout layout, VkShaderStageFlags stages, const T &value, uint32_t offset = 0) {
+    checkPushConstantType<T>();
+    vkCmdPushConstants(command_buffer, layout, stages, offset, sizeof(T), &value);
+}
+
+#endif /* push_constants_hpp */
@@ -23,7 +23,9 @@ QueueFamilyIndices findQueueFamilies(const VkPhysicalDevice& device, const VkSur
     for (const auto& queue_family: queue_families) {
         if (queue_family_indices.hasSupport())
             break;
-        if (!queue_family_indices.graphics_family.has_value() && (queue_family.queueFlags & VK_QUEUE_GRAPHICS_BIT))
+        // The graphics queue also runs the compute passes (e.g. GPU culling), and
+        // Vulkan guarantees a family supporting both graphics and compute exists
+        if (!queue_family_indices.graphics_family.has_value() && (queue_family.queueFlags & VK_QUEUE_GRAPHICS_BIT) && (queue_family.queueFlags & VK_QUEUE_COMPUTE_BIT))
             queue_family_indices.graphics_family = i;
         if (!queue_family_indices.present_family.has_value()) {
             VkBool32 present_support = false;
@@ -0,0 +1,153 @@
+//
+//  scene.cpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#include "scene.hpp"
+#include <glm/gtc/constants.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+VkVertexInputBindingDescription Vertex::bindingDescription() {
+    VkVertexInputBindingDescription binding_description {};
+    binding_description.binding = 0;
+    binding_description.stride = sizeof(Vertex);
+    binding_description.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    return binding_description;
+}
+
+std::array<VkVertexInputAttributeDescription, 3> Vertex::attributeDescriptions() {
+    std::array<VkVertexInputAttributeDescription, 3> attribute_descriptions {};
+    attribute_descriptions[0].binding = 0;
+    attribute_descriptions[0].location = 0;
+    attribute_descriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
+    attribute_descriptions[0].offset = offsetof(Vertex, position);
+    attribute_descriptions[1].binding = 0;
+    attribute_descriptions[1].location = 1;
+    attribute_descriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
+    attribute_descriptions[1].offset = offsetof(Vertex, color);
+    attribute_descriptions[2].binding = 0;
+    attribute_descriptions[2].location = 2;
+    attribute_descriptions[2].format = VK_FORMAT_R32G32_SFLOAT;
+    attribute_descriptions[2].offset = offsetof(Vertex, uv);
+    return attribute_descriptions;
+}
+
+Scene buildTriangleGridScene(uint32_t columns, uint32_t rows, const std::vector<uint32_t> &texture_handles, uint32_t streamed_texture_count, uint32_t sampler_handle) {
+    Scene scene {};
+    // The famous RGB triangle
+    scene.vertices = {
+        {{0.0f, -0.5f, 0.0f}, {1.0f, 0.0f, 0.0f}, {0.5f, 0.0f}},
+        {{0.5f, 0.5f, 0.0f}, {0.0f, 1.0f, 0.0f}, {1.0f, 1.0f}},
+        {{-0.5f, 0.5f, 0.0f}, {0.0f, 0.0f, 1.0f}, {0.0f, 1.0f}}
+    };
+    scene.indices = {0, 1, 2};
+    scene.meshes.push_back({3, 0, 0});
+    // Bounding sphere of the triangle, in mesh space
+    const glm::vec4 triangle_bounds = glm::vec4(0.0f, 0.0f, 0.0f, 0.71f);
+
+    // Spread the grid over [-1.5, 1.5] so the borders are out of the screen
+    constexpr float extent = 3.0f;
+    const float cell_width = extent / static_cast<float>(columns);
+    const float cell_height = extent / static_cast<float>(rows);
+    const float scale = 0.9f * std::min(cell_width, cell_height);
+    for (uint32_t y = 0; y < rows; y++) {
+        for (uint32_t x = 0; x < columns; x++) {
+            const uint32_t object_index = static_cast<uint32_t>(scene.objects.size());
+            ObjectData object {};
+            object.position_scale = glm::vec4(
+                -extent / 2.0f + (x + 0.5f) * cell_width,
+                -extent / 2.0f + (y + 0.5f) * cell_height,
+                0.0f,
+                scale
+            );
+            object.bounds = triangle_bounds;
+            const uint32_t texture = (x + y) % static_cast<uint32_t>(texture_handles.size() + streamed_texture_count);
+            if (texture < texture_handles.size()) {
+                object.material = glm::uvec4(texture_handles[texture], sampler_handle, 0, 0);
+            } else {
+                // The handle of a streamed texture changes: the shaders look it
+                // up in the frame uniforms. x is a valid texture all the same.
+                const uint32_t streamed_texture = texture - static_cast<uint32_t>(texture_handles.size());
+                object.material = glm::uvec4(texture_handles[0], sampler_handle, streamed_texture + 1, 0);
+            }
+            scene.objects.push_back(object);
+
+            const MeshRange &mesh = scene.meshes[0];
+            scene.draws.push_back({mesh.index_count, mesh.first_index, mesh.vertex_offset, object_index});
+        }
+    }
+    return scene;
+}
+
+MeshRange appendSphereMesh(Scene &scene, uint32_t segments, uint32_t rings) {
+    const uint32_t first_vertex = static_cast<uint32_t>(scene.vertices.size());
+    const uint32_t first_index = static_cast<uint32_t>(scene.indices.size());
+    for (uint32_t ring = 0; ring <= rings; ring++) {
+        const float theta = glm::pi<float>() * static_cast<float>(ring) / static_cast<float>(rings);
+        for (uint32_t segment = 0; segment <= segments; segment++) {
+            const float phi = glm::two_pi<float>() * static_cast<float>(segment) / static_cast<float>(segments);
+            const glm::vec3 normal(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+            // Colored by the normal, so the shape reads without lighting
+            scene.vertices.push_back({
+                normal * 0.5f,
+                normal * 0.5f + 0.5f,
+                {static_cast<float>(segment) / static_cast<float>(segments), static_cast<float>(ring) / static_cast<float>(rings)}
+            });
+        }
+    }
+    // The seam column is duplicated for its UVs: segments + 1 vertices per ring
+    const uint32_t row = segments + 1;
+    for (uint32_t ring = 0; ring < rings; ring++) {
+        for (uint32_t segment = 0; segment < segments; segment++) {
+            const uint32_t a = ring * row + segment;
+            const uint32_t b = a + 1;
+            const uint32_t c = a + row;
+            const uint32_t d = c + 1;
+            // The triangles of the poles are degenerated: skip them
+            if (ring != 0)
+                scene.indices.insert(scene.indices.end(), {a, b, c});
+            if (ring != rings - 1)
+                scene.indices.insert(scene.indices.end(), {b, d, c});
+        }
+    }
+    // Indices are relative to the first vertex of the mesh (vertex_offset)
+    const uint32_t index_count = static_cast<uint32_t>(scene.indices.size()) - first_index;
+    const MeshRange mesh = {index_count, first_index, static_cast<int32_t>(first_vertex)};
+    scene.meshes.push_back(mesh);
+    return mesh;
+}
+
+FrustumPlanes extractFrustumPlanes(const glm::mat4 &view_proj) {
+    // glm matrices are column major: row i is (m[0][i], m[1][i], m[2][i], m[3][i])
+    const auto row = [&view_proj](int i) {
+        return glm::vec4(view_proj[0][i], view_proj[1][i], view_proj[2][i], view_proj[3][i]);
+    };
+    FrustumPlanes planes = {
+        row(3) + row(0), // left
+        row(3) - row(0), // right
+        row(3) + row(1), // bottom
+        row(3) - row(1), // top
+        row(2),          // near (0 <= z)
+        row(3) - row(2)  // far (z <= w)
+    };
+    for (auto &plane: planes) {
+        const float length = glm::length(glm::vec3(plane));
+        if (length < 1e-6f)
+            plane = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f); // never culls
+        else
+            plane /= length;
+    }
+    return planes;
+}
+
+bool isSphereVisible(const FrustumPlanes &planes, const glm::vec3 &center, float radius) {
+    for (const auto &plane: planes) {
+        if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,151 @@
+//
+//  scene.hpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#ifndef scene_hpp
+#define scene_hpp
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <array>
+#include <vector>
+
+/**
+ * Vertex layout of every mesh of the scene.
+ */
+struct Vertex {
+    glm::vec3 position;
+    glm::vec3 color;
+    glm::vec2 uv;
+
+    static VkVertexInputBindingDescription bindingDescription();
+    static std::array<VkVertexInputAttributeDescription, 3> attributeDescriptions();
+};
+
+/**
+ * Part of the scene index / vertex buffers used by a mesh.
+ */
+struct MeshRange {
+    uint32_t index_count;
+    uint32_t first_index;
+    int32_t vertex_offset;
+};
+
+/**
+ * Per-object data, read by the shaders (std430 layout).
+ */
+struct ObjectData {
+    // xyz: translation, w: uniform scale
+    glm::vec4 position_scale;
+    // xyz: center of the bounding sphere (mesh space), w: radius
+    glm::vec4 bounds;
+    // x: texture handle, y: sampler handle in the bindless set,
+    // z: streamed texture index + 1 (0: x is used as is),
+    // w: LOD crossfade bits (see mesh_lod.hpp), 0 when not fading
+    glm::uvec4 material;
+};
+
+/**
+ * One draw of a mesh for an object, read by the shaders (std430 layout).
+ * object_index is passed as firstInstance so the vertex shader
+ * can fetch its ObjectData with gl_InstanceIndex.
+ */
+struct DrawRecord {
+    uint32_t index_count;
+    uint32_t first_index;
+    int32_t vertex_offset;
+    uint32_t object_index;
+};
+
+/**
+ * Per-draw data of the graphics pipeline, given with push constants.
+ * The vertex shader reads objects[object_index + gl_InstanceIndex]: indirect
+ * draws give the object as firstInstance (object_index = 0), direct draws
+ * push it (firstInstance = 0).
+ */
+struct DrawPushConstants {
+    uint32_t object_index;
+    // Bindless texture overriding the one of the object,
+    // or BINDLESS_INVALID_HANDLE (UINT32_MAX) to keep it
+    uint32_t texture_handle;
+};
+
+// Streamed textures the shaders can reach through FrameUniforms
+// (must match MAX_STREAMED_TEXTURES in the shaders)
+constexpr uint32_t const MAX_STREAMED_TEXTURES = 64;
+
+/**
+ * Per-frame data, read by the shaders (std140 layout) through a dynamic
+ * uniform buffer.
+ */
+struct FrameUniforms {
+    glm::mat4 view_proj;
+    // xy: extent of the render target, zw: 1 / extent
+    glm::vec4 viewport;
+    // Current bindless handle of each streamed texture, 4 per uvec4 (std140
+    // arrays have a 16 bytes stride): it changes when the texture gets a
+    // new image, while the objects keep their streamed texture index
+    glm::uvec4 streamed_textures[MAX_STREAMED_TEXTURES / 4];
+    // Frustum planes of view_proj and position of the camera (w = 1), for
+    // the culling done in the shaders. Shaders that do not cull may only
+    // declare the members above.
+    glm::vec4 frustum_planes[6];
+    glm::vec4 camera_position;
+    // Clustered lighting (see ClusteredLighting), read by the fragment shader.
+    // light_grid: clusters per row, per column, depth slices, tile size in pixels.
+    // light_buffers: bindless handles of the lights and of the cluster buffer,
+    // first word of the frame in the cluster buffer, light count.
+    // light_depth: near plane, depth slices per unit of log(depth), ambient light,
+    // grid pixels per rendered pixel (above 1 when dynamic resolution shrinks
+    // the render extent).
+    glm::uvec4 light_grid;
+    glm::uvec4 light_buffers;
+    glm::vec4 light_depth;
+};
+
+/**
+ * CPU side description of the scene, uploaded once to the GPU.
+ */
+struct Scene {
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    std::vector<MeshRange> meshes;
+    std::vector<ObjectData> objects;
+    std::vector<DrawRecord> draws;
+};
+
+/**
+ * Build a grid of (columns x rows) RGB triangles, spread over a slightly
+ * larger area than the screen so that some of them are always culled.
+ * The objects cycle through the given (bindless) texture handles then the
+ * streamed textures [0, streamed_texture_count), and all use the given
+ * sampler handle.
+ */
+Scene buildTriangleGridScene(uint32_t columns, uint32_t rows, const std::vector<uint32_t> &texture_handles, uint32_t streamed_texture_count, uint32_t sampler_handle);
+
+/**
+ * Append a UV sphere of radius 0.5 centered on the origin to the scene
+ * geometry (segments around its axis, rings from pole to pole), with
+ * outward front faces, and return its range.
+ */
+MeshRange appendSphereMesh(Scene &scene, uint32_t segments, uint32_t rings);
+
+using FrustumPlanes = std::array<glm::vec4, 6>;
+
+/**
+ * Extract the (normalized) frustum planes of a view projection matrix,
+ * with the Vulkan clip space conventions (0 <= z <= w).
+ * Degenerated planes (e.g. the far plane of an infinite projection) never cull.
+ */
+FrustumPlanes extractFrustumPlanes(const glm::mat4 &view_proj);
+
+/**
+ * Returns true if the sphere is (at least partially) inside the frustum.
+ */
+bool isSphereVisible(const FrustumPlanes &planes, const glm::vec3 &center, float radius);
+
+#endif /* scene_hpp */
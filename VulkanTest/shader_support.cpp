@@ -33,3 +33,30 @@ std::optional<std::vector<char>> loadShaderFile(const std::string filename) {
     
     return buffer;
 }
+
+std::string shaderPath(const std::string &filename) {
+#ifdef _WIN32
+    return std::string(SHADERS_DIR).append("\\").append(filename);
+#else
+    return std::string(SHADERS_DIR).append("/").append(filename);
+#endif
+}
+
+VkShaderModule createShaderModule(VkDevice device, const std::string &filename) {
+    const auto opt_shader_code = loadShaderFile(shaderPath(filename));
+    // Spir-V is a stream of 32 bits words
+    if (!opt_shader_code.has_value() || opt_shader_code.value().empty() || opt_shader_code.value().size() % 4 != 0) {
+        LogE("shader '" << filename << "' is empty or invalid - make sure to run 'build_shaders' script before");
+        throw std::runtime_error("invalid shader file " + filename);
+    }
+    const std::vector<char> &shader_code = opt_shader_code.value();
+    VkShaderModuleCreateInfo shader_module_create_info {};
+    shader_module_create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    shader_module_create_info.codeSize = shader_code.size();
+    shader_module_create_info.pCode = reinterpret_cast<const uint32_t*>(shader_code.data());
+    VkShaderModule shader_module {};
+    if (vkCreateShaderModule(device, &shader_module_create_info, nullptr, &shader_module) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create shader module for " + filename);
+    }
+    return shader_module;
+}
@@ -8,6 +8,8 @@
 #ifndef shader_support_hpp
 #define shader_support_hpp
 
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
 #include <vector>
 #include <optional>
 #ifdef _WIN32
@@ -22,6 +24,17 @@ constexpr char SHADERS_DIR[] = "..\\..\\shaders";
 
 std::optional<std::vector<char>> loadShaderFile(const std::string filename);
 
+/**
+ * Returns the path of a compiled (Spir-V) shader, in SHADERS_DIR.
+ */
+std::string shaderPath(const std::string &filename);
+
+/**
+ * Load a compiled shader from SHADERS_DIR and create its shader module.
+ * Throws if the file cannot be loaded or the module cannot be created.
+ */
+VkShaderModule createShaderModule(VkDevice device, const std::string &filename);
+
 #include <stdio.h>
 
 #endif /* shader_support_hpp */
@@ -0,0 +1,405 @@
+//
+//  texture_streamer.cpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#include "texture_streamer.hpp"
+#include "base.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+// Part of the memory left under the driver budget the streamer may take
+// (VK_EXT_memory_budget): the rest of the application allocates too
+constexpr VkDeviceSize const AVAILABLE_MEMORY_DIVISOR = 2;
+
+/**
+ * Build the mip chain of an RGBA8 image with a 2x2 box filter
+ * (odd sizes clamp to the last row / column).
+ */
+static void buildMipChain(const uint32_t *pixels, VkExtent2D extent, std::vector<uint32_t> &chain, std::vector<VkExtent2D> &mip_extents, std::vector<size_t> &mip_offsets) {
+    chain.assign(pixels, pixels + static_cast<size_t>(extent.width) * extent.height);
+    mip_extents = {extent};
+    mip_offsets = {0};
+    while (extent.width > 1 || extent.height > 1) {
+        const VkExtent2D next = {std::max(1u, extent.width / 2), std::max(1u, extent.height / 2)};
+        const size_t source_offset = mip_offsets.back();
+        const size_t offset = chain.size();
+        chain.resize(offset + static_cast<size_t>(next.width) * next.height);
+        for (uint32_t y = 0; y < next.height; y++) {
+            for (uint32_t x = 0; x < next.width; x++) {
+                const uint32_t x0 = std::min(2 * x, extent.width - 1), x1 = std::min(2 * x + 1, extent.width - 1);
+                const uint32_t y0 = std::min(2 * y, extent.height - 1), y1 = std::min(2 * y + 1, extent.height - 1);
+                const uint32_t texels[] = {
+                    chain[source_offset + y0 * extent.width + x0],
+                    chain[source_offset + y0 * extent.width + x1],
+                    chain[source_offset + y1 * extent.width + x0],
+                    chain[source_offset + y1 * extent.width + x1]
+                };
+                uint32_t average = 0;
+                for (uint32_t shift = 0; shift < 32; shift += 8) {
+                    uint32_t sum = 2; // rounding
+                    for (const uint32_t texel: texels)
+                        sum += (texel >> shift) & 0xFF;
+                    average |= (sum / 4) << shift;
+                }
+                chain[offset + y * next.width + x] = average;
+            }
+        }
+        mip_extents.push_back(next);
+        mip_offsets.push_back(offset);
+        extent = next;
+    }
+}
+
+/**
+ * Copy a staging buffer to every mip level of a new image, and make it
+ * readable by the shaders.
+ */
+static void recordMipChainUpload(VkCommandBuffer command_buffer, const AllocatedImage &image, VkBuffer staging_buffer, const std::vector<VkBufferImageCopy> &regions) {
+    transitionImageLayout(command_buffer, image.image, VK_IMAGE_ASPECT_COLOR_BIT, image.mip_levels, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    vkCmdCopyBufferToImage(command_buffer, staging_buffer, image.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()), regions.data());
+    transitionImageLayout(command_buffer, image.image, VK_IMAGE_ASPECT_COLOR_BIT, image.mip_levels, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+}
+
+void TextureStreamer::init(VkPhysicalDevice physical_device, VkDevice device, const DeviceCapabilities &capabilities, BindlessDescriptors &bindless, MipGenerator &mip_generator, VkDeviceSize budget, uint32_t frames_in_flight) {
+    m_physical_device = physical_device;
+    m_device = device;
+    m_bindless = &bindless;
+    m_mip_generator = &mip_generator;
+    m_memory_budget = capabilities.memory_budget;
+    m_budget = budget;
+    m_stats = TextureStreamingStats {};
+    m_stats.budget_bytes = budget;
+    m_retired_images.resize(frames_in_flight);
+    m_retired_buffers.resize(frames_in_flight);
+    m_stop = false;
+    m_thread = std::thread(&TextureStreamer::_loaderLoop, this);
+    Log("-> Texture streaming: budget of " << budget / (1024 * 1024) << " MB" << (m_memory_budget ? ", bounded by the driver memory budget" : ""));
+}
+
+void TextureStreamer::clean(VkDevice device) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake_up.notify_all();
+    if (m_thread.joinable())
+        m_thread.join();
+
+    // Queued loads have no resources yet
+    m_queued_loads.clear();
+    for (Load &load: m_completed_loads) {
+        destroyBuffer(device, load.staging_buffer);
+        destroyImage(device, load.image);
+    }
+    m_completed_loads.clear();
+    // Their image belongs to the texture now
+    for (Load &load: m_uploads)
+        destroyBuffer(device, load.staging_buffer);
+    m_uploads.clear();
+    for (auto &images: m_retired_images) {
+        for (AllocatedImage &image: images)
+            destroyImage(device, image);
+        images.clear();
+    }
+    for (auto &buffers: m_retired_buffers) {
+        for (AllocatedBuffer &buffer: buffers)
+            destroyBuffer(device, buffer);
+        buffers.clear();
+    }
+    for (auto &texture: m_textures)
+        destroyImage(device, texture->image);
+    m_textures.clear();
+    m_bindless = nullptr;
+    m_mip_generator = nullptr;
+}
+
+uint32_t TextureStreamer::addTexture(VkCommandPool command_pool, VkQueue queue, const uint32_t *pixels, VkExtent2D extent) {
+    auto texture = std::make_unique<StreamedTexture>();
+    buildMipChain(pixels, extent, texture->pixels, texture->mip_extents, texture->mip_offsets);
+    const uint32_t mip_count = static_cast<uint32_t>(texture->mip_extents.size());
+    while (texture->mip_tail + 1 < mip_count
+           && std::max(texture->mip_extents[texture->mip_tail].width, texture->mip_extents[texture->mip_tail].height) > MIP_TAIL_SIZE)
+        texture->mip_tail++;
+    const uint32_t texture_index = static_cast<uint32_t>(m_textures.size());
+    m_textures.push_back(std::move(texture));
+    StreamedTexture &added = *m_textures.back();
+
+    // Same path as the streamed loads, but waited for right away, and
+    // the whole (small) tail is copied from the CPU
+    Load load {};
+    load.texture = texture_index;
+    load.first_mip = added.mip_tail;
+    _prepareLoad(load);
+    VkCommandBuffer command_buffer = beginSingleTimeCommands(m_device, command_pool);
+    recordMipChainUpload(command_buffer, load.image, load.staging_buffer.buffer, load.regions);
+    endSingleTimeCommands(m_device, command_pool, queue, command_buffer);
+    destroyBuffer(m_device, load.staging_buffer);
+
+    added.image = load.image;
+    added.handle = m_bindless->registerTexture(added.image.view);
+    added.resident_mip = added.mip_tail;
+    added.target_mip = added.mip_tail;
+    m_stats.resident_bytes += _chainBytes(added, added.mip_tail);
+    return texture_index;
+}
+
+void TextureStreamer::request(uint32_t texture, uint32_t mip_level) {
+    // Keep the finest level requested during the frame
+    std::atomic<uint32_t> &requested = m_textures[texture]->requested_mip;
+    uint32_t current = requested.load(std::memory_order_relaxed);
+    while (mip_level < current && !requested.compare_exchange_weak(current, mip_level, std::memory_order_relaxed)) {}
+}
+
+uint32_t TextureStreamer::mipLevelForScreenSize(uint32_t texture_size, float screen_pixels) {
+    if (screen_pixels >= static_cast<float>(texture_size))
+        return 0;
+    // About one texel per pixel, rounded to the finer level
+    const float level = std::log2(static_cast<float>(texture_size) / std::max(screen_pixels, 1.0f));
+    return static_cast<uint32_t>(std::floor(level));
+}
+
+void TextureStreamer::beginFrame(VkDevice device, uint32_t frame_index) {
+    m_current_frame = frame_index;
+    m_frame_count++;
+    // The GPU is done with the previous use of this frame
+    for (AllocatedImage &image: m_retired_images[frame_index])
+        destroyImage(device, image);
+    m_retired_images[frame_index].clear();
+    for (AllocatedBuffer &buffer: m_retired_buffers[frame_index])
+        destroyBuffer(device, buffer);
+    m_retired_buffers[frame_index].clear();
+
+    _switchCompletedLoads();
+    _updateResidency();
+    m_stats.pending_loads = static_cast<uint32_t>(std::count_if(m_textures.begin(), m_textures.end(), [](const auto &texture) {
+        return texture->loading;
+    }));
+}
+
+void TextureStreamer::recordUploads(VkDevice device, VkCommandBuffer command_buffer, FrameDescriptorAllocators &frame_allocators) {
+    for (Load &load: m_uploads) {
+        if (load.generate_mips) {
+            transitionImageLayout(command_buffer, load.image.image, VK_IMAGE_ASPECT_COLOR_BIT, 1, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+            vkCmdCopyBufferToImage(command_buffer, load.staging_buffer.buffer, load.image.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(load.regions.size()), load.regions.data());
+            m_mip_generator->generate(device, command_buffer, frame_allocators, load.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+        } else {
+            recordMipChainUpload(command_buffer, load.image, load.staging_buffer.buffer, load.regions);
+        }
+        m_retired_buffers[m_current_frame].push_back(load.staging_buffer);
+    }
+    m_uploads.clear();
+}
+
+void TextureStreamer::_loaderLoop() {
+    while (true) {
+        Load load {};
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake_up.wait(lock, [this] { return m_stop || !m_queued_loads.empty(); });
+            if (m_stop)
+                return;
+            load = std::move(m_queued_loads.front());
+            m_queued_loads.pop_front();
+        }
+        try {
+            _prepareLoad(load);
+        } catch (...) {
+            destroyBuffer(m_device, load.staging_buffer);
+            destroyImage(m_device, load.image);
+            load.error = std::current_exception();
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_completed_loads.push_back(std::move(load));
+    }
+}
+
+void TextureStreamer::_prepareLoad(Load &load) const {
+    const StreamedTexture &texture = *m_textures[load.texture];
+    const uint32_t mip_count = static_cast<uint32_t>(texture.mip_extents.size()) - load.first_mip;
+    const uint32_t staged_mip_count = load.generate_mips ? 1 : mip_count;
+    // The levels are packed in order: one copy for the whole chain,
+    // or for its first level when the others are generated on the GPU
+    const size_t first_texel = texture.mip_offsets[load.first_mip];
+    const VkExtent2D &first_extent = texture.mip_extents[load.first_mip];
+    const VkDeviceSize size = load.generate_mips
+        ? static_cast<VkDeviceSize>(first_extent.width) * first_extent.height * sizeof(uint32_t)
+        : _chainBytes(texture, load.first_mip);
+    load.staging_buffer = createBuffer(m_physical_device, m_device, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    memcpy(load.staging_buffer.mapped, texture.pixels.data() + first_texel, static_cast<size_t>(size));
+
+    load.image = createImage(
+        m_physical_device,
+        m_device,
+        first_extent,
+        mip_count,
+        VK_SAMPLE_COUNT_1_BIT,
+        VK_FORMAT_R8G8B8A8_UNORM,
+        VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | (load.generate_mips ? m_mip_generator->requiredUsage(VK_FORMAT_R8G8B8A8_UNORM) : 0),
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        VK_IMAGE_ASPECT_COLOR_BIT);
+
+    load.regions.resize(staged_mip_count);
+    for (uint32_t level = 0; level < staged_mip_count; level++) {
+        const VkExtent2D &extent = texture.mip_extents[load.first_mip + level];
+        VkBufferImageCopy &region = load.regions[level];
+        region = VkBufferImageCopy {};
+        region.bufferOffset = (texture.mip_offsets[load.first_mip + level] - first_texel) * sizeof(uint32_t);
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = level;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+        region.imageOffset = {0, 0, 0};
+        region.imageExtent = {extent.width, extent.height, 1};
+    }
+}
+
+void TextureStreamer::_queueLoad(uint32_t texture, uint32_t first_mip) {
+    m_textures[texture]->loading = true;
+    m_textures[texture]->target_mip = first_mip;
+    Load load {};
+    load.texture = texture;
+    load.first_mip = first_mip;
+    load.generate_mips = true;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queued_loads.push_back(std::move(load));
+    }
+    m_wake_up.notify_one();
+}
+
+void TextureStreamer::_switchCompletedLoads() {
+    std::deque<Load> completed;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        completed.swap(m_completed_loads);
+    }
+    // The failed loads have released their own resources: switch the
+    // others first, so none leaks, then report the first failure
+    std::exception_ptr error;
+    for (Load &load: completed) {
+        if (load.error) {
+            if (!error)
+                error = load.error;
+            StreamedTexture &texture = *m_textures[load.texture];
+            texture.target_mip = texture.resident_mip;
+            texture.loading = false;
+            continue;
+        }
+        StreamedTexture &texture = *m_textures[load.texture];
+        // The frames in flight may still sample the old image: destroyed
+        // at the next use of this frame, its handle recycled by bindless
+        m_bindless->releaseTexture(texture.handle);
+        m_retired_images[m_current_frame].push_back(texture.image);
+        m_stats.resident_bytes -= _chainBytes(texture, texture.resident_mip);
+        m_stats.resident_bytes += _chainBytes(texture, load.first_mip);
+        // Sampled from this frame on, after the copies of recordUploads()
+        texture.image = load.image;
+        texture.handle = m_bindless->registerTexture(texture.image.view);
+        texture.resident_mip = load.first_mip;
+        texture.loading = false;
+        m_stats.completed_loads++;
+        m_uploads.push_back(std::move(load));
+    }
+    if (error)
+        std::rethrow_exception(error);
+}
+
+void TextureStreamer::_updateResidency() {
+    const VkDeviceSize budget = _currentBudget();
+    m_stats.budget_bytes = budget;
+    VkDeviceSize projected_bytes = 0;
+    for (const auto &texture: m_textures)
+        projected_bytes += _chainBytes(*texture, texture->target_mip);
+
+    // Gather the requests first, so the textures requested this frame are
+    // all protected from eviction
+    std::vector<uint32_t> requested_mips(m_textures.size());
+    for (size_t i = 0; i < m_textures.size(); i++) {
+        StreamedTexture &texture = *m_textures[i];
+        requested_mips[i] = texture.requested_mip.exchange(NOT_REQUESTED, std::memory_order_relaxed);
+        if (requested_mips[i] != NOT_REQUESTED)
+            texture.last_requested_frame = m_frame_count;
+    }
+
+    // Drop the finest level of the least recently requested texture
+    const auto evict = [this, &projected_bytes](uint32_t excluded_texture) {
+        const uint32_t victim_index = _leastRecentlyUsed(excluded_texture);
+        if (victim_index == NOT_REQUESTED)
+            return false;
+        const StreamedTexture &victim = *m_textures[victim_index];
+        projected_bytes -= _chainBytes(victim, victim.target_mip) - _chainBytes(victim, victim.target_mip + 1);
+        _queueLoad(victim_index, victim.target_mip + 1);
+        m_stats.evictions++;
+        return true;
+    };
+
+    for (uint32_t i = 0; i < m_textures.size(); i++) {
+        StreamedTexture &texture = *m_textures[i];
+        if (requested_mips[i] == NOT_REQUESTED || texture.loading)
+            continue;
+        uint32_t wanted_mip = std::min(requested_mips[i], texture.mip_tail);
+        if (wanted_mip >= texture.target_mip)
+            continue;
+        const auto fits = [&] {
+            return projected_bytes - _chainBytes(texture, texture.target_mip) + _chainBytes(texture, wanted_mip) <= budget;
+        };
+        while (!fits() && evict(i)) {}
+        // Nothing left to evict: only stream in the levels that fit
+        while (wanted_mip < texture.target_mip && !fits())
+            wanted_mip++;
+        if (wanted_mip < texture.target_mip) {
+            projected_bytes += _chainBytes(texture, wanted_mip) - _chainBytes(texture, texture.target_mip);
+            _queueLoad(i, wanted_mip);
+        }
+    }
+    // The budget itself may have shrunk (memory pressure)
+    while (projected_bytes > budget && evict(NOT_REQUESTED)) {}
+}
+
+uint32_t TextureStreamer::_leastRecentlyUsed(uint32_t excluded_texture) const {
+    uint32_t victim = NOT_REQUESTED;
+    for (uint32_t i = 0; i < m_textures.size(); i++) {
+        const StreamedTexture &texture = *m_textures[i];
+        // Never evict the mip tail, nor what this frame needs
+        if (i == excluded_texture || texture.loading || texture.target_mip >= texture.mip_tail || texture.last_requested_frame == m_frame_count)
+            continue;
+        if (victim == NOT_REQUESTED || texture.last_requested_frame < m_textures[victim]->last_requested_frame)
+            victim = i;
+    }
+    return victim;
+}
+
+VkDeviceSize TextureStreamer::_currentBudget() const {
+    if (!m_memory_budget)
+        return m_budget;
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budget_properties {};
+    budget_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+    VkPhysicalDeviceMemoryProperties2 memory_properties {};
+    memory_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+    memory_properties.pNext = &budget_properties;
+    vkGetPhysicalDeviceMemoryProperties2(m_physical_device, &memory_properties);
+    VkDeviceSize heap_budget = 0;
+    VkDeviceSize heap_usage = 0;
+    for (uint32_t i = 0; i < memory_properties.memoryProperties.memoryHeapCount; i++) {
+        if (memory_properties.memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) {
+            heap_budget += budget_properties.heapBudget[i];
+            heap_usage += budget_properties.heapUsage[i];
+        }
+    }
+    // heap_usage includes the resident textures: over the driver budget,
+    // give back the excess; under it, take a part of what is left
+    if (heap_usage > heap_budget) {
+        const VkDeviceSize excess = heap_usage - heap_budget;
+        return std::min(m_budget, m_stats.resident_bytes > excess ? m_stats.resident_bytes - excess : 0);
+    }
+    return std::min(m_budget, m_stats.resident_bytes + (heap_budget - heap_usage) / AVAILABLE_MEMORY_DIVISOR);
+}
+
+VkDeviceSize TextureStreamer::_chainBytes(const StreamedTexture &texture, uint32_t first_mip) {
+    return static_cast<VkDeviceSize>(texture.pixels.size() - texture.mip_offsets[first_mip]) * sizeof(uint32_t);
+}
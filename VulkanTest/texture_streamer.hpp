@@ -0,0 +1,203 @@
+//
+//  texture_streamer.hpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#ifndef texture_streamer_hpp
+#define texture_streamer_hpp
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "bindless.hpp"
+#include "buffer_utils.hpp"
+#include "descriptor_allocator.hpp"
+#include "device_capabilities.hpp"
+#include "image_utils.hpp"
+#include "mip_generator.hpp"
+
+/**
+ * Counters of the texture streamer, for the logs.
+ */
+struct TextureStreamingStats {
+    // Device memory of the streamed textures, and the budget they must fit in
+    VkDeviceSize resident_bytes = 0;
+    VkDeviceSize budget_bytes = 0;
+    // Loads queued to / being prepared by the background thread
+    uint32_t pending_loads = 0;
+    // Totals since init()
+    uint32_t completed_loads = 0;
+    uint32_t evictions = 0;
+};
+
+/**
+ * Streams the mip levels of RGBA8 textures in and out of device memory.
+ *
+ * The whole mip chain of each texture stays on the CPU; the GPU only holds
+ * the mip levels from resident_mip down to 1x1. The mip tail (levels of at
+ * most MIP_TAIL_SIZE pixels) is uploaded when the texture is added and is
+ * never evicted, so a texture can always be sampled.
+ *
+ * Each frame, the renderer requests the finest mip level it needs for each
+ * texture (from the screen size of the objects using it). When a finer
+ * level is requested, a background thread creates a new image for the
+ * longer mip chain and fills a staging buffer with its finest level; the
+ * copy is then recorded at the start of a frame, the coarser levels are
+ * generated on the GPU (MipGenerator), and the texture switches to the new
+ * image (new bindless handle). The old image is destroyed once the frames
+ * in flight that may sample it are over.
+ *
+ * Resident textures must fit in a budget: the configured one, lowered to
+ * what the driver reports as available (VK_EXT_memory_budget) when
+ * supported. To load a texture over budget, the least recently requested
+ * textures lose their finest mip level first.
+ */
+class TextureStreamer {
+
+public:
+    // Mip levels whose largest side is at most this size are always resident
+    static constexpr uint32_t const MIP_TAIL_SIZE = 8;
+
+    /**
+     * Start the background thread. Textures are registered in bindless,
+     * and their mip levels generated by mip_generator, which must both
+     * outlive the streamer.
+     */
+    void init(VkPhysicalDevice physical_device, VkDevice device, const DeviceCapabilities &capabilities, BindlessDescriptors &bindless, MipGenerator &mip_generator, VkDeviceSize budget, uint32_t frames_in_flight);
+
+    /**
+     * Stop the background thread and destroy every texture.
+     * The device must be idle.
+     */
+    void clean(VkDevice device);
+
+    /**
+     * Add a texture from its level 0 pixels: its mip chain is built on the
+     * CPU, and its mip tail uploaded right away (blocking).
+     * Returns the index of the texture.
+     */
+    uint32_t addTexture(VkCommandPool command_pool, VkQueue queue, const uint32_t *pixels, VkExtent2D extent);
+
+    /**
+     * Request mip_level (and the coarser ones) of a texture for the next
+     * frames. Thread safe: may be called from several jobs at once.
+     */
+    void request(uint32_t texture, uint32_t mip_level);
+
+    /**
+     * Once the fence of the frame has been waited for, and before the
+     * bindless descriptors are updated: destroy what the previous use of
+     * the frame retired, switch the textures whose load has completed, and
+     * queue new loads / evictions from the requests of the last frame.
+     */
+    void beginFrame(VkDevice device, uint32_t frame_index);
+
+    /**
+     * Record the uploads of the textures switched by beginFrame(), the
+     * generation of their mip levels and the barriers making them readable
+     * by the fragment shaders.
+     * Must be recorded before the passes sampling them.
+     */
+    void recordUploads(VkDevice device, VkCommandBuffer command_buffer, FrameDescriptorAllocators &frame_allocators);
+
+    /**
+     * Bindless handle of the current image of a texture (changes when it is
+     * switched to a longer / shorter mip chain).
+     */
+    BindlessHandle handle(uint32_t texture) const { return m_textures[texture]->handle; }
+
+    uint32_t textureCount() const { return static_cast<uint32_t>(m_textures.size()); }
+
+    const TextureStreamingStats& stats() const { return m_stats; }
+
+    /**
+     * Finest mip level worth sampling for a texture of texture_size pixels
+     * covering screen_pixels pixels on screen.
+     */
+    static uint32_t mipLevelForScreenSize(uint32_t texture_size, float screen_pixels);
+
+private:
+    static constexpr uint32_t const NOT_REQUESTED = UINT32_MAX;
+
+    struct StreamedTexture {
+        // Every mip level, level 0 first, tightly packed
+        std::vector<uint32_t> pixels;
+        std::vector<VkExtent2D> mip_extents;
+        std::vector<size_t> mip_offsets;
+        // First level of the mip tail
+        uint32_t mip_tail = 0;
+        // Current image, holding the levels [resident_mip, mip count)
+        AllocatedImage image;
+        BindlessHandle handle = BINDLESS_INVALID_HANDLE;
+        uint32_t resident_mip = 0;
+        // resident_mip once the pending load (if any) is done
+        uint32_t target_mip = 0;
+        bool loading = false;
+        // Finest level requested during the frame
+        std::atomic<uint32_t> requested_mip {NOT_REQUESTED};
+        uint64_t last_requested_frame = 0;
+    };
+
+    /**
+     * A mip chain to upload: prepared by the background thread, recorded
+     * by the main thread.
+     */
+    struct Load {
+        uint32_t texture = 0;
+        uint32_t first_mip = 0;
+        // Only the first level is staged, the others are generated
+        bool generate_mips = false;
+        AllocatedBuffer staging_buffer;
+        AllocatedImage image;
+        std::vector<VkBufferImageCopy> regions;
+        std::exception_ptr error;
+    };
+
+    VkPhysicalDevice m_physical_device = VK_NULL_HANDLE;
+    VkDevice m_device = VK_NULL_HANDLE;
+    BindlessDescriptors *m_bindless = nullptr;
+    MipGenerator *m_mip_generator = nullptr;
+    bool m_memory_budget = false;
+    VkDeviceSize m_budget = 0;
+    uint32_t m_current_frame = 0;
+    uint64_t m_frame_count = 0;
+    // Textures are only added at initialization: the pointers stay valid
+    // while the background thread reads their pixels
+    std::vector<std::unique_ptr<StreamedTexture>> m_textures;
+    TextureStreamingStats m_stats {};
+
+    // Background thread: m_queued_loads -> m_completed_loads
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_wake_up;
+    bool m_stop = false;
+    std::deque<Load> m_queued_loads;
+    std::deque<Load> m_completed_loads;
+
+    // Switched this frame, their copies not recorded yet
+    std::vector<Load> m_uploads;
+    // Per frame in flight: released by its previous use
+    std::vector<std::vector<AllocatedImage>> m_retired_images;
+    std::vector<std::vector<AllocatedBuffer>> m_retired_buffers;
+
+    void _loaderLoop();
+    void _prepareLoad(Load &load) const;
+    void _queueLoad(uint32_t texture, uint32_t first_mip);
+    void _switchCompletedLoads();
+    void _updateResidency();
+    uint32_t _leastRecentlyUsed(uint32_t excluded_texture) const;
+    VkDeviceSize _currentBudget() const;
+    static VkDeviceSize _chainBytes(const StreamedTexture &texture, uint32_t first_mip);
+};
+
+#endif /* texture_streamer_hpp */
@@ -0,0 +1,58 @@
+//
+//  uniform_allocator.cpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#include "uniform_allocator.hpp"
+#include "base.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+    // Vulkan alignments are powers of two
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+void LinearUniformAllocator::init(VkPhysicalDevice physical_device, VkDevice device, const DeviceCapabilities &capabilities, uint32_t frames_in_flight, VkDeviceSize bytes_per_frame) {
+    const VkPhysicalDeviceLimits &limits = capabilities.properties.limits;
+    // Allocations may be bound as uniform or storage buffers
+    m_alignment = std::max<VkDeviceSize>(
+        std::max(limits.minUniformBufferOffsetAlignment, limits.minStorageBufferOffsetAlignment),
+        16);
+    m_region_size = alignUp(bytes_per_frame, m_alignment);
+    Log("-> Uniform allocator: " << frames_in_flight << " x " << m_region_size << " bytes, alignment " << m_alignment);
+
+    m_buffer = createBuffer(
+        physical_device,
+        device,
+        m_region_size * frames_in_flight,
+        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    m_region_begin = 0;
+    m_cursor = 0;
+}
+
+void LinearUniformAllocator::clean(VkDevice device) {
+    destroyBuffer(device, m_buffer);
+}
+
+void LinearUniformAllocator::beginFrame(uint32_t frame_index) {
+    m_region_begin = m_region_size * frame_index;
+    m_cursor = m_region_begin;
+}
+
+UniformAllocation LinearUniformAllocator::allocate(VkDeviceSize size) {
+    const VkDeviceSize aligned_size = alignUp(size, m_alignment);
+    if (m_cursor + aligned_size > m_region_begin + m_region_size) {
+        LogE("uniform allocator: " << aligned_size << " bytes requested, " << (m_region_begin + m_region_size - m_cursor) << " available");
+        throw std::runtime_error("the per-frame uniform region is full");
+    }
+    UniformAllocation allocation {};
+    allocation.data = static_cast<char*>(m_buffer.mapped) + m_cursor;
+    allocation.offset = static_cast<uint32_t>(m_cursor);
+    allocation.size = size;
+    m_cursor += aligned_size;
+    return allocation;
+}
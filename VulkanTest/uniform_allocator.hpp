@@ -0,0 +1,78 @@
+//
+//  uniform_allocator.hpp
+//  VulkanTest
+//
+//  Created by Antonin on 18/10/2026.
+//
+
+#ifndef uniform_allocator_hpp
+#define uniform_allocator_hpp
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#include <cstring>
+
+#include "buffer_utils.hpp"
+#include "device_capabilities.hpp"
+
+/**
+ * Part of the uniform buffer handed out for the current frame.
+ * offset is the one to give as dynamic offset when binding the descriptor.
+ */
+struct UniformAllocation {
+    void *data = nullptr;
+    uint32_t offset = 0;
+    VkDeviceSize size = 0;
+};
+
+/**
+ * Per-frame bump allocator over a single, persistently mapped and
+ * host-coherent buffer.
+ * Each frame in flight owns a region of the buffer: allocations move a
+ * cursor forward in the region of the current frame, and are all released
+ * at once when the frame begins again (after its fence has been waited for).
+ * Data is bound through VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC (or
+ * STORAGE_BUFFER_DYNAMIC) descriptors, so a single descriptor set serves
+ * every allocation: only the dynamic offset changes.
+ */
+class LinearUniformAllocator {
+
+public:
+    void init(VkPhysicalDevice physical_device, VkDevice device, const DeviceCapabilities &capabilities, uint32_t frames_in_flight, VkDeviceSize bytes_per_frame);
+
+    void clean(VkDevice device);
+
+    /**
+     * Release every allocation of the previous use of the frame.
+     */
+    void beginFrame(uint32_t frame_index);
+
+    /**
+     * Suballocate size bytes (aligned on the device minimum offset alignment)
+     * in the region of the current frame. Throws if the region is full.
+     */
+    UniformAllocation allocate(VkDeviceSize size);
+
+    /**
+     * Copy value in a new allocation, and return its dynamic offset.
+     */
+    template<typename T>
+    uint32_t push(const T &value) {
+        UniformAllocation allocation = allocate(sizeof(T));
+        memcpy(allocation.data, &value, sizeof(T));
+        return allocation.offset;
+    }
+
+    VkBuffer buffer() const { return m_buffer.buffer; }
+    VkDeviceSize alignment() const { return m_alignment; }
+    VkDeviceSize usedBytes() const { return m_cursor - m_region_begin; }
+
+private:
+    AllocatedBuffer m_buffer;
+    VkDeviceSize m_alignment = 0;
+    VkDeviceSize m_region_size = 0;
+    VkDeviceSize m_region_begin = 0;
+    VkDeviceSize m_cursor = 0;
+};
+
+#endif /* uniform_allocator_hpp */
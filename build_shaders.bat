@@ -1,2 +1,17 @@
 glslc.exe .\shaders\shader.vert -o .\shaders\vert.spv
 glslc.exe .\shaders\shader.frag -o .\shaders\frag.spv
+glslc.exe -DNONUNIFORM_MATERIALS .\shaders\shader.frag -o .\shaders\frag_nonuniform.spv
+glslc.exe .\shaders\cull.comp -o .\shaders\cull.spv
+glslc.exe -DOCCLUSION .\shaders\cull.comp -o .\shaders\cull_occlusion.spv
+glslc.exe -DCOPY_DEPTH .\shaders\depth_pyramid.comp -o .\shaders\hiz_depth.spv
+glslc.exe -DCOPY_DEPTH -DMULTISAMPLED .\shaders\depth_pyramid.comp -o .\shaders\hiz_depth_ms.spv
+glslc.exe .\shaders\depth_pyramid.comp -o .\shaders\hiz_reduce.spv
+glslc.exe .\shaders\downsample.comp -o .\shaders\downsample.spv
+glslc.exe --target-env=vulkan1.1 -DUSE_SUBGROUP_QUAD .\shaders\downsample.comp -o .\shaders\downsample_quad.spv
+glslc.exe .\shaders\meshlet_cull.comp -o .\shaders\meshlet_cull.spv
+glslc.exe --target-env=vulkan1.2 .\shaders\meshlet.task -o .\shaders\meshlet_task.spv
+glslc.exe --target-env=vulkan1.2 .\shaders\meshlet.mesh -o .\shaders\meshlet_mesh.spv
+glslc.exe .\shaders\particles.comp -o .\shaders\particles.spv
+glslc.exe .\shaders\particle.vert -o .\shaders\particle_vert.spv
+glslc.exe .\shaders\particle.frag -o .\shaders\particle_frag.spv
+glslc.exe .\shaders\light_cull.comp -o .\shaders\light_cull.spv
@@ -1,3 +1,18 @@
 cd shaders
 glslc shader.vert -o vert.spv
 glslc shader.frag -o frag.spv
+glslc -DNONUNIFORM_MATERIALS shader.frag -o frag_nonuniform.spv
+glslc cull.comp -o cull.spv
+glslc -DOCCLUSION cull.comp -o cull_occlusion.spv
+glslc -DCOPY_DEPTH depth_pyramid.comp -o hiz_depth.spv
+glslc -DCOPY_DEPTH -DMULTISAMPLED depth_pyramid.comp -o hiz_depth_ms.spv
+glslc depth_pyramid.comp -o hiz_reduce.spv
+glslc downsample.comp -o downsample.spv
+glslc --target-env=vulkan1.1 -DUSE_SUBGROUP_QUAD downsample.comp -o downsample_quad.spv
+glslc meshlet_cull.comp -o meshlet_cull.spv
+glslc --target-env=vulkan1.2 meshlet.task -o meshlet_task.spv
+glslc --target-env=vulkan1.2 meshlet.mesh -o meshlet_mesh.spv
+glslc particles.comp -o particles.spv
+glslc particle.vert -o particle_vert.spv
+glslc particle.frag -o particle_frag.spv
+glslc light_cull.comp -o light_cull.spv
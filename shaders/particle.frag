@@ -0,0 +1,13 @@
+#version 450
+
+layout(location = 0) in vec2 fragOffset;
+layout(location = 1) in float fragLife;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    // Round sprite, fading out over the last second of life
+    const float falloff = max(1.0 - dot(fragOffset, fragOffset), 0.0);
+    const float fade = clamp(fragLife, 0.0, 1.0);
+    outColor = vec4(vec3(1.0, 0.6, 0.2) * falloff * fade, 1.0);
+}
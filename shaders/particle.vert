@@ -0,0 +1,40 @@
+#version 450
+
+layout(location = 0) out vec2 fragOffset;
+layout(location = 1) out float fragLife;
+
+// Must match Particle (particle_system.hpp)
+struct Particle {
+    vec4 position_life;
+    vec4 velocity_size;
+};
+
+// Binding 1 holds the particles written by the last simulation
+layout(std430, set = 0, binding = 1) readonly buffer Particles {
+    Particle particles[];
+};
+
+// Must match ParticleDrawPushConstants (particle_system.cpp)
+layout(push_constant) uniform Draw {
+    mat4 view_proj;
+    // World space axes of the screen, for camera facing quads
+    vec4 camera_right;
+    vec4 camera_up;
+} draw;
+
+// Two triangles per quad (drawn without culling)
+const vec2 CORNERS[6] = vec2[](
+    vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(1.0, 1.0),
+    vec2(-1.0, -1.0), vec2(1.0, 1.0), vec2(-1.0, 1.0)
+);
+
+void main() {
+    // One instance per alive particle
+    const Particle particle = particles[gl_InstanceIndex];
+    const vec2 corner = CORNERS[gl_VertexIndex];
+    const vec3 world_position = particle.position_life.xyz
+        + (draw.camera_right.xyz * corner.x + draw.camera_up.xyz * corner.y) * particle.velocity_size.w;
+    gl_Position = draw.view_proj * vec4(world_position, 1.0);
+    fragOffset = corner;
+    fragLife = particle.position_life.w;
+}
@@ -1,9 +1,164 @@
 #version 450
+#ifdef NONUNIFORM_MATERIALS
+#extension GL_EXT_nonuniform_qualifier : require
+#endif
+
+// Size of the bindless arrays, given at pipeline creation
+layout(constant_id = 0) const uint BINDLESS_TEXTURE_COUNT = 16;
+layout(constant_id = 1) const uint BINDLESS_SAMPLER_COUNT = 4;
+// Objects may be drawn during a LOD crossfade: without it, the pipeline
+// has no discard, so the depth test can always run before the shader
+layout(constant_id = 2) const bool LOD_CROSSFADE = false;
+layout(constant_id = 3) const uint BINDLESS_STORAGE_BUFFER_COUNT = 4;
+// Shade with the point lights of the cluster of the fragment (see
+// ClusteredLighting), else output the albedo as is
+layout(constant_id = 4) const bool CLUSTERED_LIGHTING = false;
+
+// The handles of the material are uniform within a draw of one object.
+// The mesh shading pipelines draw every instance in a single draw: they
+// use the NONUNIFORM_MATERIALS variant (frag_nonuniform.spv).
+#ifdef NONUNIFORM_MATERIALS
+#define MATERIAL_INDEX(index) nonuniformEXT(index)
+#else
+#define MATERIAL_INDEX(index) (index)
+#endif
+
+layout(set = 1, binding = 0) uniform texture2D textures[BINDLESS_TEXTURE_COUNT];
+layout(set = 1, binding = 2) uniform sampler samplers[BINDLESS_SAMPLER_COUNT];
+
+// Must match PointLight (clustered_lighting.hpp)
+struct PointLight {
+    vec4 position_radius;
+    vec4 color;
+};
+
+// Two views of the bindless storage buffers: the lights, and the light
+// ranges / index lists of the clusters
+layout(std430, set = 1, binding = 1) readonly buffer LightBuffer {
+    PointLight lights[];
+} light_buffers[BINDLESS_STORAGE_BUFFER_COUNT];
+layout(std430, set = 1, binding = 1) readonly buffer ClusterBuffer {
+    uint data[];
+} cluster_buffers[BINDLESS_STORAGE_BUFFER_COUNT];
+
+// Must match CLUSTER_HEADER_WORDS (clustered_lighting.cpp)
+const uint CLUSTER_HEADER_WORDS = 4;
+
+// Must match MAX_STREAMED_TEXTURES (scene.hpp)
+const uint MAX_STREAMED_TEXTURES = 64;
+
+// Must match FrameUniforms (scene.hpp)
+layout(std140, set = 2, binding = 0) uniform Frame {
+    mat4 view_proj;
+    vec4 viewport;
+    // Current bindless handle of each streamed texture, 4 per uvec4
+    uvec4 streamed_textures[MAX_STREAMED_TEXTURES / 4];
+    vec4 frustum_planes[6];
+    vec4 camera_position;
+    uvec4 light_grid;
+    uvec4 light_buffers;
+    vec4 light_depth;
+} frame;
+
+// Must match DrawPushConstants (scene.hpp)
+layout(push_constant) uniform Draw {
+    uint object_index;
+    uint texture_handle;
+} draw;
 
 layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec2 fragUV;
+layout(location = 2) flat in uvec4 fragMaterial;
+layout(location = 3) in vec3 fragWorldPosition;
 
 layout(location = 0) out vec4 outColor;
 
+// Must match LOD_FADE_MASK, LOD_FADE_OUT_BIT and LOD_FADE_BIT (mesh_lod.hpp)
+const uint LOD_FADE_MASK = 0xFFFFu;
+const uint LOD_FADE_OUT_BIT = 1u << 16;
+const uint LOD_FADE_BIT = 1u << 17;
+
+/**
+ * During a LOD crossfade, the level fading in keeps a fraction of the
+ * pixels of an ordered dither pattern, and the level fading out the other
+ * ones: together they cover the object once, without blending nor sorting.
+ */
+bool isFadedOut(uint fade_bits) {
+    if ((fade_bits & LOD_FADE_BIT) == 0u)
+        return false;
+    // 4x4 Bayer matrix
+    const uint bayer[16] = uint[16](0u, 8u, 2u, 10u, 12u, 4u, 14u, 6u, 3u, 11u, 1u, 9u, 15u, 7u, 13u, 5u);
+    const uvec2 pixel = uvec2(gl_FragCoord.xy) & 3u;
+    const float threshold = (float(bayer[pixel.y * 4u + pixel.x]) + 0.5) / 16.0;
+    const bool kept = threshold < float(fade_bits & LOD_FADE_MASK) / float(LOD_FADE_MASK);
+    return kept == ((fade_bits & LOD_FADE_OUT_BIT) != 0u);
+}
+
+/**
+ * Flat normal of the triangle, facing the camera: the vertices have no
+ * normal. Uses derivatives: to call in uniform control flow, before any
+ * discard.
+ */
+vec3 faceNormal() {
+    vec3 normal = normalize(cross(dFdx(fragWorldPosition), dFdy(fragWorldPosition)));
+    if (dot(normal, frame.camera_position.xyz - fragWorldPosition) < 0.0)
+        normal = -normal;
+    return normal;
+}
+
+/**
+ * Ambient light plus the point lights of the cluster of the fragment
+ * (Lambert), with the normal given by faceNormal().
+ */
+vec3 clusteredLighting(vec3 normal) {
+    vec3 light = vec3(frame.light_depth.z);
+    // Reverse-Z infinite projection: depth = near / view depth
+    const float view_depth = frame.light_depth.x / max(gl_FragCoord.z, 1e-7);
+    const uint slice = uint(max(log(view_depth / frame.light_depth.x) * frame.light_depth.y, 0.0));
+    if (slice >= frame.light_grid.z)
+        return light;
+    // In pixels of the extent of the grid, with dynamic resolution
+    const uvec2 tile = min(uvec2(gl_FragCoord.xy * frame.light_depth.w) / frame.light_grid.w, frame.light_grid.xy - 1u);
+    const uint cluster = (slice * frame.light_grid.y + tile.y) * frame.light_grid.x + tile.x;
+    const uint cluster_count = frame.light_grid.x * frame.light_grid.y * frame.light_grid.z;
+
+    // Uniform handles: no nonuniformEXT needed
+    const uint light_handle = frame.light_buffers.x;
+    const uint cluster_handle = frame.light_buffers.y;
+    const uint range = frame.light_buffers.z + CLUSTER_HEADER_WORDS + 2u * cluster;
+    const uint first_index = frame.light_buffers.z + CLUSTER_HEADER_WORDS + 2u * cluster_count + cluster_buffers[cluster_handle].data[range];
+    const uint count = cluster_buffers[cluster_handle].data[range + 1u];
+
+    for (uint i = 0u; i < count; i++) {
+        const PointLight point_light = light_buffers[light_handle].lights[cluster_buffers[cluster_handle].data[first_index + i]];
+        const vec3 to_light = point_light.position_radius.xyz - fragWorldPosition;
+        const float distance = length(to_light);
+        const float attenuation = clamp(1.0 - distance / point_light.position_radius.w, 0.0, 1.0);
+        light += point_light.color.rgb * (attenuation * attenuation * max(dot(normal, to_light / max(distance, 1e-5)), 0.0));
+    }
+    return light;
+}
+
 void main() {
-    outColor = vec4(fragColor, 1.0);
+    // Derivatives are undefined after a discard or a non-uniform branch
+    vec3 normal = vec3(0.0);
+    if (CLUSTERED_LIGHTING)
+        normal = faceNormal();
+    if (LOD_CROSSFADE && isFadedOut(fragMaterial.w))
+        discard;
+    // Uniform within a draw, unless several objects are drawn at once
+    // (see MATERIAL_INDEX)
+    uint texture_handle = fragMaterial.x;
+    if (fragMaterial.z != 0u) {
+        // Streamed texture: its image (and handle) changes with its resident mip levels
+        uint streamed_texture = fragMaterial.z - 1u;
+        texture_handle = frame.streamed_textures[streamed_texture / 4u][streamed_texture % 4u];
+    }
+    if (draw.texture_handle != 0xFFFFFFFFu)
+        texture_handle = draw.texture_handle;
+    vec4 albedo = texture(sampler2D(textures[MATERIAL_INDEX(texture_handle)], samplers[MATERIAL_INDEX(fragMaterial.y)]), fragUV);
+    vec3 color = fragColor * albedo.rgb;
+    if (CLUSTERED_LIGHTING)
+        color *= clusteredLighting(normal);
+    outColor = vec4(color, 1.0);
 }
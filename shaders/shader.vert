@@ -1,20 +1,54 @@
 #version 450
 
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inColor;
+layout(location = 2) in vec2 inUV;
+
 layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragUV;
+layout(location = 2) flat out uvec4 fragMaterial;
+layout(location = 3) out vec3 fragWorldPosition;
+
+// The depth pre-pass and the main pass must compute the exact same depth
+// (main pass depth test: EQUAL)
+invariant gl_Position;
+
+struct ObjectData {
+    vec4 position_scale;
+    vec4 bounds;
+    // x: texture handle, y: sampler handle (bindless set),
+    // z: streamed texture index + 1 (0: not streamed),
+    // w: LOD crossfade (see shader.frag)
+    uvec4 material;
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer Objects {
+    ObjectData objects[];
+};
+
+// Must match DrawPushConstants (scene.hpp)
+layout(push_constant) uniform Draw {
+    uint object_index;
+    uint texture_handle;
+} draw;
 
-vec2 positions[3] = vec2[](
-    vec2(0.0, -0.5),
-    vec2(0.5, 0.5),
-    vec2(-0.5, 0.5)
-);
+// Must match MAX_STREAMED_TEXTURES (scene.hpp)
+const uint MAX_STREAMED_TEXTURES = 64;
 
-vec3 colors[3] = vec3[](
-    vec3(1.0, 0.0, 0.0),
-    vec3(0.0, 1.0, 0.0),
-    vec3(0.0, 0.0, 1.0)
-);
+// Suballocated every frame, bound with a dynamic offset
+layout(std140, set = 2, binding = 0) uniform Frame {
+    mat4 view_proj;
+    vec4 viewport;
+    uvec4 streamed_textures[MAX_STREAMED_TEXTURES / 4];
+} frame;
 
 void main() {
-    gl_Position = vec4(positions[gl_VertexIndex], 0.0, 1.0);
-    fragColor = colors[gl_VertexIndex];
+    // Either object_index or firstInstance is the index of the object
+    ObjectData object = objects[draw.object_index + gl_InstanceIndex];
+    vec3 world_position = inPosition * object.position_scale.w + object.position_scale.xyz;
+    gl_Position = frame.view_proj * vec4(world_position, 1.0);
+    fragColor = inColor;
+    fragUV = inUV;
+    fragMaterial = object.material;
+    fragWorldPosition = world_position;
 }